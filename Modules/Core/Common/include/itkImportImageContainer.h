@@ -20,6 +20,7 @@
 
 #include "itkObject.h"
 #include "itkObjectFactory.h"
+#include <functional>
 #include <utility>
 
 namespace itk
@@ -75,6 +76,16 @@ public:
   void SetImportPointer(TElement *ptr, TElementIdentifier num,
                         bool LetContainerManageMemory = false);
 
+  /** Function releasing a block of memory imported with a deleter. */
+  using DeleterType = std::function< void ( TElement * ) >;
+
+  /** Set the pointer from which the image data is imported, and let
+   * this class free the memory by calling "deleter" on the pointer
+   * instead of delete[]. This allows importing memory that was not
+   * allocated with new[], such as a memory mapped file. */
+  void SetImportPointer(TElement *ptr, TElementIdentifier num,
+                        DeleterType deleter);
+
   /** Index operator. This version can be an lvalue. */
   TElement & operator[](const ElementIdentifier id)
   { return m_ImportPointer[id]; }
@@ -182,6 +193,7 @@ private:
   TElementIdentifier m_Size;
   TElementIdentifier m_Capacity;
   bool               m_ContainerManageMemory;
+  DeleterType        m_Deleter;
 };
 } // end namespace itk
 
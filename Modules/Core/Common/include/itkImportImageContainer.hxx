@@ -168,6 +168,16 @@ ImportImageContainer< TElementIdentifier, TElement >
   this->Modified();
 }
 
+template< typename TElementIdentifier, typename TElement >
+void
+ImportImageContainer< TElementIdentifier, TElement >
+::SetImportPointer(TElement *ptr, TElementIdentifier num,
+                   DeleterType deleter)
+{
+  this->SetImportPointer(ptr, num, true);
+  m_Deleter = std::move(deleter);
+}
+
 template< typename TElementIdentifier, typename TElement >
 TElement *ImportImageContainer< TElementIdentifier, TElement >
 ::AllocateElements(ElementIdentifier size, bool UseDefaultConstructor ) const
@@ -210,8 +220,16 @@ void ImportImageContainer< TElementIdentifier, TElement >
   // Encapsulate all image memory deallocation here
   if ( m_ContainerManageMemory )
     {
-    delete[] m_ImportPointer;
+    if ( m_Deleter )
+      {
+      m_Deleter(m_ImportPointer);
+      }
+    else
+      {
+      delete[] m_ImportPointer;
+      }
     }
+  m_Deleter = nullptr;
   m_ImportPointer = nullptr;
   m_Capacity = 0;
   m_Size = 0;
@@ -227,6 +245,8 @@ ImportImageContainer< TElementIdentifier, TElement >
   os << indent << "Pointer: " << static_cast< void * >( m_ImportPointer ) << std::endl;
   os << indent << "Container manages memory: "
      << ( m_ContainerManageMemory ? "true" : "false" ) << std::endl;
+  os << indent << "Deleter: "
+     << ( m_Deleter ? "set" : "not set" ) << std::endl;
   os << indent << "Size: " << m_Size << std::endl;
   os << indent << "Capacity: " << m_Capacity << std::endl;
 }
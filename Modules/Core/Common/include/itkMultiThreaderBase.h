@@ -344,6 +344,26 @@ ITK_GCC_PRAGMA_DIAG_POP()
    * If "abort generate data" is set, throws the ProcessAborted exception. */
   static void HandleFilterProgress(ProcessObject *filter, float progress = -1.0f);
 
+  /** Set/Get whether nested parallelism is enabled. It is disabled by
+   * default, so that the threading of existing applications is unchanged.
+   *
+   * When enabled, ParallelizeArray and ParallelizeImageRegion calls made
+   * from within a work unit of another parallel operation (for example from
+   * a filter's DynamicThreadedGenerateData) join the global thread pool
+   * instead of spawning additional threads or blocking a pool thread: their
+   * pieces are queued in the pool, and the calling thread executes pieces
+   * of its own call while waiting. This keeps all the processors busy in
+   * composite pipelines without oversubscribing them, and without
+   * deadlocking when all the pool threads make nested calls.
+   * When disabled, nested calls are executed like top-level calls.
+   * TBBMultiThreader handles nesting natively and ignores this setting. */
+  static void SetGlobalNestedParallelism(bool nestedParallelism);
+  static bool GetGlobalNestedParallelism();
+
+  /** Whether the calling thread is currently executing a work unit of a
+   * multi-threader, i.e. whether a parallel call made now is nested. */
+  static bool IsInsideWorkUnit();
+
 protected:
   MultiThreaderBase();
   ~MultiThreaderBase() override;
@@ -361,6 +381,24 @@ protected:
 
   static ITK_THREAD_RETURN_FUNCTION_CALL_CONVENTION ParallelizeArrayHelper(void *arg);
 
+  /** Marks the calling thread as executing a work unit for its lifetime.
+   * Multi-threaders create one around each piece of work they run, so that
+   * parallel calls made from within that piece are recognized as nested. */
+  class ITKCommon_EXPORT WorkUnitScope
+  {
+  public:
+    ITK_DISALLOW_COPY_AND_ASSIGN(WorkUnitScope);
+    WorkUnitScope();
+    ~WorkUnitScope();
+  };
+
+  /** Whether a parallel call made now should join the enclosing one,
+   * as described in SetGlobalNestedParallelism. */
+  static bool IsNestedParallelCall()
+  {
+    return GetGlobalNestedParallelism() && IsInsideWorkUnit();
+  }
+
   struct RegionAndCallback
   {
     ThreadingFunctorType functor;
@@ -105,6 +105,13 @@ protected:
   void PrintSelf(std::ostream & os, Indent indent) const override;
 
 private:
+  /** Submit work units 0 .. numberOfWorkUnits-1 to the thread pool, calling
+   * function( i ) for each of them. For a nested call, the calling thread
+   * takes part in executing them, see SetGlobalNestedParallelism. */
+  template< typename TFunction >
+  std::vector< std::future< ITK_THREAD_RETURN_TYPE > >
+  SubmitWorkUnits( SizeValueType numberOfWorkUnits, TFunction && function );
+
   // Thread pool instance and factory
   ThreadPool::Pointer m_ThreadPool;
 
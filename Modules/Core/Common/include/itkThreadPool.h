@@ -20,12 +20,16 @@
 
 #include "itkConfigure.h"
 #include "itkIntTypes.h"
+#include "itkThreadSupport.h"
 
+#include <atomic>
 #include <deque>
 #include <functional>
 #include <future>
+#include <memory>
 #include <condition_variable>
 #include <thread>
+#include <vector>
 
 #include "itkObject.h"
 #include "itkObjectFactory.h"
@@ -41,7 +45,17 @@ namespace itk
  *
  * Thread pool is called and initialized from within the PoolMultiThreader.
  * Initially the thread pool is started with GlobalDefaultNumberOfThreads.
- * The jobs are submitted via AddWork method.
+ * The jobs are submitted via AddWork method, or in bulk via AddWorkBatch.
+ *
+ * Each pool thread owns a work queue. Jobs submitted from a pool thread
+ * are pushed onto that thread's own queue, and AddWorkBatch spreads its
+ * jobs over all the per-thread queues. A thread pops jobs from the back
+ * of its own queue first, then from the shared queue (which receives
+ * single jobs submitted from outside the pool), and finally steals jobs
+ * from the front of the other threads' queues. This avoids having all
+ * the threads contend on a single lock when many fine-grained jobs are
+ * submitted. Work stealing can be disabled via SetUseWorkStealing, in
+ * which case all jobs go through the shared queue.
  *
  * This implementation heavily borrows from:
  * https://github.com/progschj/ThreadPool
@@ -89,14 +103,87 @@ public:
       std::bind( std::forward< Function >( function ), std::forward< Arguments >( arguments )... ) );
 
     std::future< return_type > res = task->get_future();
-    {
-      std::unique_lock< std::mutex > lock( this->GetMutex() );
-      m_WorkQueue.emplace_back( [task]() { ( *task )(); } );
-    }
-    m_Condition.notify_one();
+    this->SubmitJob( [task]() { ( *task )(); } );
     return res;
   }
 
+  /** Add numberOfJobs jobs to the thread pool at once.
+   *
+   * The function is called as function( i ) for i in [0, numberOfJobs).
+   * Consecutive jobs are distributed in contiguous blocks over the
+   * per-thread queues, taking each queue lock only once for the whole
+   * batch. The returned futures are in job order. Example usage:
+   * auto results = pool.AddWorkBatch(4, [](SizeValueType i) { return i * i; });
+   * for (auto & r : results) { std::cout << r.get() << std::endl; } */
+  template< class Function >
+  auto
+  AddWorkBatch( SizeValueType numberOfJobs, Function&& function )
+    -> std::vector< std::future< typename std::result_of< Function( SizeValueType ) >::type > >
+  {
+    using return_type = typename std::result_of< Function( SizeValueType ) >::type;
+
+    std::vector< std::future< return_type > > results;
+    std::vector< std::function< void() > > jobs;
+    results.reserve( numberOfJobs );
+    jobs.reserve( numberOfJobs );
+    for ( SizeValueType i = 0; i < numberOfJobs; ++i )
+      {
+      auto task = std::make_shared< std::packaged_task< return_type() > >( std::bind( function, i ) );
+      results.push_back( task->get_future() );
+      jobs.emplace_back( [task]() { ( *task )(); } );
+      }
+    this->SubmitJobs( jobs );
+    return results;
+  }
+
+  /** Same as AddWorkBatch, except that the calling thread takes part in the
+   * execution: before returning, it runs every job of the batch which has not
+   * been started by a pool thread yet. The calling thread never runs jobs of
+   * other batches, so waiting on the returned futures cannot deadlock, even
+   * when this is called from within a job while all the pool threads are busy.
+   * This is what allows nested parallel calls from pool threads. */
+  template< class Function >
+  auto
+  AddWorkBatchAndParticipate( SizeValueType numberOfJobs, Function&& function )
+    -> std::vector< std::future< typename std::result_of< Function( SizeValueType ) >::type > >
+  {
+    using return_type = typename std::result_of< Function( SizeValueType ) >::type;
+    using TaskPointer = std::shared_ptr< std::packaged_task< return_type() > >;
+
+    // each job is run by whichever thread claims it first
+    auto claimed = std::make_shared< std::vector< std::atomic< bool > > >( numberOfJobs );
+
+    std::vector< std::future< return_type > > results;
+    std::vector< TaskPointer > tasks;
+    std::vector< std::function< void() > > jobs;
+    results.reserve( numberOfJobs );
+    tasks.reserve( numberOfJobs );
+    jobs.reserve( numberOfJobs );
+    for ( SizeValueType i = 0; i < numberOfJobs; ++i )
+      {
+      TaskPointer task = std::make_shared< std::packaged_task< return_type() > >( std::bind( function, i ) );
+      results.push_back( task->get_future() );
+      tasks.push_back( task );
+      jobs.emplace_back( [task, claimed, i]()
+        {
+        if ( !( *claimed )[i].exchange( true ) )
+          {
+          ( *task )();
+          }
+        } );
+      }
+    this->SubmitJobs( jobs );
+
+    for ( SizeValueType i = 0; i < numberOfJobs; ++i )
+      {
+      if ( !( *claimed )[i].exchange( true ) )
+        {
+        ( *tasks[i] )();
+        }
+      }
+    return results;
+  }
+
   /** Can call this method if we want to add extra threads to the pool. */
   void AddThreads(ThreadIdType count);
 
@@ -108,6 +195,11 @@ public:
   /** The approximate number of idle threads. */
   int GetNumberOfCurrentlyIdleThreads() const;
 
+  /** Set/Get whether jobs are distributed over per-thread queues with
+   * work stealing (the default), or all go through one shared queue. */
+  static bool GetUseWorkStealing();
+  static void SetUseWorkStealing(bool useWorkStealing);
+
   /** Set/Get wait for threads.
   This function should be used carefully, probably only during static
   initialization phase to disable waiting for threads when ITK is built as a
@@ -121,6 +213,20 @@ protected:
    * visible in .cxx file, so this method returns it. */
   std::mutex& GetMutex();
 
+  /** Queue a single job, and wake up an idle thread to run it. */
+  void SubmitJob( std::function< void() > && job );
+
+  /** Queue a batch of jobs, and wake up idle threads to run them. */
+  void SubmitJobs( std::vector< std::function< void() > > & jobs );
+
+  /** Remove one job from the queues, looking in the own queue of the thread
+   * with index workerIndex first, then in the shared queue, and finally in
+   * the queues of the other threads. Returns false if no job was found. */
+  bool PopJob( ThreadIdType workerIndex, std::function< void() > & job );
+
+  /** Wake up at most count idle threads. */
+  void WakeThreads( SizeValueType count );
+
   ThreadPool();
   ~ThreadPool() override;
 
@@ -134,8 +240,37 @@ private:
    * Filled by AddWork, emptied by ThreadExecute. */
   std::deque< std::function< void() > > m_WorkQueue;
 
+  /** Per-thread job queue, with its own lock. The owning thread pushes
+   * and pops at the back, other threads steal from the front. */
+  struct WorkerQueue
+  {
+    std::mutex m_Mutex;
+    std::deque< std::function< void() > > m_Jobs;
+  };
+
+  /** One queue per pool thread. Statically sized, so that stealing threads
+   * can index it while AddThreads starts new threads. */
+  WorkerQueue m_WorkerQueues[ITK_MAX_THREADS];
+
+  /** Number of pool threads which own a queue in m_WorkerQueues. */
+  std::atomic< ThreadIdType > m_NumberOfWorkerQueues{ 0 };
+
+  /** Number of jobs in m_WorkQueue, readable without taking the mutex. */
+  std::atomic< SizeValueType > m_NumberOfSharedJobs{ 0 };
+
+  /** Number of jobs in all the queues. Incremented before a job is queued
+   * and decremented after it is dequeued, so it is never too small. */
+  std::atomic< SizeValueType > m_NumberOfPendingJobs{ 0 };
+
+  /** Number of threads waiting on m_Condition. */
+  std::atomic< int > m_NumberOfIdleThreads{ 0 };
+
+  /** Queue into which the next batch starts, so that consecutive small
+   * batches do not all land on the first threads. */
+  std::atomic< ThreadIdType > m_NextBatchQueue{ 0 };
+
   /** When a thread is idle, it is waiting on m_Condition.
-   * AddWork signals it to resume a (random) thread. */
+   * SubmitJob signals it to resume a (random) thread. */
   std::condition_variable m_Condition;
 
   /** Vector to hold all thread handles.
@@ -149,7 +284,7 @@ private:
   static ThreadPoolGlobals * m_PimplGlobals;
 
   /** The continuously running thread function */
-  static void ThreadExecute();
+  static void ThreadExecute( ThreadIdType workerIndex );
 };
 
 }
@@ -32,6 +32,7 @@
 #include "itkPoolMultiThreader.h"
 #endif
 #include "itkNumericTraits.h"
+#include <atomic>
 #include <mutex>
 
 #include "itksys/SystemTools.hxx"
@@ -51,6 +52,13 @@
 namespace itk
 {
 
+namespace
+{
+// Number of work units the calling thread is currently executing. More than
+// one when the thread helps with nested work while waiting for it.
+thread_local unsigned int WorkUnitDepth = 0;
+}
+
 struct MultiThreaderBaseGlobals
 {
   // Initialize static members.
@@ -68,7 +76,8 @@ struct MultiThreaderBaseGlobals
 #endif
   m_GlobalMaximumNumberOfThreads(ITK_MAX_THREADS),
   // Global default number of threads : 0 => Not initialized.
-  m_GlobalDefaultNumberOfThreads(0)
+  m_GlobalDefaultNumberOfThreads(0),
+  m_GlobalNestedParallelism(false)
   {};
   // GlobalDefaultThreaderTypeIsInitialized is used only in this
   // file to ensure that the ITK_GLOBAL_DEFAULT_THREADER or
@@ -96,6 +105,9 @@ struct MultiThreaderBaseGlobals
   //  m_GlobalMaximumNumberOfThreads and larger or equal to 1 once it has been
   //  initialized in the constructor of the first MultiThreaderBase instantiation.
   ThreadIdType m_GlobalDefaultNumberOfThreads;
+
+  // Whether parallel calls made from within a work unit join the thread pool.
+  std::atomic< bool > m_GlobalNestedParallelism;
 };
 
 itkGetGlobalSimpleMacro(MultiThreaderBase, MultiThreaderBaseGlobals, PimplGlobals);
@@ -184,6 +196,41 @@ You should now use ITK_GLOBAL_DEFAULT_THREADER\
   return m_PimplGlobals->m_GlobalDefaultThreader;
 }
 
+void
+MultiThreaderBase
+::SetGlobalNestedParallelism(bool nestedParallelism)
+{
+  itkInitGlobalsMacro(PimplGlobals);
+  m_PimplGlobals->m_GlobalNestedParallelism = nestedParallelism;
+}
+
+bool
+MultiThreaderBase
+::GetGlobalNestedParallelism()
+{
+  itkInitGlobalsMacro(PimplGlobals);
+  return m_PimplGlobals->m_GlobalNestedParallelism;
+}
+
+bool
+MultiThreaderBase
+::IsInsideWorkUnit()
+{
+  return WorkUnitDepth > 0;
+}
+
+MultiThreaderBase::WorkUnitScope
+::WorkUnitScope()
+{
+  ++WorkUnitDepth;
+}
+
+MultiThreaderBase::WorkUnitScope
+::~WorkUnitScope()
+{
+  --WorkUnitDepth;
+}
+
 MultiThreaderBase::ThreaderType
 MultiThreaderBase
 ::ThreaderTypeFromString(std::string threaderString)
@@ -449,6 +496,7 @@ MultiThreaderBase
   // execute the user specified threader callback, catching any exceptions
   try
     {
+    WorkUnitScope workUnitScope;
     ( *threadInfoStruct->ThreadFunction )(arg);
     threadInfoStruct->ThreadExitCode = WorkUnitInfo::SUCCESS;
     }
@@ -503,6 +551,18 @@ MultiThreaderBase
   ArrayThreadingFunctorType aFunc,
   ProcessObject* filter )
 {
+#if defined(POOL_MULTI_THREADER_AVAILABLE)
+  if ( Self::IsNestedParallelCall() )
+    {
+    // Spawning threads from within a work unit would oversubscribe the
+    // processors, so let the thread pool execute the nested work.
+    PoolMultiThreader::Pointer poolThreader = PoolMultiThreader::New();
+    poolThreader->SetNumberOfWorkUnits( m_NumberOfWorkUnits );
+    poolThreader->ParallelizeArray( firstIndex, lastIndexPlus1, aFunc, filter );
+    return;
+    }
+#endif
+
   // This implementation simply delegates parallelization to the old interface
   // SetSingleMethod+SingleMethodExecute. This method is meant to be overloaded!
   MultiThreaderBase::HandleFilterProgress(filter, 0.0f);
@@ -577,6 +637,17 @@ MultiThreaderBase
     MultiThreaderBase::ThreadingFunctorType funcP,
     ProcessObject* filter)
 {
+#if defined(POOL_MULTI_THREADER_AVAILABLE)
+  if ( Self::IsNestedParallelCall() )
+    {
+    // see ParallelizeArray
+    PoolMultiThreader::Pointer poolThreader = PoolMultiThreader::New();
+    poolThreader->SetNumberOfWorkUnits( m_NumberOfWorkUnits );
+    poolThreader->ParallelizeImageRegion( dimension, index, size, funcP, filter );
+    return;
+    }
+#endif
+
   // This implementation simply delegates parallelization to the old interface
   // SetSingleMethod+SingleMethodExecute. This method is meant to be overloaded!
   MultiThreaderBase::HandleFilterProgress(filter, 0.0f);
@@ -660,6 +731,8 @@ void MultiThreaderBase::PrintSelf(std::ostream & os, Indent indent) const
      << m_PimplGlobals->m_GlobalDefaultNumberOfThreads << std::endl;
   os << indent << "Global Default Threader Type: "
      << m_PimplGlobals->m_GlobalDefaultThreader << std::endl;
+  os << indent << "Global Nested Parallelism: "
+     << m_PimplGlobals->m_GlobalNestedParallelism << std::endl;
   os << indent << "SingleMethod: " << m_SingleMethod << std::endl;
   os << indent << "SingleData: " << m_SingleData << std::endl;
 }
@@ -164,6 +164,7 @@ void PlatformMultiThreader::SingleMethodExecute()
     {
     m_ThreadInfoArray[0].UserData = m_SingleData;
     m_ThreadInfoArray[0].NumberOfWorkUnits = m_NumberOfWorkUnits;
+    WorkUnitScope workUnitScope;
     m_SingleMethod( (void *)( &m_ThreadInfoArray[0] ) );
     }
   catch( ProcessAborted & )
@@ -31,8 +31,9 @@
 #include "itkImageSourceCommon.h"
 #include <algorithm>
 #include <iostream>
+#include <memory>
 #include <string>
-#include <algorithm>
+#include <vector>
 
 namespace itk
 {
@@ -90,7 +91,20 @@ void PoolMultiThreader::SingleMethodExecute()
     {
     m_ThreadInfoArray[threadLoop].UserData = m_SingleData;
     m_ThreadInfoArray[threadLoop].NumberOfWorkUnits = m_NumberOfWorkUnits;
-    m_ThreadInfoArray[threadLoop].Future = m_ThreadPool->AddWork( m_SingleMethod, &m_ThreadInfoArray[threadLoop] );
+    }
+  if ( m_NumberOfWorkUnits > 1 )
+    {
+    ThreadFunctionType singleMethod = m_SingleMethod;
+    ThreadPoolInfoStruct * threadInfoArray = m_ThreadInfoArray;
+    auto futures = this->SubmitWorkUnits( m_NumberOfWorkUnits - 1,
+      [singleMethod, threadInfoArray]( SizeValueType i )
+      {
+        return singleMethod( &threadInfoArray[i + 1] );
+      } );
+    for ( threadLoop = 1; threadLoop < m_NumberOfWorkUnits; ++threadLoop )
+      {
+      m_ThreadInfoArray[threadLoop].Future = std::move( futures[threadLoop - 1] );
+      }
     }
 
   try
@@ -98,7 +112,10 @@ void PoolMultiThreader::SingleMethodExecute()
     // Now, the parent thread calls this->SingleMethod() itself
     m_ThreadInfoArray[0].UserData = m_SingleData;
     m_ThreadInfoArray[0].NumberOfWorkUnits = m_NumberOfWorkUnits;
+    {
+    WorkUnitScope workUnitScope;
     m_SingleMethod( (void *)( &m_ThreadInfoArray[0] ) );
+    }
 
     // The parent thread has finished SingleMethod()
     // so now it waits for each of the other work units to finish
@@ -174,24 +191,25 @@ PoolMultiThreader
       chunkSize++; // we want slightly bigger chunks to be processed first
       }
 
-    SizeValueType workUnit = 0;
-    for ( SizeValueType i = firstIndex; i < lastIndexPlus1; i += chunkSize )
+    const SizeValueType workUnit = ( lastIndexPlus1 - firstIndex + chunkSize - 1 ) / chunkSize;
+    itkAssertOrThrowMacro( workUnit <= m_NumberOfWorkUnits,
+      "Number of work units was somehow miscounted!" );
+    auto futures = this->SubmitWorkUnits( workUnit,
+      [aFunc, firstIndex, lastIndexPlus1, chunkSize]( SizeValueType chunk )
       {
-      m_ThreadInfoArray[workUnit++].Future = m_ThreadPool->AddWork(
-        [aFunc]( SizeValueType start, SizeValueType end)
+        const SizeValueType start = firstIndex + chunk * chunkSize;
+        const SizeValueType end = std::min( start + chunkSize, lastIndexPlus1 );
+        for ( SizeValueType ii = start; ii < end; ii++ )
         {
-          for ( SizeValueType ii = start; ii < end; ii++ )
-          {
-            aFunc( ii );
-          }
-          // make this lambda have the same signature as m_SingleMethod
-          return ITK_THREAD_RETURN_DEFAULT_VALUE;
-        },
-        i,
-        std::min( i + chunkSize, lastIndexPlus1 ) );
+          aFunc( ii );
+        }
+        // make this lambda have the same signature as m_SingleMethod
+        return ITK_THREAD_RETURN_DEFAULT_VALUE;
+      } );
+    for ( SizeValueType i = 0; i < workUnit; i++ )
+      {
+      m_ThreadInfoArray[i].Future = std::move( futures[i] );
       }
-    itkAssertOrThrowMacro( workUnit <= m_NumberOfWorkUnits,
-      "Number of work units was somehow miscounted!" );
     //now wait for all computations to finish
     for (SizeValueType i = 0; i < workUnit; i++)
       {
@@ -244,29 +262,33 @@ PoolMultiThreader
       ThreadIdType splitCount = splitter->GetNumberOfSplits( region, m_NumberOfWorkUnits );
       itkAssertOrThrowMacro( splitCount <= m_NumberOfWorkUnits,
         "Split count is greater than number of work units!" );
-      // now wait for all computations to finish
+      // shared by the jobs, which may outlive this call if one of them throws
+      auto subRegions = std::make_shared< std::vector< ImageIORegion > >( splitCount, region );
       for ( ThreadIdType i = 0; i < splitCount; i++ )
         {
-        ImageIORegion iRegion = region;
-        ThreadIdType total = splitter->GetSplit( i, splitCount, iRegion );
-        if (i < total)
-          {
-          m_ThreadInfoArray[i].Future = m_ThreadPool->AddWork(
-            [funcP, iRegion]()
-            {
-              funcP( &iRegion.GetIndex()[0], &iRegion.GetSize()[0] );
-              // make this lambda have the same signature as m_SingleMethod
-              return ITK_THREAD_RETURN_DEFAULT_VALUE;
-            }
-            );
-          }
-        else
+        ThreadIdType total = splitter->GetSplit( i, splitCount, ( *subRegions )[i] );
+        if ( i >= total )
           {
           itkExceptionMacro( "Could not get work unit " << i
             << " even though we checked possible number of splits beforehand!" );
           }
         }
 
+      // submit all the pieces at once, spread over the thread queues
+      auto futures = this->SubmitWorkUnits( splitCount,
+        [funcP, subRegions]( SizeValueType i )
+        {
+          const ImageIORegion & iRegion = ( *subRegions )[i];
+          funcP( &iRegion.GetIndex()[0], &iRegion.GetSize()[0] );
+          // make this lambda have the same signature as m_SingleMethod
+          return ITK_THREAD_RETURN_DEFAULT_VALUE;
+        } );
+      for ( ThreadIdType i = 0; i < splitCount; i++ )
+        {
+        m_ThreadInfoArray[i].Future = std::move( futures[i] );
+        }
+
+      // now wait for all computations to finish
       for (ThreadIdType i = 0; i < splitCount; i++)
         {
         m_ThreadInfoArray[i].Future.get();
@@ -280,6 +302,27 @@ PoolMultiThreader
   MultiThreaderBase::HandleFilterProgress(filter, 1.0f);
 }
 
+template< typename TFunction >
+std::vector< std::future< ITK_THREAD_RETURN_TYPE > >
+PoolMultiThreader
+::SubmitWorkUnits( SizeValueType numberOfWorkUnits, TFunction && function )
+{
+  auto workUnit = [function]( SizeValueType i )
+    {
+    WorkUnitScope workUnitScope;
+    return function( i );
+    };
+
+  if ( Self::IsNestedParallelCall() )
+    {
+    // The calling thread is itself executing a work unit. Rather than waiting
+    // idle (and possibly occupying the last free pool thread), it executes
+    // the work units which the pool threads have not started yet.
+    return m_ThreadPool->AddWorkBatchAndParticipate( numberOfWorkUnits, workUnit );
+    }
+  return m_ThreadPool->AddWorkBatch( numberOfWorkUnits, workUnit );
+}
+
 void PoolMultiThreader::PrintSelf(std::ostream & os, Indent indent) const
 {
   Superclass::PrintSelf(os, indent);
@@ -67,6 +67,7 @@ void TBBMultiThreader::SingleMethodExecute()
     ti.WorkUnitID = r.begin();
     ti.UserData = m_SingleData;
     ti.NumberOfWorkUnits = m_NumberOfWorkUnits;
+    WorkUnitScope workUnitScope;
     m_SingleMethod(&ti); //TBB takes care of properly propagating exceptions
     },
       tbb::simple_partitioner());
@@ -108,6 +109,7 @@ TBBMultiThreader
         itkAssertInDebugAndIgnoreInReleaseMacro(r.begin() + 1 == r.end());
         MultiThreaderBase::HandleFilterProgress(filter);
 
+        WorkUnitScope workUnitScope;
         aFunc( r.begin() ); //invoke the function
 
         if ( filter )
@@ -241,6 +243,7 @@ void TBBMultiThreader
     tbb::parallel_for(regionSplitter, [&](TBBImageRegionSplitter regionToProcess)
       {
       MultiThreaderBase::HandleFilterProgress(filter);
+      WorkUnitScope workUnitScope;
       funcP(&regionToProcess.GetIndex()[0], &regionToProcess.GetSize()[0]);
       if (filter) //filter is provided, update progress
         {
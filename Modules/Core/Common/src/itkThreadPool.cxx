@@ -25,18 +25,28 @@
 #include "itkSingleton.h"
 
 #include <algorithm>
+#include <limits>
 
 
 namespace itk
 {
 
+namespace
+{
+// Index of the pool thread running on this thread, used to find its own
+// work queue. Threads which do not belong to the pool have no own queue.
+constexpr ThreadIdType NotAPoolThread = std::numeric_limits< ThreadIdType >::max();
+thread_local ThreadIdType ThreadPoolWorkerIndex = NotAPoolThread;
+}
+
 struct ThreadPoolGlobals
 {
-  ThreadPoolGlobals():m_DoNotWaitForThreads(false){};
+  ThreadPoolGlobals():m_DoNotWaitForThreads(false),m_UseWorkStealing(true){};
   // To lock on the internal variables.
   std::mutex m_Mutex;
   ThreadPool::Pointer m_ThreadPoolInstance;
   bool m_DoNotWaitForThreads;
+  std::atomic< bool > m_UseWorkStealing;
 };
 
 itkGetGlobalSimpleMacro(ThreadPool, ThreadPoolGlobals, PimplGlobals);
@@ -90,6 +100,22 @@ ThreadPool
   m_PimplGlobals->m_DoNotWaitForThreads = doNotWaitForThreads;
 }
 
+bool
+ThreadPool
+::GetUseWorkStealing()
+{
+  itkInitGlobalsMacro(PimplGlobals);
+  return m_PimplGlobals->m_UseWorkStealing;
+}
+
+void
+ThreadPool
+::SetUseWorkStealing(bool useWorkStealing)
+{
+  itkInitGlobalsMacro(PimplGlobals);
+  m_PimplGlobals->m_UseWorkStealing = useWorkStealing;
+}
+
 ThreadPool
 ::ThreadPool()
 {
@@ -99,8 +125,9 @@ ThreadPool
   m_Threads.reserve( threadCount );
   for ( unsigned int i = 0; i < threadCount; ++i )
     {
-    m_Threads.emplace_back( &ThreadPool::ThreadExecute );
+    m_Threads.emplace_back( &ThreadPool::ThreadExecute, i );
     }
+  m_NumberOfWorkerQueues = std::min( threadCount, ThreadIdType( ITK_MAX_THREADS ) );
 }
 
 void
@@ -111,8 +138,9 @@ ThreadPool
   m_Threads.reserve( m_Threads.size() + count );
   for( unsigned int i = 0; i < count; ++i )
     {
-    m_Threads.emplace_back( &ThreadPool::ThreadExecute );
+    m_Threads.emplace_back( &ThreadPool::ThreadExecute, static_cast< ThreadIdType >( m_Threads.size() ) );
     }
+  m_NumberOfWorkerQueues = std::min( static_cast< ThreadIdType >( m_Threads.size() ), ThreadIdType( ITK_MAX_THREADS ) );
 }
 
 std::mutex&
@@ -126,8 +154,179 @@ int
 ThreadPool
 ::GetNumberOfCurrentlyIdleThreads() const
 {
-  std::unique_lock<std::mutex> mutexHolder( m_PimplGlobals->m_Mutex );
-  return int(m_Threads.size()) - int(m_WorkQueue.size()); // lousy approximation
+  return m_NumberOfIdleThreads;
+}
+
+void
+ThreadPool
+::SubmitJob( std::function< void() > && job )
+{
+  ++m_NumberOfPendingJobs;
+
+  const ThreadIdType workerIndex = ThreadPoolWorkerIndex;
+  if ( workerIndex < m_NumberOfWorkerQueues && GetUseWorkStealing() )
+    {
+    // a job submitted from within the pool stays local to this thread
+    WorkerQueue & queue = m_WorkerQueues[workerIndex];
+    std::unique_lock< std::mutex > queueHolder( queue.m_Mutex );
+    queue.m_Jobs.emplace_back( std::move( job ) );
+    }
+  else
+    {
+    std::unique_lock< std::mutex > mutexHolder( m_PimplGlobals->m_Mutex );
+    m_WorkQueue.emplace_back( std::move( job ) );
+    ++m_NumberOfSharedJobs;
+    }
+
+  this->WakeThreads( 1 );
+}
+
+void
+ThreadPool
+::SubmitJobs( std::vector< std::function< void() > > & jobs )
+{
+  const auto jobCount = static_cast< SizeValueType >( jobs.size() );
+  if ( jobCount == 0 )
+    {
+    return;
+    }
+  m_NumberOfPendingJobs += jobCount;
+
+  const ThreadIdType queueCount = m_NumberOfWorkerQueues;
+  if ( queueCount > 0 && GetUseWorkStealing() )
+    {
+    // Split the batch into contiguous blocks, one per thread queue. Neighbouring
+    // jobs then tend to execute on the same thread, and imbalance is fixed up
+    // by stealing.
+    const ThreadIdType firstQueue = m_NextBatchQueue++ % queueCount;
+    const SizeValueType blockCount = std::min< SizeValueType >( jobCount, queueCount );
+    for ( SizeValueType b = 0; b < blockCount; ++b )
+      {
+      const SizeValueType begin = jobCount * b / blockCount;
+      const SizeValueType end = jobCount * ( b + 1 ) / blockCount;
+      WorkerQueue & queue = m_WorkerQueues[( firstQueue + b ) % queueCount];
+      std::unique_lock< std::mutex > queueHolder( queue.m_Mutex );
+      // the owner pops from the back, so push in reverse to keep job order
+      for ( SizeValueType i = end; i > begin; --i )
+        {
+        queue.m_Jobs.emplace_back( std::move( jobs[i - 1] ) );
+        }
+      }
+    }
+  else
+    {
+    std::unique_lock< std::mutex > mutexHolder( m_PimplGlobals->m_Mutex );
+    for ( auto & job : jobs )
+      {
+      m_WorkQueue.emplace_back( std::move( job ) );
+      }
+    m_NumberOfSharedJobs += jobCount;
+    }
+  jobs.clear();
+
+  this->WakeThreads( jobCount );
+}
+
+bool
+ThreadPool
+::PopJob( ThreadIdType workerIndex, std::function< void() > & job )
+{
+  const ThreadIdType queueCount = m_NumberOfWorkerQueues;
+
+  // own queue, most recently pushed job first
+  if ( workerIndex < queueCount )
+    {
+    WorkerQueue & queue = m_WorkerQueues[workerIndex];
+    std::unique_lock< std::mutex > queueHolder( queue.m_Mutex );
+    if ( !queue.m_Jobs.empty() )
+      {
+      job = std::move( queue.m_Jobs.back() );
+      queue.m_Jobs.pop_back();
+      --m_NumberOfPendingJobs;
+      return true;
+      }
+    }
+
+  // shared queue, in submission order
+  if ( m_NumberOfSharedJobs > 0 )
+    {
+    std::unique_lock< std::mutex > mutexHolder( m_PimplGlobals->m_Mutex );
+    if ( !m_WorkQueue.empty() )
+      {
+      job = std::move( m_WorkQueue.front() );
+      m_WorkQueue.pop_front();
+      --m_NumberOfSharedJobs;
+      --m_NumberOfPendingJobs;
+      return true;
+      }
+    }
+
+  // steal the oldest job of another thread. The first pass skips the queues
+  // which are busy; if some were skipped, the second pass waits for them
+  // rather than returning to the caller, which would spin.
+  bool skippedQueue = false;
+  for ( int pass = 0; pass < 2; ++pass )
+    {
+    for ( ThreadIdType i = 1; i <= queueCount; ++i )
+      {
+      const ThreadIdType victim = ( workerIndex + i ) % queueCount;
+      if ( victim == workerIndex )
+        {
+        continue;
+        }
+      WorkerQueue & queue = m_WorkerQueues[victim];
+      std::unique_lock< std::mutex > queueHolder( queue.m_Mutex, std::defer_lock );
+      if ( pass == 0 )
+        {
+        if ( !queueHolder.try_lock() )
+          {
+          skippedQueue = true;
+          continue;
+          }
+        }
+      else
+        {
+        queueHolder.lock();
+        }
+      if ( !queue.m_Jobs.empty() )
+        {
+        job = std::move( queue.m_Jobs.front() );
+        queue.m_Jobs.pop_front();
+        --m_NumberOfPendingJobs;
+        return true;
+        }
+      }
+    if ( !skippedQueue )
+      {
+      break;
+      }
+    }
+
+  return false;
+}
+
+void
+ThreadPool
+::WakeThreads( SizeValueType count )
+{
+  // m_NumberOfPendingJobs has already been incremented. A thread which is
+  // about to wait increments m_NumberOfIdleThreads before checking
+  // m_NumberOfPendingJobs, so either it sees the new jobs, or we see it.
+  if ( m_NumberOfIdleThreads > 0 )
+    {
+    {
+    // make sure a thread between its check and its wait receives the signal
+    std::unique_lock< std::mutex > mutexHolder( m_PimplGlobals->m_Mutex );
+    }
+    if ( count == 1 )
+      {
+      m_Condition.notify_one();
+      }
+    else
+      {
+      m_Condition.notify_all();
+      }
+    }
 }
 
 ThreadPool
@@ -170,32 +369,37 @@ ThreadPool
 
 void
 ThreadPool
-::ThreadExecute()
+::ThreadExecute( ThreadIdType workerIndex )
 {
   //plain pointer does not increase reference count
   ThreadPool* threadPool = m_PimplGlobals->m_ThreadPoolInstance.GetPointer();
+  ThreadPoolWorkerIndex = workerIndex;
 
   while ( true )
     {
       std::function< void() > task;
 
+      if ( threadPool->PopJob( workerIndex, task ) )
+        {
+        task(); //execute the task
+        continue;
+        }
+
       {
         std::unique_lock<std::mutex> mutexHolder( m_PimplGlobals->m_Mutex );
+        ++threadPool->m_NumberOfIdleThreads;
         threadPool->m_Condition.wait( mutexHolder,
           [threadPool]
         {
-            return threadPool->m_Stopping || !threadPool->m_WorkQueue.empty();
+            return threadPool->m_Stopping || threadPool->m_NumberOfPendingJobs > 0;
         }
         );
-        if ( threadPool->m_Stopping && threadPool->m_WorkQueue.empty() )
+        --threadPool->m_NumberOfIdleThreads;
+        if ( threadPool->m_Stopping && threadPool->m_NumberOfPendingJobs == 0 )
         {
             return;
         }
-        task = std::move( threadPool->m_WorkQueue.front() );
-        threadPool->m_WorkQueue.pop_front();
       }
-
-      task(); //execute the task
     }
 }
 
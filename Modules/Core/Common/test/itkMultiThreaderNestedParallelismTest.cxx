@@ -0,0 +1,125 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+#include "itkMultiThreaderBase.h"
+
+#include <atomic>
+#include <iostream>
+
+// Every element of the outer ParallelizeArray runs an inner ParallelizeArray
+// and an inner ParallelizeImageRegion. With as many outer work units as
+// threads, all the threads make nested calls at the same time.
+int itkMultiThreaderNestedParallelismTest( int argc, char* argv[] )
+{
+  itk::MultiThreaderBase::Pointer mt = itk::MultiThreaderBase::New();
+  if ( mt.IsNull() )
+    {
+    std::cerr << "MultiThreaderBase could not be instantiated!" << std::endl;
+    return EXIT_FAILURE;
+    }
+  mt->SetNumberOfWorkUnits( mt->GetMaximumNumberOfThreads() );
+  if ( argc >= 2 )
+    {
+    mt->SetNumberOfWorkUnits( static_cast< itk::ThreadIdType >( std::stoi( argv[1] ) ) );
+    }
+  std::cout << "Testing " << mt->GetNameOfClass() << " with "
+            << mt->GetNumberOfWorkUnits() << " work units" << std::endl;
+
+  int result = EXIT_SUCCESS;
+  if ( itk::MultiThreaderBase::GetGlobalNestedParallelism() )
+    {
+    std::cerr << "Nested parallelism should be disabled by default!" << std::endl;
+    result = EXIT_FAILURE;
+    }
+  itk::MultiThreaderBase::SetGlobalNestedParallelism( true );
+  if ( itk::MultiThreaderBase::IsInsideWorkUnit() )
+    {
+    std::cerr << "The main thread is not executing a work unit!" << std::endl;
+    result = EXIT_FAILURE;
+    }
+
+  constexpr itk::SizeValueType outerSize = 64;
+  constexpr itk::SizeValueType innerSize = 100;
+  using RegionType = itk::ImageRegion< 2 >;
+  RegionType::SizeType regionSize = { { 20, 30 } };
+  RegionType region;
+  region.SetSize( regionSize );
+
+  std::atomic< itk::SizeValueType > elementCount{ 0 };
+  std::atomic< itk::SizeValueType > pixelCount{ 0 };
+  std::atomic< itk::SizeValueType > outsideWorkUnit{ 0 };
+
+  for ( unsigned repetition = 0; repetition < 10; ++repetition )
+    {
+    elementCount = 0;
+    pixelCount = 0;
+    mt->ParallelizeArray(
+      0,
+      outerSize,
+      [&]( itk::SizeValueType )
+      {
+        if ( !itk::MultiThreaderBase::IsInsideWorkUnit() )
+          {
+          ++outsideWorkUnit;
+          }
+
+        itk::MultiThreaderBase::Pointer inner = itk::MultiThreaderBase::New();
+        inner->ParallelizeArray(
+          0,
+          innerSize,
+          [&elementCount]( itk::SizeValueType )
+          {
+            ++elementCount;
+          },
+          nullptr );
+        inner->ParallelizeImageRegion< 2 >(
+          region,
+          [&pixelCount]( const RegionType & piece )
+          {
+            pixelCount += piece.GetNumberOfPixels();
+          },
+          nullptr );
+      },
+      nullptr );
+
+    if ( elementCount != outerSize * innerSize )
+      {
+      std::cerr << "Visited " << elementCount
+                << " elements instead of " << outerSize * innerSize << std::endl;
+      result = EXIT_FAILURE;
+      }
+    if ( pixelCount != outerSize * region.GetNumberOfPixels() )
+      {
+      std::cerr << "Visited " << pixelCount
+                << " pixels instead of " << outerSize * region.GetNumberOfPixels() << std::endl;
+      result = EXIT_FAILURE;
+      }
+    }
+
+  if ( outsideWorkUnit != 0 )
+    {
+    std::cerr << outsideWorkUnit << " work units were not recognized as such!" << std::endl;
+    result = EXIT_FAILURE;
+    }
+
+  if ( result == EXIT_SUCCESS )
+    {
+    std::cout << "Test PASSED" << std::endl;
+    }
+  return result;
+}
@@ -0,0 +1,162 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+#include "itkThreadPool.h"
+#include "itkPoolMultiThreader.h"
+#ifdef ITK_USE_TBB
+#include "itkTBBMultiThreader.h"
+#endif
+#include "itkTimeProbesCollectorBase.h"
+
+#include <atomic>
+#include <iostream>
+#include <vector>
+
+// Runs many fine-grained ParallelizeArray and ParallelizeImageRegion calls,
+// and checks that every element and pixel was visited exactly once.
+static bool
+RunFineGrainedWork( itk::MultiThreaderBase * threader,
+                    itk::TimeProbesCollectorBase & collector,
+                    const std::string & name,
+                    unsigned repetitions )
+{
+  bool result = true;
+
+  constexpr itk::SizeValueType arraySize = 4096;
+  std::vector< std::atomic< unsigned > > visits( arraySize );
+
+  collector.Start( ( name + " ParallelizeArray" ).c_str() );
+  for ( unsigned r = 0; r < repetitions; ++r )
+    {
+    threader->ParallelizeArray(
+      0,
+      arraySize,
+      [&visits]( itk::SizeValueType i )
+      {
+        ++visits[i];
+      },
+      nullptr );
+    }
+  collector.Stop( ( name + " ParallelizeArray" ).c_str() );
+
+  for ( itk::SizeValueType i = 0; i < arraySize; ++i )
+    {
+    if ( visits[i] != repetitions )
+      {
+      std::cerr << name << ": element " << i << " was visited " << visits[i]
+                << " times instead of " << repetitions << std::endl;
+      result = false;
+      break;
+      }
+    }
+
+  using RegionType = itk::ImageRegion< 3 >;
+  RegionType::SizeType size = { { 64, 64, 64 } };
+  RegionType region;
+  region.SetSize( size );
+  std::atomic< itk::SizeValueType > pixelCount{ 0 };
+
+  collector.Start( ( name + " ParallelizeImageRegion" ).c_str() );
+  for ( unsigned r = 0; r < repetitions; ++r )
+    {
+    threader->ParallelizeImageRegion< 3 >(
+      region,
+      [&pixelCount]( const RegionType & piece )
+      {
+        pixelCount += piece.GetNumberOfPixels();
+      },
+      nullptr );
+    }
+  collector.Stop( ( name + " ParallelizeImageRegion" ).c_str() );
+
+  if ( pixelCount != region.GetNumberOfPixels() * repetitions )
+    {
+    std::cerr << name << ": visited " << pixelCount << " pixels instead of "
+              << region.GetNumberOfPixels() * repetitions << std::endl;
+    result = false;
+    }
+
+  return result;
+}
+
+int itkThreadPoolWorkStealingTest( int argc, char* argv[] )
+{
+  unsigned repetitions = 200;
+  if ( argc > 1 )
+    {
+    repetitions = static_cast< unsigned >( std::stoi( argv[1] ) );
+    }
+
+  bool result = true;
+  itk::ThreadPool::Pointer pool = itk::ThreadPool::GetInstance();
+
+  // Bulk submission returns the futures in job order.
+  auto squares = pool->AddWorkBatch( 100, []( itk::SizeValueType i ) { return i * i; } );
+  for ( itk::SizeValueType i = 0; i < squares.size(); ++i )
+    {
+    if ( squares[i].get() != i * i )
+      {
+      std::cerr << "AddWorkBatch returned a wrong result for job " << i << std::endl;
+      result = false;
+      }
+    }
+
+  // Jobs submitted from within the pool go to the submitting thread's queue,
+  // and must still be picked up by the other threads.
+  auto outer = pool->AddWorkBatch( 16, [pool]( itk::SizeValueType i )
+    {
+      return pool->AddWork( []( itk::SizeValueType j ) { return j + 1; }, i );
+    } );
+  for ( itk::SizeValueType i = 0; i < outer.size(); ++i )
+    {
+    if ( outer[i].get().get() != i + 1 )
+      {
+      std::cerr << "Nested AddWork returned a wrong result for job " << i << std::endl;
+      result = false;
+      }
+    }
+
+  // Compare the shared queue with work stealing, and with TBB when available.
+  itk::TimeProbesCollectorBase collector;
+  const bool useWorkStealing = itk::ThreadPool::GetUseWorkStealing();
+
+  itk::PoolMultiThreader::Pointer poolThreader = itk::PoolMultiThreader::New();
+  poolThreader->SetNumberOfWorkUnits( itk::MultiThreaderBase::GetGlobalMaximumNumberOfThreads() );
+
+  itk::ThreadPool::SetUseWorkStealing( false );
+  result &= RunFineGrainedWork( poolThreader, collector, "Pool (shared queue)", repetitions );
+  itk::ThreadPool::SetUseWorkStealing( true );
+  result &= RunFineGrainedWork( poolThreader, collector, "Pool (work stealing)", repetitions );
+  itk::ThreadPool::SetUseWorkStealing( useWorkStealing );
+
+#ifdef ITK_USE_TBB
+  itk::TBBMultiThreader::Pointer tbbThreader = itk::TBBMultiThreader::New();
+  tbbThreader->SetNumberOfWorkUnits( itk::MultiThreaderBase::GetGlobalMaximumNumberOfThreads() );
+  result &= RunFineGrainedWork( tbbThreader, collector, "TBB", repetitions );
+#endif
+
+  collector.Report( std::cout );
+
+  if ( !result )
+    {
+    std::cerr << "Test FAILED" << std::endl;
+    return EXIT_FAILURE;
+    }
+  std::cout << "Test PASSED" << std::endl;
+  return EXIT_SUCCESS;
+}
@@ -21,6 +21,8 @@
 #include "itkTransformMeshFilter.h"
 #include "itkMacro.h"
 
+#include <vector>
+
 namespace itk
 {
 /**
@@ -89,16 +91,34 @@ TransformMeshFilter< TInputMesh, TOutputMesh, TTransform >
   outPoints->Squeeze();  // in case the previous mesh had
                          // allocated a larger memory
 
+  // The points are transformed in batches, through copies in the point
+  // type of the transform
+  using TransformInputPointType = typename TransformType::InputPointType;
+  using TransformOutputPointType = typename TransformType::OutputPointType;
+  constexpr SizeValueType batchSize = 256;
+  std::vector< TransformInputPointType >  inputBatch( batchSize );
+  std::vector< TransformOutputPointType > outputBatch( batchSize );
+
   typename InputPointsContainer::ConstIterator inputPoint  = inPoints->Begin();
   typename OutputPointsContainer::Iterator outputPoint = outPoints->Begin();
 
   while ( inputPoint != inPoints->End() )
     {
-    outputPoint.Value() =
-      m_Transform->TransformPoint( inputPoint.Value() );
-
-    ++inputPoint;
-    ++outputPoint;
+    SizeValueType numberOfPoints = 0;
+    while ( numberOfPoints < batchSize && inputPoint != inPoints->End() )
+      {
+      inputBatch[numberOfPoints] = inputPoint.Value();
+      ++numberOfPoints;
+      ++inputPoint;
+      }
+
+    m_Transform->TransformPoints( inputBatch.data(), outputBatch.data(), numberOfPoints );
+
+    for ( SizeValueType n = 0; n < numberOfPoints; ++n )
+      {
+      outputPoint.Value() = outputBatch[n];
+      ++outputPoint;
+      }
     }
 
   // Create duplicate references to the rest of data on the mesh
@@ -258,6 +258,8 @@ public:
   ScalarType Metric() const;
 
 protected:
+  itkTransformPointsBatchedMacro(Self);
+
   /** Construct an AffineTransform object
    *
    * This method constructs a new AffineTransform object and
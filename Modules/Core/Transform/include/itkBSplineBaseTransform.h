@@ -221,6 +221,11 @@ public:
   /** Transform points by a BSpline deformable transformation. */
   OutputPointType  TransformPoint( const InputPointType & point ) const override;
 
+  /** Transform several points by a BSpline deformable transformation,
+   * with one allocation of the weights for all of them. */
+  void TransformPoints( const InputPointType *inputPoints, OutputPointType *outputPoints,
+                        SizeValueType numberOfPoints ) const override;
+
   /** Interpolation weights function type. */
   using WeightsFunctionType = BSplineInterpolationWeightFunction<ScalarType,
     Self::SpaceDimension ,
@@ -338,5 +338,31 @@ BSplineBaseTransform<TParametersValueType, NDimensions, VSplineOrder>
   return outputPoint;
 }
 
+// Transform several points
+template<typename TParametersValueType, unsigned int NDimensions, unsigned int VSplineOrder>
+void
+BSplineBaseTransform<TParametersValueType, NDimensions, VSplineOrder>
+::TransformPoints( const InputPointType *inputPoints, OutputPointType *outputPoints,
+                   SizeValueType numberOfPoints ) const
+{
+  if( !this->IsTransformPointsBatched() )
+    {
+    Superclass::TransformPoints( inputPoints, outputPoints, numberOfPoints );
+    return;
+    }
+
+  WeightsType             weights( this->m_WeightsFunction->GetNumberOfWeights() );
+  ParameterIndexArrayType indices( this->m_WeightsFunction->GetNumberOfWeights() );
+  bool                    inside;
+
+  for( SizeValueType n = 0; n < numberOfPoints; ++n )
+    {
+    // The input point is copied, since TransformPoint writes the output
+    // point before it reads the input point.
+    const InputPointType point = inputPoints[n];
+    this->TransformPoint( point, outputPoints[n], weights, indices, inside );
+    }
+}
+
 } // namespace
 #endif
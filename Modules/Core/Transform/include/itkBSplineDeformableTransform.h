@@ -303,6 +303,8 @@ public:
   itkGetConstReferenceMacro(ValidRegion, RegionType);
 
 protected:
+  itkTransformPointsBatchedMacro(Self);
+
   /** Print contents of an BSplineDeformableTransform. */
   void PrintSelf( std::ostream & os, Indent indent ) const override;
 
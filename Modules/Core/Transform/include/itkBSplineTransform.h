@@ -239,6 +239,38 @@ public:
   /** Compute the Jacobian in one position. */
   void ComputeJacobianWithRespectToParameters( const InputPointType &, JacobianType & ) const override;
 
+  /**
+   * Compute the interpolation weights at a point and the start index of
+   * their support region in the coefficient grid. They depend only on the
+   * point and the fixed parameters, so they can be computed once for points
+   * that are transformed repeatedly with changing parameters, e.g. the
+   * samples of a registration metric. The weights array must hold
+   * GetNumberOfWeights() values. On return, inside is false if the support
+   * region does not lie totally within the grid, in which case the point is
+   * not displaced and the weights and the index are not set.
+   */
+  void ComputeBSplineWeights( const InputPointType & point, WeightsType & weights,
+    IndexType & supportIndex, bool & inside ) const;
+
+  /** Transform a point with the weights and support index computed for it
+   * by ComputeBSplineWeights(). */
+  void TransformPointWithBSplineWeights( const InputPointType & point, const WeightsType & weights,
+    const IndexType & supportIndex, bool inside, OutputPointType & outputPoint ) const;
+
+  /** Compute the Jacobian at a point from the weights and support index
+   * computed for it by ComputeBSplineWeights(). */
+  void ComputeJacobianWithRespectToParametersWithBSplineWeights( const WeightsType & weights,
+    const IndexType & supportIndex, bool inside, JacobianType & jacobian ) const;
+
+  /** Compute the indices of the zeroth dimension parameters in the support
+   * region starting at the support index computed by ComputeBSplineWeights(),
+   * in the order of the weights. The Jacobian at the point is only non-zero
+   * for these parameters. Parameter indices for the i-th dimension can be
+   * obtained by adding ( i * this->GetNumberOfParametersPerDimension() ) to
+   * the indices array, which must hold GetNumberOfWeights() values. */
+  void ComputeParameterIndicesWithBSplineWeights( const IndexType & supportIndex,
+    ParameterIndexArrayType & indices ) const;
+
   /** Return the number of parameters that completely define the Transfom. */
   NumberOfParametersType GetNumberOfParameters() const override;
 
@@ -275,6 +307,8 @@ public:
   virtual MeshSizeType GetTransformDomainMeshSize( void ) const;
 
 protected:
+  itkTransformPointsBatchedMacro(Self);
+
   /** Print contents of an BSplineTransform. */
   void PrintSelf( std::ostream & os, Indent indent ) const override;
 
@@ -643,32 +643,114 @@ BSplineTransform<TParametersValueType, NDimensions, VSplineOrder>
 ::ComputeJacobianWithRespectToParameters( const InputPointType & point,
   JacobianType & jacobian ) const
 {
-  // Zero all components of jacobian
-  jacobian.SetSize( SpaceDimension, this->GetNumberOfParameters() );
-  jacobian.Fill( 0.0 );
-  RegionType   supportRegion;
-  SizeType     supportSize;
-  supportSize.Fill( SplineOrder + 1 );
-  supportRegion.SetSize( supportSize );
+  // Compute interpolation weights
+  WeightsType weights( this->m_WeightsFunction->GetNumberOfWeights() );
+  IndexType   supportIndex;
+  bool        inside;
+  this->ComputeBSplineWeights( point, weights, supportIndex, inside );
+
+  this->ComputeJacobianWithRespectToParametersWithBSplineWeights( weights, supportIndex, inside, jacobian );
+}
 
+template<typename TParametersValueType, unsigned int NDimensions, unsigned int VSplineOrder>
+void
+BSplineTransform<TParametersValueType, NDimensions, VSplineOrder>
+::ComputeBSplineWeights( const InputPointType & point, WeightsType & weights,
+  IndexType & supportIndex, bool & inside ) const
+{
   ContinuousIndexType index;
   this->m_CoefficientImages[0]->
     TransformPhysicalPointToContinuousIndex( point, index );
 
   // NOTE: if the support region does not lie totally within the grid we assume
-  // zero displacement and do no computations beyond zeroing out the value
-  // return the input point
-  if( !this->InsideValidRegion( index ) )
+  // zero displacement
+  inside = this->InsideValidRegion( index );
+  if( inside )
     {
+    this->m_WeightsFunction->Evaluate( index, weights, supportIndex );
+    }
+}
+
+template<typename TParametersValueType, unsigned int NDimensions, unsigned int VSplineOrder>
+void
+BSplineTransform<TParametersValueType, NDimensions, VSplineOrder>
+::TransformPointWithBSplineWeights( const InputPointType & point, const WeightsType & weights,
+  const IndexType & supportIndex, bool inside, OutputPointType & outputPoint ) const
+{
+  if( !this->m_CoefficientImages[0]->GetBufferPointer() )
+    {
+    itkWarningMacro( "B-spline coefficients have not been set" );
+    outputPoint = point;
+    return;
+    }
+  if( !inside )
+    {
+    outputPoint = point;
     return;
     }
 
-  // Compute interpolation weights
-  WeightsType weights( this->m_WeightsFunction->GetNumberOfWeights() );
+  // For each dimension, correlate coefficient with weights, in the same
+  // order as TransformPoint
+  SizeType   supportSize;
+  supportSize.Fill( SplineOrder + 1 );
+  RegionType supportRegion;
+  supportRegion.SetSize( supportSize );
+  supportRegion.SetIndex( supportIndex );
+
+  outputPoint.Fill( NumericTraits<ScalarType>::ZeroValue() );
+
+  using IteratorType = ImageScanlineConstIterator<ImageType>;
+  IteratorType  coeffIterator[SpaceDimension];
+  unsigned long counter = 0;
+  for( unsigned int j = 0; j < SpaceDimension; j++ )
+    {
+    coeffIterator[j] = IteratorType( this->m_CoefficientImages[j], supportRegion );
+    }
+
+  while( !coeffIterator[0].IsAtEnd() )
+    {
+    while( !coeffIterator[0].IsAtEndOfLine() )
+      {
+      for( unsigned int j = 0; j < SpaceDimension; j++ )
+        {
+        outputPoint[j] += static_cast<ScalarType>(
+          weights[counter] * coeffIterator[j].Get() );
+        ++( coeffIterator[j] );
+        }
+      ++counter;
+      }
 
-  IndexType supportIndex;
-  this->m_WeightsFunction->Evaluate( index, weights, supportIndex );
+    for( unsigned int j = 0; j < SpaceDimension; j++ )
+      {
+      coeffIterator[j].NextLine();
+      }
+    }
+
+  for( unsigned int j = 0; j < SpaceDimension; j++ )
+    {
+    outputPoint[j] += point[j];
+    }
+}
 
+template<typename TParametersValueType, unsigned int NDimensions, unsigned int VSplineOrder>
+void
+BSplineTransform<TParametersValueType, NDimensions, VSplineOrder>
+::ComputeJacobianWithRespectToParametersWithBSplineWeights( const WeightsType & weights,
+  const IndexType & supportIndex, bool inside, JacobianType & jacobian ) const
+{
+  // Zero all components of jacobian
+  jacobian.SetSize( SpaceDimension, this->GetNumberOfParameters() );
+  jacobian.Fill( 0.0 );
+
+  if( !inside )
+    {
+    return;
+    }
+
+  RegionType   supportRegion;
+  SizeType     supportSize;
+  supportSize.Fill( SplineOrder + 1 );
+  supportRegion.SetSize( supportSize );
   supportRegion.SetIndex( supportIndex );
 
   IndexType startIndex =
@@ -704,6 +786,34 @@ BSplineTransform<TParametersValueType, NDimensions, VSplineOrder>
     }
 }
 
+template<typename TParametersValueType, unsigned int NDimensions, unsigned int VSplineOrder>
+void
+BSplineTransform<TParametersValueType, NDimensions, VSplineOrder>
+::ComputeParameterIndicesWithBSplineWeights( const IndexType & supportIndex,
+  ParameterIndexArrayType & indices ) const
+{
+  RegionType supportRegion;
+  SizeType   supportSize;
+  supportSize.Fill( SplineOrder + 1 );
+  supportRegion.SetSize( supportSize );
+  supportRegion.SetIndex( supportIndex );
+
+  using IteratorType = ImageScanlineConstIterator<ImageType>;
+  IteratorType               coeffIterator( this->m_CoefficientImages[0], supportRegion );
+  const ParametersValueType *basePointer = this->m_CoefficientImages[0]->GetBufferPointer();
+  unsigned long              counter = 0;
+  while( !coeffIterator.IsAtEnd() )
+    {
+    while( !coeffIterator.IsAtEndOfLine() )
+      {
+      indices[counter] = &( coeffIterator.Value() ) - basePointer;
+      ++counter;
+      ++coeffIterator;
+      }
+    coeffIterator.NextLine();
+    }
+}
+
 template<typename TParametersValueType, unsigned int NDimensions, unsigned int VSplineOrder>
 void
 BSplineTransform<TParametersValueType, NDimensions, VSplineOrder>
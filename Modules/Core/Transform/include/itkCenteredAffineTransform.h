@@ -109,6 +109,8 @@ public:
   InverseTransformBasePointer GetInverseTransform() const override;
 
 protected:
+  itkTransformPointsBatchedMacro(Self);
+
   /** Construct an CenteredAffineTransform object */
   CenteredAffineTransform();
 
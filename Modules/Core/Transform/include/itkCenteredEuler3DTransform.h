@@ -116,6 +116,8 @@ public:
   InverseTransformBasePointer GetInverseTransform() const override;
 
 protected:
+  itkTransformPointsBatchedMacro(Self);
+
   CenteredEuler3DTransform();
   CenteredEuler3DTransform(const MatrixType & matrix, const OutputPointType & offset);
   CenteredEuler3DTransform(unsigned int ParametersDimension);
@@ -160,6 +160,8 @@ public:
   void CloneTo(Pointer & clone) const;
 
 protected:
+  itkTransformPointsBatchedMacro(Self);
+
   CenteredRigid2DTransform();
   ~CenteredRigid2DTransform() override = default;
 
@@ -166,6 +166,8 @@ public:
   void CloneTo(Pointer & clone) const;
 
 protected:
+  itkTransformPointsBatchedMacro(Self);
+
   CenteredSimilarity2DTransform();
   CenteredSimilarity2DTransform(unsigned int spaceDimension, unsigned int parametersDimension);
 
@@ -20,6 +20,7 @@
 
 #include "itkMultiTransform.h"
 
+#include <algorithm>
 #include <deque>
 
 namespace itk
@@ -247,6 +248,11 @@ public:
   */
   OutputPointType TransformPoint( const InputPointType & inputPoint ) const override;
 
+  /** Transform several points. Each transform of the queue is applied to
+   * all the points in turn, in the order of TransformPoint. */
+  void TransformPoints( const InputPointType *inputPoints, OutputPointType *outputPoints,
+                        SizeValueType numberOfPoints ) const override;
+
   /**  Method to transform a vector. */
   using Superclass::TransformVector;
   OutputVectorType TransformVector(const InputVectorType &) const override;
@@ -378,6 +384,8 @@ public:
                                                                 JacobianType & cacheJacobian ) const override;
 
 protected:
+  itkTransformPointsBatchedMacro(Self);
+
   CompositeTransform();
   ~CompositeTransform() override = default;
   void PrintSelf( std::ostream& os, Indent indent ) const override;
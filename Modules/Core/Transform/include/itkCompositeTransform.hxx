@@ -91,6 +91,31 @@ CompositeTransform<TParametersValueType, NDimensions>
 }
 
 
+template<typename TParametersValueType, unsigned int NDimensions>
+void
+CompositeTransform<TParametersValueType, NDimensions>
+::TransformPoints( const InputPointType *inputPoints, OutputPointType *outputPoints,
+                   SizeValueType numberOfPoints ) const
+{
+  if( !this->IsTransformPointsBatched() )
+    {
+    Superclass::TransformPoints( inputPoints, outputPoints, numberOfPoints );
+    return;
+    }
+
+  if( inputPoints != outputPoints )
+    {
+    std::copy( inputPoints, inputPoints + numberOfPoints, outputPoints );
+    }
+
+  /* Apply in reverse queue order.  */
+  for( auto it = this->m_TransformQueue.rbegin(); it != this->m_TransformQueue.rend(); ++it )
+    {
+    (*it)->TransformPoints( outputPoints, outputPoints, numberOfPoints );
+    }
+}
+
+
 template<typename TParametersValueType, unsigned int NDimensions>
 typename CompositeTransform<TParametersValueType, NDimensions>
 ::OutputVectorType
@@ -119,6 +119,8 @@ public:
   { this->ComputeMatrixParameters(); }
 
 protected:
+  itkTransformPointsBatchedMacro(Self);
+
   Euler2DTransform(unsigned int parametersDimension);
   Euler2DTransform();
   ~Euler2DTransform() override = default;
@@ -128,6 +128,8 @@ public:
   void SetIdentity() override;
 
 protected:
+  itkTransformPointsBatchedMacro(Self);
+
   Euler3DTransform(const MatrixType & matrix, const OutputPointType & offset);
   Euler3DTransform(unsigned int paramsSpaceDims);
   Euler3DTransform();
@@ -100,6 +100,8 @@ public:
   { return this->GetTranslation(); }
 
 protected:
+  itkTransformPointsBatchedMacro(Self);
+
   /** Construct an FixedCenterOfRotationAffineTransform object */
   FixedCenterOfRotationAffineTransform(const MatrixType & matrix,
                                        const OutputVectorType & offset);
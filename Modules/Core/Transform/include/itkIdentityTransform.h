@@ -25,6 +25,8 @@
 #include "itkArray2D.h"
 #include "itkTransform.h"
 
+#include <algorithm>
+
 namespace itk
 {
 /** \class IdentityTransform
@@ -120,6 +122,21 @@ public:
     return point;
   }
 
+  /**  Method to transform several points. */
+  void TransformPoints(const InputPointType *inputPoints, OutputPointType *outputPoints,
+                       SizeValueType numberOfPoints) const override
+  {
+    if( !this->IsTransformPointsBatched() )
+      {
+      Superclass::TransformPoints( inputPoints, outputPoints, numberOfPoints );
+      return;
+      }
+    if( inputPoints != outputPoints )
+      {
+      std::copy( inputPoints, inputPoints + numberOfPoints, outputPoints );
+      }
+  }
+
   /**  Method to transform a vector. */
   using Superclass::TransformVector;
   OutputVectorType TransformVector(const InputVectorType & vector) const override
@@ -241,6 +258,8 @@ public:
   }
 
 protected:
+  itkTransformPointsBatchedMacro(Self);
+
   IdentityTransform() : Transform<TParametersValueType, NDimensions, NDimensions>(0),
     m_ZeroJacobian(NDimensions, 0)
   {
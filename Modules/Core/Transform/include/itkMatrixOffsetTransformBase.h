@@ -368,6 +368,9 @@ public:
 
   OutputPointType       TransformPoint(const InputPointType & point) const override;
 
+  void                  TransformPoints(const InputPointType *inputPoints, OutputPointType *outputPoints,
+                                        SizeValueType numberOfPoints) const override;
+
   using Superclass::TransformVector;
 
   OutputVectorType      TransformVector(const InputVectorType & vector) const override;
@@ -453,6 +456,8 @@ public:
   }
 
 protected:
+  itkTransformPointsBatchedMacro(Self);
+
   /** \deprecated Use GetInverse for public API instead.
    * Method will eventually be made a protected member function */
   const InverseMatrixType & GetInverseMatrix() const;
@@ -176,6 +176,48 @@ MatrixOffsetTransformBase<TParametersValueType, NInputDimensions, NOutputDimensi
 }
 
 
+template<typename TParametersValueType, unsigned int NInputDimensions,
+          unsigned int NOutputDimensions>
+void
+MatrixOffsetTransformBase<TParametersValueType, NInputDimensions, NOutputDimensions>
+::TransformPoints(const InputPointType *inputPoints, OutputPointType *outputPoints,
+                  SizeValueType numberOfPoints) const
+{
+  if( !this->IsTransformPointsBatched() )
+    {
+    Superclass::TransformPoints( inputPoints, outputPoints, numberOfPoints );
+    return;
+    }
+
+  // The matrix and offset are copied, since the output points could alias
+  // them, and the sums are computed in the order of TransformPoint.
+  ScalarType matrix[NOutputDimensions][NInputDimensions];
+  ScalarType offset[NOutputDimensions];
+  for( unsigned int i = 0; i < NOutputDimensions; i++ )
+    {
+    for( unsigned int j = 0; j < NInputDimensions; j++ )
+      {
+      matrix[i][j] = m_Matrix[i][j];
+      }
+    offset[i] = m_Offset[i];
+    }
+
+  for( SizeValueType n = 0; n < numberOfPoints; n++ )
+    {
+    const InputPointType point = inputPoints[n];
+    for( unsigned int i = 0; i < NOutputDimensions; i++ )
+      {
+      ScalarType sum = NumericTraits< ScalarType >::ZeroValue();
+      for( unsigned int j = 0; j < NInputDimensions; j++ )
+        {
+        sum += matrix[i][j] * point[j];
+        }
+      outputPoints[n][i] = sum + offset[i];
+      }
+    }
+}
+
+
 template<typename TParametersValueType, unsigned int NInputDimensions,
           unsigned int NOutputDimensions>
 typename MatrixOffsetTransformBase<TParametersValueType,
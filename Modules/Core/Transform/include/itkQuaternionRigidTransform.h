@@ -130,6 +130,8 @@ public:
   void ComputeJacobianWithRespectToParameters( const InputPointType  & p, JacobianType & jacobian) const override;
 
 protected:
+  itkTransformPointsBatchedMacro(Self);
+
   QuaternionRigidTransform(const MatrixType & matrix, const OutputVectorType & offset);
   QuaternionRigidTransform(unsigned int paramDims);
   QuaternionRigidTransform();
@@ -239,6 +239,8 @@ public:
   void SetIdentity() override;
 
 protected:
+  itkTransformPointsBatchedMacro(Self);
+
   Rigid2DTransform(unsigned int outputSpaceDimension, unsigned int parametersDimension);
   Rigid2DTransform(unsigned int parametersDimension);
   Rigid2DTransform();
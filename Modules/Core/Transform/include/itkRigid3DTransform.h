@@ -152,6 +152,8 @@ public:
 
 
 protected:
+  itkTransformPointsBatchedMacro(Self);
+
   Rigid3DTransform(const MatrixType & matrix,
                    const OutputVectorType & offset);
   Rigid3DTransform(unsigned int paramDim);
@@ -114,6 +114,8 @@ public:
   InverseTransformBasePointer GetInverseTransform() const override;
 
 protected:
+  itkTransformPointsBatchedMacro(Self);
+
   /** Construct an ScalableAffineTransform object
    *
    * This method constructs a new AffineTransform object and
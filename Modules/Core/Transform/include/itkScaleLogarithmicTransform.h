@@ -106,6 +106,8 @@ public:
   void ComputeJacobianWithRespectToParameters( const InputPointType  & p, JacobianType & jacobian) const override;
 
 protected:
+  itkTransformPointsBatchedMacro(Self);
+
   /** Construct an ScaleLogarithmicTransform object. */
   ScaleLogarithmicTransform() = default;
 
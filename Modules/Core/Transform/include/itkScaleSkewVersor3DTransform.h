@@ -147,6 +147,8 @@ public:
   void ComputeJacobianWithRespectToParameters( const InputPointType  & p, JacobianType & jacobian) const override;
 
 protected:
+  itkTransformPointsBatchedMacro(Self);
+
   ScaleSkewVersor3DTransform();
   ScaleSkewVersor3DTransform(const MatrixType & matrix, const OutputVectorType & offset);
   ScaleSkewVersor3DTransform(unsigned int paramDims);
@@ -148,6 +148,9 @@ public:
    * vector. */
   OutputPointType     TransformPoint(const InputPointType  & point) const override;
 
+  void                TransformPoints(const InputPointType *inputPoints, OutputPointType *outputPoints,
+                                      SizeValueType numberOfPoints) const override;
+
   using Superclass::TransformVector;
   OutputVectorType    TransformVector(const InputVectorType & vector) const override;
 
@@ -186,6 +189,8 @@ public:
   itkGetConstReferenceMacro(Scale, ScaleType);
 
 protected:
+  itkTransformPointsBatchedMacro(Self);
+
   /** Construct an ScaleTransform object. */
   ScaleTransform();
 
@@ -124,6 +124,31 @@ ScaleTransform<TParametersValueType, NDimensions>
 }
 
 
+template<typename TParametersValueType, unsigned int NDimensions>
+void
+ScaleTransform<TParametersValueType, NDimensions>
+::TransformPoints(const InputPointType *inputPoints, OutputPointType *outputPoints,
+                  SizeValueType numberOfPoints) const
+{
+  if( !this->IsTransformPointsBatched() )
+    {
+    Superclass::TransformPoints( inputPoints, outputPoints, numberOfPoints );
+    return;
+    }
+
+  const InputPointType center = this->GetCenter();
+  const ScaleType      scale = m_Scale;
+
+  for( SizeValueType n = 0; n < numberOfPoints; n++ )
+    {
+    for( unsigned int i = 0; i < SpaceDimension; i++ )
+      {
+      outputPoints[n][i] = ( inputPoints[n][i] - center[i] ) * scale[i] + center[i];
+      }
+    }
+}
+
+
 template<typename TParametersValueType, unsigned int NDimensions>
 typename ScaleTransform<TParametersValueType, NDimensions>::OutputVectorType
 ScaleTransform<TParametersValueType, NDimensions>
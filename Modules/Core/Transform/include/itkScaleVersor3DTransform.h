@@ -132,6 +132,8 @@ public:
   void ComputeJacobianWithRespectToParameters( const InputPointType  & p, JacobianType & jacobian) const override;
 
 protected:
+  itkTransformPointsBatchedMacro(Self);
+
   ScaleVersor3DTransform();
   ScaleVersor3DTransform(const MatrixType & matrix, const OutputVectorType & offset);
   ScaleVersor3DTransform(unsigned int paramDims);
@@ -210,6 +210,8 @@ public:
   void SetMatrix(const MatrixType & matrix, const TParametersValueType tolerance) override;
 
 protected:
+  itkTransformPointsBatchedMacro(Self);
+
   Similarity2DTransform(unsigned int outputSpaceDimension, unsigned int parametersDimension);
   Similarity2DTransform(unsigned int parametersDimension);
   Similarity2DTransform();
@@ -134,6 +134,8 @@ public:
   void ComputeJacobianWithRespectToParameters( const InputPointType  & p, JacobianType & jacobian) const override;
 
 protected:
+  itkTransformPointsBatchedMacro(Self);
+
   Similarity3DTransform(const MatrixType & matrix, const OutputVectorType & offset);
   Similarity3DTransform(unsigned int paramDim);
   Similarity3DTransform();
@@ -27,6 +27,20 @@
 #include "vnl/vnl_matrix_fixed.h"
 #include "itkMatrix.h"
 
+#include <typeinfo>
+
+/** Overrides IsTransformPointsBatched() in a transform class \a x whose
+ * TransformPoints batches the points, and in each subclass which inherits
+ * this TransformPoints without overriding TransformPoint. The points are
+ * batched for the class \a x itself only, so that a subclass which
+ * overrides TransformPoint, and does not use this macro, has its
+ * TransformPoint called for each point. */
+#define itkTransformPointsBatchedMacro(x)                      \
+  bool IsTransformPointsBatched() const override               \
+    {                                                          \
+    return typeid( *this ) == typeid( x );                     \
+    }
+
 namespace itk
 {
 /** \class Transform
@@ -190,6 +204,18 @@ public:
    */
   virtual OutputPointType TransformPoint(const InputPointType  &) const = 0;
 
+  /**  Method to transform several points. The output point \c n is the
+   * transform of the input point \c n. The input and output arrays may be
+   * the same array, but may not overlap otherwise. The default
+   * implementation calls TransformPoint for each point. Transforms
+   * override it to avoid the virtual call and the set up of TransformPoint
+   * for each point, but only use their batched implementation when
+   * IsTransformPointsBatched() is true, and call TransformPoint otherwise.
+   * \warning This method must be thread-safe.
+   */
+  virtual void TransformPoints(const InputPointType *inputPoints, OutputPointType *outputPoints,
+                               SizeValueType numberOfPoints) const;
+
   /**  Method to transform a vector. */
   virtual OutputVectorType  TransformVector(const InputVectorType &) const
   {
@@ -539,6 +565,16 @@ protected:
    */
   typename LightObject::Pointer InternalClone() const override;
 
+  /** Returns whether TransformPoints may transform the points in a batch,
+   * without calling TransformPoint. A subclass may override TransformPoint,
+   * so a class which batches the points overrides this method with
+   * itkTransformPointsBatchedMacro, which returns true for its own type
+   * only. Default is false. */
+  virtual bool IsTransformPointsBatched() const
+  {
+    return false;
+  }
+
   Transform();
   Transform(NumberOfParametersType NumberOfParameters);
 #if defined(__GNUC__) && __GNUC__ < 6
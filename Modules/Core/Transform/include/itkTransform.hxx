@@ -146,6 +146,21 @@ Transform<TParametersValueType, NInputDimensions, NOutputDimensions>
 }
 
 
+template<typename TParametersValueType,
+          unsigned int NInputDimensions,
+          unsigned int NOutputDimensions>
+void
+Transform<TParametersValueType, NInputDimensions, NOutputDimensions>
+::TransformPoints( const InputPointType *inputPoints, OutputPointType *outputPoints,
+                   SizeValueType numberOfPoints ) const
+{
+  for( SizeValueType n = 0; n < numberOfPoints; n++ )
+    {
+    outputPoints[n] = this->TransformPoint( inputPoints[n] );
+    }
+}
+
+
 template<typename TParametersValueType,
           unsigned int NInputDimensions,
           unsigned int NOutputDimensions>
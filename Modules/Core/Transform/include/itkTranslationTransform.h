@@ -140,6 +140,9 @@ public:
    * vector. */
   OutputPointType     TransformPoint(const InputPointType  & point) const override;
 
+  void                TransformPoints(const InputPointType *inputPoints, OutputPointType *outputPoints,
+                                      SizeValueType numberOfPoints) const override;
+
   using Superclass::TransformVector;
   OutputVectorType    TransformVector(const InputVectorType & vector) const override;
 
@@ -223,6 +226,8 @@ public:
   }
 
 protected:
+  itkTransformPointsBatchedMacro(Self);
+
   TranslationTransform();
   ~TranslationTransform() override = default;
   /** Print contents of an TranslationTransform. */
@@ -126,6 +126,30 @@ TranslationTransform<TParametersValueType, NDimensions>
 }
 
 
+template<typename TParametersValueType, unsigned int NDimensions>
+void
+TranslationTransform<TParametersValueType, NDimensions>
+::TransformPoints(const InputPointType *inputPoints, OutputPointType *outputPoints,
+                  SizeValueType numberOfPoints) const
+{
+  if( !this->IsTransformPointsBatched() )
+    {
+    Superclass::TransformPoints( inputPoints, outputPoints, numberOfPoints );
+    return;
+    }
+
+  const OutputVectorType offset = m_Offset;
+
+  for( SizeValueType n = 0; n < numberOfPoints; n++ )
+    {
+    for( unsigned int i = 0; i < NDimensions; i++ )
+      {
+      outputPoints[n][i] = inputPoints[n][i] + offset[i];
+      }
+    }
+}
+
+
 template<typename TParametersValueType, unsigned int NDimensions>
 typename TranslationTransform<TParametersValueType, NDimensions>::OutputVectorType
 TranslationTransform<TParametersValueType, NDimensions>
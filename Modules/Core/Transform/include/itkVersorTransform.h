@@ -129,6 +129,8 @@ public:
 
 protected:
 
+  itkTransformPointsBatchedMacro(Self);
+
   /** Construct an VersorTransform object */
   VersorTransform(const MatrixType & matrix, const OutputVectorType & offset);
   VersorTransform(unsigned int paramDims);
@@ -0,0 +1,183 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+#include <cmath>
+#include <iostream>
+#include <vector>
+
+#include "itkAffineTransform.h"
+#include "itkAzimuthElevationToCartesianTransform.h"
+#include "itkBSplineTransform.h"
+#include "itkCompositeTransform.h"
+#include "itkEuler3DTransform.h"
+#include "itkIdentityTransform.h"
+#include "itkScaleTransform.h"
+#include "itkTranslationTransform.h"
+
+/* Transform::TransformPoints compared to Transform::TransformPoint, for the
+ * transforms which override it, in separate arrays and in place.
+ */
+
+namespace
+{
+// A subclass which overrides TransformPoint, and not TransformPoints: the
+// batched implementation of its superclass must not be used.
+class ShiftedAffineTransform : public itk::AffineTransform< double, 3 >
+{
+public:
+  using Self = ShiftedAffineTransform;
+  using Superclass = itk::AffineTransform< double, 3 >;
+  using Pointer = itk::SmartPointer< Self >;
+  itkNewMacro( Self );
+
+  OutputPointType TransformPoint( const InputPointType & point ) const override
+  {
+    OutputPointType outputPoint = Superclass::TransformPoint( point );
+    outputPoint[0] += 1.0;
+    return outputPoint;
+  }
+};
+
+template< typename TTransform >
+bool
+TestTransformPoints( const TTransform * transform, const char * name )
+{
+  using InputPointType = typename TTransform::InputPointType;
+  using OutputPointType = typename TTransform::OutputPointType;
+
+  std::vector< InputPointType > inputPoints;
+  for ( unsigned int n = 0; n < 100; ++n )
+    {
+    InputPointType point;
+    for ( unsigned int i = 0; i < TTransform::InputSpaceDimension; ++i )
+      {
+      point[i] = 10.0 * std::sin( 1.3 * n + i ) + 8.0;
+      }
+    inputPoints.push_back( point );
+    }
+
+  std::vector< OutputPointType > outputPoints( inputPoints.size() );
+  transform->TransformPoints( inputPoints.data(), outputPoints.data(), inputPoints.size() );
+
+  std::vector< InputPointType > inPlacePoints( inputPoints );
+  transform->TransformPoints( inPlacePoints.data(), inPlacePoints.data(), inPlacePoints.size() );
+
+  for ( unsigned int n = 0; n < inputPoints.size(); ++n )
+    {
+    const OutputPointType expected = transform->TransformPoint( inputPoints[n] );
+    if ( outputPoints[n] != expected || inPlacePoints[n] != expected )
+      {
+      std::cerr << "Test failed for " << name << "!" << std::endl;
+      std::cerr << "Point " << inputPoints[n] << " transformed to " << outputPoints[n]
+                << " and " << inPlacePoints[n] << " in place instead of " << expected << std::endl;
+      return false;
+      }
+    }
+  std::cout << name << ": OK" << std::endl;
+  return true;
+}
+}
+
+int itkTransformPointsTest( int , char *[] )
+{
+  constexpr unsigned int Dimension = 3;
+  bool testPassed = true;
+
+  // Matrix offset transforms
+  using AffineTransformType = itk::AffineTransform< double, Dimension >;
+  AffineTransformType::Pointer affine = AffineTransformType::New();
+  AffineTransformType::OutputVectorType axis;
+  axis[0] = 1.0;
+  axis[1] = 2.0;
+  axis[2] = 0.5;
+  affine->Rotate3D( axis, 0.4 );
+  affine->Scale( 1.3 );
+  affine->Translate( axis );
+  affine->Shear( 0, 2, 0.1 );
+  testPassed &= TestTransformPoints( affine.GetPointer(), "AffineTransform" );
+
+  using EulerTransformType = itk::Euler3DTransform< float >;
+  EulerTransformType::Pointer euler = EulerTransformType::New();
+  euler->SetRotation( 0.1f, -0.2f, 0.3f );
+  EulerTransformType::OutputVectorType translation;
+  translation.Fill( 2.5f );
+  euler->SetTranslation( translation );
+  testPassed &= TestTransformPoints( euler.GetPointer(), "Euler3DTransform" );
+
+  using ScaleTransformType = itk::ScaleTransform< double, Dimension >;
+  ScaleTransformType::Pointer scale = ScaleTransformType::New();
+  ScaleTransformType::ScaleType scaleFactors;
+  scaleFactors[0] = 1.5;
+  scaleFactors[1] = 0.5;
+  scaleFactors[2] = 2.0;
+  scale->SetScale( scaleFactors );
+  ScaleTransformType::InputPointType center;
+  center.Fill( 4.0 );
+  scale->SetCenter( center );
+  testPassed &= TestTransformPoints( scale.GetPointer(), "ScaleTransform" );
+
+  using AzimuthElevationTransformType = itk::AzimuthElevationToCartesianTransform< double, Dimension >;
+  AzimuthElevationTransformType::Pointer azimuthElevation = AzimuthElevationTransformType::New();
+  azimuthElevation->SetAzimuthElevationToCartesianParameters( 1.0, 5.0, 45, 45 );
+  testPassed &= TestTransformPoints( azimuthElevation.GetPointer(), "AzimuthElevationToCartesianTransform" );
+
+  // Other transforms
+  using TranslationTransformType = itk::TranslationTransform< double, Dimension >;
+  TranslationTransformType::Pointer translationTransform = TranslationTransformType::New();
+  translationTransform->SetOffset( axis );
+  testPassed &= TestTransformPoints( translationTransform.GetPointer(), "TranslationTransform" );
+
+  using IdentityTransformType = itk::IdentityTransform< double, Dimension >;
+  IdentityTransformType::Pointer identity = IdentityTransformType::New();
+  testPassed &= TestTransformPoints( identity.GetPointer(), "IdentityTransform" );
+
+  using BSplineTransformType = itk::BSplineTransform< double, Dimension, 3 >;
+  BSplineTransformType::Pointer bspline = BSplineTransformType::New();
+  BSplineTransformType::PhysicalDimensionsType physicalDimensions;
+  physicalDimensions.Fill( 16.0 );
+  BSplineTransformType::MeshSizeType meshSize;
+  meshSize.Fill( 4 );
+  bspline->SetTransformDomainPhysicalDimensions( physicalDimensions );
+  bspline->SetTransformDomainMeshSize( meshSize );
+  BSplineTransformType::ParametersType parameters( bspline->GetNumberOfParameters() );
+  for ( unsigned int n = 0; n < parameters.Size(); ++n )
+    {
+    parameters[n] = std::cos( 0.3 * n );
+    }
+  bspline->SetParametersByValue( parameters );
+  testPassed &= TestTransformPoints( bspline.GetPointer(), "BSplineTransform" );
+
+  ShiftedAffineTransform::Pointer shiftedAffine = ShiftedAffineTransform::New();
+  shiftedAffine->SetParameters( affine->GetParameters() );
+  testPassed &= TestTransformPoints( shiftedAffine.GetPointer(), "ShiftedAffineTransform" );
+
+  using CompositeTransformType = itk::CompositeTransform< double, Dimension >;
+  CompositeTransformType::Pointer composite = CompositeTransformType::New();
+  composite->AddTransform( affine );
+  composite->AddTransform( bspline );
+  composite->AddTransform( translationTransform );
+  composite->AddTransform( shiftedAffine );
+  testPassed &= TestTransformPoints( composite.GetPointer(), "CompositeTransform" );
+
+  if ( !testPassed )
+    {
+    return EXIT_FAILURE;
+    }
+  std::cout << "Test finished." << std::endl;
+  return EXIT_SUCCESS;
+}
@@ -160,6 +160,8 @@ public:
   void SetMeshSizeForTheUpdateField( const ArrayType & );
 
 protected:
+  itkTransformPointsBatchedMacro(Self);
+
   BSplineExponentialDiffeomorphicTransform();
   ~BSplineExponentialDiffeomorphicTransform() override = default;
 
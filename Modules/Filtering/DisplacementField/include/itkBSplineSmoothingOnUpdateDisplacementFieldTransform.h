@@ -176,6 +176,8 @@ public:
   itkGetConstMacro( EnforceStationaryBoundary, bool );
 
 protected:
+  itkTransformPointsBatchedMacro(Self);
+
   BSplineSmoothingOnUpdateDisplacementFieldTransform();
   ~BSplineSmoothingOnUpdateDisplacementFieldTransform() override = default;
 
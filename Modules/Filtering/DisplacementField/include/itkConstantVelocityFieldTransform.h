@@ -187,6 +187,8 @@ public:
 
 protected:
 
+  itkTransformPointsBatchedMacro(Self);
+
   ConstantVelocityFieldTransform();
   ~ConstantVelocityFieldTransform() override = default;
   void PrintSelf( std::ostream& os, Indent indent ) const override;
@@ -211,6 +211,11 @@ public:
    * be returned with zero displacemnt. */
   OutputPointType TransformPoint( const InputPointType& thisPoint ) const override;
 
+  /**  Method to transform several points. Out-of-bounds points will
+   * be returned with zero displacement. */
+  void TransformPoints( const InputPointType *inputPoints, OutputPointType *outputPoints,
+                        SizeValueType numberOfPoints ) const override;
+
   /**  Method to transform a vector. */
   using Superclass::TransformVector;
   OutputVectorType TransformVector(const InputVectorType &) const override
@@ -427,6 +432,8 @@ public:
 
 protected:
 
+  itkTransformPointsBatchedMacro(Self);
+
   DisplacementFieldTransform();
   ~DisplacementFieldTransform() override = default;
   void PrintSelf( std::ostream& os, Indent indent ) const override;
@@ -448,6 +455,11 @@ protected:
   JacobianType m_IdentityJacobian;
 
 private:
+  /** Transform the points by the displacement field, for TransformPoint
+   * and the batched TransformPoints. */
+  void InternalTransformPoints( const InputPointType *inputPoints, OutputPointType *outputPoints,
+                                SizeValueType numberOfPoints ) const;
+
   /** Internal method for calculating either forward or inverse jacobian,
    * depending on state of \c doInverseJacobian. Used by
    * public methods \c ComputeJacobianWithRespectToPosition and
@@ -66,6 +66,31 @@ template<typename TParametersValueType, unsigned int NDimensions>
 typename DisplacementFieldTransform<TParametersValueType, NDimensions>::OutputPointType
 DisplacementFieldTransform<TParametersValueType, NDimensions>
 ::TransformPoint( const InputPointType& inputPoint ) const
+{
+  OutputPointType outputPoint;
+  this->InternalTransformPoints( &inputPoint, &outputPoint, 1 );
+  return outputPoint;
+}
+
+template<typename TParametersValueType, unsigned int NDimensions>
+void
+DisplacementFieldTransform<TParametersValueType, NDimensions>
+::TransformPoints( const InputPointType *inputPoints, OutputPointType *outputPoints,
+                   SizeValueType numberOfPoints ) const
+{
+  if( !this->IsTransformPointsBatched() )
+    {
+    Superclass::TransformPoints( inputPoints, outputPoints, numberOfPoints );
+    return;
+    }
+  this->InternalTransformPoints( inputPoints, outputPoints, numberOfPoints );
+}
+
+template<typename TParametersValueType, unsigned int NDimensions>
+void
+DisplacementFieldTransform<TParametersValueType, NDimensions>
+::InternalTransformPoints( const InputPointType *inputPoints, OutputPointType *outputPoints,
+                           SizeValueType numberOfPoints ) const
 {
   if( !this->m_DisplacementField )
     {
@@ -76,26 +101,30 @@ DisplacementFieldTransform<TParametersValueType, NDimensions>
     itkExceptionMacro( "No interpolator is specified." );
     }
 
+  const DisplacementFieldType * displacementField = this->m_DisplacementField.GetPointer();
+  const InterpolatorType * interpolator = this->m_Interpolator.GetPointer();
+
   typename InterpolatorType::ContinuousIndexType cidx;
   typename InterpolatorType::PointType point;
-  point.CastFrom( inputPoint );
+  for( SizeValueType n = 0; n < numberOfPoints; ++n )
+    {
+    point.CastFrom( inputPoints[n] );
 
-  OutputPointType outputPoint;
-  outputPoint.CastFrom( inputPoint );
+    OutputPointType & outputPoint = outputPoints[n];
+    outputPoint.CastFrom( point );
 
-  if( this->m_Interpolator->IsInsideBuffer( point ) )
-    {
-    this->m_DisplacementField->TransformPhysicalPointToContinuousIndex( point, cidx );
-    typename InterpolatorType::OutputType displacement = this->m_Interpolator->EvaluateAtContinuousIndex( cidx );
-    for( unsigned int ii = 0; ii < NDimensions; ++ii )
+    if( interpolator->IsInsideBuffer( point ) )
       {
-      outputPoint[ii] += displacement[ii];
+      displacementField->TransformPhysicalPointToContinuousIndex( point, cidx );
+      typename InterpolatorType::OutputType displacement = interpolator->EvaluateAtContinuousIndex( cidx );
+      for( unsigned int ii = 0; ii < NDimensions; ++ii )
+        {
+        outputPoint[ii] += displacement[ii];
+        }
       }
+    // else
+    // simply return inputPoint
     }
-  // else
-  // simply return inputPoint
-
-  return outputPoint;
 }
 
 template<typename TParametersValueType, unsigned int NDimensions>
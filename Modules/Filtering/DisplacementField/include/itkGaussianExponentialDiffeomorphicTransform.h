@@ -114,6 +114,8 @@ public:
   itkGetConstMacro( GaussianSmoothingVarianceForTheUpdateField, ScalarType );
 
 protected:
+  itkTransformPointsBatchedMacro(Self);
+
   GaussianExponentialDiffeomorphicTransform();
   ~GaussianExponentialDiffeomorphicTransform() override = default;
 
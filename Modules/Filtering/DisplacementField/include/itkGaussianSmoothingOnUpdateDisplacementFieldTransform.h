@@ -103,6 +103,8 @@ public:
   virtual DisplacementFieldPointer GaussianSmoothDisplacementField( DisplacementFieldType *, ScalarType );
 
 protected:
+  itkTransformPointsBatchedMacro(Self);
+
   GaussianSmoothingOnUpdateDisplacementFieldTransform();
   ~GaussianSmoothingOnUpdateDisplacementFieldTransform() override = default;
   void PrintSelf( std::ostream& os, Indent indent ) const override;
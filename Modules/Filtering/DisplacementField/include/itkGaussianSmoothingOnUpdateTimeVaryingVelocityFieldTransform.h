@@ -116,6 +116,8 @@ public:
   virtual TimeVaryingVelocityFieldPointer GaussianSmoothTimeVaryingVelocityField( VelocityFieldType *, ScalarType, ScalarType );
 
 protected:
+  itkTransformPointsBatchedMacro(Self);
+
   GaussianSmoothingOnUpdateTimeVaryingVelocityFieldTransform();
   ~GaussianSmoothingOnUpdateTimeVaryingVelocityFieldTransform() override = default;
   void PrintSelf( std::ostream& os, Indent indent ) const override;
@@ -172,6 +172,8 @@ public:
   itkGetConstMacro( SplineOrder, unsigned int );
 
 protected:
+  itkTransformPointsBatchedMacro(Self);
+
   TimeVaryingBSplineVelocityFieldTransform();
   ~TimeVaryingBSplineVelocityFieldTransform() override = default;
   void PrintSelf( std::ostream& os, Indent indent ) const override;
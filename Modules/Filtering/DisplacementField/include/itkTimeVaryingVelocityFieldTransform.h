@@ -125,6 +125,8 @@ public:
   void IntegrateVelocityField() override;
 
 protected:
+  itkTransformPointsBatchedMacro(Self);
+
   TimeVaryingVelocityFieldTransform() = default;
   ~TimeVaryingVelocityFieldTransform() override = default;
 };
@@ -192,6 +192,8 @@ public:
 
 protected:
 
+  itkTransformPointsBatchedMacro(Self);
+
   VelocityFieldTransform();
   ~VelocityFieldTransform() override = default;
   void PrintSelf( std::ostream& os, Indent indent ) const override;
@@ -436,6 +436,20 @@ int itkDisplacementFieldTransformTest( int argc, char* argv[] )
     return EXIT_FAILURE;
     }
 
+  // Test transforming several points, the second one outside the field
+  DisplacementTransformType::InputPointType  testPoints[2];
+  DisplacementTransformType::OutputPointType deformOutputs[2];
+  testPoints[0] = testPoint;
+  testPoints[1].Fill( 1e6 );
+  displacementTransform->TransformPoints( testPoints, deformOutputs, 2 );
+
+  if( !samePoint( deformOutputs[0], deformTruth ) || !samePoint( deformOutputs[1], testPoints[1] ) )
+    {
+    std::cout << "Error transforming points: TransformPoints(...)" << std::endl;
+    std::cout << "Test failed!" << std::endl;
+    return EXIT_FAILURE;
+    }
+
   DisplacementTransformType::InputVectorType  testVector;
   DisplacementTransformType::OutputVectorType deformVector, deformVectorTruth;
   testVector[0] = 0.5;
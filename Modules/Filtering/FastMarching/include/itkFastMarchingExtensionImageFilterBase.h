@@ -137,6 +137,11 @@ protected:
 
   void UpdateValue( OutputImageType* oImage, const NodeType& iValue ) override;
 
+  /** The auxiliary values are extended by UpdateValue(), which the fast
+   * iterative method does not call: the heap-based method is always used. */
+  bool IsFastIterativeMethodSupported() const override
+  { return false; }
+
   /** Generate the output image meta information */
   void GenerateOutputInformation() override;
 
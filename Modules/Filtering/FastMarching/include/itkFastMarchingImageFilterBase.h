@@ -61,6 +61,21 @@ namespace itk
  * "Level Set Methods and Fast Marching Methods", J.A. Sethian,
  * Cambridge Press, Second edition, 1999.
  *
+ * By default, the front is propagated with the heap-based fast marching
+ * method described above, which visits one node at a time. When
+ * UseFastIterativeMethod is on, the arrival times are instead computed with
+ * a parallel variant of the Fast Iterative Method (W.-K. Jeong and
+ * R. T. Whitaker, "A Fast Iterative Method for Eikonal Equations", SIAM
+ * Journal on Scientific Computing, 30(5):2512-2534, 2008). The trial nodes
+ * are processed in bands of arrival times: within a band, all the neighbors
+ * of the nodes whose value changed are updated concurrently until the values
+ * in the band no longer change. The nodes of the band are then made alive in
+ * increasing order of arrival time, and the stopping criterion is evaluated
+ * on each of them as the heap-based method would, so that the threshold and
+ * target nodes criteria stop the front at the same place. The topology checks
+ * depend on the order in which the nodes are visited, hence the heap-based
+ * method is used whenever TopologyCheck is not Nothing.
+ *
  * For an alternative implementation, see itk::FastMarchingImageFilter.
  *
  * \tparam TTraits traits
@@ -155,6 +170,13 @@ public:
   itkGetConstReferenceMacro(OverrideOutputInformation, bool);
   itkBooleanMacro(OverrideOutputInformation);
 
+  /** Set/Get whether the front is propagated with the parallel fast
+   * iterative method instead of the heap-based fast marching method.
+   * Default is false. */
+  itkSetMacro(UseFastIterativeMethod, bool);
+  itkGetConstReferenceMacro(UseFastIterativeMethod, bool);
+  itkBooleanMacro(UseFastIterativeMethod);
+
 protected:
 
   FastMarchingImageFilterBase();
@@ -172,12 +194,30 @@ protected:
   OutputSpacingType   m_OutputSpacing;
   OutputDirectionType m_OutputDirection;
   bool                m_OverrideOutputInformation{ false };
+  bool                m_UseFastIterativeMethod{ false };
 
   /** Generate the output image meta information. */
   void GenerateOutputInformation() override;
 
   void EnlargeOutputRequestedRegion(DataObject *output) override;
 
+  /** Propagate the front with the heap-based or with the fast iterative
+   * method. */
+  void GenerateData() override;
+
+  /** Propagate the front with the fast iterative method. */
+  void FastIterativeGenerateData();
+
+  /** Returns true when the front can be propagated with the fast iterative
+   * method, that is when no topology check is requested. */
+  virtual bool IsFastIterativeMethodSupported() const;
+
+  /** Called by the fast iterative method for each node made alive, once all
+   * the nodes with a smaller value are alive. It may be called concurrently
+   * for different nodes. */
+  virtual void FinalizeAliveNode( OutputImageType * itkNotUsed( oImage ),
+                                  const NodeType & itkNotUsed( iNode ) ) {}
+
   LabelImagePointer               m_LabelImage;
   ConnectedComponentImagePointer  m_ConnectedComponentImage;
 
@@ -24,6 +24,9 @@
 #include "itkImageRegionIterator.h"
 #include "itkConnectedComponentImageFilter.h"
 #include "itkRelabelComponentImageFilter.h"
+#include "itkProgressReporter.h"
+
+#include <algorithm>
 
 namespace itk
 {
@@ -1078,6 +1081,315 @@ InitializeIndices3D()
     }
 }
 
+template< typename TInput, typename TOutput >
+void
+FastMarchingImageFilterBase< TInput, TOutput >::
+GenerateData()
+{
+  if ( m_UseFastIterativeMethod && this->IsFastIterativeMethodSupported() )
+    {
+    this->FastIterativeGenerateData();
+    }
+  else
+    {
+    Superclass::GenerateData();
+    }
+}
+
+template< typename TInput, typename TOutput >
+bool
+FastMarchingImageFilterBase< TInput, TOutput >::
+IsFastIterativeMethodSupported() const
+{
+  return ( this->m_TopologyCheck == Superclass::Nothing );
+}
+
+template< typename TInput, typename TOutput >
+void
+FastMarchingImageFilterBase< TInput, TOutput >::
+FastIterativeGenerateData()
+{
+  OutputImageType* output = this->GetOutput();
+
+  this->Initialize( output );
+
+  using NodeIndexValueType = typename NodeType::IndexValueType;
+  using NodeListType = std::vector< OffsetValueType >;
+
+  OutputPixelType * const       values = output->GetBufferPointer();
+  unsigned char * const         labels = m_LabelImage->GetBufferPointer();
+  const OffsetValueType * const offsetTable = output->GetOffsetTable();
+
+  // Flags telling which of the node lists below a node belongs to
+  constexpr unsigned char InPending = 1;
+  constexpr unsigned char InBand = 2;
+  constexpr unsigned char InCandidates = 4;
+  std::vector< unsigned char > flags( m_BufferedRegion.GetNumberOfPixels(), 0 );
+
+  // The trial nodes pushed onto the heap by InitializeOutput() seed the
+  // propagation.
+  NodeListType pending;
+  while( !this->m_Heap.empty() )
+    {
+    const OffsetValueType p = output->ComputeOffset( this->m_Heap.top().GetNode() );
+    this->m_Heap.pop();
+    if ( !( flags[p] & InPending ) )
+      {
+      flags[p] |= InPending;
+      pending.push_back( p );
+      }
+    }
+
+  // Same as UpdateValue(), except that the current value of every neighbor
+  // which is not forbidden is used, whether it is alive or not.
+  auto solve = [&]( OffsetValueType p ) -> OutputPixelType
+    {
+    const NodeType node = output->ComputeIndex( p );
+
+    InternalNodeStructureArray nodesUsed;
+    for ( unsigned int j = 0; j < ImageDimension; j++ )
+      {
+      InternalNodeStructure & nodeUsed = nodesUsed[j];
+      nodeUsed.m_Node = node;
+      nodeUsed.m_Value = this->m_LargeValue;
+      nodeUsed.m_Axis = j;
+      for ( int s = -1; s < 2; s += 2 )
+        {
+        const NodeIndexValueType neighbor = node[j] + s;
+        const OffsetValueType    q = p + s * offsetTable[j];
+        if ( ( neighbor >= m_StartIndex[j] ) && ( neighbor <= m_LastIndex[j] ) &&
+             ( labels[q] != Traits::Forbidden ) && ( values[q] < nodeUsed.m_Value ) )
+          {
+          nodeUsed.m_Value = values[q];
+          nodeUsed.m_Node[j] = neighbor;
+          }
+        }
+      }
+    return static_cast< OutputPixelType >( this->Solve( output, node, nodesUsed ) );
+    };
+
+  // The node lists are processed in contiguous chunks, one per work unit,
+  // and the nodes found by each chunk are appended in chunk order.
+  const SizeValueType numberOfChunks = std::max< SizeValueType >( this->GetNumberOfWorkUnits(), 1 );
+  auto forEachChunk = [&]( SizeValueType size, const std::function< void( SizeValueType, SizeValueType, SizeValueType ) > & function )
+    {
+    this->GetMultiThreader()->ParallelizeArray( 0, numberOfChunks,
+      [&]( SizeValueType chunk )
+      {
+        function( chunk, size * chunk / numberOfChunks, size * ( chunk + 1 ) / numberOfChunks );
+      }, nullptr );
+    };
+  auto concatenate = []( std::vector< NodeListType > & chunkLists, NodeListType & list )
+    {
+    for ( NodeListType & chunkList : chunkLists )
+      {
+      list.insert( list.end(), chunkList.begin(), chunkList.end() );
+      chunkList.clear();
+      }
+    };
+
+  std::vector< NodeListType > frontierChunks( numberOfChunks );
+  std::vector< NodeListType > bandChunks( numberOfChunks );
+  std::vector< NodeListType > pendingChunks( numberOfChunks );
+  NodeListType                frontier;
+  NodeListType                band;
+  NodeListType                candidates;
+  std::vector< OutputPixelType > candidateValues;
+
+  ProgressReporter progress( this, 0, this->GetTotalNumberOfNodes() );
+
+  this->m_StoppingCriterion->Reinitialize();
+
+  OutputPixelType current_value = NumericTraits< OutputPixelType >::ZeroValue();
+  bool            stopped = false;
+
+  try
+    {
+    while( !stopped )
+      {
+      pending.erase( std::remove_if( pending.begin(), pending.end(),
+                                     [labels]( OffsetValueType p ) { return labels[p] == Traits::Alive; } ),
+                     pending.end() );
+      if ( pending.empty() )
+        {
+        break;
+        }
+
+      // The band extends up to the median value of the pending trial nodes,
+      // and those below it are the first nodes to change in the band.
+      std::vector< OutputPixelType > pendingValues( pending.size() );
+      for ( SizeValueType i = 0; i < pending.size(); i++ )
+        {
+        pendingValues[i] = values[pending[i]];
+        }
+      const auto median = pendingValues.begin() + ( pendingValues.size() - 1 ) / 2;
+      std::nth_element( pendingValues.begin(), median, pendingValues.end() );
+      const OutputPixelType bandLimit = *median;
+
+      NodeListType stillPending;
+      for ( const OffsetValueType p : pending )
+        {
+        if ( values[p] <= bandLimit )
+          {
+          flags[p] = ( flags[p] & ~InPending ) | InBand;
+          band.push_back( p );
+          frontier.push_back( p );
+          }
+        else
+          {
+          stillPending.push_back( p );
+          }
+        }
+      pending.swap( stillPending );
+
+      // Update the neighbors of the nodes whose value changed until the values
+      // in the band no longer change. The values are all computed before any of
+      // them is written, so that the result does not depend on the chunks.
+      while( !frontier.empty() )
+        {
+        forEachChunk( frontier.size(),
+          [&]( SizeValueType chunk, SizeValueType begin, SizeValueType end )
+          {
+            NodeListType & chunkCandidates = frontierChunks[chunk];
+            for ( SizeValueType i = begin; i < end; i++ )
+              {
+              const OffsetValueType p = frontier[i];
+              const NodeType        node = output->ComputeIndex( p );
+              for ( unsigned int j = 0; j < ImageDimension; j++ )
+                {
+                for ( int s = -1; s < 2; s += 2 )
+                  {
+                  const NodeIndexValueType neighbor = node[j] + s;
+                  const OffsetValueType    q = p + s * offsetTable[j];
+                  if ( ( neighbor >= m_StartIndex[j] ) && ( neighbor <= m_LastIndex[j] ) &&
+                       ( labels[q] == Traits::Far || labels[q] == Traits::Trial ) )
+                    {
+                    chunkCandidates.push_back( q );
+                    }
+                  }
+                }
+              }
+          } );
+
+        candidates.clear();
+        for ( NodeListType & chunkCandidates : frontierChunks )
+          {
+          for ( const OffsetValueType q : chunkCandidates )
+            {
+            if ( !( flags[q] & InCandidates ) )
+              {
+              flags[q] |= InCandidates;
+              candidates.push_back( q );
+              }
+            }
+          chunkCandidates.clear();
+          }
+        frontier.clear();
+
+        candidateValues.resize( candidates.size() );
+        forEachChunk( candidates.size(),
+          [&]( SizeValueType, SizeValueType begin, SizeValueType end )
+          {
+            for ( SizeValueType i = begin; i < end; i++ )
+              {
+              candidateValues[i] = solve( candidates[i] );
+              }
+          } );
+
+        forEachChunk( candidates.size(),
+          [&]( SizeValueType chunk, SizeValueType begin, SizeValueType end )
+          {
+            for ( SizeValueType i = begin; i < end; i++ )
+              {
+              const OffsetValueType q = candidates[i];
+              const OutputPixelType value = candidateValues[i];
+              flags[q] &= ~InCandidates;
+              if ( value < values[q] )
+                {
+                values[q] = value;
+                labels[q] = Traits::Trial;
+                if ( value <= bandLimit )
+                  {
+                  frontierChunks[chunk].push_back( q );
+                  if ( !( flags[q] & InBand ) )
+                    {
+                    flags[q] |= InBand;
+                    bandChunks[chunk].push_back( q );
+                    }
+                  }
+                else if ( !( flags[q] & InPending ) )
+                  {
+                  flags[q] |= InPending;
+                  pendingChunks[chunk].push_back( q );
+                  }
+                }
+              }
+          } );
+
+        concatenate( frontierChunks, frontier );
+        concatenate( bandChunks, band );
+        concatenate( pendingChunks, pending );
+        }
+
+      // All the nodes with a value up to the band limit now have their final
+      // value: make them alive in the order of the heap-based method.
+      std::sort( band.begin(), band.end(),
+                 [values]( OffsetValueType a, OffsetValueType b )
+                 { return std::make_pair( values[a], a ) < std::make_pair( values[b], b ); } );
+
+      SizeValueType numberOfAliveNodes = 0;
+      for ( const OffsetValueType p : band )
+        {
+        flags[p] &= ~InBand;
+
+        const NodePairType current_node_pair( output->ComputeIndex( p ), values[p] );
+        current_value = values[p];
+
+        this->m_StoppingCriterion->SetCurrentNodePair( current_node_pair );
+        if ( this->m_StoppingCriterion->IsSatisfied() )
+          {
+          stopped = true;
+          break;
+          }
+
+        if ( this->m_CollectPoints )
+          {
+          this->m_ProcessedPoints->push_back( current_node_pair );
+          }
+        labels[p] = Traits::Alive;
+        ++numberOfAliveNodes;
+
+        progress.CompletedPixel();
+        }
+
+      if ( numberOfAliveNodes > 0 )
+        {
+        this->GetMultiThreader()->ParallelizeArray( 0, numberOfAliveNodes,
+          [&]( SizeValueType i )
+          {
+            this->FinalizeAliveNode( output, output->ComputeIndex( band[i] ) );
+          }, nullptr );
+        }
+      band.clear();
+      }
+    }
+  catch ( ProcessAborted & )
+    {
+    // User aborted filter execution. As in GenerateData(), release the heap
+    // and rethrow the exception thrown by the progress reporter with the
+    // correct line number and file name. The process object invokes
+    // AbortEvent, and the node lists are released as they go out of scope.
+    while( !this->m_Heap.empty() )
+      {
+      this->m_Heap.pop();
+      }
+
+    throw ProcessAborted(__FILE__, __LINE__);
+    }
+
+  this->m_TargetReachedValue = current_value;
+}
+
 template< typename TInput, typename TOutput >
 void FastMarchingImageFilterBase< TInput, TOutput >::
 PrintSelf( std::ostream & os, Indent indent ) const
@@ -1095,6 +1407,8 @@ PrintSelf( std::ostream & os, Indent indent ) const
 
   os << indent << "OverrideOutputInformation: " << m_OverrideOutputInformation
     << std::endl;
+  os << indent << "UseFastIterativeMethod: " << m_UseFastIterativeMethod
+    << std::endl;
 
   itkPrintSelfObjectMacro( LabelImage );
 
@@ -41,6 +41,10 @@ namespace itk
  * information only propagates from points where the wavefront has already
  * passed. This is consistent with how the fast marching method works.
  *
+ * With UseFastIterativeMethod on, the gradient at a node is computed once all
+ * the nodes with a smaller arrival time are alive, which gives the same
+ * gradient vectors as the heap-based method.
+ *
  * For an alternative implementation, see itk::FastMarchingUpwindGradientImageFilter.
  *
  * \author Luca Antiga Ph.D.  Biomedical Technologies Laboratory,
@@ -105,6 +109,11 @@ protected:
 
   virtual void ComputeGradient(OutputImageType* oImage,
                                const NodeType& iNode );
+
+  /** Compute the gradient at the nodes made alive by the fast iterative
+   * method. */
+  void FinalizeAliveNode( OutputImageType* oImage,
+                          const NodeType& iNode ) override;
 };
 
 /* this class was made in the case where isotropic and anisotropic fast
@@ -104,6 +104,16 @@ UpdateNeighbors(
   this->ComputeGradient( oImage, iNode );
 }
 
+template< typename TInput, typename TOutput >
+void
+FastMarchingUpwindGradientImageFilterBase< TInput, TOutput >::
+FinalizeAliveNode(
+  OutputImageType* oImage,
+  const NodeType& iNode )
+{
+  this->ComputeGradient( oImage, iNode );
+}
+
 /**
  *
  */
@@ -0,0 +1,328 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+#include "itkFastMarchingUpwindGradientImageFilterBase.h"
+#include "itkFastMarchingThresholdStoppingCriterion.h"
+#include "itkFastMarchingReachedTargetNodesStoppingCriterion.h"
+#include "itkImageRegionConstIteratorWithIndex.h"
+#include "itkImageRegionIteratorWithIndex.h"
+#include "itkCommand.h"
+#include "itkTestingMacros.h"
+
+/* Compares the arrival times computed with the fast iterative method to the
+ * ones of the heap-based fast marching method, for a speed image with a slow
+ * barrier, forbidden nodes, a threshold and a target nodes stopping criterion.
+ * The fast iterative method must give the same result whatever the number of
+ * work units, and abort like the heap-based method.
+ */
+
+namespace
+{
+template< unsigned int VDimension >
+class FastIterativeTester
+{
+public:
+  using ImageType = itk::Image< float, VDimension >;
+  using MarcherType = itk::FastMarchingUpwindGradientImageFilterBase< ImageType, ImageType >;
+  using GradientImageType = typename MarcherType::GradientImageType;
+  using NodeType = typename MarcherType::NodeType;
+  using NodePairType = typename MarcherType::NodePairType;
+  using NodePairContainerType = typename MarcherType::NodePairContainerType;
+  using ThresholdCriterionType = itk::FastMarchingThresholdStoppingCriterion< ImageType, ImageType >;
+  using TargetCriterionType = itk::FastMarchingReachedTargetNodesStoppingCriterion< ImageType, ImageType >;
+  using CriterionType = typename MarcherType::StoppingCriterionType;
+
+  FastIterativeTester()
+  {
+    typename ImageType::SizeType size;
+    size.Fill( 24 );
+    size[0] = 64;
+    size[1] = 48;
+    typename ImageType::SpacingType spacing;
+    for ( unsigned int d = 0; d < VDimension; ++d )
+      {
+      spacing[d] = 1.0 + 0.25 * d;
+      }
+
+    m_Speed = ImageType::New();
+    m_Speed->SetRegions( size );
+    m_Speed->SetSpacing( spacing );
+    m_Speed->Allocate();
+
+    // A smoothly varying speed, with a slow wall across the first axis that
+    // has a gap in it. The heap-based method does not update the inner
+    // neighbors of the nodes on the image border, hence the border is slow
+    // enough never to be upwind of the inner nodes.
+    itk::ImageRegionIteratorWithIndex< ImageType > it( m_Speed, m_Speed->GetLargestPossibleRegion() );
+    for ( ; !it.IsAtEnd(); ++it )
+      {
+      const typename ImageType::IndexType index = it.GetIndex();
+      float speed = 1.0f + 0.5f * static_cast< float >( std::sin( 0.2 * index[0] ) * std::cos( 0.15 * index[1] ) );
+      if ( index[0] >= 40 && index[0] <= 42 && index[1] > 8 )
+        {
+        speed = 0.05f;
+        }
+      for ( unsigned int d = 0; d < VDimension; ++d )
+        {
+        if ( index[d] == 0 || index[d] == static_cast< itk::IndexValueType >( size[d] ) - 1 )
+          {
+          speed = 0.01f;
+          }
+        }
+      it.Set( speed );
+      }
+
+    NodeType seed;
+    seed.Fill( 10 );
+    seed[1] = 20;
+    m_Alive = NodePairContainerType::New();
+    m_Alive->push_back( NodePairType( seed, 0.0f ) );
+
+    m_Trial = NodePairContainerType::New();
+    for ( unsigned int d = 0; d < VDimension; ++d )
+      {
+      NodeType neighbor = seed;
+      neighbor[d] = seed[d] - 1;
+      m_Trial->push_back( NodePairType( neighbor, static_cast< float >( spacing[d] ) ) );
+      neighbor[d] = seed[d] + 1;
+      m_Trial->push_back( NodePairType( neighbor, static_cast< float >( spacing[d] ) ) );
+      }
+    NodeType secondSeed;
+    secondSeed.Fill( 5 );
+    secondSeed[0] = 55;
+    secondSeed[1] = 40;
+    m_Trial->push_back( NodePairType( secondSeed, 12.0f ) );
+
+    m_Forbidden = NodePairContainerType::New();
+    for ( itk::IndexValueType i = 0; i < 12; ++i )
+      {
+      NodeType forbidden = seed;
+      forbidden[0] = seed[0] + 4;
+      forbidden[1] = seed[1] - 6 + i;
+      m_Forbidden->push_back( NodePairType( forbidden, 0.0f ) );
+      }
+
+    m_Target.Fill( 3 );
+    m_Target[0] = 60;
+    m_Target[1] = 4;
+  }
+
+  typename MarcherType::Pointer
+  CreateMarcher( CriterionType * criterion, bool useFastIterativeMethod, itk::ThreadIdType numberOfWorkUnits )
+  {
+    typename MarcherType::Pointer marcher = MarcherType::New();
+    marcher->SetInput( m_Speed );
+    marcher->SetAlivePoints( m_Alive );
+    marcher->SetTrialPoints( m_Trial );
+    marcher->SetForbiddenPoints( m_Forbidden );
+    marcher->SetStoppingCriterion( criterion );
+    marcher->SetUseFastIterativeMethod( useFastIterativeMethod );
+    marcher->SetNumberOfWorkUnits( numberOfWorkUnits );
+    marcher->CollectPointsOn();
+    return marcher;
+  }
+
+  typename MarcherType::Pointer
+  March( CriterionType * criterion, bool useFastIterativeMethod, itk::ThreadIdType numberOfWorkUnits )
+  {
+    typename MarcherType::Pointer marcher = CreateMarcher( criterion, useFastIterativeMethod, numberOfWorkUnits );
+    marcher->Update();
+    return marcher;
+  }
+
+  void
+  AbortMarcher()
+  {
+    m_AbortedMarcher->AbortGenerateDataOn();
+  }
+
+  void
+  CountAbortEvent()
+  {
+    ++m_NumberOfAbortEvents;
+  }
+
+  typename CriterionType::Pointer
+  CreateThresholdCriterion( float threshold )
+  {
+    typename ThresholdCriterionType::Pointer criterion = ThresholdCriterionType::New();
+    criterion->SetThreshold( threshold );
+    return criterion.GetPointer();
+  }
+
+  typename CriterionType::Pointer
+  CreateTargetCriterion()
+  {
+    typename TargetCriterionType::Pointer criterion = TargetCriterionType::New();
+    std::vector< NodeType > targets;
+    targets.push_back( m_Target );
+    criterion->SetTargetNodes( targets );
+    criterion->SetTargetCondition( TargetCriterionType::OneTarget );
+    return criterion.GetPointer();
+  }
+
+  // Compares the arrival times and gradients of the nodes the heap-based
+  // method made alive, and checks that the other nodes are not below the
+  // value reached by the front.
+  static bool
+  Compare( MarcherType * expected, MarcherType * marcher, double tolerance )
+  {
+    const ImageType *         expectedOutput = expected->GetOutput();
+    const ImageType *         output = marcher->GetOutput();
+    const GradientImageType * expectedGradient = expected->GetGradientImage();
+    const GradientImageType * gradient = marcher->GetGradientImage();
+    const float               reachedValue = expected->GetTargetReachedValue();
+
+    double                   maximumDifference = 0.0;
+    double                   maximumGradientDifference = 0.0;
+    itk::SizeValueType       numberOfMismatches = 0;
+
+    itk::ImageRegionConstIteratorWithIndex< ImageType > it( expectedOutput, expectedOutput->GetBufferedRegion() );
+    for ( ; !it.IsAtEnd(); ++it )
+      {
+      const float expectedValue = it.Get();
+      const float value = output->GetPixel( it.GetIndex() );
+      if ( expectedValue < reachedValue )
+        {
+        maximumDifference = std::max( maximumDifference, static_cast< double >( std::abs( value - expectedValue ) ) );
+        const typename GradientImageType::PixelType difference =
+          gradient->GetPixel( it.GetIndex() ) - expectedGradient->GetPixel( it.GetIndex() );
+        maximumGradientDifference = std::max( maximumGradientDifference, static_cast< double >( difference.GetNorm() ) );
+        }
+      else if ( value < reachedValue - tolerance )
+        {
+        ++numberOfMismatches;
+        }
+      }
+
+    std::cout << "    Reached value: " << marcher->GetTargetReachedValue() << " (expected " << reachedValue
+              << "), maximum difference: " << maximumDifference << ", maximum gradient difference: "
+              << maximumGradientDifference << ", processed points: "
+              << marcher->GetProcessedPoints()->Size() << " (expected "
+              << expected->GetProcessedPoints()->Size() << ")" << std::endl;
+
+    if ( maximumDifference > tolerance || maximumGradientDifference > tolerance || numberOfMismatches > 0 ||
+         std::abs( marcher->GetTargetReachedValue() - reachedValue ) > tolerance )
+      {
+      std::cerr << "Test failed!" << std::endl;
+      std::cerr << numberOfMismatches << " nodes below the reached value were not reached" << std::endl;
+      return false;
+      }
+    return true;
+  }
+
+  static bool
+  CompareExactly( MarcherType * expected, MarcherType * marcher )
+  {
+    itk::ImageRegionConstIteratorWithIndex< ImageType > it( expected->GetOutput(),
+                                                            expected->GetOutput()->GetBufferedRegion() );
+    for ( ; !it.IsAtEnd(); ++it )
+      {
+      if ( itk::Math::NotExactlyEquals( it.Get(), marcher->GetOutput()->GetPixel( it.GetIndex() ) ) )
+        {
+        std::cerr << "Test failed!" << std::endl;
+        std::cerr << "The result depends on the number of work units at " << it.GetIndex() << std::endl;
+        return false;
+        }
+      }
+    return true;
+  }
+
+  bool
+  Run()
+  {
+    bool testPassed = true;
+    const double tolerance = 1e-3;
+
+    std::cout << VDimension << "D, whole image" << std::endl;
+    typename CriterionType::Pointer criterion = CreateThresholdCriterion( 1e6 );
+    typename MarcherType::Pointer heap = March( criterion, false, 1 );
+    typename MarcherType::Pointer fastIterative = March( criterion, true, 4 );
+    testPassed &= Compare( heap, fastIterative, tolerance );
+    testPassed &= CompareExactly( fastIterative, March( criterion, true, 1 ) );
+
+    std::cout << VDimension << "D, threshold" << std::endl;
+    criterion = CreateThresholdCriterion( 30.0f );
+    heap = March( criterion, false, 1 );
+    fastIterative = March( criterion, true, 3 );
+    testPassed &= Compare( heap, fastIterative, tolerance );
+
+    std::cout << VDimension << "D, target node" << std::endl;
+    criterion = CreateTargetCriterion();
+    heap = March( criterion, false, 1 );
+    fastIterative = March( criterion, true, 4 );
+    testPassed &= Compare( heap, fastIterative, tolerance );
+    if ( fastIterative->GetOutput()->GetPixel( m_Target ) > fastIterative->GetTargetReachedValue() )
+      {
+      std::cerr << "Test failed!" << std::endl;
+      std::cerr << "The front stopped before the target node" << std::endl;
+      testPassed = false;
+      }
+
+    // The filter is aborted by its first progress event
+    std::cout << VDimension << "D, aborted" << std::endl;
+    m_AbortedMarcher = CreateMarcher( CreateThresholdCriterion( 1e6 ), true, 4 );
+    using CommandType = itk::SimpleMemberCommand< FastIterativeTester >;
+    typename CommandType::Pointer abortCommand = CommandType::New();
+    abortCommand->SetCallbackFunction( this, &FastIterativeTester::AbortMarcher );
+    m_AbortedMarcher->AddObserver( itk::ProgressEvent(), abortCommand );
+    typename CommandType::Pointer abortEventCommand = CommandType::New();
+    abortEventCommand->SetCallbackFunction( this, &FastIterativeTester::CountAbortEvent );
+    m_AbortedMarcher->AddObserver( itk::AbortEvent(), abortEventCommand );
+    m_NumberOfAbortEvents = 0;
+    TRY_EXPECT_EXCEPTION( m_AbortedMarcher->Update() );
+    if ( m_NumberOfAbortEvents != 1 )
+      {
+      std::cerr << "Test failed!" << std::endl;
+      std::cerr << m_NumberOfAbortEvents << " abort events instead of 1" << std::endl;
+      testPassed = false;
+      }
+
+    return testPassed;
+  }
+
+private:
+  typename ImageType::Pointer             m_Speed;
+  typename NodePairContainerType::Pointer m_Alive;
+  typename NodePairContainerType::Pointer m_Trial;
+  typename NodePairContainerType::Pointer m_Forbidden;
+  NodeType                                m_Target;
+  typename MarcherType::Pointer           m_AbortedMarcher;
+  unsigned int                            m_NumberOfAbortEvents{ 0 };
+};
+}
+
+int itkFastMarchingImageFilterBaseFastIterativeTest( int, char *[] )
+{
+  using ImageType = itk::Image< float, 2 >;
+  using MarcherType = itk::FastMarchingImageFilterBase< ImageType, ImageType >;
+  MarcherType::Pointer marcher = MarcherType::New();
+  TEST_SET_GET_BOOLEAN( marcher, UseFastIterativeMethod, true );
+  TEST_SET_GET_BOOLEAN( marcher, UseFastIterativeMethod, false );
+
+  bool testPassed = true;
+  testPassed &= FastIterativeTester< 2 >().Run();
+  testPassed &= FastIterativeTester< 3 >().Run();
+
+  if ( !testPassed )
+    {
+    return EXIT_FAILURE;
+    }
+  std::cout << "Test finished." << std::endl;
+  return EXIT_SUCCESS;
+}
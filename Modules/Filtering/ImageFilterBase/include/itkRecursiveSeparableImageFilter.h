@@ -19,9 +19,12 @@
 #define itkRecursiveSeparableImageFilter_h
 
 #include "itkInPlaceImageFilter.h"
+#include "itkImage.h"
 #include "itkNumericTraits.h"
 #include "itkVariableLengthVector.h"
 
+#include <type_traits>
+
 namespace itk
 {
 /** \class RecursiveSeparableImageFilter
@@ -44,6 +47,12 @@ namespace itk
  * G. Farneback & C.-F. Westin, "On Implementation of Recursive Gaussian
  * Filters", so far unpublished.
  *
+ * When filtering images of scalars along another direction than the
+ * first one, the lines adjacent along the first dimension are filtered
+ * together, from a buffer where they are interleaved, so that the pixels
+ * are read in contiguous blocks and the recursion runs over several lines
+ * at once.
+ *
  * \ingroup ImageFilters
  * \ingroup ITKImageFilterBase
  */
@@ -132,6 +141,13 @@ protected:
   void FilterDataArray(RealType *outs, const RealType *data, RealType *scratch,
                        SizeValueType ln);
 
+  /** Apply the Recursive Filter to several lines of scalars at once. The
+   * values of the lines are interleaved: the i-th value of line b is at
+   * i * numberOfLines + b in "outs", "data" and "scratch". The results
+   * are those of FilterDataArray on each line. */
+  void FilterDataArrays(ScalarRealType *outs, const ScalarRealType *data, ScalarRealType *scratch,
+                        SizeValueType ln, SizeValueType numberOfLines);
+
 protected:
   /** Causal coefficients that multiply the input data. */
   ScalarRealType m_N0;
@@ -224,6 +240,22 @@ protected:
     }
 
 private:
+  /** Images of scalars, whose lines are filtered by bundles. */
+  using LineBundleType = std::integral_constant< bool,
+                                                 std::is_arithmetic< InputPixelType >::value
+                                                 && std::is_arithmetic< typename TOutputImage::PixelType >::value
+                                                 && std::is_same< TInputImage,
+                                                                  Image< InputPixelType,
+                                                                         TInputImage::ImageDimension > >::value
+                                                 && std::is_same< TOutputImage,
+                                                                  Image< typename TOutputImage::PixelType,
+                                                                         TOutputImage::ImageDimension > >::value >;
+
+  /** Filters the lines of the region by bundles of lines adjacent along
+   * the first dimension. */
+  void GenerateDataOnLineBundles(const OutputImageRegionType & outputRegionForThread, std::true_type);
+  void GenerateDataOnLineBundles(const OutputImageRegionType &, std::false_type) {}
+
   /** Direction in which the filter is to be applied
    * this should be in the range [0,ImageDimension-1]. */
   unsigned int m_Direction{ 0 };
@@ -21,7 +21,10 @@
 #include "itkRecursiveSeparableImageFilter.h"
 #include "itkObjectFactory.h"
 #include "itkImageLinearIteratorWithIndex.h"
+#include "itkImageScanlineConstIterator.h"
 #include <new>
+#include <algorithm>
+#include <vector>
 
 namespace itk
 {
@@ -168,6 +171,109 @@ RecursiveSeparableImageFilter< TInputImage, TOutputImage >
     }
 }
 
+/**
+ * Apply Recursive Filter to interleaved lines
+ */
+template< typename TInputImage, typename TOutputImage >
+void
+RecursiveSeparableImageFilter< TInputImage, TOutputImage >
+::FilterDataArrays(ScalarRealType *outs, const ScalarRealType *data,
+                   ScalarRealType *scratch, SizeValueType ln, SizeValueType numberOfLines)
+{
+  // The computations are those of FilterDataArray, on each line. Along
+  // the lines, the values are numberOfLines apart.
+  const SizeValueType w = numberOfLines;
+
+  ScalarRealType * scratch1 = outs;
+  ScalarRealType * scratch2 = scratch;
+
+  /**
+   * Causal direction pass, initializing the borders of each line
+   */
+  for ( SizeValueType b = 0; b < w; ++b )
+    {
+    const ScalarRealType *d = data + b;
+    ScalarRealType *      s1 = scratch1 + b;
+    const ScalarRealType &outV1 = d[0];
+
+    MathEMAMAMAM( s1[0]    , outV1    , m_N0,   outV1  , m_N1, outV1  , m_N2, outV1, m_N3 );
+    MathEMAMAMAM( s1[w]    , d[w]     , m_N0,   outV1  , m_N1, outV1  , m_N2, outV1, m_N3 );
+    MathEMAMAMAM( s1[2 * w], d[2 * w] , m_N0, d[w]     , m_N1, outV1  , m_N2, outV1, m_N3 );
+    MathEMAMAMAM( s1[3 * w], d[3 * w] , m_N0, d[2 * w] , m_N1, d[w]   , m_N2, outV1, m_N3 );
+
+    MathSMAMAMAM( s1[0]    , outV1      , m_BN1, outV1  , m_BN2, outV1  , m_BN3, outV1, m_BN4);
+    MathSMAMAMAM( s1[w]    , s1[0]      , m_D1 , outV1  , m_BN2, outV1  , m_BN3, outV1, m_BN4);
+    MathSMAMAMAM( s1[2 * w], s1[w]      , m_D1 , s1[0]  , m_D2 , outV1  , m_BN3, outV1, m_BN4);
+    MathSMAMAMAM( s1[3 * w], s1[2 * w]  , m_D1 , s1[w]  , m_D2 , s1[0]  , m_D3 , outV1, m_BN4);
+    }
+
+  // the lines are independent, so the innermost loop can be vectorized
+  for ( SizeValueType i = 4; i < ln; ++i )
+    {
+    const ScalarRealType *d0 = data + i * w;
+    const ScalarRealType *d1 = d0 - w;
+    const ScalarRealType *d2 = d1 - w;
+    const ScalarRealType *d3 = d2 - w;
+    ScalarRealType *      s0 = scratch1 + i * w;
+    const ScalarRealType *s1 = s0 - w;
+    const ScalarRealType *s2 = s1 - w;
+    const ScalarRealType *s3 = s2 - w;
+    const ScalarRealType *s4 = s3 - w;
+    for ( SizeValueType b = 0; b < w; ++b )
+      {
+      MathEMAMAMAM( s0[b], d0[b], m_N0, d1[b], m_N1, d2[b], m_N2, d3[b], m_N3);
+      MathSMAMAMAM( s0[b], s1[b], m_D1, s2[b], m_D2, s3[b], m_D3, s4[b], m_D4);
+      }
+    }
+
+  /**
+   * AntiCausal direction pass, initializing the borders of each line from
+   * the last four values
+   */
+  for ( SizeValueType b = 0; b < w; ++b )
+    {
+    const ScalarRealType *d = data + ( ln - 4 ) * w + b;
+    ScalarRealType *      s2 = scratch2 + ( ln - 4 ) * w + b;
+    const ScalarRealType &outV2 = d[3 * w];
+
+    MathEMAMAMAM( s2[3 * w], outV2     , m_M1, outV2    , m_M2, outV2   , m_M3, outV2, m_M4);
+    MathEMAMAMAM( s2[2 * w], d[3 * w]  , m_M1, outV2    , m_M2, outV2   , m_M3, outV2, m_M4);
+    MathEMAMAMAM( s2[w]    , d[2 * w]  , m_M1, d[3 * w] , m_M2, outV2   , m_M3, outV2, m_M4);
+    MathEMAMAMAM( s2[0]    , d[w]      , m_M1, d[2 * w] , m_M2, d[3 * w], m_M3, outV2, m_M4);
+
+    MathSMAMAMAM( s2[3 * w], outV2     , m_BM1, outV2    , m_BM2, outV2    , m_BM3, outV2, m_BM4);
+    MathSMAMAMAM( s2[2 * w], s2[3 * w] , m_D1 , outV2    , m_BM2, outV2    , m_BM3, outV2, m_BM4);
+    MathSMAMAMAM( s2[w]    , s2[2 * w] , m_D1 , s2[3 * w], m_D2 , outV2    , m_BM3, outV2, m_BM4);
+    MathSMAMAMAM( s2[0]    , s2[w]     , m_D1 , s2[2 * w], m_D2 , s2[3 * w], m_D3 , outV2, m_BM4);
+    }
+
+  for ( SizeValueType i = ln - 4; i > 0; --i )
+    {
+    const ScalarRealType *d0 = data + i * w;
+    const ScalarRealType *d1 = d0 + w;
+    const ScalarRealType *d2 = d1 + w;
+    const ScalarRealType *d3 = d2 + w;
+    ScalarRealType *      s0 = scratch2 + ( i - 1 ) * w;
+    const ScalarRealType *s1 = s0 + w;
+    const ScalarRealType *s2 = s1 + w;
+    const ScalarRealType *s3 = s2 + w;
+    const ScalarRealType *s4 = s3 + w;
+    for ( SizeValueType b = 0; b < w; ++b )
+      {
+      MathEMAMAMAM( s0[b], d0[b], m_M1, d1[b], m_M2, d2[b], m_M3, d3[b], m_M4);
+      MathSMAMAMAM( s0[b], s1[b], m_D1, s2[b], m_D2, s3[b], m_D3, s4[b], m_D4);
+      }
+    }
+
+  /**
+   * Roll the antiCausal part into the output
+   */
+  for ( SizeValueType m = 0; m < ln * w; ++m )
+    {
+    outs[m] += scratch2[m];
+    }
+}
+
 //
 // we need all of the image in just the "Direction" we are separated into
 //
@@ -263,6 +369,13 @@ void
 RecursiveSeparableImageFilter< TInputImage, TOutputImage >
 ::DynamicThreadedGenerateData(const OutputImageRegionType & outputRegionForThread)
 {
+  // the lines along the first dimension are contiguous already
+  if ( LineBundleType::value && this->m_Direction != 0 )
+    {
+    this->GenerateDataOnLineBundles( outputRegionForThread, LineBundleType() );
+    return;
+    }
+
   using OutputPixelType = typename TOutputImage::PixelType;
 
   using InputConstIteratorType = ImageLinearConstIteratorWithIndex< TInputImage >;
@@ -338,6 +451,69 @@ RecursiveSeparableImageFilter< TInputImage, TOutputImage >
   delete[] scratch;
 }
 
+template< typename TInputImage, typename TOutputImage >
+void
+RecursiveSeparableImageFilter< TInputImage, TOutputImage >
+::GenerateDataOnLineBundles(const OutputImageRegionType & outputRegionForThread, std::true_type)
+{
+  using OutputPixelType = typename TOutputImage::PixelType;
+  using IndexType = typename OutputImageRegionType::IndexType;
+
+  // a bundle of lines of doubles fills a few cache lines
+  constexpr SizeValueType BundleWidth = 16;
+
+  const TInputImage * inputImage = this->GetInputImage();
+  TOutputImage *      outputImage = this->GetOutput();
+
+  const SizeValueType   ln = outputRegionForThread.GetSize(this->m_Direction);
+  const OffsetValueType inputStride = inputImage->GetOffsetTable()[this->m_Direction];
+  const OffsetValueType outputStride = outputImage->GetOffsetTable()[this->m_Direction];
+
+  std::vector< ScalarRealType > inps( ln * BundleWidth );
+  std::vector< ScalarRealType > outs( ln * BundleWidth );
+  std::vector< ScalarRealType > scratch( ln * BundleWidth );
+
+  OutputImageRegionType lineStarts = outputRegionForThread;
+  lineStarts.SetSize( this->m_Direction, 1 );
+  const SizeValueType numberOfAdjacentLines = lineStarts.GetSize(0);
+
+  // The input and the output may share their buffer, and each bundle is
+  // read before being written.
+  ImageScanlineConstIterator< TOutputImage > it( outputImage, lineStarts );
+  while ( !it.IsAtEnd() )
+    {
+    for ( SizeValueType x = 0; x < numberOfAdjacentLines; x += BundleWidth )
+      {
+      const SizeValueType width = std::min( BundleWidth, numberOfAdjacentLines - x );
+      IndexType           index = it.GetIndex();
+      index[0] += x;
+
+      const InputPixelType * input = inputImage->GetBufferPointer() + inputImage->ComputeOffset( index );
+      for ( SizeValueType i = 0; i < ln; ++i )
+        {
+        for ( SizeValueType b = 0; b < width; ++b )
+          {
+          inps[i * width + b] = static_cast< ScalarRealType >( input[b] );
+          }
+        input += inputStride;
+        }
+
+      this->FilterDataArrays( outs.data(), inps.data(), scratch.data(), ln, width );
+
+      OutputPixelType * output = outputImage->GetBufferPointer() + outputImage->ComputeOffset( index );
+      for ( SizeValueType i = 0; i < ln; ++i )
+        {
+        for ( SizeValueType b = 0; b < width; ++b )
+          {
+          output[b] = static_cast< OutputPixelType >( outs[i * width + b] );
+          }
+        output += outputStride;
+        }
+      }
+    it.NextLine();
+    }
+}
+
 template< typename TInputImage, typename TOutputImage >
 void
 RecursiveSeparableImageFilter< TInputImage, TOutputImage >
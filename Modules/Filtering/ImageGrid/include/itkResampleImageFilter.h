@@ -27,7 +27,10 @@
 #include "itkSize.h"
 #include "itkDefaultConvertPixelTraits.h"
 #include "itkDataObjectDecorator.h"
+#include "itkImage.h"
+#include "itkVector.h"
 
+#include <type_traits>
 
 namespace itk
 {
@@ -68,6 +71,17 @@ namespace itk
  * ProcessObject::GenerateInputRequestedRegion() and
  * ProcessObject::GenerateOutputInformation().
  *
+ * When the transform is linear, the samples of each output scanline lie on
+ * a line of the input, and the span of the scanline that falls inside the
+ * input buffer is computed once, so that the samples are not checked one
+ * by one. For images of scalars, the linear and nearest neighbor
+ * interpolators are evaluated inside this span directly from the buffer.
+ *
+ * Otherwise, the transform is evaluated at every output pixel. With
+ * PrecomputeDisplacementFieldOn(), it is evaluated once into a
+ * displacement field on the output grid, which the following updates
+ * reuse as long as the transform and the output grid are not modified.
+ *
  * This filter is implemented as a multithreaded filter.  It provides a
  * DynamicThreadedGenerateData() method for its implementation.
  * \warning For multithreading, the TransformPoint method of the
@@ -182,6 +196,11 @@ public:
   /** Typedef the reference image type to be the ImageBase of the OutputImageType */
   using ReferenceImageBaseType = ImageBase<ImageDimension>;
 
+  /** Displacement field type alias, for the transform evaluated on the
+   * output grid. */
+  using DisplacementFieldType = Image< Vector< TTransformPrecisionType, ImageDimension >, ImageDimension >;
+  using DisplacementFieldPointer = typename DisplacementFieldType::Pointer;
+
   /** Get/Set the coordinate transformation.
    * Set the coordinate transform to use for resampling.  Note that this must
    * be in physical coordinates and it is the output-to-input transform, NOT
@@ -261,6 +280,25 @@ public:
   itkBooleanMacro(UseReferenceImage);
   itkGetConstMacro(UseReferenceImage, bool);
 
+  /** Turn on/off the evaluation of a non-linear transform into a
+   * displacement field on the output grid. The field is computed in
+   * parallel at the first update, and then kept until the transform, one
+   * of the transforms of a composite transform, or the output grid is
+   * modified. The following updates, for instance of the other channels
+   * or label maps resampled by this filter, then read one displacement
+   * per output pixel instead of evaluating the transform. The field
+   * covers the output largest possible region. Linear transforms are not
+   * affected. The default is off.
+   *
+   * The field is not computed again when an image which the transform
+   * refers to, such as the displacement field of a
+   * DisplacementFieldTransform or a coefficient image of a
+   * BSplineTransform, is modified in place. Call Modified() on the
+   * transform after such a change. */
+  itkSetMacro(PrecomputeDisplacementField, bool);
+  itkBooleanMacro(PrecomputeDisplacementField);
+  itkGetConstMacro(PrecomputeDisplacementField, bool);
+
 #ifdef ITK_USE_CONCEPT_CHECKING
   // Begin concept checking
   itkConceptMacro( OutputHasNumericTraitsCheck,
@@ -332,6 +370,70 @@ protected:
                                                  const ComponentType maxComponent) const);
 
 private:
+  /** Interpolations evaluated from the buffer of the input image. */
+  enum class BufferInterpolationEnum { None, NearestNeighbor, Linear };
+
+  /** Plain images of scalars, whose buffer may be interpolated directly. */
+  using BufferInterpolationType = std::integral_constant< bool,
+                                                          std::is_arithmetic< InputPixelType >::value
+                                                          && std::is_same< TInputImage,
+                                                                           Image< InputPixelType,
+                                                                                  InputImageDimension > >::value
+                                                          && InputImageDimension <= 3 >;
+
+  using OffsetValueType = typename TInputImage::OffsetValueType;
+  using InterpolationRealType = typename LinearInterpolatorType::RealType;
+
+  /** Returns the interpolation that replaces the interpolator, if any. */
+  BufferInterpolationEnum SelectBufferInterpolation(std::true_type) const;
+  BufferInterpolationEnum SelectBufferInterpolation(std::false_type) const
+  {
+    return BufferInterpolationEnum::None;
+  }
+
+  /** Evaluates the interpolation at an index where all the pixels it
+   * uses are in the buffer. */
+  InterpolatorOutputType EvaluateFromBuffer(BufferInterpolationEnum interpolation,
+                                            const ContinuousInputIndexType & index, std::true_type) const;
+  InterpolatorOutputType EvaluateFromBuffer(BufferInterpolationEnum,
+                                            const ContinuousInputIndexType & index, std::false_type) const
+  {
+    return m_Interpolator->EvaluateAtContinuousIndex(index);
+  }
+
+  /** Interpolates linearly along the first VDimension dimensions, in the
+   * order of LinearInterpolateImageFunction. */
+  template< unsigned int VDimension >
+  static InterpolationRealType InterpolateLinearly(const InputPixelType *pixel, const OffsetValueType *offsetTable,
+                                                   const TInterpolatorPrecisionType *distance,
+                                                   std::integral_constant< unsigned int, VDimension >);
+  static InterpolationRealType InterpolateLinearly(const InputPixelType *pixel, const OffsetValueType *,
+                                                   const TInterpolatorPrecisionType *,
+                                                   std::integral_constant< unsigned int, 0 >)
+  {
+    return static_cast< InterpolationRealType >( *pixel );
+  }
+
+  /** Restricts [spanBegin, spanEnd) to the indices of the scanline whose
+   * continuous index is in [lower, upper) along every dimension. The
+   * continuous indices change monotonously along the scanline, so that
+   * these samples are contiguous, and are found from an estimation of the
+   * span that is refined by calling isInside on the actual indices. */
+  template< typename TContinuousIndexFunction, typename TPredicate >
+  static void RestrictToSpan(IndexValueType & spanBegin, IndexValueType & spanEnd,
+                             IndexValueType lineStart, SizeValueType lineSize,
+                             const ContinuousInputIndexType & startIndex, const ContinuousInputIndexType & endIndex,
+                             const ContinuousInputIndexType & lower, const ContinuousInputIndexType & upper,
+                             const TContinuousIndexFunction & continuousIndexAt, const TPredicate & isInside);
+
+  /** Evaluates the transform into m_DisplacementField, unless the field
+   * is already up to date. */
+  void UpdateDisplacementField();
+
+  /** Returns the latest modification time of the transform and of the
+   * transforms it is composed of. */
+  static ModifiedTimeType GetTransformMTime(const TransformType *transform);
+
   static PixelComponentType CastComponentWithBoundsChecking(const PixelComponentType value);
 
   template <typename TComponent>
@@ -355,6 +457,13 @@ private:
   DirectionType   m_OutputDirection;      // output image direction cosines
   IndexType       m_OutputStartIndex;     // output image start index
   bool            m_UseReferenceImage{ false };
+  bool            m_PrecomputeDisplacementField{ false };
+
+  // The transform evaluated on the output grid, and the transform and
+  // modification time it was evaluated from
+  DisplacementFieldPointer m_DisplacementField;
+  TransformPointerType     m_DisplacementFieldTransform;
+  ModifiedTimeType         m_DisplacementFieldTransformMTime{ 0 };
 
 };
 } // end namespace itk
@@ -21,14 +21,21 @@
 #include "itkResampleImageFilter.h"
 #include "itkObjectFactory.h"
 #include "itkIdentityTransform.h"
+#include "itkMultiTransform.h"
 #include "itkProgressReporter.h"
 #include "itkImageRegionIteratorWithIndex.h"
 #include "itkImageScanlineIterator.h"
 #include "itkSpecialCoordinatesImage.h"
 #include "itkDefaultConvertPixelTraits.h"
 #include "itkImageAlgorithm.h"
+#include "itkNearestNeighborInterpolateImageFunction.h"
+#include "itkMath.h"
 
+#include <algorithm>
+#include <cmath>
 #include <type_traits>  // For is_same.
+#include <typeinfo>
+#include <vector>
 
 namespace itk
 {
@@ -137,6 +144,21 @@ ResampleImageFilter< TInputImage, TOutputImage, TInterpolatorPrecisionType, TTra
     m_Extrapolator->SetInputImage( this->GetInput() );
     }
 
+  // Evaluate a non-linear transform on the output grid, or release the
+  // field of a previous update
+  using OutputSpecialCoordinatesImageType = SpecialCoordinatesImage< PixelType, ImageDimension >;
+  if ( m_PrecomputeDisplacementField
+       && this->GetTransform()->GetTransformCategory() != TransformType::Linear
+       && !dynamic_cast< const OutputSpecialCoordinatesImageType * >( this->GetOutput() ) )
+    {
+    this->UpdateDisplacementField();
+    }
+  else
+    {
+    m_DisplacementField = nullptr;
+    m_DisplacementFieldTransform = nullptr;
+    }
+
   unsigned int nComponents
     = DefaultConvertPixelTraits<PixelType>::GetNumberOfComponents(
         m_DefaultPixelValue );
@@ -155,6 +177,99 @@ ResampleImageFilter< TInputImage, TOutputImage, TInterpolatorPrecisionType, TTra
     }
 }
 
+template< typename TInputImage,
+          typename TOutputImage,
+          typename TInterpolatorPrecisionType,
+          typename TTransformPrecisionType >
+void
+ResampleImageFilter< TInputImage, TOutputImage, TInterpolatorPrecisionType, TTransformPrecisionType >
+::UpdateDisplacementField()
+{
+  const OutputImageType *outputPtr = this->GetOutput();
+  const TransformType *transformPtr = this->GetTransform();
+  const ModifiedTimeType transformMTime = Self::GetTransformMTime(transformPtr);
+
+  if ( m_DisplacementField
+       && m_DisplacementFieldTransform == transformPtr
+       && m_DisplacementFieldTransformMTime == transformMTime
+       && m_DisplacementField->GetLargestPossibleRegion() == outputPtr->GetLargestPossibleRegion()
+       && m_DisplacementField->GetOrigin() == outputPtr->GetOrigin()
+       && m_DisplacementField->GetSpacing() == outputPtr->GetSpacing()
+       && m_DisplacementField->GetDirection() == outputPtr->GetDirection() )
+    {
+    return;
+    }
+
+  DisplacementFieldPointer field = DisplacementFieldType::New();
+  field->CopyInformation( outputPtr );
+  field->SetRegions( outputPtr->GetLargestPossibleRegion() );
+  field->Allocate();
+
+  // Each displacement is computed like the input point of the pixel in
+  // NonlinearThreadedGenerateData, one scanline at a time
+  DisplacementFieldType *fieldPtr = field.GetPointer();
+  this->GetMultiThreader()->template ParallelizeImageRegion< ImageDimension >(
+    field->GetBufferedRegion(),
+    [outputPtr, transformPtr, fieldPtr](const OutputImageRegionType & region)
+      {
+      using TransformPointType = typename TransformType::InputPointType;
+      const SizeValueType               lineSize = region.GetSize(0);
+      std::vector< PointType >          outputPoints( lineSize );
+      std::vector< TransformPointType > transformPoints( lineSize );
+      PointType                         inputPoint;
+      typename DisplacementFieldType::PixelType displacement;
+      for ( ImageScanlineIterator< DisplacementFieldType > it( fieldPtr, region ); !it.IsAtEnd(); it.NextLine() )
+        {
+        IndexType index = it.GetIndex();
+        const IndexValueType lineStart = index[0];
+        for ( SizeValueType n = 0; n < lineSize; ++n )
+          {
+          index[0] = lineStart + static_cast< IndexValueType >( n );
+          outputPtr->TransformIndexToPhysicalPoint( index, outputPoints[n] );
+          transformPoints[n] = outputPoints[n];
+          }
+        transformPtr->TransformPoints( transformPoints.data(), transformPoints.data(), lineSize );
+        for ( SizeValueType n = 0; n < lineSize; ++n, ++it )
+          {
+          inputPoint = transformPoints[n];
+          for ( unsigned int i = 0; i < ImageDimension; ++i )
+            {
+            displacement[i] = inputPoint[i] - outputPoints[n][i];
+            }
+          it.Set( displacement );
+          }
+        }
+      },
+    nullptr );
+
+  m_DisplacementField = field;
+  m_DisplacementFieldTransform = transformPtr;
+  m_DisplacementFieldTransformMTime = transformMTime;
+}
+
+template< typename TInputImage,
+          typename TOutputImage,
+          typename TInterpolatorPrecisionType,
+          typename TTransformPrecisionType >
+ModifiedTimeType
+ResampleImageFilter< TInputImage, TOutputImage, TInterpolatorPrecisionType, TTransformPrecisionType >
+::GetTransformMTime(const TransformType *transform)
+{
+  // The transforms of a composite transform are modified independently
+  // of it
+  using MultiTransformType = MultiTransform< TTransformPrecisionType, ImageDimension, ImageDimension >;
+
+  ModifiedTimeType latestTime = transform->GetMTime();
+  if ( const auto * multiTransform = dynamic_cast< const MultiTransformType * >( transform ) )
+    {
+    for ( SizeValueType n = 0; n < multiTransform->GetNumberOfTransforms(); ++n )
+      {
+      latestTime = std::max( latestTime, Self::GetTransformMTime( multiTransform->GetNthTransformConstPointer(n) ) );
+      }
+    }
+  return latestTime;
+}
+
 template< typename TInputImage,
           typename TOutputImage,
           typename TInterpolatorPrecisionType,
@@ -347,51 +462,94 @@ ResampleImageFilter< TInputImage, TOutputImage, TInterpolatorPrecisionType, TTra
 
 
   // Create an iterator that will walk the output region for this thread.
-  using OutputIterator = ImageRegionIteratorWithIndex< TOutputImage >;
+  using OutputIterator = ImageScanlineIterator< TOutputImage >;
   OutputIterator outIt(outputPtr, outputRegionForThread);
 
   // Define a few indices that will be used to translate from an input pixel
   // to an output pixel
   PointType outputPoint;         // Coordinates of current output pixel
-  PointType inputPoint;          // Coordinates of current input pixel
 
   ContinuousInputIndexType inputIndex;
 
   using OutputType = typename InterpolatorType::OutputType;
 
+  // The displacements of the transform, when they are precomputed
+  const DisplacementFieldType *displacementField = m_DisplacementField.GetPointer();
+  ImageRegionConstIterator< DisplacementFieldType > displacementIt;
+  if ( displacementField )
+    {
+    displacementIt = ImageRegionConstIterator< DisplacementFieldType >( displacementField, outputRegionForThread );
+    }
+
+  // The points of a scanline, which are transformed all at once
+  using TransformPointType = typename TransformType::InputPointType;
+  const SizeValueType             lineSize = outputRegionForThread.GetSize(0);
+  std::vector< TransformPointType > transformPoints( lineSize );
+  std::vector< PointType >          inputPoints( lineSize ); // Coordinates of the input pixels
+
   // Walk the output region
   outIt.GoToBegin();
 
   while ( !outIt.IsAtEnd() )
     {
-    // Determine the index of the current output pixel
-    outputPtr->TransformIndexToPhysicalPoint(outIt.GetIndex(), outputPoint);
-
-    // Compute corresponding input pixel position
-    inputPoint = transformPtr->TransformPoint(outputPoint);
-    const bool isInsideInput = inputPtr->TransformPhysicalPointToContinuousIndex(inputPoint, inputIndex);
+    // Compute the input pixel positions of the scanline
+    IndexType index = outIt.GetIndex();
+    const IndexValueType lineStart = index[0];
+    for ( SizeValueType n = 0; n < lineSize; ++n )
+      {
+      index[0] = lineStart + static_cast< IndexValueType >( n );
+      outputPtr->TransformIndexToPhysicalPoint(index, outputPoint);
 
-    OutputType value;
-    // Evaluate input at right position and copy to the output
-    if( m_Interpolator->IsInsideBuffer(inputIndex) && ( !isSpecialCoordinatesImage || isInsideInput ) )
+      if ( displacementField )
+        {
+        const typename DisplacementFieldType::PixelType & displacement = displacementIt.Get();
+        for ( unsigned int i = 0; i < ImageDimension; ++i )
+          {
+          inputPoints[n][i] = outputPoint[i] + displacement[i];
+          }
+        ++displacementIt;
+        }
+      else
+        {
+        transformPoints[n] = outputPoint;
+        }
+      }
+    if ( !displacementField )
       {
-      value = m_Interpolator->EvaluateAtContinuousIndex(inputIndex);
-      outIt.Set( Self::CastPixelWithBoundsChecking(value) );
+      transformPtr->TransformPoints(transformPoints.data(), transformPoints.data(), lineSize);
+      for ( SizeValueType n = 0; n < lineSize; ++n )
+        {
+        inputPoints[n] = transformPoints[n];
+        }
       }
-    else
+
+    for ( SizeValueType n = 0; n < lineSize; ++n )
       {
-      if( m_Extrapolator.IsNull() )
+      const bool isInsideInput = inputPtr->TransformPhysicalPointToContinuousIndex(inputPoints[n], inputIndex);
+
+      OutputType value;
+      // Evaluate input at right position and copy to the output
+      if( m_Interpolator->IsInsideBuffer(inputIndex) && ( !isSpecialCoordinatesImage || isInsideInput ) )
         {
-        outIt.Set( m_DefaultPixelValue ); // default background value
+        value = m_Interpolator->EvaluateAtContinuousIndex(inputIndex);
+        outIt.Set( Self::CastPixelWithBoundsChecking(value) );
         }
       else
         {
-        value = m_Extrapolator->EvaluateAtContinuousIndex( inputIndex );
-        outIt.Set( Self::CastPixelWithBoundsChecking(value) );
+        if( m_Extrapolator.IsNull() )
+          {
+          outIt.Set( m_DefaultPixelValue ); // default background value
+          }
+        else
+          {
+          value = m_Extrapolator->EvaluateAtContinuousIndex( inputIndex );
+          outIt.Set( Self::CastPixelWithBoundsChecking(value) );
+          }
         }
-      }
 
-    ++outIt;
+      ++outIt;
+      }
+    outIt.NextLine();
     }
 }
 
@@ -423,7 +581,21 @@ ResampleImageFilter< TInputImage, TOutputImage, TInterpolatorPrecisionType, TTra
   // Cache information from the superclass
   PixelType defaultValue = this->GetDefaultPixelValue();
 
-  using OutputType = typename InterpolatorType::OutputType;
+  // The bounds of the continuous indices inside the buffer, and of the
+  // ones whose interpolation only uses pixels of the buffer
+  const ContinuousInputIndexType startContinuousIndex = m_Interpolator->GetStartContinuousIndex();
+  const ContinuousInputIndexType endContinuousIndex = m_Interpolator->GetEndContinuousIndex();
+  const BufferInterpolationEnum  bufferInterpolation = this->SelectBufferInterpolation( BufferInterpolationType() );
+  ContinuousInputIndexType       bufferLower = startContinuousIndex;
+  ContinuousInputIndexType       bufferUpper = endContinuousIndex;
+  if ( bufferInterpolation == BufferInterpolationEnum::Linear )
+    {
+    for ( unsigned int i = 0; i < ImageDimension; ++i )
+      {
+      bufferLower[i] = m_Interpolator->GetStartIndex()[i];
+      bufferUpper[i] = m_Interpolator->GetEndIndex()[i];
+      }
+    }
 
   // As we walk across a scan line in the output image, we trace
   // an oriented/scaled/translated line in the input image. Each scan
@@ -457,24 +629,71 @@ ResampleImageFilter< TInputImage, TOutputImage, TInterpolatorPrecisionType, TTra
     inputPoint = transformPtr->TransformPoint(outputPoint);
     inputPtr->TransformPhysicalPointToContinuousIndex(inputPoint, endIndex);
 
-    IndexValueType scanlineIndex = outIt.GetIndex()[0];
-
-
-    while ( !outIt.IsAtEndOfLine() )
+    // Perform linear interpolation between startIndex and endIndex, from
+    // copies of the values of the scanline that the writes to the output
+    // cannot alias
+    const IndexValueType     lineStart = largestPossibleRegion.GetIndex(0);
+    const double             lineSize = static_cast< double >( largestPossibleRegion.GetSize(0) );
+    ContinuousInputIndexType lineDelta;
+    for (unsigned int i = 0; i < ImageDimension; ++i)
       {
-
-      // Perform linear interpolation between startIndex and endIndex
-      const double alpha = (scanlineIndex - largestPossibleRegion.GetIndex(0)) / (double)(largestPossibleRegion.GetSize(0));
+      lineDelta[i] = endIndex[i] - startIndex[i];
+      }
+    const auto continuousIndexAt = [lineStart, lineSize, startIndex, lineDelta](IndexValueType scanlineIndex)
+      {
+      const double alpha = (scanlineIndex - lineStart) / lineSize;
 
       ContinuousInputIndexType inputIndex( startIndex );
       for (unsigned int i = 0; i < ImageDimension; ++i)
         {
-        inputIndex[i] += alpha * ( endIndex[i] - startIndex[i] );
+        inputIndex[i] += alpha * lineDelta[i];
         }
+      return inputIndex;
+      };
+
+    // The samples inside the buffer are interpolated, and the ones that
+    // only use pixels of the buffer are evaluated from it.
+    const IndexValueType lineBegin = outIt.GetIndex()[0];
+    const IndexValueType lineEnd = lineBegin + static_cast< IndexValueType >( outputRegionForThread.GetSize(0) );
+    IndexValueType       insideBegin = lineBegin;
+    IndexValueType       insideEnd = lineEnd;
+    Self::RestrictToSpan(insideBegin, insideEnd, lineStart, largestPossibleRegion.GetSize(0),
+                         startIndex, endIndex, startContinuousIndex, endContinuousIndex, continuousIndexAt,
+                         [this](const ContinuousInputIndexType & inputIndex)
+                           { return m_Interpolator->IsInsideBuffer(inputIndex); });
+    IndexValueType bufferBegin = insideBegin;
+    IndexValueType bufferEnd = insideBegin;
+    if ( bufferInterpolation != BufferInterpolationEnum::None )
+      {
+      bufferEnd = insideEnd;
+      Self::RestrictToSpan(bufferBegin, bufferEnd, lineStart, largestPossibleRegion.GetSize(0),
+                           startIndex, endIndex, bufferLower, bufferUpper, continuousIndexAt,
+                           [&bufferLower, &bufferUpper](const ContinuousInputIndexType & inputIndex)
+                             {
+                             for ( unsigned int i = 0; i < ImageDimension; ++i )
+                               {
+                               if ( !( inputIndex[i] >= bufferLower[i] && inputIndex[i] < bufferUpper[i] ) )
+                                 {
+                                 return false;
+                                 }
+                               }
+                             return true;
+                             });
+      }
+
+    IndexValueType scanlineIndex = lineBegin;
+    while ( !outIt.IsAtEndOfLine() )
+      {
+      const ContinuousInputIndexType inputIndex = continuousIndexAt( scanlineIndex );
 
       OutputType value;
       // Evaluate input at right position and copy to the output
-      if ( m_Interpolator->IsInsideBuffer(inputIndex) )
+      if ( scanlineIndex >= bufferBegin && scanlineIndex < bufferEnd )
+        {
+        value = this->EvaluateFromBuffer( bufferInterpolation, inputIndex, BufferInterpolationType() );
+        outIt.Set( Self::CastPixelWithBoundsChecking(value) );
+        }
+      else if ( scanlineIndex >= insideBegin && scanlineIndex < insideEnd )
         {
         value = m_Interpolator->EvaluateAtContinuousIndex(inputIndex);
         outIt.Set( Self::CastPixelWithBoundsChecking(value) );
@@ -499,6 +718,143 @@ ResampleImageFilter< TInputImage, TOutputImage, TInterpolatorPrecisionType, TTra
     }
 }
 
+template< typename TInputImage,
+          typename TOutputImage,
+          typename TInterpolatorPrecisionType,
+          typename TTransformPrecisionType >
+auto ResampleImageFilter< TInputImage, TOutputImage, TInterpolatorPrecisionType, TTransformPrecisionType >
+::SelectBufferInterpolation(std::true_type) const -> BufferInterpolationEnum
+{
+  // Subclasses of the interpolators may evaluate differently
+  using NearestNeighborInterpolatorType = NearestNeighborInterpolateImageFunction< InputImageType,
+                                                                                   TInterpolatorPrecisionType >;
+  const InterpolatorType & interpolator = *m_Interpolator;
+  if ( typeid( interpolator ) == typeid( LinearInterpolatorType ) )
+    {
+    return BufferInterpolationEnum::Linear;
+    }
+  if ( typeid( interpolator ) == typeid( NearestNeighborInterpolatorType ) )
+    {
+    return BufferInterpolationEnum::NearestNeighbor;
+    }
+  return BufferInterpolationEnum::None;
+}
+
+template< typename TInputImage,
+          typename TOutputImage,
+          typename TInterpolatorPrecisionType,
+          typename TTransformPrecisionType >
+auto ResampleImageFilter< TInputImage, TOutputImage, TInterpolatorPrecisionType, TTransformPrecisionType >
+::EvaluateFromBuffer(BufferInterpolationEnum interpolation, const ContinuousInputIndexType & index,
+                     std::true_type) const -> InterpolatorOutputType
+{
+  const InputImageType *  inputPtr = this->GetInput();
+  const OffsetValueType * offsetTable = inputPtr->GetOffsetTable();
+
+  // The results are the ones of the interpolators, without their bounds
+  // checking.
+  typename InputImageType::IndexType baseIndex;
+  if ( interpolation == BufferInterpolationEnum::NearestNeighbor )
+    {
+    baseIndex.CopyWithRound(index);
+    return static_cast< InterpolatorOutputType >( inputPtr->GetBufferPointer()[inputPtr->ComputeOffset(baseIndex)] );
+    }
+
+  TInterpolatorPrecisionType distance[InputImageDimension];
+  for ( unsigned int i = 0; i < InputImageDimension; ++i )
+    {
+    baseIndex[i] = Math::Floor< IndexValueType >(index[i]);
+    distance[i] = index[i] - static_cast< TInterpolatorPrecisionType >( baseIndex[i] );
+    }
+  const InputPixelType * pixel = inputPtr->GetBufferPointer() + inputPtr->ComputeOffset(baseIndex);
+  return static_cast< InterpolatorOutputType >(
+    Self::InterpolateLinearly(pixel, offsetTable, distance,
+                              std::integral_constant< unsigned int, InputImageDimension >()) );
+}
+
+template< typename TInputImage,
+          typename TOutputImage,
+          typename TInterpolatorPrecisionType,
+          typename TTransformPrecisionType >
+template< unsigned int VDimension >
+auto ResampleImageFilter< TInputImage, TOutputImage, TInterpolatorPrecisionType, TTransformPrecisionType >
+::InterpolateLinearly(const InputPixelType *pixel, const OffsetValueType *offsetTable,
+                      const TInterpolatorPrecisionType *distance,
+                      std::integral_constant< unsigned int, VDimension >) -> InterpolationRealType
+{
+  using LowerDimension = std::integral_constant< unsigned int, VDimension - 1 >;
+
+  // Like LinearInterpolateImageFunction, the upper pixels are only read
+  // when they have a weight.
+  const InterpolationRealType lower = Self::InterpolateLinearly(pixel, offsetTable, distance, LowerDimension());
+  if ( distance[VDimension - 1] <= 0. )
+    {
+    return lower;
+    }
+  const InterpolationRealType upper =
+    Self::InterpolateLinearly(pixel + offsetTable[VDimension - 1], offsetTable, distance, LowerDimension());
+  return lower + ( upper - lower ) * distance[VDimension - 1];
+}
+
+template< typename TInputImage,
+          typename TOutputImage,
+          typename TInterpolatorPrecisionType,
+          typename TTransformPrecisionType >
+template< typename TContinuousIndexFunction, typename TPredicate >
+void
+ResampleImageFilter< TInputImage, TOutputImage, TInterpolatorPrecisionType, TTransformPrecisionType >
+::RestrictToSpan(IndexValueType & spanBegin, IndexValueType & spanEnd,
+                 IndexValueType lineStart, SizeValueType lineSize,
+                 const ContinuousInputIndexType & startIndex, const ContinuousInputIndexType & endIndex,
+                 const ContinuousInputIndexType & lower, const ContinuousInputIndexType & upper,
+                 const TContinuousIndexFunction & continuousIndexAt, const TPredicate & isInside)
+{
+  const IndexValueType lineBegin = spanBegin;
+  const IndexValueType lineEnd = spanEnd;
+
+  // Estimate the span along each dimension, with a margin of one sample
+  // for the rounding errors.
+  for ( unsigned int i = 0; i < ImageDimension && spanBegin < spanEnd; ++i )
+    {
+    const double delta = endIndex[i] - startIndex[i];
+    double       first = lineStart + lineSize * ( lower[i] - startIndex[i] ) / delta;
+    double       last = lineStart + lineSize * ( upper[i] - startIndex[i] ) / delta;
+    if ( !std::isfinite( first ) || !std::isfinite( last ) )
+      {
+      continue;
+      }
+    if ( first > last )
+      {
+      std::swap(first, last);
+      }
+    first = std::min( std::max( std::floor( first ) - 1.0, static_cast< double >( spanBegin ) ),
+                      static_cast< double >( spanEnd ) );
+    last = std::min( std::max( std::ceil( last ) + 2.0, first ), static_cast< double >( spanEnd ) );
+    spanBegin = static_cast< IndexValueType >( first );
+    spanEnd = static_cast< IndexValueType >( last );
+    }
+
+  while ( spanBegin < spanEnd && !isInside( continuousIndexAt( spanBegin ) ) )
+    {
+    ++spanBegin;
+    }
+  while ( spanBegin < spanEnd && !isInside( continuousIndexAt( spanEnd - 1 ) ) )
+    {
+    --spanEnd;
+    }
+
+  // Interpolators that accept the samples outside the buffer extend the
+  // span beyond the estimation.
+  while ( spanBegin > lineBegin && isInside( continuousIndexAt( spanBegin - 1 ) ) )
+    {
+    --spanBegin;
+    }
+  while ( spanEnd < lineEnd && isInside( continuousIndexAt( spanEnd ) ) )
+    {
+    ++spanEnd;
+    }
+}
+
 template< typename TInputImage,
           typename TOutputImage,
           typename TInterpolatorPrecisionType,
@@ -651,6 +1007,8 @@ ResampleImageFilter< TInputImage, TOutputImage, TInterpolatorPrecisionType, TTra
   os << indent << "Extrapolator: " << m_Extrapolator.GetPointer() << std::endl;
   os << indent << "UseReferenceImage: " << ( m_UseReferenceImage ? "On" : "Off" )
      << std::endl;
+  os << indent << "PrecomputeDisplacementField: " << ( m_PrecomputeDisplacementField ? "On" : "Off" )
+     << std::endl;
 }
 } // end namespace itk
 
@@ -0,0 +1,130 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+#include <cstring>
+#include <iostream>
+
+#include "itkAffineTransform.h"
+#include "itkImageFileReader.h"
+#include "itkImageFileWriter.h"
+#include "itkNearestNeighborExtrapolateImageFunction.h"
+#include "itkNearestNeighborInterpolateImageFunction.h"
+#include "itkResampleImageFilter.h"
+#include "itkTestingMacros.h"
+
+/* Further testing of itkResampleImageFilter
+ * Test the scanline spans of the linear transform path, which interpolate
+ * the samples inside the input from its buffer. The input is rotated and
+ * scaled about its center, so that the scanlines cross its borders.
+ * Output is compared with the MD5 of the output computed sample by sample
+ * using the cmake itk_add_test '--compare-MD5' option. Float inputs are
+ * resampled to short images, whose MD5 the test driver can compute.
+ */
+
+template< typename TInputPixel, typename TOutputPixel, unsigned int VDimension >
+int
+ResampleImageTest8( char * argv[] )
+{
+  using ImageType = itk::Image< TInputPixel, VDimension >;
+  using OutputImageType = itk::Image< TOutputPixel, VDimension >;
+  using CoordRepType = double;
+
+  using TransformType = itk::AffineTransform< CoordRepType, VDimension >;
+  using LinearInterpolatorType = itk::LinearInterpolateImageFunction< ImageType, CoordRepType >;
+  using NearestInterpolatorType = itk::NearestNeighborInterpolateImageFunction< ImageType, CoordRepType >;
+  using ExtrapolatorType = itk::NearestNeighborExtrapolateImageFunction< ImageType, CoordRepType >;
+
+  using ReaderType = itk::ImageFileReader< ImageType >;
+  using WriterType = itk::ImageFileWriter< OutputImageType >;
+  using ResampleFilterType = itk::ResampleImageFilter< ImageType, OutputImageType >;
+
+  typename ReaderType::Pointer reader = ReaderType::New();
+  reader->SetFileName( argv[3] );
+  TRY_EXPECT_NO_EXCEPTION( reader->Update() );
+
+  const ImageType * input = reader->GetOutput();
+  const typename ImageType::RegionType & region = input->GetLargestPossibleRegion();
+  typename TransformType::InputPointType center;
+  for ( unsigned int i = 0; i < VDimension; ++i )
+    {
+    center[i] = input->GetOrigin()[i] + 0.5 * input->GetSpacing()[i] * region.GetSize()[i];
+    }
+
+  // Create a rotation and a scaling about the center
+  typename TransformType::Pointer transform = TransformType::New();
+  transform->SetCenter( center );
+  transform->Rotate( 0, 1, std::stod( argv[6] ) );
+  transform->Scale( std::stod( argv[7] ) );
+
+  // Create and configure a resampling filter
+  typename ResampleFilterType::Pointer resample = ResampleFilterType::New();
+  resample->SetInput( input );
+  resample->SetTransform( transform );
+  if ( !strcmp( argv[5], "nearest" ) )
+    {
+    resample->SetInterpolator( NearestInterpolatorType::New() );
+    }
+  else
+    {
+    resample->SetInterpolator( LinearInterpolatorType::New() );
+    }
+  if ( std::stoi( argv[8] ) )
+    {
+    resample->SetExtrapolator( ExtrapolatorType::New() );
+    }
+  resample->SetOutputParametersFromImage( input );
+
+  typename WriterType::Pointer writer = WriterType::New();
+  writer->SetFileName( argv[4] );
+  writer->SetInput( resample->GetOutput() );
+
+  // Run the resampling filter
+  TRY_EXPECT_NO_EXCEPTION( writer->Update() );
+
+  return EXIT_SUCCESS;
+}
+
+int itkResampleImageTest8( int argc, char * argv[] )
+{
+  if ( argc < 9 )
+    {
+    std::cerr << "Usage: " << argv[0];
+    std::cerr << " imageDimension pixelType(uchar|float) inputImage resampledImage"
+              << " interpolator(linear|nearest) angle scale useExtrapolator" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  const unsigned int dimension = std::stoi( argv[1] );
+  const char *       pixelType = argv[2];
+
+  if ( dimension == 2 && !strcmp( pixelType, "uchar" ) )
+    {
+    return ResampleImageTest8< unsigned char, unsigned char, 2 >( argv );
+    }
+  if ( dimension == 2 && !strcmp( pixelType, "float" ) )
+    {
+    return ResampleImageTest8< float, short, 2 >( argv );
+    }
+  if ( dimension == 3 && !strcmp( pixelType, "float" ) )
+    {
+    return ResampleImageTest8< float, short, 3 >( argv );
+    }
+
+  std::cerr << "Unsupported image type: " << dimension << "D " << pixelType << std::endl;
+  return EXIT_FAILURE;
+}
@@ -0,0 +1,169 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+#include <atomic>
+#include <cmath>
+#include <iostream>
+
+#include "itkAffineTransform.h"
+#include "itkBSplineTransform.h"
+#include "itkCompositeTransform.h"
+#include "itkImageFileReader.h"
+#include "itkImageFileWriter.h"
+#include "itkResampleImageFilter.h"
+#include "itkTestingMacros.h"
+
+/* Further testing of itkResampleImageFilter
+ * Test the displacement field which PrecomputeDisplacementFieldOn()
+ * evaluates from a composite of an affine and a B-spline transform. The
+ * field is reused while the transform is not modified, and computed again
+ * when one of its transforms is modified.
+ * Output is compared with the MD5 of the output computed without the field
+ * using the cmake itk_add_test '--compare-MD5' option.
+ */
+
+namespace
+{
+// A B-spline transform which counts the points it transforms.
+class CountingBSplineTransform : public itk::BSplineTransform< double, 2, 3 >
+{
+public:
+  ITK_DISALLOW_COPY_AND_ASSIGN(CountingBSplineTransform);
+
+  using Self = CountingBSplineTransform;
+  using Superclass = itk::BSplineTransform< double, 2, 3 >;
+  using Pointer = itk::SmartPointer< Self >;
+  using ConstPointer = itk::SmartPointer< const Self >;
+
+  itkNewMacro(Self);
+  itkTypeMacro(CountingBSplineTransform, BSplineTransform);
+
+  using Superclass::TransformPoint;
+  OutputPointType TransformPoint( const InputPointType & point ) const override
+  {
+    ++m_NumberOfTransformedPoints;
+    return Superclass::TransformPoint( point );
+  }
+
+  itk::SizeValueType GetNumberOfTransformedPoints() const
+  {
+    return m_NumberOfTransformedPoints;
+  }
+
+protected:
+  CountingBSplineTransform() = default;
+  ~CountingBSplineTransform() override = default;
+
+private:
+  mutable std::atomic< itk::SizeValueType > m_NumberOfTransformedPoints{ 0 };
+};
+}
+
+int itkResampleImageTest9( int argc, char * argv[] )
+{
+  if ( argc < 3 )
+    {
+    std::cerr << "Usage: " << argv[0];
+    std::cerr << " inputImage resampledImage" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  constexpr unsigned int NDimensions = 2;
+
+  using PixelType = unsigned char;
+  using ImageType = itk::Image< PixelType, NDimensions >;
+  using CoordRepType = double;
+
+  using AffineTransformType = itk::AffineTransform< CoordRepType, NDimensions >;
+  using CompositeTransformType = itk::CompositeTransform< CoordRepType, NDimensions >;
+
+  using ReaderType = itk::ImageFileReader< ImageType >;
+  using WriterType = itk::ImageFileWriter< ImageType >;
+  using ResampleFilterType = itk::ResampleImageFilter< ImageType, ImageType >;
+
+  ReaderType::Pointer reader = ReaderType::New();
+  reader->SetFileName( argv[1] );
+  TRY_EXPECT_NO_EXCEPTION( reader->Update() );
+
+  const ImageType::SizeType & size = reader->GetOutput()->GetLargestPossibleRegion().GetSize();
+  const itk::SizeValueType    numberOfPixels = size[0] * size[1];
+
+  // Create a composite of an affine and a B-spline transform over the image
+  AffineTransformType::Pointer affineTransform = AffineTransformType::New();
+  AffineTransformType::InputPointType center;
+  center[0] = 0.5 * size[0];
+  center[1] = 0.5 * size[1];
+  affineTransform->SetCenter( center );
+  affineTransform->Rotate2D( 0.2 );
+  affineTransform->Scale( 1.1 );
+
+  CountingBSplineTransform::Pointer bsplineTransform = CountingBSplineTransform::New();
+  CountingBSplineTransform::PhysicalDimensionsType physicalDimensions;
+  physicalDimensions[0] = size[0];
+  physicalDimensions[1] = size[1];
+  CountingBSplineTransform::MeshSizeType meshSize;
+  meshSize.Fill( 4 );
+  bsplineTransform->SetTransformDomainPhysicalDimensions( physicalDimensions );
+  bsplineTransform->SetTransformDomainMeshSize( meshSize );
+  CountingBSplineTransform::ParametersType parameters( bsplineTransform->GetNumberOfParameters() );
+  for ( unsigned int n = 0; n < parameters.Size(); ++n )
+    {
+    parameters[n] = 5.0 * std::sin( 0.7 * n );
+    }
+  bsplineTransform->SetParametersByValue( parameters );
+
+  CompositeTransformType::Pointer transform = CompositeTransformType::New();
+  transform->AddTransform( affineTransform );
+  transform->AddTransform( bsplineTransform );
+
+  // Create and configure a resampling filter
+  ResampleFilterType::Pointer resample = ResampleFilterType::New();
+
+  EXERCISE_BASIC_OBJECT_METHODS( resample, ResampleImageFilter, ImageToImageFilter );
+
+  TEST_SET_GET_BOOLEAN( resample, PrecomputeDisplacementField, false );
+  TEST_SET_GET_BOOLEAN( resample, PrecomputeDisplacementField, true );
+
+  resample->SetInput( reader->GetOutput() );
+  resample->SetTransform( transform );
+  resample->SetOutputParametersFromImage( reader->GetOutput() );
+
+  WriterType::Pointer writer = WriterType::New();
+  writer->SetFileName( argv[2] );
+  writer->SetInput( resample->GetOutput() );
+
+  // Run the resampling filter, which evaluates the transform once per pixel
+  TRY_EXPECT_NO_EXCEPTION( writer->Update() );
+  TEST_EXPECT_EQUAL( bsplineTransform->GetNumberOfTransformedPoints(), numberOfPixels );
+
+  // The field is reused when the filter runs again
+  resample->Modified();
+  TRY_EXPECT_NO_EXCEPTION( resample->Update() );
+  TEST_EXPECT_EQUAL( bsplineTransform->GetNumberOfTransformedPoints(), numberOfPixels );
+
+  // The field is computed again when a transform of the composite
+  // transform is modified. The pipeline only checks the composite
+  // transform, so the filter is modified too.
+  bsplineTransform->Modified();
+  resample->Modified();
+  TRY_EXPECT_NO_EXCEPTION( resample->Update() );
+  TEST_EXPECT_EQUAL( bsplineTransform->GetNumberOfTransformedPoints(), 2 * numberOfPixels );
+
+  std::cout << "Test finished." << std::endl;
+  return EXIT_SUCCESS;
+}
@@ -23,8 +23,10 @@
 #include "itkImageScanlineIterator.h"
 #include "itkConstShapedNeighborhoodIterator.h"
 #include "itkConnectedComponentAlgorithm.h"
+#include "itkLabelMapRunMerger.h"
 #include "itkProgressReporter.h"
 #include "itkProgressTransformer.h"
+#include <algorithm>
 
 namespace itk
 {
@@ -117,7 +119,6 @@ BinaryImageToLabelMapFilter< TInputImage, TOutputImage >
   // AfterThreadedGenerateData
   typename TInputImage::ConstPointer input = this->GetInput();
   m_NumberOfObjects = this->CreateConsecutive(m_OutputBackgroundValue);
-  ProgressReporter progress(this, 0, linecount, 25, 0.75f, 0.25f);
   // check for overflow exception here
   if ( m_NumberOfObjects > static_cast< SizeValueType >( NumericTraits< OutputPixelType >::max() ) )
     {
@@ -125,21 +126,38 @@ BinaryImageToLabelMapFilter< TInputImage, TOutputImage >
       << static_cast< typename NumericTraits< OutputImagePixelType >::PrintType >( NumericTraits< OutputPixelType >::max() ) << ").");
     }
 
-  for ( SizeValueType thisIdx = 0; thisIdx < linecount; thisIdx++ )
+  // now fill the labelled sections: each work unit collects the runs of
+  // consecutive lines, and the runs are then merged by label in parallel
+  const SizeValueType numberOfChunks =
+    std::max< SizeValueType >( 1, std::min< SizeValueType >( this->GetNumberOfWorkUnits(), linecount ) );
+  LabelMapRunMerger< OutputImageType > runMerger;
+  runMerger.Initialize( output, numberOfChunks );
+
+  ProgressTransformer progress4( 0.75f, 0.9f, this );
+  multiThreader->ParallelizeArray(
+    0, numberOfChunks,
+    [this, &runMerger, linecount, numberOfChunks]( SizeValueType chunk )
     {
-    // now fill the labelled sections
-    LineEncodingConstIterator cIt = this->m_LineMap[thisIdx].begin();
-    const LineEncodingConstIterator cEnd = this->m_LineMap[thisIdx].end();
+      const SizeValueType firstLine = chunk * linecount / numberOfChunks;
+      const SizeValueType endLine = ( chunk + 1 ) * linecount / numberOfChunks;
+      for ( SizeValueType thisIdx = firstLine; thisIdx < endLine; thisIdx++ )
+        {
+        LineEncodingConstIterator cIt = this->m_LineMap[thisIdx].begin();
+        const LineEncodingConstIterator cEnd = this->m_LineMap[thisIdx].end();
 
-    while ( cIt != cEnd )
-      {
-      const InternalLabelType Ilab = this->LookupSet(cIt->label);
-      const OutputPixelType lab = this->m_Consecutive[Ilab];
-      output->SetLine(cIt->where, cIt->length, lab);
-      ++cIt;
-      }
-    progress.CompletedPixel();
-    }
+        while ( cIt != cEnd )
+          {
+          const InternalLabelType Ilab = this->LookupSet(cIt->label);
+          const OutputPixelType lab = this->m_Consecutive[Ilab];
+          runMerger.AddRun( chunk, cIt->where, cIt->length, lab );
+          ++cIt;
+          }
+        }
+    },
+    progress4.GetProcessObject());
+
+  runMerger.Merge( multiThreader );
+  this->UpdateProgress( 1.0f );
 
   //clear and make sure memory is freed
   std::deque<WorkUnitData>().swap(this->m_WorkUnitResults);
@@ -20,6 +20,7 @@
 
 #include "itkImageToImageFilter.h"
 #include "itkLabelMap.h"
+#include "itkLabelMapRunMerger.h"
 #include "itkLabelObject.h"
 
 namespace itk
@@ -30,6 +31,10 @@ namespace itk
  * LabelImageToLabelMapFilter converts a label image to a label collection image.
  * The labels are the same in the input and the output image.
  *
+ * Each thread records the runs of its part of the image in its own label
+ * map, without any lock. The label maps are then merged in parallel, see
+ * LabelMapRunMerger.
+ *
  * \author Gaetan Lehmann. Biologie du Developpement et de la Reproduction, INRA de Jouy-en-Josas, France.
  *
  * This implementation was taken from the Insight Journal paper:
@@ -125,7 +130,8 @@ protected:
 private:
   OutputImagePixelType m_BackgroundValue;
 
-  typename std::vector< OutputImagePointer > m_TemporaryImages;
+  /** The runs found by each thread */
+  LabelMapRunMerger< OutputImageType > m_RunMerger;
 }; // end of class
 } // end namespace itk
 
@@ -63,25 +63,9 @@ void
 LabelImageToLabelMapFilter< TInputImage, TOutputImage >
 ::BeforeThreadedGenerateData()
 {
-  // init the temp images - one per thread
-  m_TemporaryImages.resize( this->GetNumberOfWorkUnits() );
-
-  for ( ThreadIdType i = 0; i < this->GetNumberOfWorkUnits(); i++ )
-    {
-    if ( i == 0 )
-      {
-      // the first one is the output image
-      m_TemporaryImages[0] = this->GetOutput();
-      }
-    else
-      {
-      // the other must be created
-      m_TemporaryImages[i] = OutputImageType::New();
-      }
-
-    // set the minimum data needed to create the objects properly
-    m_TemporaryImages[i]->SetBackgroundValue(m_BackgroundValue);
-    }
+  // one run buffer per thread - the first one is the output image
+  this->GetOutput()->SetBackgroundValue(m_BackgroundValue);
+  m_RunMerger.Initialize( this->GetOutput(), this->GetNumberOfWorkUnits() );
 }
 
 template< typename TInputImage, typename TOutputImage >
@@ -116,7 +100,7 @@ LabelImageToLabelMapFilter< TInputImage, TOutputImage >
           ++it;
           }
         // create the run length object to go in the vector
-        m_TemporaryImages[threadId]->SetLine(idx, length, value);
+        m_RunMerger.AddRun(threadId, idx, length, value);
         }
       else
         {
@@ -132,38 +116,8 @@ void
 LabelImageToLabelMapFilter< TInputImage, TOutputImage >
 ::AfterThreadedGenerateData()
 {
-  OutputImageType *output = this->GetOutput();
-
-  // merge the lines from the temporary images in the output image
-  // don't use the first image - that's the output image
-  for ( ThreadIdType i = 1; i < this->GetNumberOfWorkUnits(); i++ )
-    {
-    for ( typename OutputImageType::Iterator it( m_TemporaryImages[i] );
-          ! it.IsAtEnd();
-          ++it )
-      {
-      LabelObjectType *labelObject = it.GetLabelObject();
-      if ( output->HasLabel( labelObject->GetLabel() ) )
-        {
-        // merge the lines in the output's object
-        LabelObjectType * lo = output->GetLabelObject( labelObject->GetLabel() );
-        typename LabelObjectType::ConstLineIterator lit( labelObject );
-        while( ! lit.IsAtEnd() )
-          {
-          lo->AddLine( lit.GetLine() );
-          ++lit;
-          }
-        }
-      else
-        {
-        // simply take the object
-        output->AddLabelObject(labelObject);
-        }
-      }
-    }
-
-  // release the data in the temp images
-  m_TemporaryImages.clear();
+  // merge the runs of the threads in the output image
+  m_RunMerger.Merge( this->GetMultiThreader() );
 }
 
 template< typename TInputImage, typename TOutputImage >
@@ -21,6 +21,7 @@
 #include "itkImageBase.h"
 #include "itkWeakPointer.h"
 #include <map>
+#include <type_traits>
 
 namespace itk
 {
@@ -463,6 +464,23 @@ private:
   LabelObjectContainerType m_LabelObjectContainer;
   LabelType                m_BackgroundValue;
 
+  /** Direct access to the label objects for the integer labels. The entry
+   * label - m_DenseLabelIndexOrigin points to the object with that label, or
+   * is null. The index is dropped, and the map is searched again, when the
+   * labels are too sparse for it to stay small. */
+  using DenseLabelIndexType = std::vector< LabelObjectType * >;
+
+  DenseLabelIndexType m_DenseLabelIndex;
+  LabelType           m_DenseLabelIndexOrigin{};
+  bool                m_UseDenseLabelIndex{ std::is_integral< LabelType >::value };
+
+  /** Return the label object with the given label, or nullptr. */
+  LabelObjectType * FindLabelObject( const LabelType & label ) const;
+
+  void AddToDenseLabelIndex( const LabelType & label, LabelObjectType * labelObject );
+
+  void ResetDenseLabelIndex();
+
   void AddPixel( const LabelObjectContainerIterator& it,
                  const IndexType& idx,
                  const LabelType& iLabel );
@@ -94,6 +94,9 @@ LabelMap< TLabelObject >
     m_LabelObjectContainer.clear();
     LabelObjectContainerType newLabelObjectContainer( imgData->m_LabelObjectContainer );
     std::swap( m_LabelObjectContainer, newLabelObjectContainer );
+    m_DenseLabelIndex = imgData->m_DenseLabelIndex;
+    m_DenseLabelIndexOrigin = imgData->m_DenseLabelIndexOrigin;
+    m_UseDenseLabelIndex = imgData->m_UseDenseLabelIndex;
     }
   m_BackgroundValue = imgData->m_BackgroundValue;
 }
@@ -133,15 +136,15 @@ LabelMap< TLabelObject >
                       << static_cast< typename NumericTraits< LabelType >::PrintType >( label )
                       << " is the background label.");
     }
-  auto it = m_LabelObjectContainer.find( label );
-  if ( it == m_LabelObjectContainer.end() )
+  LabelObjectType * labelObject = this->FindLabelObject( label );
+  if ( labelObject == nullptr )
     {
     itkExceptionMacro(<< "No label object with label "
                       << static_cast< typename NumericTraits< LabelType >::PrintType >( label )
                       << ".");
     }
 
-  return it->second;
+  return labelObject;
 }
 
 
@@ -156,15 +159,15 @@ LabelMap< TLabelObject >
                       << static_cast< typename NumericTraits< LabelType >::PrintType >( label )
                       << " is the background label.");
     }
-  auto it = m_LabelObjectContainer.find( label );
-  if ( it == m_LabelObjectContainer.end() )
+  LabelObjectType * labelObject = this->FindLabelObject( label );
+  if ( labelObject == nullptr )
     {
     itkExceptionMacro(<< "No label object with label "
                       << static_cast< typename NumericTraits< LabelType >::PrintType >( label )
                       << ".");
     }
 
-  return it->second;
+  return labelObject;
 }
 
 
@@ -173,7 +176,102 @@ bool
 LabelMap< TLabelObject >
 ::HasLabel(const LabelType label) const
 {
-  return m_LabelObjectContainer.find(label) != m_LabelObjectContainer.end();
+  return this->FindLabelObject(label) != nullptr;
+}
+
+
+template< typename TLabelObject >
+typename LabelMap< TLabelObject >::LabelObjectType *
+LabelMap< TLabelObject >
+::FindLabelObject(const LabelType & label) const
+{
+  if ( m_UseDenseLabelIndex )
+    {
+    // the unsigned difference is out of range for the labels below the origin
+    const auto offset = static_cast< SizeValueType >( label ) - static_cast< SizeValueType >( m_DenseLabelIndexOrigin );
+    if ( offset < m_DenseLabelIndex.size() )
+      {
+      return m_DenseLabelIndex[offset];
+      }
+    return nullptr;
+    }
+
+  auto it = m_LabelObjectContainer.find( label );
+  if ( it == m_LabelObjectContainer.end() )
+    {
+    return nullptr;
+    }
+  return it->second.GetPointer();
+}
+
+
+template< typename TLabelObject >
+void
+LabelMap< TLabelObject >
+::AddToDenseLabelIndex(const LabelType & label, LabelObjectType * labelObject)
+{
+  if ( !m_UseDenseLabelIndex )
+    {
+    return;
+    }
+  if ( m_DenseLabelIndex.empty() )
+    {
+    m_DenseLabelIndexOrigin = label;
+    m_DenseLabelIndex.assign( 1, labelObject );
+    return;
+    }
+
+  // the index may hold a few null entries per label object, not more
+  const SizeValueType maximumSize = 4 * static_cast< SizeValueType >( m_LabelObjectContainer.size() ) + 1024;
+  const auto size = static_cast< SizeValueType >( m_DenseLabelIndex.size() );
+  if ( label < m_DenseLabelIndexOrigin )
+    {
+    const SizeValueType growth =
+      static_cast< SizeValueType >( m_DenseLabelIndexOrigin ) - static_cast< SizeValueType >( label );
+    if ( growth >= maximumSize || size + growth > maximumSize )
+      {
+      m_DenseLabelIndex = DenseLabelIndexType();
+      m_UseDenseLabelIndex = false;
+      return;
+      }
+    // grow geometrically, as at the back, so that the labels added in
+    // decreasing order do not move the whole index each time. The room left
+    // below the label stays within the range of the label type.
+    SizeValueType room = std::min( std::max( growth, size ), maximumSize - size );
+    room = std::min( room, static_cast< SizeValueType >( m_DenseLabelIndexOrigin )
+                           - static_cast< SizeValueType >( NumericTraits< LabelType >::NonpositiveMin() ) );
+    DenseLabelIndexType denseLabelIndex( room + size, nullptr );
+    std::copy( m_DenseLabelIndex.begin(), m_DenseLabelIndex.end(), denseLabelIndex.begin() + room );
+    m_DenseLabelIndex.swap( denseLabelIndex );
+    m_DenseLabelIndexOrigin =
+      static_cast< LabelType >( static_cast< SizeValueType >( m_DenseLabelIndexOrigin ) - room );
+    m_DenseLabelIndex[room - growth] = labelObject;
+    return;
+    }
+
+  const SizeValueType offset =
+    static_cast< SizeValueType >( label ) - static_cast< SizeValueType >( m_DenseLabelIndexOrigin );
+  if ( offset >= size )
+    {
+    if ( offset >= maximumSize )
+      {
+      m_DenseLabelIndex = DenseLabelIndexType();
+      m_UseDenseLabelIndex = false;
+      return;
+      }
+    m_DenseLabelIndex.resize( offset + 1, nullptr );
+    }
+  m_DenseLabelIndex[offset] = labelObject;
+}
+
+
+template< typename TLabelObject >
+void
+LabelMap< TLabelObject >
+::ResetDenseLabelIndex()
+{
+  m_DenseLabelIndex = DenseLabelIndexType();
+  m_UseDenseLabelIndex = std::is_integral< LabelType >::value;
 }
 
 
@@ -293,9 +391,17 @@ LabelMap< TLabelObject >
     return;
     }
 
-  LabelObjectContainerIterator it = m_LabelObjectContainer.find(label);
-
-  this->AddPixel( it, idx, label );
+  LabelObjectType * labelObject = this->FindLabelObject(label);
+  if ( labelObject != nullptr )
+    {
+    // the label already exist - add the pixel to it
+    labelObject->AddIndex(idx);
+    this->Modified();
+    }
+  else
+    {
+    this->AddPixel( m_LabelObjectContainer.end(), idx, label );
+    }
 }
 
 
@@ -384,22 +490,22 @@ LabelMap< TLabelObject >
     return;
     }
 
-  auto it = m_LabelObjectContainer.find(label);
+  LabelObjectType * labelObject = this->FindLabelObject(label);
 
-  if ( it != m_LabelObjectContainer.end() )
+  if ( labelObject != nullptr )
     {
     // the label already exist - add the pixel to it
-    ( *it ).second->AddLine(idx, length);
+    labelObject->AddLine(idx, length);
     this->Modified();
     }
   else
     {
     // the label does not exist yet - create a new one
-    LabelObjectPointerType labelObject = LabelObjectType::New();
-    labelObject->SetLabel(label);
-    labelObject->AddLine(idx, length);
+    LabelObjectPointerType newLabelObject = LabelObjectType::New();
+    newLabelObject->SetLabel(label);
+    newLabelObject->AddLine(idx, length);
     // Modified() is called in AddLabelObject()
-    this->AddLabelObject(labelObject);
+    this->AddLabelObject(newLabelObject);
     }
 }
 
@@ -431,6 +537,7 @@ LabelMap< TLabelObject >
   itkAssertOrThrowMacro( ( labelObject != nullptr ), "Input LabelObject can't be Null" );
 
   m_LabelObjectContainer[labelObject->GetLabel()] = labelObject;
+  this->AddToDenseLabelIndex( labelObject->GetLabel(), labelObject );
   this->Modified();
 }
 
@@ -523,7 +630,17 @@ LabelMap< TLabelObject >
                       << static_cast< typename NumericTraits< LabelType >::PrintType >( label )
                       << " is the background label.");
     }
-  m_LabelObjectContainer.erase(label);
+  if ( m_LabelObjectContainer.erase(label) != 0 )
+    {
+    if ( m_LabelObjectContainer.empty() )
+      {
+      this->ResetDenseLabelIndex();
+      }
+    else if ( m_UseDenseLabelIndex )
+      {
+      m_DenseLabelIndex[static_cast< SizeValueType >( label ) - static_cast< SizeValueType >( m_DenseLabelIndexOrigin )] = nullptr;
+      }
+    }
   this->Modified();
 }
 
@@ -536,6 +653,7 @@ LabelMap< TLabelObject >
   if ( !m_LabelObjectContainer.empty() )
     {
     m_LabelObjectContainer.clear();
+    this->ResetDenseLabelIndex();
     this->Modified();
     }
 }
@@ -131,6 +131,7 @@ protected:
 private:
   typename InputImageType::Iterator m_LabelObjectIterator;
   float                             m_InverseNumberOfLabelObjects{ 1.0f };
+  SizeValueType                     m_NumberOfLabelObjects{ 0 };
   SizeValueType                     m_NumberOfLabelObjectsProcessed{ 1 };
 };
 } // end namespace itk
@@ -28,7 +28,9 @@
 #ifndef itkLabelMapFilter_hxx
 #define itkLabelMapFilter_hxx
 #include "itkLabelMapFilter.h"
+#include <algorithm>
 #include <mutex>
+#include <vector>
 
 namespace itk
 {
@@ -80,7 +82,7 @@ LabelMapFilter< TInputImage, TOutputImage >
     {
     m_InverseNumberOfLabelObjects = 1.0f/this->GetLabelMap()->GetNumberOfLabelObjects();
     }
-  //TODO: set number of work units to be equal to GetNumberOfLabelObjects()
+  m_NumberOfLabelObjects = this->GetLabelMap()->GetNumberOfLabelObjects();
   m_NumberOfLabelObjectsProcessed = 0;
 }
 
@@ -97,9 +99,11 @@ void
 LabelMapFilter< TInputImage, TOutputImage >
 ::DynamicThreadedGenerateData( const OutputImageRegionType & )
 {
+  std::vector< LabelObjectType * > labelObjects;
+
   while ( true )
     {
-    LabelObjectType *labelObject;
+    labelObjects.clear();
     // begin mutex lock
     {
     std::lock_guard< std::mutex > lock( m_LabelObjectContainerLock );
@@ -110,32 +114,42 @@ LabelMapFilter< TInputImage, TOutputImage >
       return;
       }
 
-    // get the label object
-    labelObject = m_LabelObjectIterator.GetLabelObject();
-
-    // increment the iterator now, so it will not be invalidated if the object
-    // is destroyed
-    ++m_LabelObjectIterator;
-    ++m_NumberOfLabelObjectsProcessed;
+    // take several objects at once, so the threads don't fight for the lock
+    // when the objects are small. The batches get smaller as the remaining
+    // work decreases, to keep the threads busy until the end.
+    const SizeValueType remaining = m_NumberOfLabelObjects > m_NumberOfLabelObjectsProcessed
+                                    ? m_NumberOfLabelObjects - m_NumberOfLabelObjectsProcessed : 1;
+    const SizeValueType batchSize = std::max< SizeValueType >( 1,
+      std::min< SizeValueType >( 256, remaining / ( 4 * this->GetNumberOfWorkUnits() ) ) );
+
+    // get the label objects and increment the iterator now, so it will not be
+    // invalidated if an object is destroyed
+    while ( labelObjects.size() < batchSize && !m_LabelObjectIterator.IsAtEnd() )
+      {
+      labelObjects.push_back( m_LabelObjectIterator.GetLabelObject() );
+      ++m_LabelObjectIterator;
+      }
+    m_NumberOfLabelObjectsProcessed += labelObjects.size();
 
     // unlock the mutex, so the other threads can get an object
     }
     // end mutex lock
 
-
-    // and run the user defined method for that object
-    this->ThreadedProcessLabelObject(labelObject);
-
-    // all threads needs to check the abort flag
-    if ( this->GetAbortGenerateData() )
+    for ( LabelObjectType * labelObject : labelObjects )
       {
-      std::string    msg;
-      ProcessAborted e(__FILE__, __LINE__);
-      msg += "Object " + std::string(this->GetNameOfClass() ) + ": AbortGenerateDataOn";
-      e.SetDescription(msg);
-      throw e;
+      // and run the user defined method for that object
+      this->ThreadedProcessLabelObject(labelObject);
+
+      // all threads needs to check the abort flag
+      if ( this->GetAbortGenerateData() )
+        {
+        std::string    msg;
+        ProcessAborted e(__FILE__, __LINE__);
+        msg += "Object " + std::string(this->GetNameOfClass() ) + ": AbortGenerateDataOn";
+        e.SetDescription(msg);
+        throw e;
+        }
       }
-
     }
 }
 
@@ -0,0 +1,95 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef itkLabelMapRunMerger_h
+#define itkLabelMapRunMerger_h
+
+#include "itkMultiThreaderBase.h"
+#include <utility>
+#include <vector>
+
+namespace itk
+{
+/** \class LabelMapRunMerger
+ * \brief Collect the runs found by several threads and merge them in a LabelMap.
+ *
+ * Each thread adds the runs it finds to its own buffer, without any lock.
+ * A buffer is a LabelMap, so the runs are grouped by label as they are
+ * added. The first buffer is the output LabelMap itself.
+ *
+ * Merge() then moves the lines of the other buffers to the output in
+ * parallel: the labels are split in ranges of about the same number of label
+ * objects, and each range is merged from all the buffers by a single thread.
+ * Only the insertion of the new labels in the output is serial.
+ *
+ * The lines of a label object are in the order of the buffers, and, for a
+ * given buffer, in the order in which they were added. A filter which gives
+ * the buffers the consecutive parts of the image, and adds the runs in the
+ * scanning order, thus gets the same label objects as a serial scan.
+ *
+ * \sa LabelImageToLabelMapFilter, BinaryImageToLabelMapFilter
+ * \ingroup LabeledImageObject
+ * \ingroup ITKLabelMap
+ */
+template< typename TLabelMap >
+class LabelMapRunMerger
+{
+public:
+  using LabelMapType = TLabelMap;
+  using LabelMapPointer = typename LabelMapType::Pointer;
+  using LabelObjectType = typename LabelMapType::LabelObjectType;
+  using LabelType = typename LabelObjectType::LabelType;
+  using IndexType = typename LabelObjectType::IndexType;
+  using LengthType = typename LabelObjectType::LengthType;
+
+  /** Use the given label map as the first buffer, and create the other
+   * ones. The runs with the background label of the output are ignored. */
+  void Initialize( LabelMapType * output, SizeValueType numberOfBuffers );
+
+  SizeValueType GetNumberOfBuffers() const
+  {
+    return static_cast< SizeValueType >( m_Buffers.size() );
+  }
+
+  /** Add a run to a buffer. Several threads may add runs at the same time,
+   * as long as they use different buffers. */
+  void AddRun( SizeValueType buffer, const IndexType & index, const LengthType & length, const LabelType & label )
+  {
+    m_Buffers[buffer]->SetLine( index, length, label );
+  }
+
+  /** Merge all the buffers in the output, and release them. */
+  void Merge( MultiThreaderBase * multiThreader );
+
+private:
+  using LabelObjectVectorType = std::vector< LabelObjectType * >;
+  using RangeType = std::pair< typename LabelObjectVectorType::const_iterator,
+                               typename LabelObjectVectorType::const_iterator >;
+
+  /** Merge the label objects of a range of labels. The objects which must
+   * be added to the output are returned in newLabelObjects. */
+  void MergeRanges( std::vector< RangeType > ranges, LabelObjectVectorType & newLabelObjects ) const;
+
+  std::vector< LabelMapPointer > m_Buffers;
+};
+} // end namespace itk
+
+#ifndef ITK_MANUAL_INSTANTIATION
+#include "itkLabelMapRunMerger.hxx"
+#endif
+
+#endif
@@ -0,0 +1,201 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef itkLabelMapRunMerger_hxx
+#define itkLabelMapRunMerger_hxx
+
+#include "itkLabelMapRunMerger.h"
+#include <algorithm>
+#include <utility>
+
+namespace itk
+{
+template< typename TLabelMap >
+void
+LabelMapRunMerger< TLabelMap >
+::Initialize( LabelMapType * output, SizeValueType numberOfBuffers )
+{
+  m_Buffers.assign( 1, output );
+  for ( SizeValueType i = 1; i < numberOfBuffers; ++i )
+    {
+    LabelMapPointer buffer = LabelMapType::New();
+    buffer->SetBackgroundValue( output->GetBackgroundValue() );
+    m_Buffers.push_back( buffer );
+    }
+}
+
+
+template< typename TLabelMap >
+void
+LabelMapRunMerger< TLabelMap >
+::Merge( MultiThreaderBase * multiThreader )
+{
+  const SizeValueType numberOfBuffers = this->GetNumberOfBuffers();
+  if ( numberOfBuffers < 2 )
+    {
+    m_Buffers.clear();
+    return;
+    }
+  LabelMapType * output = m_Buffers[0];
+
+  // the label objects of each buffer, in the label order. The buffers keep
+  // them alive until the end of the merge.
+  std::vector< LabelObjectVectorType > labelObjects( numberOfBuffers );
+  multiThreader->ParallelizeArray( 0, numberOfBuffers,
+    [this, &labelObjects]( SizeValueType i )
+    {
+      labelObjects[i].reserve( m_Buffers[i]->GetNumberOfLabelObjects() );
+      for ( typename LabelMapType::Iterator it( m_Buffers[i] ); !it.IsAtEnd(); ++it )
+        {
+        labelObjects[i].push_back( it.GetLabelObject() );
+        }
+    },
+    nullptr );
+
+  // choose the bounds of the label ranges from a sample of the labels, so
+  // that the ranges have about the same number of label objects
+  SizeValueType numberOfLabelObjects = 0;
+  for ( const LabelObjectVectorType & bufferLabelObjects : labelObjects )
+    {
+    numberOfLabelObjects += bufferLabelObjects.size();
+    }
+  const SizeValueType numberOfRanges =
+    std::max< SizeValueType >( 1, std::min< SizeValueType >( 4 * multiThreader->GetNumberOfWorkUnits(),
+                                                             numberOfLabelObjects ) );
+  const SizeValueType samplesPerBuffer = 8 * numberOfRanges;
+  std::vector< LabelType > samples;
+  for ( const LabelObjectVectorType & bufferLabelObjects : labelObjects )
+    {
+    const SizeValueType size = bufferLabelObjects.size();
+    const SizeValueType step = std::max< SizeValueType >( 1, size / samplesPerBuffer );
+    for ( SizeValueType i = step / 2; i < size; i += step )
+      {
+      samples.push_back( bufferLabelObjects[i]->GetLabel() );
+      }
+    }
+  std::sort( samples.begin(), samples.end() );
+  std::vector< LabelType > bounds;
+  for ( SizeValueType r = 1; r < numberOfRanges && !samples.empty(); ++r )
+    {
+    const LabelType & bound = samples[r * samples.size() / numberOfRanges];
+    if ( bounds.empty() || bounds.back() < bound )
+      {
+      bounds.push_back( bound );
+      }
+    }
+
+  // merge the ranges of labels in parallel. The label objects are not
+  // shared between the ranges, so no lock is needed.
+  const SizeValueType numberOfBounds = bounds.size();
+  std::vector< LabelObjectVectorType > newLabelObjects( numberOfBounds + 1 );
+  multiThreader->ParallelizeArray( 0, numberOfBounds + 1,
+    [this, &labelObjects, &bounds, &newLabelObjects, numberOfBounds]( SizeValueType r )
+    {
+      auto labelLess = []( const LabelObjectType * labelObject, const LabelType & label )
+        {
+        return labelObject->GetLabel() < label;
+        };
+      std::vector< RangeType > ranges;
+      ranges.reserve( labelObjects.size() );
+      for ( const LabelObjectVectorType & bufferLabelObjects : labelObjects )
+        {
+        auto begin = bufferLabelObjects.begin();
+        auto end = bufferLabelObjects.end();
+        if ( r > 0 )
+          {
+          begin = std::lower_bound( begin, end, bounds[r - 1], labelLess );
+          }
+        if ( r < numberOfBounds )
+          {
+          end = std::lower_bound( begin, end, bounds[r], labelLess );
+          }
+        ranges.push_back( RangeType( begin, end ) );
+        }
+      this->MergeRanges( std::move( ranges ), newLabelObjects[r] );
+    },
+    nullptr );
+
+  // add the new labels to the output, in the label order
+  for ( const LabelObjectVectorType & rangeLabelObjects : newLabelObjects )
+    {
+    for ( LabelObjectType * labelObject : rangeLabelObjects )
+      {
+      output->AddLabelObject( labelObject );
+      }
+    }
+
+  m_Buffers.clear();
+}
+
+
+template< typename TLabelMap >
+void
+LabelMapRunMerger< TLabelMap >
+::MergeRanges( std::vector< RangeType > ranges, LabelObjectVectorType & newLabelObjects ) const
+{
+  while ( true )
+    {
+    // the smallest label not merged yet
+    bool      found = false;
+    LabelType label{};
+    for ( const RangeType & range : ranges )
+      {
+      if ( range.first != range.second && ( !found || ( *range.first )->GetLabel() < label ) )
+        {
+        label = ( *range.first )->GetLabel();
+        found = true;
+        }
+      }
+    if ( !found )
+      {
+      return;
+      }
+
+    // the lines of the first label object with that label are followed by
+    // the lines of the other buffers, in order
+    LabelObjectType * labelObject = nullptr;
+    for ( SizeValueType b = 0; b < ranges.size(); ++b )
+      {
+      RangeType & range = ranges[b];
+      if ( range.first == range.second || ( *range.first )->GetLabel() != label )
+        {
+        continue;
+        }
+      LabelObjectType * bufferLabelObject = *range.first;
+      if ( labelObject == nullptr )
+        {
+        labelObject = bufferLabelObject;
+        if ( b > 0 )
+          {
+          // this label is not in the output yet
+          newLabelObjects.push_back( labelObject );
+          }
+        }
+      else
+        {
+        for ( SizeValueType i = 0; i < bufferLabelObject->GetNumberOfLines(); ++i )
+          {
+          labelObject->AddLine( bufferLabelObject->GetLine( i ) );
+          }
+        }
+      ++range.first;
+      }
+    }
+}
+} // end namespace itk
+
+#endif
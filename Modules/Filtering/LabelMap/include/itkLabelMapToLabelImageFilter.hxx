@@ -22,6 +22,8 @@
 #include "itkNumericTraits.h"
 #include "itkProgressReporter.h"
 #include "itkImageRegionConstIteratorWithIndex.h"
+#include "itkImageRegionIterator.h"
+#include <algorithm>
 
 namespace itk
 {
@@ -42,7 +44,20 @@ LabelMapToLabelImageFilter< TInputImage, TOutputImage >
   OutputImageType * output = this->GetOutput();
   const InputImageType *input = this->GetInput();
 
-  output->FillBuffer( input->GetBackgroundValue() );
+  // fill the buffer in parallel - the label objects may cover a small part
+  // of a large image
+  const OutputImagePixelType backgroundValue = input->GetBackgroundValue();
+  this->GetMultiThreader()->template ParallelizeImageRegion< OutputImageDimension >(
+    output->GetBufferedRegion(),
+    [output, backgroundValue]( const OutputImageRegionType & region )
+    {
+      ImageRegionIterator< OutputImageType > it( output, region );
+      for ( ; !it.IsAtEnd(); ++it )
+        {
+        it.Set( backgroundValue );
+        }
+    },
+    nullptr );
   Superclass::BeforeThreadedGenerateData();
   this->m_OutputImage = this->GetOutput();
 }
@@ -54,12 +69,14 @@ LabelMapToLabelImageFilter< TInputImage, TOutputImage >
 ::ThreadedProcessLabelObject(LabelObjectType *labelObject)
 {
   const typename LabelObjectType::LabelType & label = labelObject->GetLabel();
-  typename LabelObjectType::ConstIndexIterator it( labelObject );
+  OutputImagePixelType * buffer = this->m_OutputImage->GetBufferPointer();
 
-  while( !it.IsAtEnd() )
+  // the pixels of a line are contiguous in the output buffer
+  for ( SizeValueType i = 0; i < labelObject->GetNumberOfLines(); ++i )
     {
-    this->m_OutputImage->SetPixel( it.GetIndex(), label );
-    ++it;
+    const typename LabelObjectType::LineType & line = labelObject->GetLine( i );
+    std::fill_n( buffer + this->m_OutputImage->ComputeOffset( line.GetIndex() ), line.GetLength(),
+                 static_cast< OutputImagePixelType >( label ) );
     }
 }
 
@@ -18,7 +18,7 @@
 #ifndef itkLabelObject_h
 #define itkLabelObject_h
 
-#include <deque>
+#include <vector>
 #include "itkLightObject.h"
 #include "itkLabelObjectLine.h"
 #include "itkWeakPointer.h"
@@ -87,6 +87,8 @@ public:
   using LabelType = TLabel;
   using LineType = LabelObjectLine< VImageDimension >;
   using LengthType = typename LineType::LengthType;
+  /** The lines are stored contiguously, in the order they were added. */
+  using LineContainerType = std::vector< LineType >;
   using AttributeType = unsigned int;
   using SizeValueType = itk::SizeValueType;
 
@@ -252,7 +254,6 @@ public:
     }
 
   private:
-    using LineContainerType = typename std::deque< LineType >;
     using InternalIteratorType = typename LineContainerType::const_iterator;
     InternalIteratorType m_Iterator;
     InternalIteratorType m_Begin;
@@ -347,7 +348,6 @@ public:
 
   private:
 
-    using LineContainerType = typename std::deque< LineType >;
     using InternalIteratorType = typename LineContainerType::const_iterator;
     void NextValidLine()
     {
@@ -373,8 +373,6 @@ protected:
   void PrintSelf(std::ostream & os, Indent indent) const override;
 
 private:
-  using LineContainerType = typename std::deque< LineType >;
-
   LineContainerType m_LineContainer;
   LabelType         m_Label;
 };
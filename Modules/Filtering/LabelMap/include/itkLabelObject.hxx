@@ -229,7 +229,7 @@ typename LabelObject< TLabel, VImageDimension >::SizeValueType
 LabelObject< TLabel, VImageDimension >
 ::Size() const
 {
-  int size = 0;
+  SizeValueType size = 0;
 
   for ( auto it = m_LineContainer.begin();
         it != m_LineContainer.end();
@@ -287,6 +287,7 @@ LabelObject< TLabel, VImageDimension >
   itkAssertOrThrowMacro ( ( src != nullptr ), "Null Pointer" );
   // clear original lines and copy lines
   m_LineContainer.clear();
+  m_LineContainer.reserve( src->GetNumberOfLines() );
   for( size_t i = 0; i < src->GetNumberOfLines(); ++i )
     {
     this->AddLine( src->GetLine( static_cast< SizeValueType >( i ) ) );
@@ -329,26 +330,20 @@ LabelObject< TLabel, VImageDimension >
 {
   if ( !m_LineContainer.empty() )
     {
-    // first copy the lines in another container and clear the current one
-    LineContainerType lineContainer = m_LineContainer;
-    m_LineContainer.clear();
-
     // reorder the lines
     typename Functor::LabelObjectLineComparator< LineType > comparator;
-    std::sort(lineContainer.begin(), lineContainer.end(), comparator);
-
-    // then check the lines consistancy
-    // we'll proceed line index by line index
-    IndexType currentIdx = lineContainer.begin()->GetIndex();
-    LengthType  currentLength = lineContainer.begin()->GetLength();
+    std::sort(m_LineContainer.begin(), m_LineContainer.end(), comparator);
 
-    typename LineContainerType::const_iterator it = lineContainer.begin();
+    // then check the lines consistancy, and merge them in place: the lines
+    // up to currentLine are already optimized, and currentLine is extended
+    // as long as the next lines touch it
+    auto currentLine = m_LineContainer.begin();
 
-    while ( it != lineContainer.end() )
+    for ( auto it = m_LineContainer.begin() + 1; it != m_LineContainer.end(); ++it )
       {
-      const LineType & line = *it;
-      IndexType        idx = line.GetIndex();
-      LengthType    length = line.GetLength();
+      const IndexType & currentIdx = currentLine->GetIndex();
+      const IndexType & idx = it->GetIndex();
+      const LengthType  currentLength = currentLine->GetLength();
 
       // check the index to be sure that we are still in the same line idx
       bool sameIdx = true;
@@ -360,27 +355,22 @@ LabelObject< TLabel, VImageDimension >
           }
         }
 
-      // try to extend the current line idx, or create a new line
+      // try to extend the current line idx, or start a new line
       if ( sameIdx && currentIdx[0] + (OffsetValueType)currentLength >= idx[0] )
         {
         // we may expand the line
-        LengthType newLength = idx[0] + (OffsetValueType)length - currentIdx[0];
-        currentLength = std::max(newLength, currentLength);
+        LengthType newLength = idx[0] + (OffsetValueType)it->GetLength() - currentIdx[0];
+        currentLine->SetLength( std::max(newLength, currentLength) );
         }
       else
         {
-        // add the previous line to the new line container and use the new line
-        // index and size
-        this->AddLine(currentIdx, currentLength);
-        currentIdx = idx;
-        currentLength = length;
+        ++currentLine;
+        *currentLine = *it;
         }
-
-      it++;
       }
 
-    // complete the last line
-    this->AddLine(currentIdx, currentLength);
+    // drop the lines merged into the previous ones
+    m_LineContainer.erase( currentLine + 1, m_LineContainer.end() );
     }
 }
 
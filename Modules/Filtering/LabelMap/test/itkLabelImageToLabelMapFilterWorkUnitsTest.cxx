@@ -0,0 +1,202 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+#include <iostream>
+
+#include "itkBinaryImageToLabelMapFilter.h"
+#include "itkImageRegionConstIterator.h"
+#include "itkImageRegionIteratorWithIndex.h"
+#include "itkLabelImageToLabelMapFilter.h"
+#include "itkLabelMapToLabelImageFilter.h"
+#include "itkMersenneTwisterRandomVariateGenerator.h"
+
+/* LabelImageToLabelMapFilter and BinaryImageToLabelMapFilter merge the runs
+ * found by the threads in parallel. The label maps computed with several
+ * work units must have the same label objects, with the same lines in the
+ * same order, as the ones computed with a single work unit, and
+ * LabelMapToLabelImageFilter must give back the label image.
+ */
+
+namespace
+{
+constexpr unsigned int Dimension = 3;
+
+using ImageType = itk::Image< unsigned int, Dimension >;
+using LabelObjectType = itk::LabelObject< unsigned int, Dimension >;
+using LabelMapType = itk::LabelMap< LabelObjectType >;
+
+// Many small objects, a few objects spread over the whole image, and some
+// labels far apart.
+ImageType::Pointer
+CreateImage()
+{
+  using RandomizerType = itk::Statistics::MersenneTwisterRandomVariateGenerator;
+  RandomizerType::Pointer randomizer = RandomizerType::New();
+  randomizer->SetSeed( 4321 );
+
+  ImageType::SizeType size;
+  size[0] = 57;
+  size[1] = 31;
+  size[2] = 23;
+  ImageType::Pointer image = ImageType::New();
+  image->SetRegions( size );
+  image->Allocate();
+
+  itk::ImageRegionIteratorWithIndex< ImageType > it( image, image->GetLargestPossibleRegion() );
+  for ( ; !it.IsAtEnd(); ++it )
+    {
+    const ImageType::IndexType & idx = it.GetIndex();
+    unsigned int value = 1 + ( idx[0] / 4 ) + 20 * ( idx[1] / 3 ) + 300 * ( idx[2] / 2 );
+    const unsigned int draw = randomizer->GetIntegerVariate( 19 );
+    if ( draw < 4 )
+      {
+      value = 0;
+      }
+    else if ( draw == 4 )
+      {
+      value = 5000000 + idx[2] % 3;
+      }
+    else if ( draw == 5 )
+      {
+      value = 7 + 100000 * randomizer->GetIntegerVariate( 3 );
+      }
+    it.Set( value );
+    }
+  return image;
+}
+
+bool
+CompareLabelMaps( const LabelMapType * labelMap, const LabelMapType * reference, const char * name )
+{
+  if ( labelMap->GetLabels() != reference->GetLabels() )
+    {
+    std::cerr << "Test failed!" << std::endl;
+    std::cerr << name << ": " << labelMap->GetNumberOfLabelObjects() << " labels instead of "
+              << reference->GetNumberOfLabelObjects() << std::endl;
+    return false;
+    }
+  for ( LabelMapType::ConstIterator it( reference ); !it.IsAtEnd(); ++it )
+    {
+    const LabelObjectType * referenceObject = it.GetLabelObject();
+    const LabelObjectType * labelObject = labelMap->GetLabelObject( it.GetLabel() );
+    bool sameLines = labelObject->GetNumberOfLines() == referenceObject->GetNumberOfLines();
+    for ( itk::SizeValueType i = 0; sameLines && i < referenceObject->GetNumberOfLines(); ++i )
+      {
+      sameLines = labelObject->GetLine( i ).GetIndex() == referenceObject->GetLine( i ).GetIndex()
+                  && labelObject->GetLine( i ).GetLength() == referenceObject->GetLine( i ).GetLength();
+      }
+    if ( !sameLines )
+      {
+      std::cerr << "Test failed!" << std::endl;
+      std::cerr << name << ": the lines of the label " << it.GetLabel() << " differ" << std::endl;
+      return false;
+      }
+    }
+  return true;
+}
+
+bool
+CompareImages( const ImageType * image, const ImageType * reference, const char * name )
+{
+  itk::ImageRegionConstIterator< ImageType > it( image, image->GetLargestPossibleRegion() );
+  itk::ImageRegionConstIterator< ImageType > rit( reference, reference->GetLargestPossibleRegion() );
+  itk::SizeValueType numberOfDifferences = 0;
+  for ( ; !it.IsAtEnd(); ++it, ++rit )
+    {
+    if ( it.Get() != rit.Get() )
+      {
+      ++numberOfDifferences;
+      }
+    }
+  if ( numberOfDifferences > 0 )
+    {
+    std::cerr << "Test failed!" << std::endl;
+    std::cerr << name << ": " << numberOfDifferences << " different pixels" << std::endl;
+    return false;
+    }
+  return true;
+}
+}
+
+int itkLabelImageToLabelMapFilterWorkUnitsTest( int, char *[] )
+{
+  bool testPassed = true;
+
+  ImageType::Pointer image = CreateImage();
+
+  using LabelImageToLabelMapType = itk::LabelImageToLabelMapFilter< ImageType, LabelMapType >;
+  using BinaryImageToLabelMapType = itk::BinaryImageToLabelMapFilter< ImageType, LabelMapType >;
+  using LabelMapToLabelImageType = itk::LabelMapToLabelImageFilter< LabelMapType, ImageType >;
+
+  LabelMapType::Pointer labelReference;
+  LabelMapType::Pointer binaryReference;
+  ImageType::Pointer    binaryImageReference;
+
+  const itk::ThreadIdType workUnits[] = { 1, 2, 3, 8, 17 };
+  for ( itk::ThreadIdType numberOfWorkUnits : workUnits )
+    {
+    std::cout << numberOfWorkUnits << " work units" << std::endl;
+
+    LabelImageToLabelMapType::Pointer labelToMap = LabelImageToLabelMapType::New();
+    labelToMap->SetInput( image );
+    labelToMap->SetBackgroundValue( 0 );
+    labelToMap->SetNumberOfWorkUnits( numberOfWorkUnits );
+
+    LabelMapToLabelImageType::Pointer labelToImage = LabelMapToLabelImageType::New();
+    labelToImage->SetInput( labelToMap->GetOutput() );
+    labelToImage->SetNumberOfWorkUnits( numberOfWorkUnits );
+    labelToImage->Update();
+    testPassed &= CompareImages( labelToImage->GetOutput(), image, "label image round trip" );
+
+    BinaryImageToLabelMapType::Pointer binaryToMap = BinaryImageToLabelMapType::New();
+    binaryToMap->SetInput( image );
+    binaryToMap->SetInputForegroundValue( 5000000 );
+    binaryToMap->SetFullyConnected( true );
+    binaryToMap->SetNumberOfWorkUnits( numberOfWorkUnits );
+
+    LabelMapToLabelImageType::Pointer binaryToImage = LabelMapToLabelImageType::New();
+    binaryToImage->SetInput( binaryToMap->GetOutput() );
+    binaryToImage->SetNumberOfWorkUnits( numberOfWorkUnits );
+    binaryToImage->Update();
+
+    if ( numberOfWorkUnits == 1 )
+      {
+      labelReference = labelToMap->GetOutput();
+      labelReference->DisconnectPipeline();
+      binaryReference = binaryToMap->GetOutput();
+      binaryReference->DisconnectPipeline();
+      binaryImageReference = binaryToImage->GetOutput();
+      binaryImageReference->DisconnectPipeline();
+      std::cout << "  " << labelReference->GetNumberOfLabelObjects() << " labels, "
+                << binaryReference->GetNumberOfLabelObjects() << " connected components" << std::endl;
+      }
+    else
+      {
+      testPassed &= CompareLabelMaps( labelToMap->GetOutput(), labelReference, "LabelImageToLabelMapFilter" );
+      testPassed &= CompareLabelMaps( binaryToMap->GetOutput(), binaryReference, "BinaryImageToLabelMapFilter" );
+      testPassed &= CompareImages( binaryToImage->GetOutput(), binaryImageReference, "binary image round trip" );
+      }
+    }
+
+  if ( !testPassed )
+    {
+    return EXIT_FAILURE;
+    }
+  std::cout << "Test finished." << std::endl;
+  return EXIT_SUCCESS;
+}
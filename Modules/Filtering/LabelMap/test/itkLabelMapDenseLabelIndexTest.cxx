@@ -0,0 +1,174 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+#include <algorithm>
+#include <iostream>
+#include <limits>
+#include "itkLabelMap.h"
+#include "itkLabelObject.h"
+#include "itkTestingMacros.h"
+
+/* The label lookups of LabelMap must give the same answers whether the
+ * labels are dense, sparse, negative, removed or added again, and the lines
+ * of the label objects must be merged by Optimize().
+ */
+
+namespace
+{
+constexpr unsigned int Dimension = 2;
+
+using LabelObjectType = itk::LabelObject< int, Dimension >;
+using LabelMapType = itk::LabelMap< LabelObjectType >;
+using IndexType = LabelObjectType::IndexType;
+
+bool
+CheckLabels( const LabelMapType * map, int firstLabel, int lastLabel, const char * step )
+{
+  // the labels present in the map, in any order
+  const LabelMapType::LabelVectorType labels = map->GetLabels();
+  for ( int label = firstLabel; label <= lastLabel; ++label )
+    {
+    const bool expected = std::find( labels.begin(), labels.end(), label ) != labels.end();
+    if ( map->HasLabel( label ) != expected )
+      {
+      std::cerr << "Test failed!" << std::endl;
+      std::cerr << step << ": HasLabel(" << label << ") is " << !expected << std::endl;
+      return false;
+      }
+    if ( expected && map->GetLabelObject( label )->GetLabel() != label )
+      {
+      std::cerr << "Test failed!" << std::endl;
+      std::cerr << step << ": GetLabelObject(" << label << ") returned the label "
+                << map->GetLabelObject( label )->GetLabel() << std::endl;
+      return false;
+      }
+    }
+  return true;
+}
+}
+
+int itkLabelMapDenseLabelIndexTest( int, char *[] )
+{
+  bool testPassed = true;
+
+  LabelMapType::Pointer map = LabelMapType::New();
+  LabelMapType::SizeType size;
+  size.Fill( 100 );
+  map->SetRegions( size );
+
+  IndexType idx;
+  idx.Fill( 0 );
+
+  // dense labels, added out of order and below the first label
+  for ( int label = 10; label > -20; label -= 3 )
+    {
+    idx[1] = label + 20;
+    map->SetLine( idx, 5, label );
+    }
+  map->AddPixel( idx, 50 );
+  testPassed &= CheckLabels( map, -30, 60, "dense labels" );
+  TEST_EXPECT_EQUAL( map->GetNumberOfLabelObjects(), 11 );
+
+  // labels added in decreasing order, down to the smallest label
+  LabelMapType::Pointer decreasingMap = LabelMapType::New();
+  decreasingMap->SetRegions( size );
+  const int lowestLabel = std::numeric_limits< int >::min();
+  for ( int i = 3000; i >= 0; --i )
+    {
+    decreasingMap->AddPixel( idx, lowestLabel + i );
+    }
+  testPassed &= CheckLabels( decreasingMap, lowestLabel, lowestLabel + 3010, "decreasing labels" );
+  TEST_EXPECT_EQUAL( decreasingMap->GetNumberOfLabelObjects(), 3001 );
+
+  // remove and add again
+  map->RemoveLabel( -5 );
+  map->RemoveLabel( 50 );
+  testPassed &= CheckLabels( map, -30, 60, "removed labels" );
+  TEST_EXPECT_EQUAL( map->HasLabel( 50 ), false );
+  TRY_EXPECT_EXCEPTION( map->GetLabelObject( -5 ) );
+  idx[1] = 15;
+  map->SetLine( idx, 5, -5 );
+  testPassed &= CheckLabels( map, -30, 60, "label added again" );
+
+  // labels too sparse to be indexed directly
+  map->AddPixel( idx, 1000000 );
+  map->AddPixel( idx, -2000000000 );
+  map->AddPixel( idx, 2000000000 );
+  testPassed &= CheckLabels( map, -30, 60, "sparse labels" );
+  TEST_EXPECT_EQUAL( map->HasLabel( 1000000 ), true );
+  TEST_EXPECT_EQUAL( map->HasLabel( -2000000000 ), true );
+  TEST_EXPECT_EQUAL( map->GetLabelObject( 2000000000 )->GetLabel(), 2000000000 );
+  TEST_EXPECT_EQUAL( map->HasLabel( 999999 ), false );
+
+  // the grafted map has the same labels
+  LabelMapType::Pointer graft = LabelMapType::New();
+  graft->Graft( map );
+  testPassed &= CheckLabels( graft, -30, 60, "graft" );
+  TEST_EXPECT_EQUAL( graft->GetLabelObject( 1000000 ), map->GetLabelObject( 1000000 ) );
+
+  // the labels are indexed again once the map is cleared
+  map->ClearLabels();
+  testPassed &= CheckLabels( map, -30, 60, "cleared" );
+  TEST_EXPECT_EQUAL( map->HasLabel( 1000000 ), false );
+  TEST_EXPECT_EQUAL( graft->HasLabel( 1000000 ), true );
+  for ( int label = 1; label < 5; ++label )
+    {
+    map->AddPixel( idx, label );
+    }
+  testPassed &= CheckLabels( map, -30, 60, "labels added after the clear" );
+
+  // the overlapping and adjacent lines of an object are merged by Optimize()
+  // - the object already has the pixel [0, 15]
+  idx[1] = 3;
+  idx[0] = 8;
+  map->SetLine( idx, 5, 2 );
+  idx[0] = 2;
+  map->SetLine( idx, 4, 2 );
+  idx[0] = 20;
+  map->SetLine( idx, 2, 2 );
+  idx[0] = 5;
+  map->SetLine( idx, 3, 2 );
+  idx[1] = 0;
+  idx[0] = 1;
+  map->SetLine( idx, 2, 2 );
+  idx[0] = 0;
+  map->SetLine( idx, 2, 2 );
+  map->Optimize();
+  const LabelObjectType * labelObject = map->GetLabelObject( 2 );
+  TEST_EXPECT_EQUAL( labelObject->GetNumberOfLines(), 4 );
+  TEST_EXPECT_EQUAL( labelObject->Size(), 17 );
+  const int expectedLines[4][3] = { { 0, 0, 3 }, { 2, 3, 11 }, { 20, 3, 2 }, { 0, 15, 1 } };
+  for ( unsigned int i = 0; i < 4; ++i )
+    {
+    const LabelObjectType::LineType & line = labelObject->GetLine( i );
+    if ( line.GetIndex()[0] != expectedLines[i][0] || line.GetIndex()[1] != expectedLines[i][1]
+         || line.GetLength() != static_cast< itk::SizeValueType >( expectedLines[i][2] ) )
+      {
+      std::cerr << "Test failed!" << std::endl;
+      std::cerr << "Line " << i << " is " << line.GetIndex() << " " << line.GetLength() << std::endl;
+      testPassed = false;
+      }
+    }
+
+  if ( !testPassed )
+    {
+    return EXIT_FAILURE;
+    }
+  std::cout << "Test finished." << std::endl;
+  return EXIT_SUCCESS;
+}
@@ -43,6 +43,15 @@ namespace itk
  * applications and efficient algorithms" -- IEEE Transactions on
  * Image processing, Vol 2, No 2, pp 176-201, April 1993
  *
+ * When UseInternalCopy is on (the default), the image is split into slabs
+ * along its last dimension, which are processed in parallel. The raster
+ * and antiraster steps are performed within each slab, then the FIFO based
+ * propagation proceeds concurrently in each slab. The values propagated
+ * across the boundary of a slab are passed to the neighboring slab, and
+ * exchanged until no value changes. Since the reconstruction is unique,
+ * the result is identical to the one of the serial algorithm, whatever the
+ * number of work units.
+ *
  * \author Richard Beare. Department of Medicine, Monash University,
  * Melbourne, Australia.
  *
@@ -150,6 +159,11 @@ protected:
 
   void GenerateData() override;
 
+  /** Reconstruct the padded marker image in place, under the padded mask
+   * image, with one slab of the image per work unit. The border of the
+   * padded images must be set to the marker value. */
+  void ParallelReconstruction(InputImageType *markerImage, const InputImageType *maskImage);
+
   /**
    * the value of the border - used in boundary condition.
    */
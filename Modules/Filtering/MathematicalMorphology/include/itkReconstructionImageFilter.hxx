@@ -25,6 +25,10 @@
 
 #include "itkConstantPadImageFilter.h"
 #include "itkCropImageFilter.h"
+#include "itkImageScanlineConstIterator.h"
+
+#include <atomic>
+#include <vector>
 
 namespace itk
 {
@@ -107,11 +111,6 @@ ReconstructionImageFilter< TInputImage, TOutputImage, TCompare >
 {
   // Allocate the output
   this->AllocateOutputs();
-  // there are 2 passes that use all pixels and a 3rd that uses some
-  // subset of the pixels. We'll just pretend that the third pass
-  // takes the same as each of the others. Is it OK to update more
-  // often than pixels?
-  ProgressReporter progress(this, 0, this->GetOutput()->GetRequestedRegion().GetNumberOfPixels() * 3);
 
   TCompare compare;
 
@@ -151,76 +150,59 @@ ReconstructionImageFilter< TInputImage, TOutputImage, TCompare >
     MaskPad->Update();
     MarkerPad->Update();
 
-    markerImageP = MarkerPad->GetOutput();
-    maskImageP = MaskPad->GetOutput();
+    // the padded marker is reconstructed in place
+    this->ParallelReconstruction( MarkerPad->GetOutput(), MaskPad->GetOutput() );
+
+    using CropType = typename itk::CropImageFilter< InputImageType, OutputImageType >;
+    typename CropType::Pointer crop = CropType::New();
+
+    crop->SetInput( MarkerPad->GetOutput() );
+    crop->SetUpperBoundaryCropSize(padSize);
+    crop->SetLowerBoundaryCropSize(padSize);
+    crop->GraftOutput( this->GetOutput() );
+    /** execute the minipipeline */
+    crop->Update();
+
+    /** graft the minipipeline output back into this filter's output */
+    this->GraftOutput( crop->GetOutput() );
+    return;
     }
-  else
-    {
-    maskImageP = this->GetMaskImage();
-    InputIteratorType inIt( markerImage,
+
+  // there are 2 passes that use all pixels and a 3rd that uses some
+  // subset of the pixels. We'll just pretend that the third pass
+  // takes the same as each of the others. Is it OK to update more
+  // often than pixels?
+  ProgressReporter progress(this, 0, this->GetOutput()->GetRequestedRegion().GetNumberOfPixels() * 3);
+
+  maskImageP = this->GetMaskImage();
+  InputIteratorType inIt( markerImage,
+                          output->GetRequestedRegion() );
+  OutputIteratorType outIt( output,
                             output->GetRequestedRegion() );
-    OutputIteratorType outIt( output,
-                              output->GetRequestedRegion() );
-    // copy marker to output - isn't there a better way?
-    while ( !outIt.IsAtEnd() )
-      {
-      MarkerImagePixelType currentValue = inIt.Get();
-      outIt.Set( static_cast< OutputImagePixelType >( currentValue ) );
-      ++inIt;
-      ++outIt;
-      }
-    markerImageP = output;
+  // copy marker to output - isn't there a better way?
+  while ( !outIt.IsAtEnd() )
+    {
+    MarkerImagePixelType currentValue = inIt.Get();
+    outIt.Set( static_cast< OutputImagePixelType >( currentValue ) );
+    ++inIt;
+    ++outIt;
     }
+  markerImageP = output;
 
   // declare our queue type
   using FifoType = typename std::queue< OutputImageIndexType >;
   FifoType IndexFifo;
 
-  NOutputIterator   outNIt;
-  InputIteratorType mskIt;
-  CNInputIterator   mskNIt;
-  ISizeType         kernelRadius;
+  ISizeType kernelRadius;
   kernelRadius.Fill(1);
-  if ( m_UseInternalCopy )
-    {
-    FaceCalculatorType faceCalculator;
-
-    FaceListType   faceList;
-    FaceListTypeIt fit;
-
-    faceList = faceCalculator(maskImageP, maskImageP->GetLargestPossibleRegion(),
-                              kernelRadius);
-    // we will only be processing the body region
-    fit = faceList.begin();
-    // must be a better way of doing this
-    NOutputIterator tt(kernelRadius,
-                       markerImageP,
-                       *fit);
-    outNIt = tt;
-
-    InputIteratorType ttt(maskImageP,
-                          *fit);
-    mskIt = ttt;
-    CNInputIterator tttt(kernelRadius,
-                         maskImageP,
-                         *fit);
-    mskNIt = tttt;
-    }
-  else
-    {
-    NOutputIterator tt( kernelRadius,
-                        markerImageP,
-                        output->GetRequestedRegion() );
-    outNIt = tt;
-
-    InputIteratorType ttt( maskImageP,
+  NOutputIterator   outNIt( kernelRadius,
+                            markerImageP,
+                            output->GetRequestedRegion() );
+  InputIteratorType mskIt( maskImageP,
                            output->GetRequestedRegion() );
-    mskIt = ttt;
-    CNInputIterator tttt( kernelRadius,
-                          maskImageP,
-                          output->GetRequestedRegion() );
-    mskNIt = tttt;
-    }
+  CNInputIterator   mskNIt( kernelRadius,
+                            maskImageP,
+                            output->GetRequestedRegion() );
 
   setConnectivityPrevious(&outNIt, m_FullyConnected);
 
@@ -370,22 +352,355 @@ ReconstructionImageFilter< TInputImage, TOutputImage, TCompare >
       }
     progress.CompletedPixel();
     }
+}
 
-  if ( m_UseInternalCopy )
+template< typename TInputImage, typename TOutputImage, typename TCompare >
+void
+ReconstructionImageFilter< TInputImage, TOutputImage, TCompare >
+::ParallelReconstruction(InputImageType *markerImage, const InputImageType *maskImage)
+{
+  constexpr unsigned int ImageDimension = InputImageType::ImageDimension;
+  constexpr unsigned int LastDimension = ImageDimension - 1;
+
+  using MessageType = std::pair< OffsetValueType, InputImagePixelType >;
+  using MessageListType = std::vector< MessageType >;
+  using FifoType = std::queue< OffsetValueType >;
+
+  TCompare compare;
+
+  InputImagePixelType *       marker = markerImage->GetBufferPointer();
+  const InputImagePixelType * mask = maskImage->GetBufferPointer();
+  const MarkerImageRegionType paddedRegion = markerImage->GetBufferedRegion();
+  const OffsetValueType *     offsetTable = markerImage->GetOffsetTable();
+
+  // The neighbors, as buffer offsets, together with their step along the
+  // last dimension. The previous neighbors precede the pixel in raster
+  // order, the later ones follow it.
+  std::vector< OffsetValueType > neighbors;
+  std::vector< int >             neighborSteps;
+  unsigned int numberOfNeighborhoodPixels = 1;
+  for ( unsigned int d = 0; d < ImageDimension; ++d )
     {
-    using CropType = typename itk::CropImageFilter< InputImageType, OutputImageType >;
-    typename CropType::Pointer crop = CropType::New();
+    numberOfNeighborhoodPixels *= 3;
+    }
+  for ( unsigned int n = 0; n < numberOfNeighborhoodPixels; ++n )
+    {
+    OffsetValueType offset = 0;
+    unsigned int    numberOfNonZeroSteps = 0;
+    int             lastStep = 0;
+    for ( unsigned int d = 0, k = n; d < ImageDimension; ++d, k /= 3 )
+      {
+      const int step = static_cast< int >( k % 3 ) - 1;
+      offset += step * offsetTable[d];
+      numberOfNonZeroSteps += ( step != 0 );
+      lastStep = step;
+      }
+    if ( numberOfNonZeroSteps > 0 && ( m_FullyConnected || numberOfNonZeroSteps == 1 ) )
+      {
+      neighbors.push_back(offset);
+      neighborSteps.push_back(lastStep);
+      }
+    }
+  std::vector< OffsetValueType > previousNeighbors;
+  std::vector< int >             previousNeighborSteps;
+  std::vector< OffsetValueType > laterNeighbors;
+  std::vector< int >             laterNeighborSteps;
+  for ( unsigned int k = 0; k < neighbors.size(); ++k )
+    {
+    if ( neighbors[k] < 0 )
+      {
+      previousNeighbors.push_back(neighbors[k]);
+      previousNeighborSteps.push_back(neighborSteps[k]);
+      }
+    else
+      {
+      laterNeighbors.push_back(neighbors[k]);
+      laterNeighborSteps.push_back(neighborSteps[k]);
+      }
+    }
 
-    crop->SetInput(markerImageP);
-    crop->SetUpperBoundaryCropSize(padSize);
-    crop->SetLowerBoundaryCropSize(padSize);
-    crop->GraftOutput( this->GetOutput() );
-    /** execute the minipipeline */
-    crop->Update();
+  // The slabs split the unpadded region along the last dimension. A slab
+  // only reads and writes its own pixels and the padding, except when the
+  // slabs are seeded, during which no pixel is written.
+  MarkerImageRegionType region = paddedRegion;
+  region.ShrinkByRadius(1);
+  const IndexValueType firstSlice = region.GetIndex(LastDimension);
+  const SizeValueType  numberOfSlices = region.GetSize(LastDimension);
+  const SizeValueType  numberOfSlabs = ( ImageDimension > 1 )
+    ? std::max< SizeValueType >( 1, std::min< SizeValueType >( this->GetNumberOfWorkUnits(), numberOfSlices ) )
+    : 1;
+  std::vector< IndexValueType > slabStarts( numberOfSlabs + 1 );
+  for ( SizeValueType slab = 0; slab <= numberOfSlabs; ++slab )
+    {
+    slabStarts[slab] = firstSlice + static_cast< IndexValueType >( slab * numberOfSlices / numberOfSlabs );
+    }
 
-    /** graft the minipipeline output back into this filter's output */
-    this->GraftOutput( crop->GetOutput() );
+  auto sliceOf = [&]( OffsetValueType offset ) -> IndexValueType
+    {
+    return paddedRegion.GetIndex(LastDimension) + static_cast< IndexValueType >( offset / offsetTable[LastDimension] );
+    };
+
+  // The buffer offsets of the first pixel of each line of a slab
+  auto lineStartsOf = [&]( SizeValueType slab ) -> std::vector< OffsetValueType >
+    {
+    MarkerImageRegionType slabRegion = region;
+    slabRegion.SetIndex( LastDimension, slabStarts[slab] );
+    slabRegion.SetSize( LastDimension, slabStarts[slab + 1] - slabStarts[slab] );
+    std::vector< OffsetValueType > lineStarts;
+    lineStarts.reserve( slabRegion.GetNumberOfPixels() / slabRegion.GetSize(0) );
+    ImageScanlineConstIterator< InputImageType > it(markerImage, slabRegion);
+    while ( !it.IsAtEnd() )
+      {
+      lineStarts.push_back( markerImage->ComputeOffset( it.GetIndex() ) );
+      it.NextLine();
+      }
+    return lineStarts;
+    };
+
+  const SizeValueType lineLength = region.GetSize(0);
+  std::vector< FifoType > fifos(numberOfSlabs);
+  std::atomic< bool >     markerExceedsMask(false);
+
+  // Raster and antiraster steps of each slab, which ignore the neighbors in
+  // the other slabs.
+  this->GetMultiThreader()->ParallelizeArray(0, numberOfSlabs,
+    [&]( SizeValueType slab )
+    {
+      const IndexValueType                 slabStart = slabStarts[slab];
+      const IndexValueType                 slabEnd = slabStarts[slab + 1];
+      const std::vector< OffsetValueType > lineStarts = lineStartsOf(slab);
+      FifoType &                           fifo = fifos[slab];
+
+      for ( const OffsetValueType lineStart : lineStarts )
+        {
+        const bool atLowerBoundary = ( slab > 0 && sliceOf(lineStart) == slabStart );
+        for ( OffsetValueType p = lineStart; p < lineStart + static_cast< OffsetValueType >( lineLength ); ++p )
+          {
+          InputImagePixelType V = marker[p];
+          const InputImagePixelType iV = mask[p];
+
+          // be sure that the pixels in the images follow the preconditions
+          if ( compare(V, iV) )
+            {
+            markerExceedsMask = true;
+            return;
+            }
+
+          // visit the previous neighbours
+          for ( unsigned int k = 0; k < previousNeighbors.size(); ++k )
+            {
+            if ( atLowerBoundary && previousNeighborSteps[k] < 0 )
+              {
+              continue;
+              }
+            const InputImagePixelType VN = marker[p + previousNeighbors[k]];
+            if ( compare(VN, V) )
+              {
+              V = VN;
+              }
+            }
+
+          // this step clamps to the mask
+          if ( compare(V, iV) )
+            {
+            V = iV;
+            }
+          marker[p] = V;
+          }
+        }
+
+      for ( auto lineIt = lineStarts.rbegin(); lineIt != lineStarts.rend(); ++lineIt )
+        {
+        const OffsetValueType lineStart = *lineIt;
+        const bool            atUpperBoundary = ( slab + 1 < numberOfSlabs && sliceOf(lineStart) == slabEnd - 1 );
+        for ( OffsetValueType p = lineStart + static_cast< OffsetValueType >( lineLength ) - 1; p >= lineStart; --p )
+          {
+          InputImagePixelType V = marker[p];
+          for ( unsigned int k = 0; k < laterNeighbors.size(); ++k )
+            {
+            if ( atUpperBoundary && laterNeighborSteps[k] > 0 )
+              {
+              continue;
+              }
+            const InputImagePixelType VN = marker[p + laterNeighbors[k]];
+            if ( compare(VN, V) )
+              {
+              V = VN;
+              }
+            }
+          const InputImagePixelType iV = mask[p];
+          if ( compare(V, iV) )
+            {
+            V = iV;
+            }
+          marker[p] = V;
+
+          // now put indexes in the fifo
+          for ( unsigned int k = 0; k < laterNeighbors.size(); ++k )
+            {
+            if ( atUpperBoundary && laterNeighborSteps[k] > 0 )
+              {
+              continue;
+              }
+            const OffsetValueType     q = p + laterNeighbors[k];
+            const InputImagePixelType VN = marker[q];
+            const InputImagePixelType iN = mask[q];
+            if ( compare(V, VN) && compare(iN, VN) )
+              {
+              fifo.push(p);
+              break;
+              }
+            }
+          }
+        }
+    },
+    nullptr);
+
+  if ( markerExceedsMask )
+    {
+    if ( compare(0, 1) )
+      {
+      itkExceptionMacro(<< "Marker pixels must be <= mask pixels.");
+      }
+    else
+      {
+      itkExceptionMacro(<< "Marker pixels must be >= mask pixels.");
+      }
     }
+  this->UpdateProgress(0.5f);
+
+  // The pixels of the boundary slices of the slabs which can propagate
+  // their value to the neighboring slabs
+  if ( numberOfSlabs > 1 )
+    {
+    this->GetMultiThreader()->ParallelizeArray(0, numberOfSlabs,
+      [&]( SizeValueType slab )
+      {
+        for ( const OffsetValueType lineStart : lineStartsOf(slab) )
+          {
+          const IndexValueType slice = sliceOf(lineStart);
+          const bool           atLowerBoundary = ( slab > 0 && slice == slabStarts[slab] );
+          const bool           atUpperBoundary = ( slab + 1 < numberOfSlabs && slice == slabStarts[slab + 1] - 1 );
+          if ( !atLowerBoundary && !atUpperBoundary )
+            {
+            continue;
+            }
+          for ( OffsetValueType p = lineStart; p < lineStart + static_cast< OffsetValueType >( lineLength ); ++p )
+            {
+            const InputImagePixelType V = marker[p];
+            for ( unsigned int k = 0; k < neighbors.size(); ++k )
+              {
+              if ( ( atLowerBoundary && neighborSteps[k] < 0 ) || ( atUpperBoundary && neighborSteps[k] > 0 ) )
+                {
+                const OffsetValueType q = p + neighbors[k];
+                if ( compare(V, marker[q]) && compare(mask[q], marker[q]) )
+                  {
+                  fifos[slab].push(p);
+                  break;
+                  }
+                }
+              }
+            }
+          }
+      },
+      nullptr);
+    }
+
+  // Process the fifos - this fills the parts that weren't dealt with by the
+  // raster and antiraster steps. The values propagated to another slab are
+  // sent to it, and applied at the next round. messages[2 * slab] holds the
+  // values sent to the slab by the previous slab, and messages[2 * slab + 1]
+  // the ones sent by the next slab.
+  std::vector< MessageListType > messages[2];
+  messages[0].resize(2 * numberOfSlabs);
+  messages[1].resize(2 * numberOfSlabs);
+  unsigned int current = 0;
+  bool         hasMessages;
+  do
+    {
+    std::vector< MessageListType > & received = messages[current];
+    std::vector< MessageListType > & sent = messages[1 - current];
+    this->GetMultiThreader()->ParallelizeArray(0, numberOfSlabs,
+      [&]( SizeValueType slab )
+      {
+        FifoType & fifo = fifos[slab];
+        for ( unsigned int side = 0; side < 2; ++side )
+          {
+          for ( const MessageType & message : received[2 * slab + side] )
+            {
+            const OffsetValueType     q = message.first;
+            const InputImagePixelType V = message.second;
+            const InputImagePixelType VN = marker[q];
+            const InputImagePixelType iN = mask[q];
+            if ( compare(V, VN) && Math::NotAlmostEquals( iN, VN ) )
+              {
+              marker[q] = compare(iN, V) ? V : iN;
+              fifo.push(q);
+              }
+            }
+          received[2 * slab + side].clear();
+          }
+
+        const IndexValueType slabStart = slabStarts[slab];
+        const IndexValueType slabEnd = slabStarts[slab + 1];
+        while ( !fifo.empty() )
+          {
+          const OffsetValueType p = fifo.front();
+          fifo.pop();
+          const InputImagePixelType V = marker[p];
+          bool atLowerBoundary = false;
+          bool atUpperBoundary = false;
+          if ( numberOfSlabs > 1 )
+            {
+            const IndexValueType slice = sliceOf(p);
+            atLowerBoundary = ( slab > 0 && slice == slabStart );
+            atUpperBoundary = ( slab + 1 < numberOfSlabs && slice == slabEnd - 1 );
+            }
+          for ( unsigned int k = 0; k < neighbors.size(); ++k )
+            {
+            const OffsetValueType q = p + neighbors[k];
+            if ( atLowerBoundary && neighborSteps[k] < 0 )
+              {
+              sent[2 * ( slab - 1 ) + 1].emplace_back(q, V);
+              continue;
+              }
+            if ( atUpperBoundary && neighborSteps[k] > 0 )
+              {
+              sent[2 * ( slab + 1 )].emplace_back(q, V);
+              continue;
+              }
+            const InputImagePixelType VN = marker[q];
+            const InputImagePixelType iN = mask[q];
+            // candidate for dilation via flooding
+            if ( compare(V, VN) && Math::NotAlmostEquals( iN, VN ) )
+              {
+              if ( compare(iN, V) )
+                {
+                // not clamped by the mask, propagate the center value
+                marker[q] = V;
+                }
+              else
+                {
+                // apply the clamping
+                marker[q] = iN;
+                }
+              fifo.push(q);
+              }
+            }
+          }
+      },
+      nullptr);
+
+    hasMessages = false;
+    for ( const MessageListType & messageList : sent )
+      {
+      hasMessages |= !messageList.empty();
+      }
+    current = 1 - current;
+    }
+  while ( hasMessages );
+
+  this->UpdateProgress(1.0f);
 }
 
 template< typename TInputImage, typename TOutputImage, typename TCompare >
@@ -21,7 +21,7 @@
 #include "itkImageToImageFilter.h"
 #include "itkShapedNeighborhoodIterator.h"
 #include "itkConstantBoundaryCondition.h"
-#include <stack>
+#include <queue>
 
 namespace itk
 {
@@ -57,6 +57,14 @@ namespace itk
  *
  * The implementation uses the functor model from itkMaximumImageFilter.
  *
+ * The filter is multi-threaded. The image is split into slabs along its
+ * last dimension. A first parallel pass copies the input and marks the
+ * pixels which have a lower neighbor, then each slab floods its flat zones
+ * from these pixels. The pixels of a flat zone which lie in another slab
+ * are sent to that slab, and the floods are resumed in rounds until no
+ * slab has anything left to send. The output does not depend on the number
+ * of work units, and is the same as the one of the raster scan above.
+ *
  *
  * This code was contributed in the Insight Journal paper:
  * "Finding regional extrema - methods and performance"
@@ -164,9 +172,7 @@ private:
 
   using OutIndexType = typename OutputImageType::IndexType;
   using InIndexType = typename InputImageType::IndexType;
-  using ConstInputIterator = ConstShapedNeighborhoodIterator< InputImageType >;
-  using NOutputIterator = ShapedNeighborhoodIterator< OutputImageType >;
-  using IndexStack = std::stack< OutIndexType >;
+  using OffsetFifoType = std::queue< OffsetValueType >;
 }; // end of class
 } // end namespace itk
 
@@ -18,11 +18,11 @@
 #ifndef itkValuedRegionalExtremaImageFilter_hxx
 #define itkValuedRegionalExtremaImageFilter_hxx
 
-#include "itkImageRegionIterator.h"
 #include "itkNumericTraits.h"
 #include "itkValuedRegionalExtremaImageFilter.h"
-#include "itkProgressReporter.h"
-#include "itkConnectedComponentAlgorithm.h"
+
+#include <atomic>
+#include <vector>
 
 
 namespace itk
@@ -84,148 +84,250 @@ ValuedRegionalExtremaImageFilter< TInputImage, TOutputImage, TFunction1,
   const InputImageType * input = this->GetInput();
   OutputImageType * output = this->GetOutput();
 
-  // 2 phases
-  ProgressReporter progress(this, 0,
-                            this->GetOutput()->GetRequestedRegion().GetNumberOfPixels() * 2);
-
-  // copy input to output - isn't there a better way?
-  using InputIterator = ImageRegionConstIterator< TInputImage >;
-  using OutputIterator = ImageRegionIterator< TOutputImage >;
-
-  InputIterator inIt( input,
-                      output->GetRequestedRegion() );
-  OutputIterator outIt( output,
-                        output->GetRequestedRegion() );
-  inIt.GoToBegin();
-  outIt.GoToBegin();
-
-  InputImagePixelType firstValue = inIt.Get();
-  this->m_Flat = true;
-
-  while( !outIt.IsAtEnd() )
+  constexpr unsigned int ImageDimension = OutputImageType::ImageDimension;
+  constexpr unsigned int LastDimension = ImageDimension - 1;
+
+  // Note : all comments refer to finding regional minima, because
+  // it is briefer and clearer than trying to describe both regional
+  // maxima and minima processes at the same time
+  TFunction1 compareIn;
+  TFunction2 compareOut;
+
+  const OutputImageRegionType region = output->GetRequestedRegion();
+  const InputImagePixelType * inBuffer = input->GetBufferPointer() + input->ComputeOffset( region.GetIndex() );
+  OutputImagePixelType *      outBuffer = output->GetBufferPointer() + output->ComputeOffset( region.GetIndex() );
+  const OffsetValueType *     offsetTable = output->GetOffsetTable();
+  const OutputImagePixelType  markerValue = static_cast< OutputImagePixelType >( m_MarkerValue );
+
+  // The neighbors, as buffer offsets, together with their steps along each
+  // dimension, which are needed at the border of the image, where the
+  // neighbors outside the image have the marker value.
+  using StepType = Offset< ImageDimension >;
+  std::vector< OffsetValueType > neighbors;
+  std::vector< StepType >        neighborSteps;
+  unsigned int numberOfNeighborhoodPixels = 1;
+  for ( unsigned int d = 0; d < ImageDimension; ++d )
     {
-    InputImagePixelType currentValue = inIt.Get();
-    outIt.Set( static_cast< OutputImagePixelType >( currentValue ) );
-    if ( currentValue != firstValue )
+    numberOfNeighborhoodPixels *= 3;
+    }
+  for ( unsigned int n = 0; n < numberOfNeighborhoodPixels; ++n )
+    {
+    StepType        step;
+    OffsetValueType offset = 0;
+    unsigned int    numberOfNonZeroSteps = 0;
+    for ( unsigned int d = 0, k = n; d < ImageDimension; ++d, k /= 3 )
+      {
+      step[d] = static_cast< OffsetValueType >( k % 3 ) - 1;
+      offset += step[d] * offsetTable[d];
+      numberOfNonZeroSteps += ( step[d] != 0 );
+      }
+    if ( numberOfNonZeroSteps > 0 && ( m_FullyConnected || numberOfNonZeroSteps == 1 ) )
       {
-      this->m_Flat = false;
+      neighbors.push_back(offset);
+      neighborSteps.push_back(step);
       }
-    ++inIt;
-    ++outIt;
-    progress.CompletedPixel();
     }
 
-  // if the image is flat, there is no need to do the work:
-  // the image will be unchanged
-  if( !this->m_Flat )
+  const typename OutputImageRegionType::SizeType size = region.GetSize();
+  auto isOnBorder = [&]( const OutIndexType & index ) -> bool
     {
-    // Now for the real work!
-    // More iterators - use shaped ones so that we can set connectivity
-    // Note : all comments refer to finding regional minima, because
-    // it is briefer and clearer than trying to describe both regional
-    // maxima and minima processes at the same time
-    ISizeType kernelRadius;
-    kernelRadius.Fill( 1 );
-    NOutputIterator outNIt( kernelRadius,
-                            output,
-                            output->GetRequestedRegion() );
-    setConnectivity(&outNIt, m_FullyConnected);
-
-    ConstInputIterator inNIt( kernelRadius,
-                              input,
-                              output->GetRequestedRegion() );
-    setConnectivity(&inNIt, m_FullyConnected);
-
-    ConstantBoundaryCondition< OutputImageType > iBC;
-    iBC.SetConstant(m_MarkerValue);
-    inNIt.OverrideBoundaryCondition(&iBC);
-
-    ConstantBoundaryCondition< OutputImageType > oBC;
-    oBC.SetConstant(m_MarkerValue);
-    outNIt.OverrideBoundaryCondition(&oBC);
-
-    TFunction1 compareIn;
-    TFunction2 compareOut;
-
-    outIt.GoToBegin();
-    // set up the stack and neighbor list
-    IndexStack IS;
-    typename NOutputIterator::IndexListType IndexList;
-    IndexList = outNIt.GetActiveIndexList();
-
-    while( !outIt.IsAtEnd() )
+    for ( unsigned int d = 0; d < ImageDimension; ++d )
       {
-      OutputImagePixelType V = outIt.Get();
-      // if the output pixel value = the marker value then we have
-      // already visited this pixel and don't need to do so again
-      if ( compareOut(V, m_MarkerValue) )
+      if ( index[d] == 0 || index[d] + 1 == static_cast< IndexValueType >( size[d] ) )
         {
-        // reposition the input iterator
-        inNIt += outIt.GetIndex() - inNIt.GetIndex();
+        return true;
+        }
+      }
+    return false;
+    };
+  auto isInside = [&]( const OutIndexType & index, unsigned int k ) -> bool
+    {
+    for ( unsigned int d = 0; d < ImageDimension; ++d )
+      {
+      const IndexValueType neighborIndex = index[d] + neighborSteps[k][d];
+      if ( neighborIndex < 0 || neighborIndex >= static_cast< IndexValueType >( size[d] ) )
+        {
+        return false;
+        }
+      }
+    return true;
+    };
+  // The index of a buffer offset, relative to the start of the region
+  auto indexOf = [&]( OffsetValueType offset ) -> OutIndexType
+    {
+    OutIndexType index;
+    for ( unsigned int d = ImageDimension - 1; d > 0; --d )
+      {
+      index[d] = static_cast< IndexValueType >( offset / offsetTable[d] );
+      offset -= index[d] * offsetTable[d];
+      }
+    index[0] = static_cast< IndexValueType >( offset );
+    return index;
+    };
+
+  // The slabs split the region along the last dimension. A slab only writes
+  // its own pixels, and reads the input anywhere.
+  const SizeValueType numberOfSlices = size[LastDimension];
+  const SizeValueType numberOfSlabs = ( ImageDimension > 1 )
+    ? std::max< SizeValueType >( 1, std::min< SizeValueType >( this->GetNumberOfWorkUnits(), numberOfSlices ) )
+    : 1;
+  std::vector< IndexValueType > slabStarts( numberOfSlabs + 1 );
+  for ( SizeValueType slab = 0; slab <= numberOfSlabs; ++slab )
+    {
+    slabStarts[slab] = static_cast< IndexValueType >( slab * numberOfSlices / numberOfSlabs );
+    }
 
-        auto Cent = static_cast< InputImagePixelType >( V );
+  const InputImagePixelType firstValue = inBuffer[0];
+  std::atomic< bool >       flat(true);
+  std::vector< OffsetFifoType > fifos(numberOfSlabs);
 
-        // check each neighbor of the input pixel
-        typename ConstInputIterator::ConstIterator sIt;
-        for ( sIt = inNIt.Begin(); !sIt.IsAtEnd(); ++sIt )
+  // Copy the input to the output, and mark the pixels which have a lower
+  // neighbor: they cannot be part of a regional minimum.
+  this->GetMultiThreader()->ParallelizeArray(0, numberOfSlabs,
+    [&]( SizeValueType slab )
+    {
+      const OffsetValueType slabBegin = slabStarts[slab] * offsetTable[LastDimension];
+      const OffsetValueType slabEnd = slabStarts[slab + 1] * offsetTable[LastDimension];
+      bool slabIsFlat = true;
+      for ( OffsetValueType p = slabBegin; p < slabEnd; ++p )
+        {
+        const InputImagePixelType currentValue = inBuffer[p];
+        const auto                V = static_cast< OutputImagePixelType >( currentValue );
+        outBuffer[p] = V;
+        if ( currentValue != firstValue )
+          {
+          slabIsFlat = false;
+          }
+        // if the output pixel value = the marker value then it cannot be
+        // flooded, and doesn't need to be visited
+        if ( !compareOut(V, markerValue) )
           {
-          InputImagePixelType Adjacent = sIt.Get();
+          continue;
+          }
+        const auto         Cent = static_cast< InputImagePixelType >( V );
+        const OutIndexType index = indexOf(p);
+        const bool         onBorder = isOnBorder(index);
+        for ( unsigned int k = 0; k < neighbors.size(); ++k )
+          {
+          const InputImagePixelType Adjacent = ( !onBorder || isInside(index, k) )
+            ? inBuffer[p + neighbors[k]] : m_MarkerValue;
           if ( compareIn(Adjacent, Cent) )
             {
             // The centre pixel cannot be part of a regional minima
             // because one of its neighbors is smaller.
-            // Set all pixels in the output image that are connected to
-            // the centre pixel and have the same value to
-            // m_MarkerValue
-            // This is the flood filling step. It is a simple, stack
-            // based, procedure. The original value (V) of the pixel is
-            // recorded and the pixel index in the output image
-            // is set to the marker value. The stack is initialized
-            // with the pixel index. The flooding procedure pops the
-            // stack, sets that index to the marker value and places the
-            // indexes of all neighbors with value V on the stack. The
-            // process terminates when the stack is empty.
-
-            outNIt += outIt.GetIndex() - outNIt.GetIndex();
-
-            OutputImagePixelType NVal;
-            OutIndexType         idx;
-            // Initialize the stack
-            IS.push( outNIt.GetIndex() );
-            outNIt.SetCenterPixel(m_MarkerValue);
-
-            typename NOutputIterator::IndexListType::const_iterator LIt;
-
-            while( !IS.empty() )
-              {
-              // Pop the stack
-              idx = IS.top();
-              IS.pop();
-              // position the iterator
-              outNIt += idx - outNIt.GetIndex();
-              // check neighbors
-              for ( LIt = IndexList.begin(); LIt != IndexList.end(); ++LIt )
-                {
-                NVal = outNIt.GetPixel(*LIt);
-                if ( NVal == V )
-                  {
-                  // still in a flat zone
-                  IS.push( outNIt.GetIndex(*LIt) );
-
-                  // set the output as the marker value
-                  outNIt.SetPixel(*LIt, m_MarkerValue);
-                  }
-                }
-              }
-            // end flooding
+            outBuffer[p] = markerValue;
+            fifos[slab].push(p);
             break;
             }
           }
         }
-      ++outIt;
-      progress.CompletedPixel();
+      if ( !slabIsFlat )
+        {
+        flat = false;
+        }
+    },
+    nullptr);
+  this->m_Flat = flat;
+  this->UpdateProgress(0.5f);
+
+  // if the image is flat, there is no need to do the work: the image will
+  // be unchanged, even if the marker value is lower than the flat zone
+  if ( this->m_Flat )
+    {
+    for ( OffsetFifoType & fifo : fifos )
+      {
+      for ( ; !fifo.empty(); fifo.pop() )
+        {
+        outBuffer[fifo.front()] = static_cast< OutputImagePixelType >( inBuffer[fifo.front()] );
+        }
+      }
+    this->UpdateProgress(1.0f);
+    return;
+    }
+
+  // Set all pixels in the output image that are connected to a marked pixel
+  // and have the same value to m_MarkerValue. The flat zone pixels found in
+  // another slab are sent to it, and flooded at the next round.
+  // messages[2 * slab] holds the pixels sent to the slab by the previous
+  // slab, and messages[2 * slab + 1] the ones sent by the next slab.
+  std::vector< std::vector< OffsetValueType > > messages[2];
+  messages[0].resize(2 * numberOfSlabs);
+  messages[1].resize(2 * numberOfSlabs);
+  unsigned int current = 0;
+  bool         hasMessages;
+  do
+    {
+    std::vector< std::vector< OffsetValueType > > & received = messages[current];
+    std::vector< std::vector< OffsetValueType > > & sent = messages[1 - current];
+    this->GetMultiThreader()->ParallelizeArray(0, numberOfSlabs,
+      [&]( SizeValueType slab )
+      {
+        OffsetFifoType & fifo = fifos[slab];
+        for ( unsigned int side = 0; side < 2; ++side )
+          {
+          for ( const OffsetValueType q : received[2 * slab + side] )
+            {
+            if ( outBuffer[q] == static_cast< OutputImagePixelType >( inBuffer[q] ) )
+              {
+              outBuffer[q] = markerValue;
+              fifo.push(q);
+              }
+            }
+          received[2 * slab + side].clear();
+          }
+
+        while ( !fifo.empty() )
+          {
+          const OffsetValueType p = fifo.front();
+          fifo.pop();
+          // the original value of the pixel
+          const auto         V = static_cast< OutputImagePixelType >( inBuffer[p] );
+          const OutIndexType index = indexOf(p);
+          const bool         onBorder = isOnBorder(index);
+          const bool         atLowerBoundary = ( slab > 0 && index[LastDimension] == slabStarts[slab] );
+          const bool         atUpperBoundary =
+            ( slab + 1 < numberOfSlabs && index[LastDimension] == slabStarts[slab + 1] - 1 );
+          for ( unsigned int k = 0; k < neighbors.size(); ++k )
+            {
+            if ( onBorder && !isInside(index, k) )
+              {
+              continue;
+              }
+            const OffsetValueType q = p + neighbors[k];
+            if ( static_cast< OutputImagePixelType >( inBuffer[q] ) != V )
+              {
+              continue;
+              }
+            // still in a flat zone
+            if ( atLowerBoundary && neighborSteps[k][LastDimension] < 0 )
+              {
+              sent[2 * ( slab - 1 ) + 1].push_back(q);
+              }
+            else if ( atUpperBoundary && neighborSteps[k][LastDimension] > 0 )
+              {
+              sent[2 * ( slab + 1 )].push_back(q);
+              }
+            else if ( outBuffer[q] == V )
+              {
+              // set the output as the marker value
+              outBuffer[q] = markerValue;
+              fifo.push(q);
+              }
+            }
+          }
+      },
+      nullptr);
+
+    hasMessages = false;
+    for ( const std::vector< OffsetValueType > & messageList : sent )
+      {
+      hasMessages |= !messageList.empty();
       }
+    current = 1 - current;
     }
+  while ( hasMessages );
+
+  this->UpdateProgress(1.0f);
 }
 
 
@@ -0,0 +1,322 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+#include <iostream>
+#include <queue>
+#include <vector>
+
+#include "itkImageRegionConstIterator.h"
+#include "itkImageRegionIteratorWithIndex.h"
+#include "itkMersenneTwisterRandomVariateGenerator.h"
+#include "itkReconstructionByDilationImageFilter.h"
+#include "itkReconstructionByErosionImageFilter.h"
+#include "itkValuedRegionalMaximaImageFilter.h"
+#include "itkValuedRegionalMinimaImageFilter.h"
+
+/* ReconstructionImageFilter and ValuedRegionalExtremaImageFilter split the
+ * image into slabs processed in parallel. The reconstructions by dilation
+ * and erosion computed with several work units are compared to the serial
+ * reconstruction, performed without the internal copy, and the valued
+ * regional extrema to a flat zone labeling of the image. In 2D and 3D, with
+ * face and full connectivity.
+ */
+
+namespace
+{
+
+// Piecewise constant images with noise, so that the flat zones and the
+// reconstructed regions span several slabs.
+template< typename TImage >
+typename TImage::Pointer
+CreateImage( const typename TImage::SizeType & size, unsigned int blockSize, int noise )
+{
+  using RandomizerType = itk::Statistics::MersenneTwisterRandomVariateGenerator;
+  RandomizerType::Pointer randomizer = RandomizerType::New();
+  randomizer->SetSeed( 1234 );
+
+  typename TImage::Pointer image = TImage::New();
+  image->SetRegions( size );
+  image->Allocate();
+
+  itk::ImageRegionIteratorWithIndex< TImage > it( image, image->GetLargestPossibleRegion() );
+  for ( ; !it.IsAtEnd(); ++it )
+    {
+    unsigned int block = 0;
+    for ( unsigned int d = 0; d < TImage::ImageDimension; ++d )
+      {
+      block = 7 * block + static_cast< unsigned int >( it.GetIndex()[d] ) / blockSize;
+      }
+    int value = static_cast< int >( ( block * 37 ) % 11 ) * 20;
+    if ( noise > 0 && randomizer->GetIntegerVariate( 9 ) == 0 )
+      {
+      value += static_cast< int >( randomizer->GetIntegerVariate( 2 * noise ) ) - noise;
+      }
+    it.Set( static_cast< typename TImage::PixelType >( std::min( 255, std::max( 0, value ) ) ) );
+    }
+  return image;
+}
+
+// The marker of an h-maxima or h-minima transform
+template< typename TImage >
+typename TImage::Pointer
+ShiftImage( const TImage * image, int shift )
+{
+  typename TImage::Pointer shifted = TImage::New();
+  shifted->SetRegions( image->GetLargestPossibleRegion() );
+  shifted->Allocate();
+  itk::ImageRegionConstIterator< TImage > it( image, image->GetLargestPossibleRegion() );
+  itk::ImageRegionIterator< TImage >      sit( shifted, shifted->GetLargestPossibleRegion() );
+  for ( ; !it.IsAtEnd(); ++it, ++sit )
+    {
+    sit.Set( static_cast< typename TImage::PixelType >( std::min( 255, std::max( 0, it.Get() + shift ) ) ) );
+    }
+  return shifted;
+}
+
+template< typename TImage >
+bool
+CompareImages( const TImage * image, const TImage * expected, const char * name )
+{
+  itk::ImageRegionConstIterator< TImage > it( image, image->GetLargestPossibleRegion() );
+  itk::ImageRegionConstIterator< TImage > eit( expected, expected->GetLargestPossibleRegion() );
+  for ( ; !it.IsAtEnd(); ++it, ++eit )
+    {
+    if ( it.Get() != eit.Get() )
+      {
+      std::cerr << "Test failed!" << std::endl;
+      std::cerr << name << ": " << static_cast< int >( it.Get() ) << " instead of "
+                << static_cast< int >( eit.Get() ) << " at " << it.GetIndex() << std::endl;
+      return false;
+      }
+    }
+  return true;
+}
+
+template< typename TFilter >
+bool
+TestReconstruction( const typename TFilter::InputImageType * marker, const typename TFilter::InputImageType * mask,
+                    bool fullyConnected, const char * name )
+{
+  typename TFilter::Pointer serialFilter = TFilter::New();
+  serialFilter->SetMarkerImage( marker );
+  serialFilter->SetMaskImage( mask );
+  serialFilter->SetFullyConnected( fullyConnected );
+  serialFilter->UseInternalCopyOff();
+  serialFilter->Update();
+
+  bool testPassed = true;
+  for ( itk::ThreadIdType numberOfWorkUnits : { 1, 3, 8, 100 } )
+    {
+    typename TFilter::Pointer filter = TFilter::New();
+    filter->SetMarkerImage( marker );
+    filter->SetMaskImage( mask );
+    filter->SetFullyConnected( fullyConnected );
+    filter->SetNumberOfWorkUnits( numberOfWorkUnits );
+    filter->Update();
+    std::cout << "  " << name << ", " << numberOfWorkUnits << " work units" << std::endl;
+    testPassed &= CompareImages( filter->GetOutput(), serialFilter->GetOutput(), name );
+    }
+  return testPassed;
+}
+
+// The pixels of the flat zones which have a neighbor lower (or greater)
+// than them are set to the marker value.
+template< typename TImage, typename TCompare >
+typename TImage::Pointer
+ComputeValuedRegionalExtrema( const TImage * image, bool fullyConnected, typename TImage::PixelType markerValue )
+{
+  constexpr unsigned int Dimension = TImage::ImageDimension;
+  using IndexType = typename TImage::IndexType;
+  using OffsetType = typename TImage::OffsetType;
+
+  const typename TImage::RegionType region = image->GetLargestPossibleRegion();
+  std::vector< OffsetType > neighbors;
+  unsigned int numberOfNeighborhoodPixels = 1;
+  for ( unsigned int d = 0; d < Dimension; ++d )
+    {
+    numberOfNeighborhoodPixels *= 3;
+    }
+  for ( unsigned int n = 0; n < numberOfNeighborhoodPixels; ++n )
+    {
+    OffsetType   offset;
+    unsigned int numberOfNonZeroSteps = 0;
+    for ( unsigned int d = 0, k = n; d < Dimension; ++d, k /= 3 )
+      {
+      offset[d] = static_cast< int >( k % 3 ) - 1;
+      numberOfNonZeroSteps += ( offset[d] != 0 );
+      }
+    if ( numberOfNonZeroSteps > 0 && ( fullyConnected || numberOfNonZeroSteps == 1 ) )
+      {
+      neighbors.push_back( offset );
+      }
+    }
+
+  using LabelImageType = itk::Image< int, Dimension >;
+  typename LabelImageType::Pointer visited = LabelImageType::New();
+  visited->SetRegions( region );
+  visited->Allocate( true );
+
+  typename TImage::Pointer output = TImage::New();
+  output->SetRegions( region );
+  output->Allocate();
+
+  TCompare compare;
+  itk::ImageRegionConstIteratorWithIndex< TImage > it( image, region );
+  for ( ; !it.IsAtEnd(); ++it )
+    {
+    if ( visited->GetPixel( it.GetIndex() ) )
+      {
+      continue;
+      }
+    const typename TImage::PixelType value = it.Get();
+    std::vector< IndexType > zone;
+    std::queue< IndexType >  fifo;
+    fifo.push( it.GetIndex() );
+    visited->SetPixel( it.GetIndex(), 1 );
+    bool isExtremum = true;
+    while ( !fifo.empty() )
+      {
+      const IndexType index = fifo.front();
+      fifo.pop();
+      zone.push_back( index );
+      for ( const OffsetType & offset : neighbors )
+        {
+        const IndexType neighbor = index + offset;
+        if ( !region.IsInside( neighbor ) )
+          {
+          continue;
+          }
+        const typename TImage::PixelType neighborValue = image->GetPixel( neighbor );
+        if ( compare( neighborValue, value ) )
+          {
+          isExtremum = false;
+          }
+        else if ( neighborValue == value && !visited->GetPixel( neighbor ) )
+          {
+          visited->SetPixel( neighbor, 1 );
+          fifo.push( neighbor );
+          }
+        }
+      }
+    for ( const IndexType & index : zone )
+      {
+      output->SetPixel( index, isExtremum ? value : markerValue );
+      }
+    }
+  return output;
+}
+
+template< typename TFilter, typename TCompare >
+bool
+TestValuedRegionalExtrema( const typename TFilter::InputImageType * image, bool fullyConnected, const char * name )
+{
+  using ImageType = typename TFilter::InputImageType;
+
+  bool testPassed = true;
+  for ( itk::ThreadIdType numberOfWorkUnits : { 1, 3, 8, 100 } )
+    {
+    typename TFilter::Pointer filter = TFilter::New();
+    filter->SetInput( image );
+    filter->SetFullyConnected( fullyConnected );
+    filter->SetNumberOfWorkUnits( numberOfWorkUnits );
+    filter->Update();
+    std::cout << "  " << name << ", " << numberOfWorkUnits << " work units" << std::endl;
+    typename ImageType::Pointer expected =
+      ComputeValuedRegionalExtrema< ImageType, TCompare >( image, fullyConnected, filter->GetMarkerValue() );
+    testPassed &= CompareImages( filter->GetOutput(), expected.GetPointer(), name );
+    if ( filter->GetFlat() )
+      {
+      std::cerr << "Test failed!" << std::endl;
+      std::cerr << name << ": the image is not flat" << std::endl;
+      testPassed = false;
+      }
+    }
+  return testPassed;
+}
+
+template< unsigned int VDimension >
+bool
+TestDimension( const typename itk::Image< unsigned char, VDimension >::SizeType & size, unsigned int blockSize )
+{
+  using ImageType = itk::Image< unsigned char, VDimension >;
+  using DilationFilterType = itk::ReconstructionByDilationImageFilter< ImageType, ImageType >;
+  using ErosionFilterType = itk::ReconstructionByErosionImageFilter< ImageType, ImageType >;
+  using MaximaFilterType = itk::ValuedRegionalMaximaImageFilter< ImageType, ImageType >;
+  using MinimaFilterType = itk::ValuedRegionalMinimaImageFilter< ImageType, ImageType >;
+
+  std::cout << VDimension << "D" << std::endl;
+
+  typename ImageType::Pointer image = CreateImage< ImageType >( size, blockSize, 15 );
+  typename ImageType::Pointer lowered = ShiftImage< ImageType >( image, -30 );
+  typename ImageType::Pointer raised = ShiftImage< ImageType >( image, 30 );
+  typename ImageType::Pointer plateaus = CreateImage< ImageType >( size, blockSize, 0 );
+
+  bool testPassed = true;
+  for ( bool fullyConnected : { false, true } )
+    {
+    std::cout << " FullyConnected: " << fullyConnected << std::endl;
+    testPassed &= TestReconstruction< DilationFilterType >( lowered, image, fullyConnected, "Dilation" );
+    testPassed &= TestReconstruction< ErosionFilterType >( raised, image, fullyConnected, "Erosion" );
+    testPassed &= TestValuedRegionalExtrema< MaximaFilterType, std::greater< unsigned char > >(
+      image, fullyConnected, "Maxima" );
+    testPassed &= TestValuedRegionalExtrema< MinimaFilterType, std::less< unsigned char > >(
+      image, fullyConnected, "Minima" );
+    testPassed &= TestValuedRegionalExtrema< MaximaFilterType, std::greater< unsigned char > >(
+      plateaus, fullyConnected, "Maxima, plateaus" );
+    testPassed &= TestValuedRegionalExtrema< MinimaFilterType, std::less< unsigned char > >(
+      plateaus, fullyConnected, "Minima, plateaus" );
+    }
+
+  // A flat image is left unchanged
+  typename ImageType::Pointer flatImage = ImageType::New();
+  flatImage->SetRegions( size );
+  flatImage->Allocate();
+  flatImage->FillBuffer( 100 );
+  typename MinimaFilterType::Pointer filter = MinimaFilterType::New();
+  filter->SetInput( flatImage );
+  filter->SetNumberOfWorkUnits( 4 );
+  filter->Update();
+  testPassed &= CompareImages( filter->GetOutput(), flatImage.GetPointer(), "Flat" );
+  if ( !filter->GetFlat() )
+    {
+    std::cerr << "Test failed!" << std::endl;
+    std::cerr << "Flat: the image is flat" << std::endl;
+    testPassed = false;
+    }
+
+  return testPassed;
+}
+}
+
+int itkReconstructionImageFilterWorkUnitsTest( int, char *[] )
+{
+  bool testPassed = true;
+
+  itk::Size< 2 > size2D = {{ 41, 37 }};
+  testPassed &= TestDimension< 2 >( size2D, 5 );
+
+  itk::Size< 3 > size3D = {{ 15, 13, 17 }};
+  testPassed &= TestDimension< 3 >( size3D, 3 );
+
+  if ( !testPassed )
+    {
+    return EXIT_FAILURE;
+    }
+  std::cout << "Test finished." << std::endl;
+  return EXIT_SUCCESS;
+}
@@ -21,6 +21,9 @@
 #include "itkImageToImageFilter.h"
 #include "itkImage.h"
 
+#include <type_traits>
+#include <vector>
+
 namespace itk
 {
 /**
@@ -43,6 +46,11 @@ namespace itk
  * When the Gaussian kernel is small, this filter tends to run faster than
  * itk::RecursiveGaussianImageFilter.
  *
+ * Images of scalars are convolved one dimension after the other, by
+ * bundles of lines copied to buffers, through a single intermediate
+ * image. The other images are convolved by a mini-pipeline of
+ * NeighborhoodOperatorImageFilter, with the same results.
+ *
  * \sa GaussianOperator
  * \sa Image
  * \sa Neighborhood
@@ -244,13 +252,40 @@ protected:
   void PrintSelf(std::ostream & os, Indent indent) const override;
 
   /** Standard pipeline method. While this class does not implement a
-   * ThreadedGenerateData(), its GenerateData() delegates all
-   * calculations to an NeighborhoodOperatorImageFilter.  Since the
+   * ThreadedGenerateData(), its GenerateData() convolves the lines of
+   * images of scalars in parallel, and delegates the calculations on the
+   * other images to an NeighborhoodOperatorImageFilter.  Since the
    * NeighborhoodOperatorImageFilter is multithreaded, this filter is
    * multithreaded by default. */
   void GenerateData() override;
 
 private:
+  using OutputImageRegionType = typename TOutputImage::RegionType;
+
+  /** Images of scalars, whose lines are convolved without the
+   * mini-pipeline. */
+  using LineConvolutionType = std::integral_constant< bool,
+                                                      std::is_arithmetic< InputPixelType >::value
+                                                      && std::is_arithmetic< OutputPixelType >::value
+                                                      && std::is_same< TInputImage,
+                                                                       Image< InputPixelType, ImageDimension > >::value
+                                                      && std::is_same< TOutputImage,
+                                                                       Image< OutputPixelType, ImageDimension > >::value >;
+
+  /** Convolves the output requested region with the kernels, one
+   * dimension after the other from the last one filtered, as the
+   * mini-pipeline does. */
+  void LineConvolutionGenerateData(const std::vector< std::vector< double > > & kernels, std::true_type);
+  void LineConvolutionGenerateData(const std::vector< std::vector< double > > &, std::false_type) {}
+
+  /** Convolves the lines of the region along the direction, clamping the
+   * indices to the region of the source as done by the
+   * ZeroFluxNeumannBoundaryCondition. */
+  template< typename TSourceImage >
+  void ConvolveLines(const TSourceImage *source, const OutputImageRegionType & sourceRegion,
+                     TOutputImage *destination, const OutputImageRegionType & region,
+                     unsigned int direction, const std::vector< double > & kernel);
+
   /** The variance of the gaussian blurring kernel in each dimensional
     direction. */
   ArrayType m_Variance;
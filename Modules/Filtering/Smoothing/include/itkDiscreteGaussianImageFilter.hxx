@@ -22,9 +22,12 @@
 #include "itkNeighborhoodOperatorImageFilter.h"
 #include "itkGaussianOperator.h"
 #include "itkImageRegionIterator.h"
+#include "itkImageScanlineConstIterator.h"
 #include "itkProgressAccumulator.h"
 #include "itkImageAlgorithm.h"
 
+#include <algorithm>
+
 namespace itk
 {
 template< typename TInputImage, typename TOutputImage >
@@ -212,6 +215,17 @@ DiscreteGaussianImageFilter< TInputImage, TOutputImage >
     oper[reverse_i].CreateDirectional();
     }
 
+  if ( LineConvolutionType::value )
+    {
+    std::vector< std::vector< double > > kernels( filterDimensionality );
+    for ( i = 0; i < filterDimensionality; ++i )
+      {
+      kernels[i].assign( oper[i].Begin(), oper[i].End() );
+      }
+    this->LineConvolutionGenerateData( kernels, LineConvolutionType() );
+    return;
+    }
+
   // Create a chain of filters
   //
   //
@@ -303,6 +317,158 @@ DiscreteGaussianImageFilter< TInputImage, TOutputImage >
     }
 }
 
+template< typename TInputImage, typename TOutputImage >
+void
+DiscreteGaussianImageFilter< TInputImage, TOutputImage >
+::LineConvolutionGenerateData(const std::vector< std::vector< double > > & kernels, std::true_type)
+{
+  const InputImageType * input = this->GetInput();
+  OutputImageType *      output = this->GetOutput();
+  const auto             numberOfStages = static_cast< unsigned int >( kernels.size() );
+
+  // Each stage computes the region requested by the next one, padded
+  // along the direction of the next one and cropped, as requested by a
+  // NeighborhoodOperatorImageFilter.
+  std::vector< OutputImageRegionType > regions( numberOfStages );
+  regions[numberOfStages - 1] = output->GetRequestedRegion();
+  for ( unsigned int k = numberOfStages - 1; k > 0; --k )
+    {
+    typename OutputImageRegionType::SizeType radius;
+    radius.Fill( 0 );
+    radius[numberOfStages - 1 - k] = kernels[k].size() / 2;
+    regions[k - 1] = regions[k];
+    regions[k - 1].PadByRadius( radius );
+    regions[k - 1].Crop( input->GetLargestPossibleRegion() );
+    }
+
+  // The regions of the stages are nested, and computed in place in a
+  // single intermediate image.
+  typename OutputImageType::Pointer intermediate;
+  if ( numberOfStages > 1 )
+    {
+    intermediate = OutputImageType::New();
+    intermediate->SetRegions( regions[0] );
+    intermediate->Allocate();
+    }
+
+  for ( unsigned int k = 0; k < numberOfStages; ++k )
+    {
+    const unsigned int direction = numberOfStages - 1 - k;
+    OutputImageType * destination = ( k + 1 == numberOfStages ) ? output : intermediate.GetPointer();
+    if ( k == 0 )
+      {
+      this->ConvolveLines( input, input->GetBufferedRegion(), destination, regions[k], direction, kernels[k] );
+      }
+    else
+      {
+      const OutputImageType * source = intermediate.GetPointer();
+      this->ConvolveLines( source, regions[k - 1], destination, regions[k], direction, kernels[k] );
+      }
+    this->UpdateProgress( static_cast< float >( k + 1 ) / static_cast< float >( numberOfStages ) );
+    }
+}
+
+template< typename TInputImage, typename TOutputImage >
+template< typename TSourceImage >
+void
+DiscreteGaussianImageFilter< TInputImage, TOutputImage >
+::ConvolveLines(const TSourceImage *source, const OutputImageRegionType & sourceRegion,
+                TOutputImage *destination, const OutputImageRegionType & region,
+                unsigned int direction, const std::vector< double > & kernel)
+{
+  using IndexType = typename OutputImageRegionType::IndexType;
+  using SourcePixelType = typename TSourceImage::PixelType;
+  // the type in which NeighborhoodOperatorImageFilter computes the pixels
+  using ComputingPixelType = typename NumericTraits< OutputPixelType >::RealType;
+
+  if ( region.GetNumberOfPixels() == 0 )
+    {
+    return;
+    }
+
+  // The lines adjacent along the first dimension are convolved together,
+  // so that the pixels are read and written in contiguous blocks.
+  const SizeValueType bundleWidth = ( direction == 0 ) ? 1 : 16;
+
+  const auto            radius = static_cast< IndexValueType >( kernel.size() / 2 );
+  const IndexValueType  firstSourceIndex = sourceRegion.GetIndex(direction);
+  const IndexValueType  lastSourceIndex = firstSourceIndex + static_cast< IndexValueType >( sourceRegion.GetSize(direction) ) - 1;
+  const IndexValueType  start = region.GetIndex(direction);
+  const SizeValueType   length = region.GetSize(direction);
+  const OffsetValueType sourceStride = source->GetOffsetTable()[direction];
+  const OffsetValueType destinationStride = destination->GetOffsetTable()[direction];
+
+  MultiThreaderBase * multiThreader = this->GetMultiThreader();
+  multiThreader->SetNumberOfWorkUnits( this->GetNumberOfWorkUnits() );
+  multiThreader->template ParallelizeImageRegionRestrictDirection< ImageDimension >(
+    direction,
+    region,
+    [&](const OutputImageRegionType & lines)
+    {
+      std::vector< double > values( ( length + kernel.size() - 1 ) * bundleWidth );
+      std::vector< double > sums( length * bundleWidth );
+
+      OutputImageRegionType lineStarts = lines;
+      lineStarts.SetSize( direction, 1 );
+      const SizeValueType numberOfAdjacentLines = lineStarts.GetSize(0);
+
+      ImageScanlineConstIterator< TOutputImage > it( destination, lineStarts );
+      while ( !it.IsAtEnd() )
+        {
+        for ( SizeValueType x = 0; x < numberOfAdjacentLines; x += bundleWidth )
+          {
+          const SizeValueType width = std::min( bundleWidth, numberOfAdjacentLines - x );
+
+          IndexType sourceIndex = it.GetIndex();
+          sourceIndex[0] += x;
+          sourceIndex[direction] = firstSourceIndex;
+          const SourcePixelType * sourceLines = source->GetBufferPointer() + source->ComputeOffset( sourceIndex );
+          for ( SizeValueType j = 0; j < length + kernel.size() - 1; ++j )
+            {
+            const IndexValueType position = std::min( std::max( start - radius + static_cast< IndexValueType >( j ),
+                                                                firstSourceIndex ), lastSourceIndex );
+            const SourcePixelType * pixels = sourceLines + ( position - firstSourceIndex ) * sourceStride;
+            double * lineValues = values.data() + j * width;
+            for ( SizeValueType b = 0; b < width; ++b )
+              {
+              lineValues[b] = static_cast< double >( pixels[b] );
+              }
+            }
+
+          // the products are summed in the order of the kernel, as by
+          // NeighborhoodInnerProduct, over the contiguous sums
+          const SizeValueType numberOfSums = length * width;
+          std::fill( sums.begin(), sums.begin() + numberOfSums, 0.0 );
+          for ( SizeValueType k = 0; k < kernel.size(); ++k )
+            {
+            const double   coefficient = kernel[k];
+            const double * lineValues = values.data() + k * width;
+            for ( SizeValueType m = 0; m < numberOfSums; ++m )
+              {
+              sums[m] += coefficient * lineValues[m];
+              }
+            }
+
+          IndexType destinationIndex = it.GetIndex();
+          destinationIndex[0] += x;
+          destinationIndex[direction] = start;
+          OutputPixelType * destinationLines =
+            destination->GetBufferPointer() + destination->ComputeOffset( destinationIndex );
+          for ( SizeValueType i = 0; i < length; ++i )
+            {
+            OutputPixelType * pixels = destinationLines + i * destinationStride;
+            for ( SizeValueType b = 0; b < width; ++b )
+              {
+              pixels[b] = static_cast< OutputPixelType >( static_cast< ComputingPixelType >( sums[i * width + b] ) );
+              }
+            }
+          }
+        it.NextLine();
+        }
+    },
+    nullptr);
+}
+
 #if !defined( ITK_LEGACY_REMOVE )
 template< typename TInputImage, typename TOutputImage >
 unsigned int
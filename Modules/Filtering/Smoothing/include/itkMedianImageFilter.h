@@ -21,6 +21,8 @@
 #include "itkBoxImageFilter.h"
 #include "itkImage.h"
 
+#include <type_traits>
+
 namespace itk
 {
 /** \class MedianImageFilter
@@ -35,6 +37,14 @@ namespace itk
  * This filter requires that the input pixel type provides an operator<()
  * (LessThan Comparable).
  *
+ * The algorithm is chosen from the pixel type and the radius. For 8-bit
+ * and 16-bit integer pixels and large neighborhoods, a histogram of the
+ * neighborhood is updated while sliding along the rows (Huang's
+ * algorithm), so that the cost per pixel grows with the size of a
+ * neighborhood face rather than with the size of the neighborhood. The
+ * median of a 3x3 neighborhood of scalars is found with a fixed network
+ * of compare-exchanges, and the other neighborhoods are partially sorted.
+ *
  * \sa Image
  * \sa Neighborhood
  * \sa NeighborhoodOperator
@@ -111,6 +121,25 @@ protected:
    *     ImageToImageFilter::GenerateData() */
   void DynamicThreadedGenerateData(const OutputImageRegionType & outputRegionForThread) override;
 
+private:
+  /** Integer pixel types of at most 16 bits, whose values index a
+   * histogram. */
+  using HistogramPixelType = std::integral_constant< bool,
+                                                     std::is_integral< InputPixelType >::value
+                                                     && !std::is_same< InputPixelType, bool >::value
+                                                     && sizeof( InputPixelType ) <= 2 >;
+
+  /** Computes the medians with a histogram sliding along the rows. */
+  void HistogramThreadedGenerateData(const OutputImageRegionType & outputRegionForThread, std::true_type);
+  void HistogramThreadedGenerateData(const OutputImageRegionType &, std::false_type) {}
+
+  /** Computes the medians by partially sorting each neighborhood. */
+  void SortingThreadedGenerateData(const OutputImageRegionType & outputRegionForThread);
+
+  /** Returns the median of nine values, reordering them with the network
+   * of compare-exchanges of Paeth, "Median Finding on a 3x3 Grid",
+   * Graphics Gems, 1990. */
+  static InputPixelType MedianOfNine(InputPixelType *values);
 };
 } // end namespace itk
 
@@ -22,12 +22,14 @@
 #include "itkConstNeighborhoodIterator.h"
 #include "itkNeighborhoodInnerProduct.h"
 #include "itkImageRegionIterator.h"
+#include "itkImageScanlineIterator.h"
 #include "itkNeighborhoodAlgorithm.h"
 #include "itkOffset.h"
 #include "itkProgressReporter.h"
 
 #include <vector>
 #include <algorithm>
+#include <limits>
 
 namespace itk
 {
@@ -42,6 +44,170 @@ template< typename TInputImage, typename TOutputImage >
 void
 MedianImageFilter< TInputImage, TOutputImage >
 ::DynamicThreadedGenerateData(const OutputImageRegionType & outputRegionForThread)
+{
+  // The histogram is worth updating when the neighborhood is larger than
+  // the number of bins searched for the median, which are fewer for 8-bit
+  // pixels.
+  const SizeValueType minimumHistogramNeighborhoodSize = ( sizeof( InputPixelType ) == 1 ) ? 25 : 125;
+
+  SizeValueType neighborhoodSize = 1;
+  for ( unsigned int i = 0; i < InputImageDimension; ++i )
+    {
+    neighborhoodSize *= 2 * this->GetRadius()[i] + 1;
+    }
+
+  if ( HistogramPixelType::value && neighborhoodSize >= minimumHistogramNeighborhoodSize )
+    {
+    this->HistogramThreadedGenerateData( outputRegionForThread, HistogramPixelType() );
+    }
+  else
+    {
+    this->SortingThreadedGenerateData( outputRegionForThread );
+    }
+}
+
+template< typename TInputImage, typename TOutputImage >
+void
+MedianImageFilter< TInputImage, TOutputImage >
+::HistogramThreadedGenerateData(const OutputImageRegionType & outputRegionForThread, std::true_type)
+{
+  // The bins are split in coarse bins, so that the median is found by
+  // walking a few coarse bins and then the fine bins of one of them.
+  constexpr unsigned int  NumberOfBits = 8 * sizeof( InputPixelType );
+  constexpr unsigned int  FineBitShift = NumberOfBits / 2;
+  constexpr SizeValueType NumberOfBins = SizeValueType{ 1 } << NumberOfBits;
+  constexpr SizeValueType NumberOfCoarseBins = NumberOfBins >> FineBitShift;
+  constexpr long          MinimumValue = std::numeric_limits< InputPixelType >::min();
+
+  OutputImageType *      output = this->GetOutput();
+  const InputImageType * input = this->GetInput();
+  const InputSizeType &  radius = this->GetRadius();
+
+  const InputImageRegionType & bufferedRegion = input->GetBufferedRegion();
+  const InputPixelType *       buffer = input->GetBufferPointer();
+  const OffsetValueType *      offsetTable = input->GetOffsetTable();
+
+  // The neighborhood is made of rows along the first dimension. The
+  // indices out of the buffer are clamped, as with the
+  // ZeroFluxNeumannBoundaryCondition.
+  const auto clamp = [&bufferedRegion](IndexValueType index, unsigned int dimension) -> OffsetValueType
+    {
+    const IndexValueType first = bufferedRegion.GetIndex(dimension);
+    const IndexValueType last = first + static_cast< IndexValueType >( bufferedRegion.GetSize(dimension) ) - 1;
+    return std::min( std::max( index, first ), last ) - first;
+    };
+
+  SizeValueType numberOfRows = 1;
+  for ( unsigned int i = 1; i < InputImageDimension; ++i )
+    {
+    numberOfRows *= 2 * radius[i] + 1;
+    }
+  const SizeValueType medianRank = numberOfRows * ( 2 * radius[0] + 1 ) / 2;
+
+  // the columns of the neighborhoods of the pixels of a row of the output
+  const SizeValueType            rowLength = outputRegionForThread.GetSize(0);
+  const SizeValueType            windowWidth = 2 * radius[0] + 1;
+  std::vector< OffsetValueType > columns( rowLength + 2 * radius[0] );
+  for ( SizeValueType i = 0; i < columns.size(); ++i )
+    {
+    columns[i] = clamp( outputRegionForThread.GetIndex(0) - static_cast< IndexValueType >( radius[0] )
+                        + static_cast< IndexValueType >( i ), 0 );
+    }
+
+  std::vector< unsigned int >           fineCounts( NumberOfBins, 0 );
+  std::vector< unsigned int >           coarseCounts( NumberOfCoarseBins, 0 );
+  std::vector< const InputPixelType * > rows( numberOfRows );
+
+  // the coarse bin of the last median, and the number of values below it
+  SizeValueType medianCoarseBin = 0;
+  SizeValueType belowMedianCoarseBin = 0;
+
+  const auto addColumn = [&](OffsetValueType column)
+    {
+    for ( const InputPixelType * row : rows )
+      {
+      const auto bin = static_cast< SizeValueType >( row[column] - MinimumValue );
+      ++fineCounts[bin];
+      ++coarseCounts[bin >> FineBitShift];
+      belowMedianCoarseBin += ( ( bin >> FineBitShift ) < medianCoarseBin );
+      }
+    };
+  const auto removeColumn = [&](OffsetValueType column)
+    {
+    for ( const InputPixelType * row : rows )
+      {
+      const auto bin = static_cast< SizeValueType >( row[column] - MinimumValue );
+      --fineCounts[bin];
+      --coarseCounts[bin >> FineBitShift];
+      belowMedianCoarseBin -= ( ( bin >> FineBitShift ) < medianCoarseBin );
+      }
+    };
+
+  ImageScanlineIterator< OutputImageType > it( output, outputRegionForThread );
+  while ( !it.IsAtEnd() )
+    {
+    const typename OutputImageType::IndexType & lineIndex = it.GetIndex();
+    for ( SizeValueType r = 0; r < numberOfRows; ++r )
+      {
+      OffsetValueType offset = 0;
+      SizeValueType   remainder = r;
+      for ( unsigned int i = 1; i < InputImageDimension; ++i )
+        {
+        const SizeValueType width = 2 * radius[i] + 1;
+        const IndexValueType index = lineIndex[i] - static_cast< IndexValueType >( radius[i] )
+                                     + static_cast< IndexValueType >( remainder % width );
+        offset += clamp( index, i ) * offsetTable[i];
+        remainder /= width;
+        }
+      rows[r] = buffer + offset;
+      }
+
+    for ( SizeValueType i = 0; i < windowWidth; ++i )
+      {
+      addColumn( columns[i] );
+      }
+    for ( SizeValueType i = 0; ; )
+      {
+      // the median moves by a few coarse bins from one pixel to the next
+      while ( belowMedianCoarseBin > medianRank )
+        {
+        --medianCoarseBin;
+        belowMedianCoarseBin -= coarseCounts[medianCoarseBin];
+        }
+      while ( belowMedianCoarseBin + coarseCounts[medianCoarseBin] <= medianRank )
+        {
+        belowMedianCoarseBin += coarseCounts[medianCoarseBin];
+        ++medianCoarseBin;
+        }
+      SizeValueType bin = medianCoarseBin << FineBitShift;
+      for ( SizeValueType count = belowMedianCoarseBin + fineCounts[bin]; count <= medianRank; count += fineCounts[bin] )
+        {
+        ++bin;
+        }
+      it.Set( static_cast< OutputPixelType >( static_cast< InputPixelType >( static_cast< long >( bin ) + MinimumValue ) ) );
+      ++it;
+
+      if ( ++i == rowLength )
+        {
+        break;
+        }
+      removeColumn( columns[i - 1] );
+      addColumn( columns[i + windowWidth - 1] );
+      }
+
+    // empty the histogram for the next row
+    for ( SizeValueType i = rowLength - 1; i < rowLength - 1 + windowWidth; ++i )
+      {
+      removeColumn( columns[i] );
+      }
+    it.NextLine();
+    }
+}
+
+template< typename TInputImage, typename TOutputImage >
+void
+MedianImageFilter< TInputImage, TOutputImage >
+::SortingThreadedGenerateData(const OutputImageRegionType & outputRegionForThread)
 {
   // Allocate output
   typename OutputImageType::Pointer output = this->GetOutput();
@@ -81,15 +247,44 @@ MedianImageFilter< TInputImage, TOutputImage >
         }
 
       // get the median value
-      const typename std::vector< InputPixelType >::iterator medianIterator = pixels.begin() + medianPosition;
-      std::nth_element( pixels.begin(), medianIterator, pixels.end() );
-      it.Set( static_cast< typename OutputImageType::PixelType >( *medianIterator ) );
+      if ( neighborhoodSize == 9 && std::is_arithmetic< InputPixelType >::value )
+        {
+        it.Set( static_cast< typename OutputImageType::PixelType >( Self::MedianOfNine( pixels.data() ) ) );
+        }
+      else
+        {
+        const typename std::vector< InputPixelType >::iterator medianIterator = pixels.begin() + medianPosition;
+        std::nth_element( pixels.begin(), medianIterator, pixels.end() );
+        it.Set( static_cast< typename OutputImageType::PixelType >( *medianIterator ) );
+        }
 
       ++bit;
       ++it;
       }
     }
 }
+template< typename TInputImage, typename TOutputImage >
+typename MedianImageFilter< TInputImage, TOutputImage >::InputPixelType
+MedianImageFilter< TInputImage, TOutputImage >
+::MedianOfNine(InputPixelType *p)
+{
+  // the values of each pair are sorted with min and max, without branches
+  const auto sort = [](InputPixelType & a, InputPixelType & b)
+    {
+    const InputPixelType minimum = std::min( a, b );
+    b = std::max( a, b );
+    a = minimum;
+    };
+
+  sort( p[1], p[2] ); sort( p[4], p[5] ); sort( p[7], p[8] );
+  sort( p[0], p[1] ); sort( p[3], p[4] ); sort( p[6], p[7] );
+  sort( p[1], p[2] ); sort( p[4], p[5] ); sort( p[7], p[8] );
+  sort( p[0], p[3] ); sort( p[5], p[8] ); sort( p[4], p[7] );
+  sort( p[3], p[6] ); sort( p[1], p[4] ); sort( p[2], p[5] );
+  sort( p[4], p[7] ); sort( p[4], p[2] ); sort( p[6], p[4] );
+  sort( p[4], p[2] );
+  return p[4];
+}
 } // end namespace itk
 
 #endif
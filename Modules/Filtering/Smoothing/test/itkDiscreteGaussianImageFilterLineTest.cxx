@@ -0,0 +1,94 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+#include "itkDiscreteGaussianImageFilter.h"
+#include "itkImageFileReader.h"
+#include "itkImageFileWriter.h"
+#include "itkTestingMacros.h"
+
+#include <cstring>
+
+// Smooths the scalar image, whose lines are convolved instead of going
+// through the mini-pipeline of NeighborhoodOperatorImageFilter. The
+// baselines are the outputs of the mini-pipeline. Float and double inputs
+// are smoothed to short images, whose MD5 the test driver can compute.
+template< typename TInputPixel, typename TOutputPixel, unsigned int VDimension >
+int
+DiscreteGaussianImageFilterLineTest( char * argv[] )
+{
+  using ImageType = itk::Image< TInputPixel, VDimension >;
+  using OutputImageType = itk::Image< TOutputPixel, VDimension >;
+
+  using ReaderType = itk::ImageFileReader< ImageType >;
+  typename ReaderType::Pointer reader = ReaderType::New();
+  reader->SetFileName( argv[3] );
+
+  using FilterType = itk::DiscreteGaussianImageFilter< ImageType, OutputImageType >;
+  typename FilterType::Pointer filter = FilterType::New();
+  filter->SetInput( reader->GetOutput() );
+  filter->SetVariance( std::stod( argv[5] ) );
+  filter->SetMaximumKernelWidth( 64 );
+  filter->SetFilterDimensionality( std::stoi( argv[6] ) );
+
+  using WriterType = itk::ImageFileWriter< OutputImageType >;
+  typename WriterType::Pointer writer = WriterType::New();
+  writer->SetFileName( argv[4] );
+  writer->SetInput( filter->GetOutput() );
+  TRY_EXPECT_NO_EXCEPTION( writer->Update() );
+
+  return EXIT_SUCCESS;
+}
+
+int itkDiscreteGaussianImageFilterLineTest( int argc, char * argv[] )
+{
+  if ( argc < 7 )
+    {
+    std::cerr << "Missing parameters." << std::endl;
+    std::cerr << "Usage: " << argv[0]
+              << " imageDimension pixelType(uchar|short|float|double) inputImage outputImage variance"
+              << " filterDimensionality" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  const unsigned int dimension = std::stoi( argv[1] );
+  const char *       pixelType = argv[2];
+
+  if ( dimension == 2 && !strcmp( pixelType, "uchar" ) )
+    {
+    return DiscreteGaussianImageFilterLineTest< unsigned char, unsigned char, 2 >( argv );
+    }
+  if ( dimension == 2 && !strcmp( pixelType, "float" ) )
+    {
+    return DiscreteGaussianImageFilterLineTest< float, short, 2 >( argv );
+    }
+  if ( dimension == 2 && !strcmp( pixelType, "double" ) )
+    {
+    return DiscreteGaussianImageFilterLineTest< double, short, 2 >( argv );
+    }
+  if ( dimension == 3 && !strcmp( pixelType, "short" ) )
+    {
+    return DiscreteGaussianImageFilterLineTest< short, short, 3 >( argv );
+    }
+  if ( dimension == 3 && !strcmp( pixelType, "float" ) )
+    {
+    return DiscreteGaussianImageFilterLineTest< float, short, 3 >( argv );
+    }
+
+  std::cerr << "Unsupported image type: " << dimension << "D " << pixelType << std::endl;
+  return EXIT_FAILURE;
+}
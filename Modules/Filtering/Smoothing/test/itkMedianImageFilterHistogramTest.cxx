@@ -0,0 +1,136 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+#include "itkConstNeighborhoodIterator.h"
+#include "itkImageFileReader.h"
+#include "itkImageFileWriter.h"
+#include "itkMedianImageFilter.h"
+#include "itkTestingMacros.h"
+#include "itkTimeProbe.h"
+
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+namespace
+{
+// Computes the median of each neighborhood by partially sorting it, as the
+// filter did before the histogram and the compare-exchange network. Only
+// used to time the filter against it.
+template< typename TImage >
+void
+PartialSortMedian( const TImage * input, const typename TImage::SizeType & radius, TImage * output )
+{
+  itk::ZeroFluxNeumannBoundaryCondition< TImage > boundaryCondition;
+  itk::ConstNeighborhoodIterator< TImage > nit( radius, input, input->GetBufferedRegion() );
+  nit.OverrideBoundaryCondition( &boundaryCondition );
+  std::vector< typename TImage::PixelType > pixels( nit.Size() );
+  for ( nit.GoToBegin(); !nit.IsAtEnd(); ++nit )
+    {
+    for ( unsigned int i = 0; i < nit.Size(); ++i )
+      {
+      pixels[i] = nit.GetPixel( i );
+      }
+    std::nth_element( pixels.begin(), pixels.begin() + pixels.size() / 2, pixels.end() );
+    output->SetPixel( nit.GetIndex(), pixels[pixels.size() / 2] );
+    }
+}
+
+// Float inputs are filtered to short images, whose MD5 the test driver can
+// compute.
+template< typename TInputPixel, typename TOutputPixel, unsigned int VDimension >
+int
+MedianImageFilterHistogramTest( char * argv[] )
+{
+  using ImageType = itk::Image< TInputPixel, VDimension >;
+  using OutputImageType = itk::Image< TOutputPixel, VDimension >;
+
+  using ReaderType = itk::ImageFileReader< ImageType >;
+  typename ReaderType::Pointer reader = ReaderType::New();
+  reader->SetFileName( argv[3] );
+  TRY_EXPECT_NO_EXCEPTION( reader->Update() );
+
+  using FilterType = itk::MedianImageFilter< ImageType, OutputImageType >;
+  typename FilterType::Pointer filter = FilterType::New();
+  filter->SetInput( reader->GetOutput() );
+  filter->SetRadius( std::stoi( argv[5] ) );
+
+  itk::TimeProbe filterProbe;
+  filterProbe.Start();
+  TRY_EXPECT_NO_EXCEPTION( filter->Update() );
+  filterProbe.Stop();
+
+  // The time of the partial sort is only informative.
+  typename ImageType::Pointer sorted = ImageType::New();
+  sorted->CopyInformation( reader->GetOutput() );
+  sorted->SetRegions( reader->GetOutput()->GetBufferedRegion() );
+  sorted->Allocate();
+  itk::TimeProbe sortProbe;
+  sortProbe.Start();
+  PartialSortMedian< ImageType >( reader->GetOutput(), filter->GetRadius(), sorted );
+  sortProbe.Stop();
+  std::cout << "MedianImageFilter: " << filterProbe.GetTotal() << " s, partial sort: " << sortProbe.GetTotal()
+            << " s" << std::endl;
+
+  using WriterType = itk::ImageFileWriter< OutputImageType >;
+  typename WriterType::Pointer writer = WriterType::New();
+  writer->SetFileName( argv[4] );
+  writer->SetInput( filter->GetOutput() );
+  TRY_EXPECT_NO_EXCEPTION( writer->Update() );
+
+  return EXIT_SUCCESS;
+}
+}
+
+int itkMedianImageFilterHistogramTest( int argc, char * argv[] )
+{
+  if ( argc < 6 )
+    {
+    std::cerr << "Missing parameters." << std::endl;
+    std::cerr << "Usage: " << argv[0]
+              << " imageDimension pixelType(uchar|short|ushort|float) inputImage outputImage radius" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  const unsigned int dimension = std::stoi( argv[1] );
+  const char *       pixelType = argv[2];
+
+  if ( dimension == 2 && !strcmp( pixelType, "uchar" ) )
+    {
+    return MedianImageFilterHistogramTest< unsigned char, unsigned char, 2 >( argv );
+    }
+  if ( dimension == 2 && !strcmp( pixelType, "ushort" ) )
+    {
+    return MedianImageFilterHistogramTest< unsigned short, unsigned short, 2 >( argv );
+    }
+  if ( dimension == 2 && !strcmp( pixelType, "float" ) )
+    {
+    return MedianImageFilterHistogramTest< float, short, 2 >( argv );
+    }
+  if ( dimension == 3 && !strcmp( pixelType, "uchar" ) )
+    {
+    return MedianImageFilterHistogramTest< unsigned char, unsigned char, 3 >( argv );
+    }
+  if ( dimension == 3 && !strcmp( pixelType, "short" ) )
+    {
+    return MedianImageFilterHistogramTest< short, short, 3 >( argv );
+    }
+
+  std::cerr << "Unsupported image type: " << dimension << "D " << pixelType << std::endl;
+  return EXIT_FAILURE;
+}
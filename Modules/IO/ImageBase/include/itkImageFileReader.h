@@ -118,6 +118,21 @@ public:
   itkGetConstReferenceMacro(UseStreaming, bool);
   itkBooleanMacro(UseStreaming);
 
+  /** Set/Get whether the file is memory mapped instead of read, when the
+   * ImageIO reports that the whole image is stored uncompressed, in the
+   * byte order of the system, and the pixel type of the file is the one of
+   * the output image. The output image then shares the pages of the file
+   * with the other processes reading it, and they are only copied when
+   * written to. Otherwise, or when only a region of the image is read, the
+   * file is read as usual. Default is false. */
+  itkSetMacro(UseMemoryMapping, bool);
+  itkGetConstReferenceMacro(UseMemoryMapping, bool);
+  itkBooleanMacro(UseMemoryMapping);
+
+  /** Get whether the pixel data of the output image was memory mapped by
+   * the last update, rather than read. */
+  itkGetConstMacro(PixelDataMemoryMapped, bool);
+
 protected:
   ImageFileReader();
   ~ImageFileReader() override = default;
@@ -154,7 +169,15 @@ protected:
 
   bool m_UseStreaming;
 
+  bool m_UseMemoryMapping;
+
+  bool m_PixelDataMemoryMapped;
+
 private:
+  /** Memory map the pixel data of the file into the output image, if
+   * possible. Returns false if the data has to be read. */
+  bool MapPixelData(TOutputImage *output);
+
   std::string m_ExceptionMessage;
 
   // The region that the ImageIO class will return when we ask to
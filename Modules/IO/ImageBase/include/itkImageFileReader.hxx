@@ -21,6 +21,7 @@
 
 #include "itkObjectFactory.h"
 #include "itkImageIOFactory.h"
+#include "itkMemoryMappedFile.h"
 #include "itkConvertPixelBuffer.h"
 #include "itkPixelTraits.h"
 #include "itkVectorImage.h"
@@ -39,6 +40,8 @@ ImageFileReader< TOutputImage, ConvertPixelTraits >
   this->SetFileName("");
   m_UserSpecifiedImageIO = false;
   m_UseStreaming = true;
+  m_UseMemoryMapping = false;
+  m_PixelDataMemoryMapped = false;
 }
 
 template< typename TOutputImage, typename ConvertPixelTraits >
@@ -51,6 +54,8 @@ void ImageFileReader< TOutputImage, ConvertPixelTraits >
 
   os << indent << "UserSpecifiedImageIO flag: " << m_UserSpecifiedImageIO << "\n";
   os << indent << "m_UseStreaming: " << m_UseStreaming << "\n";
+  os << indent << "m_UseMemoryMapping: " << m_UseMemoryMapping << "\n";
+  os << indent << "m_PixelDataMemoryMapped: " << m_PixelDataMemoryMapped << "\n";
 }
 
 template< typename TOutputImage, typename ConvertPixelTraits >
@@ -364,6 +369,13 @@ void ImageFileReader< TOutputImage, ConvertPixelTraits >
                  << "Allocating the buffer with the EnlargedRequestedRegion \n"
                  << output->GetRequestedRegion() << "\n");
 
+  m_PixelDataMemoryMapped = m_UseMemoryMapping && this->MapPixelData(output);
+  if ( m_PixelDataMemoryMapped )
+    {
+    this->UpdateProgress( 1.0f );
+    return;
+    }
+
   // allocated the output image to the size of the enlarge requested region
   this->AllocateOutputs();
 
@@ -453,6 +465,74 @@ void ImageFileReader< TOutputImage, ConvertPixelTraits >
   this->UpdateProgress( 1.0f );
 }
 
+template< typename TOutputImage, typename ConvertPixelTraits >
+bool
+ImageFileReader< TOutputImage, ConvertPixelTraits >
+::MapPixelData(TOutputImage *output)
+{
+  // only the whole image, without conversion, can be mapped
+  ImageIOBase::IOComponentType ioType =
+    ImageIOBase
+    ::MapPixelType< typename ConvertPixelTraits::ComponentType >::CType;
+  if ( m_ImageIO->GetComponentType() != ioType
+       || ( m_ImageIO->GetNumberOfComponents() !=
+            ConvertPixelTraits::GetNumberOfComponents() ) )
+    {
+    return false;
+    }
+  for ( unsigned int i = 0; i < m_ActualIORegion.GetImageDimension(); ++i )
+    {
+    if ( m_ActualIORegion.GetIndex(i) != 0
+         || m_ActualIORegion.GetSize(i) != m_ImageIO->GetDimensions(i) )
+      {
+      return false;
+      }
+    }
+  if ( m_ActualIORegion.GetNumberOfPixels() !=
+       output->GetRequestedRegion().GetNumberOfPixels() )
+    {
+    return false;
+    }
+
+  // a VectorImage stores each component as an element of its buffer
+  const bool isVectorImage(strcmp(output->GetNameOfClass(), "VectorImage") == 0);
+  const SizeValueType elementsPerPixel = isVectorImage ? m_ImageIO->GetNumberOfComponents() : 1;
+  const SizeValueType pixelSize = m_ImageIO->GetComponentSize() * m_ImageIO->GetNumberOfComponents();
+  if ( sizeof( OutputImagePixelType ) * elementsPerPixel != pixelSize )
+    {
+    return false;
+    }
+
+  std::string   fileName;
+  SizeValueType offset = 0;
+  if ( !m_ImageIO->GetPixelDataLocation(fileName, offset)
+       || offset % m_ImageIO->GetComponentSize() != 0 )
+    {
+    return false;
+    }
+
+  MemoryMappedFile::Pointer mappedFile = MemoryMappedFile::New();
+  try
+    {
+    mappedFile->Map(fileName, offset, m_ActualIORegion.GetNumberOfPixels() * pixelSize);
+    }
+  catch ( ExceptionObject & )
+    {
+    // reading the file reports the errors
+    return false;
+    }
+
+  itkDebugMacro(<< "Memory mapping " << fileName << " at offset " << offset);
+
+  // the mapping is released along with the pixel container
+  output->SetBufferedRegion( output->GetRequestedRegion() );
+  output->GetPixelContainer()->SetImportPointer(
+    static_cast< OutputImagePixelType * >( mappedFile->GetData() ),
+    m_ActualIORegion.GetNumberOfPixels() * elementsPerPixel,
+    [mappedFile](OutputImagePixelType *) { mappedFile->Unmap(); } );
+  return true;
+}
+
 template< typename TOutputImage, typename ConvertPixelTraits >
 void
 ImageFileReader< TOutputImage, ConvertPixelTraits >
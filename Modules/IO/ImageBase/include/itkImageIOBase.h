@@ -349,6 +349,17 @@ public:
   /** Reads the data from disk into the memory buffer provided. */
   virtual void Read(void *buffer) = 0;
 
+  /** Determine if the whole image, as Read() would return it, is stored
+   * uncompressed, contiguously and in the byte order of the system, in a
+   * single file. If so, the name of that file and the position of the
+   * first pixel are returned, so that the file can be memory mapped
+   * instead of read. This is queried after the header of the file has
+   * been read. Default is false. */
+  virtual bool GetPixelDataLocation(std::string & itkNotUsed(fileName), SizeValueType & itkNotUsed(offset))
+  {
+    return false;
+  }
+
   /*-------- This part of the interfaces deals with writing data ----- */
 
   /** Determine the file type. Returns true if this ImageIO can read the
@@ -162,6 +162,22 @@ public:
   itkGetConstReferenceMacro(UseStreaming, bool);
   itkBooleanMacro(UseStreaming);
 
+  /** Set/Get the maximum number of files which are read at the same time.
+   *
+   * With the default of 1, the files are read one after another. With a
+   * larger value, the files are read and decoded concurrently by a
+   * multi-threader, at most this many at a time, and each slice is read
+   * directly into its part of the output buffer. This helps when reading is
+   * bound by the latency of each file rather than by bandwidth, as with long
+   * series of small files on fast storage. The MetaDataDictionaryArray is
+   * still in file order.
+   *
+   * An ImageIO instance can only read one file at a time, and its settings
+   * can not be copied to other instances, so when an ImageIO is set with
+   * SetImageIO the files are read one after another whatever this value. */
+  itkSetClampMacro(NumberOfConcurrentReads, unsigned int, 1, NumericTraits< unsigned int >::max());
+  itkGetConstMacro(NumberOfConcurrentReads, unsigned int);
+
 protected:
   ImageSeriesReader() :
     m_ImageIO(nullptr)
@@ -198,11 +214,21 @@ protected:
 
   bool m_UseStreaming{true};
 
+  unsigned int m_NumberOfConcurrentReads{1};
+
 private:
   using ReaderType = ImageFileReader< TOutputImage >;
 
   int ComputeMovingDimensionIndex(ReaderType *reader);
 
+  /** Read file number i of the series into its slice of the output, if that
+   * slice is inside the requested region, and set sliceRead accordingly.
+   * Uses imageIO when it is not null. Returns a copy of the meta data
+   * dictionary of the file if needToUpdateMetaDataDictionaryArray is true,
+   * nullptr otherwise. Can be called concurrently for different files. */
+  DictionaryRawPointer ReadSlice(int i, ImageIOBase * imageIO,
+                                 bool needToUpdateMetaDataDictionaryArray, bool & sliceRead);
+
   /** Modified time of the MetaDataDictionaryArray */
   TimeStamp m_MetaDataDictionaryArrayMTime;
 
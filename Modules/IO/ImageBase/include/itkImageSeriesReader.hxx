@@ -26,6 +26,11 @@
 #include "itkMath.h"
 #include "itkProgressReporter.h"
 #include "itkMetaDataObject.h"
+#include "itkMultiThreaderBase.h"
+
+#include <atomic>
+#include <exception>
+#include <mutex>
 
 namespace itk
 {
@@ -55,6 +60,7 @@ void ImageSeriesReader< TOutputImage >
   os << indent << "ReverseOrder: " << m_ReverseOrder << std::endl;
   os << indent << "ForceOrthogonalDirection: " << m_ForceOrthogonalDirection << std::endl;
   os << indent << "UseStreaming: " << m_UseStreaming << std::endl;
+  os << indent << "NumberOfConcurrentReads: " << m_NumberOfConcurrentReads << std::endl;
 
   itkPrintSelfObjectMacro( ImageIO );
 
@@ -259,33 +265,11 @@ void ImageSeriesReader< TOutputImage >
   TOutputImage *output = this->GetOutput();
 
   ImageRegionType requestedRegion = output->GetRequestedRegion();
-  ImageRegionType largestRegion = output->GetLargestPossibleRegion();
-  ImageRegionType sliceRegionToRequest = output->GetRequestedRegion();
-
-  // Each file must have the same size.
-  SizeType validSize = largestRegion.GetSize();
-
-  // If more than one file is being read, then the input dimension
-  // will be less than the output dimension.  In this case, set
-  // the last dimension that is other than 1 of validSize to 1.  However, if the
-  // input and output have the same number of dimensions, this should
-  // not be done because it will lower the dimension of the output image.
-  if ( TOutputImage::ImageDimension != this->m_NumberOfDimensionsInImage )
-    {
-    validSize[this->m_NumberOfDimensionsInImage] = 1;
-    sliceRegionToRequest.SetSize(this->m_NumberOfDimensionsInImage, 1);
-    sliceRegionToRequest.SetIndex(this->m_NumberOfDimensionsInImage, 0);
-    }
 
   // Allocate the output buffer
   output->SetBufferedRegion(requestedRegion);
   output->Allocate();
 
-  // progress reported on a per slice basis
-  ProgressReporter progress(this, 0,
-                            requestedRegion.GetSize(TOutputImage::ImageDimension-1),
-                            100);
-
   // We utilize the modified time of the output information to
   // know when the meta array needs to be updated, when the output
   // information is updated so should the meta array.
@@ -295,147 +279,258 @@ void ImageSeriesReader< TOutputImage >
     this->m_OutputInformationMTime > this->m_MetaDataDictionaryArrayMTime
     && m_MetaDataDictionaryArrayUpdate;
 
-  typename  TOutputImage::InternalPixelType *outputBuffer = output->GetBufferPointer();
-  IndexType                           sliceStartIndex = requestedRegion.GetIndex();
   const auto numberOfFiles = static_cast< int >( m_FileNames.size() );
 
-  for ( int i = 0; i != numberOfFiles; ++i )
+  // An ImageIO set by the user can only read one file at a time, and its
+  // settings can not be copied to other instances, so the files are only
+  // read concurrently when each reader creates its own ImageIO.
+  if ( m_NumberOfConcurrentReads > 1 && numberOfFiles > 1 && m_ImageIO.IsNull() )
     {
-    if ( TOutputImage::ImageDimension != this->m_NumberOfDimensionsInImage )
+    // Each slice is read into its own part of the output buffer, so the
+    // files can be read concurrently. The dictionaries are stored per file
+    // to keep them in order.
+    std::vector< DictionaryRawPointer > dictionaries( numberOfFiles, nullptr );
+    std::atomic< int > nextFile( 0 );
+    std::atomic< bool > failed( false );
+    std::exception_ptr firstException;
+    std::mutex exceptionMutex;
+    // the progress observers are called by one thread at a time
+    std::mutex progressMutex;
+    int completedSlices = 0;
+    const auto numberOfSlicesToRead = static_cast< float >( requestedRegion.GetSize( TOutputImage::ImageDimension - 1 ) );
+    const unsigned int numberOfReads = std::min( m_NumberOfConcurrentReads, static_cast< unsigned int >( numberOfFiles ) );
+
+    MultiThreaderBase::Pointer multiThreader = MultiThreaderBase::New();
+    multiThreader->SetMaximumNumberOfThreads( numberOfReads );
+    multiThreader->SetNumberOfWorkUnits( numberOfReads );
+    multiThreader->ParallelizeArray(
+      0,
+      numberOfReads,
+      [&]( SizeValueType )
       {
-      sliceStartIndex[this->m_NumberOfDimensionsInImage] = i;
-      }
-
-    const bool insideRequestedRegion = requestedRegion.IsInside(sliceStartIndex);
-    const int  iFileName = ( m_ReverseOrder ? numberOfFiles - i - 1 : i );
+        // each work unit reads one file at a time, taking the next one
+        // which has not been claimed yet
+        for ( int i = nextFile++; i < numberOfFiles && !failed; i = nextFile++ )
+          {
+          try
+            {
+            MultiThreaderBase::HandleFilterProgress( this );
+
+            bool sliceRead = false;
+            dictionaries[i] = this->ReadSlice( i, nullptr, needToUpdateMetaDataDictionaryArray, sliceRead );
+            if ( sliceRead )
+              {
+              std::lock_guard< std::mutex > lock( progressMutex );
+              ++completedSlices;
+              this->UpdateProgress( completedSlices / numberOfSlicesToRead );
+              }
+            }
+          catch ( ... )
+            {
+            std::lock_guard< std::mutex > lock( exceptionMutex );
+            if ( !failed )
+              {
+              firstException = std::current_exception();
+              failed = true;
+              }
+            }
+          }
+      },
+      nullptr );
 
-    // check if we need this slice
-    if ( !insideRequestedRegion && !needToUpdateMetaDataDictionaryArray )
+    for ( int i = 0; i < numberOfFiles; ++i )
       {
-      continue;
+      if ( dictionaries[i] != nullptr )
+        {
+        m_MetaDataDictionaryArray.push_back( dictionaries[i] );
+        }
       }
-
-    // configure reader
-    typename ReaderType::Pointer reader = ReaderType::New();
-    reader->SetFileName( m_FileNames[iFileName].c_str() );
-
-    TOutputImage * readerOutput = reader->GetOutput();
-
-    if ( m_ImageIO )
+    if ( firstException )
       {
-      reader->SetImageIO(m_ImageIO);
+      std::rethrow_exception( firstException );
       }
-    reader->SetUseStreaming(m_UseStreaming);
-    readerOutput->SetRequestedRegion(sliceRegionToRequest);
+    }
+  else
+    {
+    // progress reported on a per slice basis
+    ProgressReporter progress(this, 0,
+                              requestedRegion.GetSize(TOutputImage::ImageDimension-1),
+                              100);
 
-    // update the data or info
-    if ( !insideRequestedRegion )
+    for ( int i = 0; i != numberOfFiles; ++i )
       {
-      reader->UpdateOutputInformation();
+      bool sliceRead = false;
+      DictionaryRawPointer dictionary = this->ReadSlice( i, m_ImageIO, needToUpdateMetaDataDictionaryArray, sliceRead );
+      if ( dictionary != nullptr )
+        {
+        m_MetaDataDictionaryArray.push_back( dictionary );
+        }
+      if ( sliceRead )
+        {
+        // report progress for read slices
+        progress.CompletedPixel();
+        }
       }
-    else
-      {
-      // read the meta data information
-      readerOutput->UpdateOutputInformation();
+    }
 
-      // propagate the requested region to determin what the region
-      // will actually be read
-      readerOutput->PropagateRequestedRegion();
+  // update the time if we modified the meta array
+  if ( needToUpdateMetaDataDictionaryArray )
+    {
+    m_MetaDataDictionaryArrayMTime.Modified();
+    }
+}
 
-      // check that the size of each slice is the same
-      if ( readerOutput->GetLargestPossibleRegion().GetSize() != validSize )
-        {
-        itkExceptionMacro( << "Size mismatch! The size of  "
-                           << m_FileNames[iFileName].c_str()
-                           << " is "
-                           << readerOutput->GetLargestPossibleRegion().GetSize()
-                           << " and does not match the required size "
-                           << validSize
-                           << " from file "
-                           << m_FileNames[m_ReverseOrder ? numberOfFiles - 1 : 0].c_str() );
-        }
+template< typename TOutputImage >
+typename ImageSeriesReader< TOutputImage >::DictionaryRawPointer
+ImageSeriesReader< TOutputImage >
+::ReadSlice(int i, ImageIOBase * imageIO, bool needToUpdateMetaDataDictionaryArray, bool & sliceRead)
+{
+  TOutputImage *output = this->GetOutput();
 
-      // get the size of the region to be read
-      SizeType readSize = readerOutput->GetRequestedRegion().GetSize();
+  const ImageRegionType requestedRegion = output->GetRequestedRegion();
+  ImageRegionType sliceRegionToRequest = requestedRegion;
 
-      if( readSize == sliceRegionToRequest.GetSize() )
-        {
-        // if the buffer of the ImageReader is going to match that of
-        // ourselves, then set the ImageReader's buffer to a section
-        // of ours
+  // Each file must have the same size.
+  SizeType validSize = output->GetLargestPossibleRegion().GetSize();
 
-        const size_t  numberOfPixelsInSlice = sliceRegionToRequest.GetNumberOfPixels();
+  // If more than one file is being read, then the input dimension
+  // will be less than the output dimension.  In this case, set
+  // the last dimension that is other than 1 of validSize to 1.  However, if the
+  // input and output have the same number of dimensions, this should
+  // not be done because it will lower the dimension of the output image.
+  IndexType sliceStartIndex = requestedRegion.GetIndex();
+  if ( TOutputImage::ImageDimension != this->m_NumberOfDimensionsInImage )
+    {
+    validSize[this->m_NumberOfDimensionsInImage] = 1;
+    sliceRegionToRequest.SetSize(this->m_NumberOfDimensionsInImage, 1);
+    sliceRegionToRequest.SetIndex(this->m_NumberOfDimensionsInImage, 0);
+    sliceStartIndex[this->m_NumberOfDimensionsInImage] = i;
+    }
 
-        using AccessorFunctorType = typename TOutputImage::AccessorFunctorType;
-        const size_t      numberOfInternalComponentsPerPixel =  AccessorFunctorType::GetVectorLength( output );
+  const auto numberOfFiles = static_cast< int >( m_FileNames.size() );
+  const bool insideRequestedRegion = requestedRegion.IsInside(sliceStartIndex);
+  const int  iFileName = ( m_ReverseOrder ? numberOfFiles - i - 1 : i );
 
+  sliceRead = false;
 
-        const ptrdiff_t   sliceOffset = ( TOutputImage::ImageDimension != this->m_NumberOfDimensionsInImage ) ?
-          ( i - requestedRegion.GetIndex(this->m_NumberOfDimensionsInImage)) : 0;
+  // check if we need this slice
+  if ( !insideRequestedRegion && !needToUpdateMetaDataDictionaryArray )
+    {
+    return nullptr;
+    }
 
-        const ptrdiff_t  numberOfPixelComponentsUpToSlice =  numberOfPixelsInSlice * numberOfInternalComponentsPerPixel * sliceOffset;
-        const bool       bufferDelete = false;
+  // configure reader
+  typename ReaderType::Pointer reader = ReaderType::New();
+  reader->SetFileName( m_FileNames[iFileName].c_str() );
 
-        typename  TOutputImage::InternalPixelType * outputSliceBuffer = outputBuffer + numberOfPixelComponentsUpToSlice;
+  TOutputImage * readerOutput = reader->GetOutput();
 
-        if ( strcmp(output->GetNameOfClass(), "VectorImage") == 0 )
-          {
-          // if the input image type is a vector image then the number
-          // of components needs to be set for the size
-          readerOutput->GetPixelContainer()->SetImportPointer( outputSliceBuffer,
-                                                               static_cast<unsigned long>( numberOfPixelsInSlice*numberOfInternalComponentsPerPixel ),
-                                                               bufferDelete );
-          }
-        else
-          {
-          // otherwise the actual number of pixels needs to be passed
-          readerOutput->GetPixelContainer()->SetImportPointer( outputSliceBuffer,
-                                                               static_cast<unsigned long>( numberOfPixelsInSlice ),
-                                                               bufferDelete );
-          }
-        readerOutput->UpdateOutputData();
-        }
-      else
-        {
-        // the read region isn't going to match exactly what we need
-        // to update to buffer created by the reader, then copy
+  if ( imageIO )
+    {
+    reader->SetImageIO(imageIO);
+    }
+  reader->SetUseStreaming(m_UseStreaming);
+  readerOutput->SetRequestedRegion(sliceRegionToRequest);
 
-        reader->Update();
+  // update the data or info
+  if ( !insideRequestedRegion )
+    {
+    reader->UpdateOutputInformation();
+    }
+  else
+    {
+    // read the meta data information
+    readerOutput->UpdateOutputInformation();
 
-        // output of buffer copy
-        ImageRegionType outRegion = requestedRegion;
-        outRegion.SetIndex( sliceStartIndex );
+    // propagate the requested region to determin what the region
+    // will actually be read
+    readerOutput->PropagateRequestedRegion();
 
-        // set the moving dimension to a size of 1
-        if ( TOutputImage::ImageDimension != this->m_NumberOfDimensionsInImage )
-          {
-          outRegion.SetSize(this->m_NumberOfDimensionsInImage, 1);
-          }
+    // check that the size of each slice is the same
+    if ( readerOutput->GetLargestPossibleRegion().GetSize() != validSize )
+      {
+      itkExceptionMacro( << "Size mismatch! The size of  "
+                         << m_FileNames[iFileName].c_str()
+                         << " is "
+                         << readerOutput->GetLargestPossibleRegion().GetSize()
+                         << " and does not match the required size "
+                         << validSize
+                         << " from file "
+                         << m_FileNames[m_ReverseOrder ? numberOfFiles - 1 : 0].c_str() );
+      }
 
-        ImageAlgorithm::Copy( readerOutput, output, sliceRegionToRequest, outRegion );
+    // get the size of the region to be read
+    SizeType readSize = readerOutput->GetRequestedRegion().GetSize();
+
+    if( readSize == sliceRegionToRequest.GetSize() )
+      {
+      // if the buffer of the ImageReader is going to match that of
+      // ourselves, then set the ImageReader's buffer to a section
+      // of ours
+
+      const size_t  numberOfPixelsInSlice = sliceRegionToRequest.GetNumberOfPixels();
+
+      using AccessorFunctorType = typename TOutputImage::AccessorFunctorType;
+      const size_t      numberOfInternalComponentsPerPixel =  AccessorFunctorType::GetVectorLength( output );
 
-        }
 
-      // report progress for read slices
-      progress.CompletedPixel();
+      const ptrdiff_t   sliceOffset = ( TOutputImage::ImageDimension != this->m_NumberOfDimensionsInImage ) ?
+        ( i - requestedRegion.GetIndex(this->m_NumberOfDimensionsInImage)) : 0;
 
-     } // end !insidedRequestedRegion
+      const ptrdiff_t  numberOfPixelComponentsUpToSlice =  numberOfPixelsInSlice * numberOfInternalComponentsPerPixel * sliceOffset;
+      const bool       bufferDelete = false;
 
-    // Deep copy the MetaDataDictionary into the array
-    if ( reader->GetImageIO() &&  needToUpdateMetaDataDictionaryArray )
+      typename  TOutputImage::InternalPixelType * outputSliceBuffer = output->GetBufferPointer() + numberOfPixelComponentsUpToSlice;
+
+      if ( strcmp(output->GetNameOfClass(), "VectorImage") == 0 )
+        {
+        // if the input image type is a vector image then the number
+        // of components needs to be set for the size
+        readerOutput->GetPixelContainer()->SetImportPointer( outputSliceBuffer,
+                                                             static_cast<unsigned long>( numberOfPixelsInSlice*numberOfInternalComponentsPerPixel ),
+                                                             bufferDelete );
+        }
+      else
+        {
+        // otherwise the actual number of pixels needs to be passed
+        readerOutput->GetPixelContainer()->SetImportPointer( outputSliceBuffer,
+                                                             static_cast<unsigned long>( numberOfPixelsInSlice ),
+                                                             bufferDelete );
+        }
+      readerOutput->UpdateOutputData();
+      }
+    else
       {
-      auto newDictionary = new DictionaryType;
-      *newDictionary = reader->GetImageIO()->GetMetaDataDictionary();
-      m_MetaDataDictionaryArray.push_back(newDictionary);
+      // the read region isn't going to match exactly what we need
+      // to update to buffer created by the reader, then copy
+
+      reader->Update();
+
+      // output of buffer copy
+      ImageRegionType outRegion = requestedRegion;
+      outRegion.SetIndex( sliceStartIndex );
+
+      // set the moving dimension to a size of 1
+      if ( TOutputImage::ImageDimension != this->m_NumberOfDimensionsInImage )
+        {
+        outRegion.SetSize(this->m_NumberOfDimensionsInImage, 1);
+        }
+
+      ImageAlgorithm::Copy( readerOutput, output, sliceRegionToRequest, outRegion );
+
       }
 
-    } // end per slice loop
+    sliceRead = true;
+   } // end !insidedRequestedRegion
 
-  // update the time if we modified the meta array
-  if ( needToUpdateMetaDataDictionaryArray )
+  // Deep copy the MetaDataDictionary into the array
+  if ( reader->GetImageIO() &&  needToUpdateMetaDataDictionaryArray )
     {
-    m_MetaDataDictionaryArrayMTime.Modified();
+    auto newDictionary = new DictionaryType;
+    *newDictionary = reader->GetImageIO()->GetMetaDataDictionary();
+    return newDictionary;
     }
+  return nullptr;
 }
 
 template< typename TOutputImage >
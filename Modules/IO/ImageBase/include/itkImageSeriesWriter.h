@@ -199,6 +199,20 @@ public:
   itkGetConstReferenceMacro(UseCompression, bool);
   itkBooleanMacro(UseCompression);
 
+  /** Set/Get the maximum number of files which are written concurrently.
+   * The default value of 1 writes the files one after the other. With a
+   * larger value, the slices are copied, encoded and written in parallel,
+   * each by a worker with its own slice buffer and ImageIO. This helps when
+   * writing is bound by compression, as with PNG or compressed TIFF stacks.
+   * The files are identical to the ones written one after the other.
+   *
+   * An ImageIO instance can only write one file at a time, and its settings
+   * (compression, GDCM KeepOriginalUID, ...) can not be copied to other
+   * instances, so when an ImageIO is set with SetImageIO the files are
+   * written one after the other whatever this value. */
+  itkSetClampMacro(NumberOfConcurrentWrites, unsigned int, 1, NumericTraits< unsigned int >::max());
+  itkGetConstMacro(NumberOfConcurrentWrites, unsigned int);
+
 protected:
   ImageSeriesWriter();
   ~ImageSeriesWriter() override = default;
@@ -231,6 +245,8 @@ private:
 
   bool m_UseCompression;
 
+  unsigned int m_NumberOfConcurrentWrites{1};
+
   /** Array of MetaDataDictionary used for passing information to each slice */
   DictionaryArrayRawPointer m_MetaDataDictionaryArray{nullptr};
 
@@ -240,6 +256,11 @@ private:
   void GenerateNumericFileNames();
 
   void WriteFiles();
+
+  /** Copies the given slice of the input into outputImage, and writes it
+   * with imageIO, or with an ImageIO created by the factory if none is given. */
+  void WriteSlice(unsigned int slice, const typename InputImageType::SizeType & inSize, SizeValueType pixelsPerFile,
+                  OutputImageType *outputImage, ImageIOBase *imageIO);
 };
 } // end namespace itk
 
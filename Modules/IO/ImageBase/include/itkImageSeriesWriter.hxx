@@ -26,8 +26,13 @@
 #include "itkImageAlgorithm.h"
 #include "itkMetaDataObject.h"
 #include "itkArray.h"
+#include "itkMultiThreaderBase.h"
 #include "vnl/algo/vnl_determinant.h"
+#include <algorithm>
+#include <atomic>
 #include <cstdio>
+#include <exception>
+#include <mutex>
 
 #if defined(_MSC_VER)
 #define snprintf _snprintf
@@ -237,8 +242,7 @@ ImageSeriesWriter< TInputImage, TOutputImage >
   outputImage->SetSpacing(spacing);
   outputImage->SetDirection(direction);
 
-  Index< TInputImage::ImageDimension > inIndex;
-  Size< TInputImage::ImageDimension >  inSize;
+  Size< TInputImage::ImageDimension > inSize;
 
   SizeValueType pixelsPerFile = outputImage->GetRequestedRegion().GetNumberOfPixels();
 
@@ -264,105 +268,180 @@ ImageSeriesWriter< TInputImage, TOutputImage >
 
   itkDebugMacro( << "Number of files to write = " << m_FileNames.size() );
 
-  ProgressReporter progress(this, 0,
-                            expectedNumberOfFiles,
-                            expectedNumberOfFiles);
+  const auto numberOfFiles = static_cast< unsigned int >( m_FileNames.size() );
 
-  // For each "slice" in the input, copy the region to the output,
-  // build a filename and write the file.
-
-  typename InputImageType::OffsetValueType offset = 0;
-  for ( unsigned int slice = 0; slice < m_FileNames.size(); slice++ )
+  // An ImageIO set by the user can only write one file at a time, and its
+  // settings can not be copied to other instances, so the files are only
+  // written concurrently when each writer creates its own ImageIO.
+  if ( m_NumberOfConcurrentWrites > 1 && numberOfFiles > 1 && m_ImageIO.IsNull() )
     {
-    // Select a "slice" of the image.
-    inIndex = inputImage->ComputeIndex(offset);
-    inRegion.SetIndex(inIndex);
-    inRegion.SetSize(inSize);
+    // Each work unit copies its slices into its own buffer, and writes them,
+    // taking the next slice which has not been claimed yet.
+    std::atomic< unsigned int > nextSlice( 0 );
+    std::atomic< bool > failed( false );
+    std::exception_ptr firstException;
+    std::mutex exceptionMutex;
+    // the progress observers are called by one thread at a time
+    std::mutex progressMutex;
+    unsigned int completedSlices = 0;
+    const unsigned int numberOfWrites = std::min( m_NumberOfConcurrentWrites, numberOfFiles );
+
+    MultiThreaderBase::Pointer multiThreader = MultiThreaderBase::New();
+    multiThreader->SetMaximumNumberOfThreads( numberOfWrites );
+    multiThreader->SetNumberOfWorkUnits( numberOfWrites );
+    multiThreader->ParallelizeArray(
+      0,
+      numberOfWrites,
+      [&]( SizeValueType )
+      {
+        try
+          {
+          typename OutputImageType::Pointer sliceImage = OutputImageType::New();
+          sliceImage->CopyInformation( outputImage );
+          sliceImage->SetRegions( outRegion );
+          sliceImage->SetNumberOfComponentsPerPixel( outputImage->GetNumberOfComponentsPerPixel() );
+          sliceImage->Allocate();
 
-    // Copy the selected "slice" into the output image.
-    ImageAlgorithm::Copy(inputImage, outputImage.GetPointer(), inRegion, outRegion);
+          for ( unsigned int slice = nextSlice++; slice < numberOfFiles && !failed; slice = nextSlice++ )
+            {
+            MultiThreaderBase::HandleFilterProgress( this );
+            this->WriteSlice( slice, inSize, pixelsPerFile, sliceImage, nullptr );
 
-    typename WriterType::Pointer writer = WriterType::New();
+            std::lock_guard< std::mutex > lock( progressMutex );
+            ++completedSlices;
+            this->UpdateProgress( static_cast< float >( completedSlices ) / numberOfFiles );
+            }
+          }
+        catch ( ... )
+          {
+          std::lock_guard< std::mutex > lock( exceptionMutex );
+          if ( !failed )
+            {
+            firstException = std::current_exception();
+            failed = true;
+            }
+          }
+      },
+      nullptr );
 
-    writer->UseInputMetaDataDictionaryOff(); // use the dictionary from the
-                                             // ImageIO class
-    writer->SetInput(outputImage);
+    if ( firstException )
+      {
+      std::rethrow_exception( firstException );
+      }
+    }
+  else
+    {
+    ProgressReporter progress(this, 0,
+                              expectedNumberOfFiles,
+                              expectedNumberOfFiles);
 
-    if ( m_ImageIO )
+    // For each "slice" in the input, copy the region to the output,
+    // build a filename and write the file.
+    for ( unsigned int slice = 0; slice < numberOfFiles; slice++ )
       {
-      writer->SetImageIO(m_ImageIO);
+      this->WriteSlice( slice, inSize, pixelsPerFile, outputImage, m_ImageIO );
+      progress.CompletedPixel();
       }
+    }
+}
+
+//---------------------------------------------------------
+template< typename TInputImage, typename TOutputImage >
+void
+ImageSeriesWriter< TInputImage, TOutputImage >
+::WriteSlice(unsigned int slice, const typename InputImageType::SizeType & inSize, SizeValueType pixelsPerFile,
+             OutputImageType *outputImage, ImageIOBase *imageIO)
+{
+  const InputImageType *inputImage = this->GetInput();
+  const OutputImageRegionType outRegion = outputImage->GetLargestPossibleRegion();
+
+  // Select a "slice" of the image.
+  const auto offset = static_cast< typename InputImageType::OffsetValueType >( slice ) * pixelsPerFile;
+  const typename InputImageType::IndexType inIndex = inputImage->ComputeIndex(offset);
+  InputImageRegionType inRegion;
+  inRegion.SetIndex(inIndex);
+  inRegion.SetSize(inSize);
+
+  // Copy the selected "slice" into the output image.
+  ImageAlgorithm::Copy(inputImage, outputImage, inRegion, outRegion);
 
-    if ( m_MetaDataDictionaryArray )
+  typename WriterType::Pointer writer = WriterType::New();
+
+  writer->UseInputMetaDataDictionaryOff(); // use the dictionary from the
+                                           // ImageIO class
+  writer->SetInput(outputImage);
+
+  if ( imageIO )
+    {
+    writer->SetImageIO(imageIO);
+    }
+
+  if ( m_MetaDataDictionaryArray )
+    {
+    if ( imageIO )
       {
-      if ( m_ImageIO )
+      if ( slice > m_MetaDataDictionaryArray->size() - 1 )
         {
-        if ( slice > m_MetaDataDictionaryArray->size() - 1 )
-          {
-          itkExceptionMacro (
-            "The slice number: " << slice + 1 << " exceeds the size of the MetaDataDictionaryArray "
-                                 << m_MetaDataDictionaryArray->size() << ".");
-          }
-        DictionaryRawPointer dictionary = ( *m_MetaDataDictionaryArray )[slice];
-        m_ImageIO->SetMetaDataDictionary( ( *dictionary ) );
-        }
-      else
-        {
-        itkExceptionMacro(<< "Attempted to use a MetaDataDictionaryArray without specifying an ImageIO!");
+        itkExceptionMacro (
+          "The slice number: " << slice + 1 << " exceeds the size of the MetaDataDictionaryArray "
+                               << m_MetaDataDictionaryArray->size() << ".");
         }
+      DictionaryRawPointer dictionary = ( *m_MetaDataDictionaryArray )[slice];
+      imageIO->SetMetaDataDictionary( ( *dictionary ) );
       }
     else
       {
-      if ( m_ImageIO )
-        {
-        DictionaryType & dictionary = m_ImageIO->GetMetaDataDictionary();
+      itkExceptionMacro(<< "Attempted to use a MetaDataDictionaryArray without specifying an ImageIO!");
+      }
+    }
+  else
+    {
+    if ( imageIO )
+      {
+      DictionaryType & dictionary = imageIO->GetMetaDataDictionary();
 
-        typename InputImageType::SpacingType spacing2 = inputImage->GetSpacing();
+      typename InputImageType::SpacingType spacing2 = inputImage->GetSpacing();
 
-        // origin of the output slice in the
-        // N-Dimensional space of the input image.
-        typename InputImageType::PointType origin2;
+      // origin of the output slice in the
+      // N-Dimensional space of the input image.
+      typename InputImageType::PointType origin2;
 
-        inputImage->TransformIndexToPhysicalPoint(inIndex, origin2);
+      inputImage->TransformIndexToPhysicalPoint(inIndex, origin2);
 
-        const unsigned int inputImageDimension = TInputImage::ImageDimension;
+      const unsigned int inputImageDimension = TInputImage::ImageDimension;
 
-        using DoubleArrayType = Array< double >;
+      using DoubleArrayType = Array< double >;
 
-        DoubleArrayType originArray(inputImageDimension);
-        DoubleArrayType spacingArray(inputImageDimension);
+      DoubleArrayType originArray(inputImageDimension);
+      DoubleArrayType spacingArray(inputImageDimension);
 
-        for ( unsigned int d = 0; d < inputImageDimension; d++ )
-          {
-          originArray[d]  = origin2[d];
-          spacingArray[d] = spacing2[d];
-          }
+      for ( unsigned int d = 0; d < inputImageDimension; d++ )
+        {
+        originArray[d]  = origin2[d];
+        spacingArray[d] = spacing2[d];
+        }
 
-        EncapsulateMetaData< DoubleArrayType >(dictionary, ITK_Origin, originArray);
-        EncapsulateMetaData< DoubleArrayType >(dictionary, ITK_Spacing, spacingArray);
-        EncapsulateMetaData<  unsigned int   >(dictionary, ITK_NumberOfDimensions, inputImageDimension);
+      EncapsulateMetaData< DoubleArrayType >(dictionary, ITK_Origin, originArray);
+      EncapsulateMetaData< DoubleArrayType >(dictionary, ITK_Spacing, spacingArray);
+      EncapsulateMetaData<  unsigned int   >(dictionary, ITK_NumberOfDimensions, inputImageDimension);
 
-        typename InputImageType::DirectionType direction2 = inputImage->GetDirection();
-        using DoubleMatrixType = Matrix< double, inputImageDimension, inputImageDimension>;
-        DoubleMatrixType directionMatrix;
-        for( unsigned int i = 0; i < inputImageDimension; i++ )
+      typename InputImageType::DirectionType direction2 = inputImage->GetDirection();
+      using DoubleMatrixType = Matrix< double, inputImageDimension, inputImageDimension>;
+      DoubleMatrixType directionMatrix;
+      for( unsigned int i = 0; i < inputImageDimension; i++ )
+        {
+        for( unsigned int j = 0; j < inputImageDimension; j++ )
           {
-          for( unsigned int j = 0; j < inputImageDimension; j++ )
-            {
-            directionMatrix[j][i]  = direction2[i][j];
-            }
+          directionMatrix[j][i]  = direction2[i][j];
           }
-        EncapsulateMetaData< DoubleMatrixType >( dictionary, ITK_ZDirection, directionMatrix );
         }
+      EncapsulateMetaData< DoubleMatrixType >( dictionary, ITK_ZDirection, directionMatrix );
       }
-
-    writer->SetFileName( m_FileNames[slice].c_str() );
-    writer->SetUseCompression(m_UseCompression);
-    writer->Update();
-
-    progress.CompletedPixel();
-    offset += pixelsPerFile;
     }
+
+  writer->SetFileName( m_FileNames[slice].c_str() );
+  writer->SetUseCompression(m_UseCompression);
+  writer->Update();
 }
 
 //---------------------------------------------------------
@@ -387,6 +466,7 @@ ImageSeriesWriter< TInputImage, TOutputImage >
   os << indent << "IncrementIndex: " << m_IncrementIndex << std::endl;
   os << indent << "SeriesFormat: " << m_SeriesFormat << std::endl;
   os << indent << "MetaDataDictionaryArray: " << m_MetaDataDictionaryArray << std::endl;
+  os << indent << "NumberOfConcurrentWrites: " << m_NumberOfConcurrentWrites << std::endl;
 
   if ( m_UseCompression )
     {
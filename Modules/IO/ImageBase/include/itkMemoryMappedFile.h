@@ -0,0 +1,90 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef itkMemoryMappedFile_h
+#define itkMemoryMappedFile_h
+#include "ITKIOImageBaseExport.h"
+
+#include "itkObject.h"
+#include "itkObjectFactory.h"
+#include "itkIntTypes.h"
+#include <string>
+
+namespace itk
+{
+/** \class MemoryMappedFile
+ * \brief Read-only view of a part of a file, mapped into memory.
+ *
+ * The mapping is private: the mapped memory can be written to, but the
+ * modified pages are copied on write and the file itself is never
+ * modified. Pages that are not written to are shared, through the page
+ * cache, with every other process mapping or reading the same file.
+ *
+ * The part of the file is unmapped when this object is destroyed, so the
+ * mapped memory can be handed to an ImportImageContainer with a deleter
+ * holding a smart pointer to this object.
+ *
+ * \ingroup IOFilters
+ * \ingroup ITKIOImageBase
+ */
+class ITKIOImageBase_EXPORT MemoryMappedFile:public Object
+{
+public:
+  ITK_DISALLOW_COPY_AND_ASSIGN(MemoryMappedFile);
+
+  /** Standard class type aliases. */
+  using Self = MemoryMappedFile;
+  using Superclass = Object;
+  using Pointer = SmartPointer< Self >;
+
+  /** Method for creation through the object factory. */
+  itkNewMacro(Self);
+
+  /** Run-time type information (and related methods). */
+  itkTypeMacro(MemoryMappedFile, Object);
+
+  /** Map "length" bytes of the file, starting at "offset". Any previous
+   * mapping is released first. An exception is thrown if the file cannot
+   * be opened, is too short, or cannot be mapped. */
+  void Map(const std::string & fileName, SizeValueType offset, SizeValueType length);
+
+  /** Release the mapping. */
+  void Unmap();
+
+  /** Pointer to the mapped byte at "offset", or nullptr if nothing is
+   * mapped. */
+  void * GetData() const { return m_Data; }
+
+  /** Number of bytes mapped. */
+  itkGetConstMacro(Length, SizeValueType);
+
+protected:
+  MemoryMappedFile();
+  ~MemoryMappedFile() override;
+  void PrintSelf(std::ostream & os, Indent indent) const override;
+
+private:
+  void *        m_Data{ nullptr };
+  SizeValueType m_Length{ 0 };
+
+  // start and size of the mapping, aligned on the platform granularity
+  void *        m_MappingAddress{ nullptr };
+  SizeValueType m_MappingLength{ 0 };
+};
+} // end namespace itk
+
+#endif // itkMemoryMappedFile_h
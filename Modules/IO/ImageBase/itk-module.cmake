@@ -15,6 +15,7 @@ itk_module(ITKIOImageBase
     ITKTestKernel
     ITKIOGDCM
     ITKIOMeta
+    ITKIORAW
     ITKImageIntensity
   DESCRIPTION
     "${DOCUMENTATION}"
@@ -0,0 +1,150 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#include "itkMemoryMappedFile.h"
+#include "itksys/SystemTools.hxx"
+
+#if defined( _WIN32 )
+#include "itksys/Encoding.hxx"
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace itk
+{
+MemoryMappedFile::MemoryMappedFile() = default;
+
+MemoryMappedFile::~MemoryMappedFile()
+{
+  this->Unmap();
+}
+
+void
+MemoryMappedFile::Map(const std::string & fileName, SizeValueType offset, SizeValueType length)
+{
+  this->Unmap();
+  if ( length == 0 )
+    {
+    itkExceptionMacro(<< "Cannot map an empty part of " << fileName);
+    }
+
+#if defined( _WIN32 )
+  SYSTEM_INFO systemInfo;
+  GetSystemInfo(&systemInfo);
+  const SizeValueType granularity = systemInfo.dwAllocationGranularity;
+#else
+  const auto granularity = static_cast< SizeValueType >( sysconf(_SC_PAGESIZE) );
+#endif
+  const SizeValueType mappingOffset = offset - offset % granularity;
+  const SizeValueType mappingLength = length + offset % granularity;
+
+#if defined( _WIN32 )
+  const std::wstring wideFileName = itksys::Encoding::ToWide(fileName);
+  HANDLE file = CreateFileW(wideFileName.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+                            OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+  if ( file == INVALID_HANDLE_VALUE )
+    {
+    itkExceptionMacro(<< "Cannot open " << fileName << " for memory mapping");
+    }
+  LARGE_INTEGER fileSize;
+  if ( !GetFileSizeEx(file, &fileSize)
+       || static_cast< SizeValueType >( fileSize.QuadPart ) < offset + length )
+    {
+    CloseHandle(file);
+    itkExceptionMacro(<< "File " << fileName << " is too short to map "
+                      << length << " bytes at offset " << offset);
+    }
+  HANDLE mapping = CreateFileMappingW(file, nullptr, PAGE_WRITECOPY, 0, 0, nullptr);
+  CloseHandle(file);
+  if ( mapping == nullptr )
+    {
+    itkExceptionMacro(<< "Cannot memory map " << fileName);
+    }
+  void *address = MapViewOfFile(mapping, FILE_MAP_COPY,
+                                static_cast< DWORD >( static_cast< uint64_t >( mappingOffset ) >> 32 ),
+                                static_cast< DWORD >( mappingOffset & 0xffffffff ),
+                                static_cast< SIZE_T >( mappingLength ));
+  // the view keeps the mapping alive
+  CloseHandle(mapping);
+  if ( address == nullptr )
+    {
+    itkExceptionMacro(<< "Cannot memory map " << fileName);
+    }
+#else
+  const int file = open(fileName.c_str(), O_RDONLY);
+  if ( file < 0 )
+    {
+    itkExceptionMacro(<< "Cannot open " << fileName << " for memory mapping: "
+                      << itksys::SystemTools::GetLastSystemError());
+    }
+  struct stat fileStatus;
+  if ( fstat(file, &fileStatus) != 0
+       || static_cast< SizeValueType >( fileStatus.st_size ) < offset + length )
+    {
+    close(file);
+    itkExceptionMacro(<< "File " << fileName << " is too short to map "
+                      << length << " bytes at offset " << offset);
+    }
+  void *address = mmap(nullptr, mappingLength, PROT_READ | PROT_WRITE, MAP_PRIVATE,
+                       file, static_cast< off_t >( mappingOffset ));
+  // the mapping remains valid after closing the file
+  close(file);
+  if ( address == MAP_FAILED )
+    {
+    itkExceptionMacro(<< "Cannot memory map " << fileName << ": "
+                      << itksys::SystemTools::GetLastSystemError());
+    }
+#endif
+
+  m_MappingAddress = address;
+  m_MappingLength = mappingLength;
+  m_Data = static_cast< char * >( address ) + ( offset - mappingOffset );
+  m_Length = length;
+  this->Modified();
+}
+
+void
+MemoryMappedFile::Unmap()
+{
+  if ( m_MappingAddress == nullptr )
+    {
+    return;
+    }
+#if defined( _WIN32 )
+  UnmapViewOfFile(m_MappingAddress);
+#else
+  munmap(m_MappingAddress, m_MappingLength);
+#endif
+  m_MappingAddress = nullptr;
+  m_MappingLength = 0;
+  m_Data = nullptr;
+  m_Length = 0;
+  this->Modified();
+}
+
+void
+MemoryMappedFile::PrintSelf(std::ostream & os, Indent indent) const
+{
+  Superclass::PrintSelf(os, indent);
+  os << indent << "Data: " << m_Data << std::endl;
+  os << indent << "Length: " << m_Length << std::endl;
+}
+} // end namespace itk
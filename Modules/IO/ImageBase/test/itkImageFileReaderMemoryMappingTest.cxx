@@ -0,0 +1,180 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+#include "itkImageFileReader.h"
+#include "itkImageFileWriter.h"
+#include "itkImageRegionIteratorWithIndex.h"
+#include "itkRawImageIO.h"
+#include "itkTestingMacros.h"
+
+namespace
+{
+// Writes an image, reads it with and without memory mapping, and checks
+// whether it was mapped, that the images are identical and that writing to
+// the mapped image leaves the file unchanged. The ImageIO, if given, is used
+// for all of them.
+template< typename TImage >
+int
+CompareMappedAndReadImages( const std::string & fileName, bool compress, bool expectMapped,
+                            itk::ImageIOBase * imageIO = nullptr )
+{
+  using ReaderType = itk::ImageFileReader< TImage >;
+  using WriterType = itk::ImageFileWriter< TImage >;
+
+  std::cout << fileName << std::endl;
+
+  typename TImage::SizeType size;
+  size.Fill( 17 );
+  typename TImage::Pointer image = TImage::New();
+  image->SetRegions( size );
+  image->Allocate();
+  itk::ImageRegionIteratorWithIndex< TImage > it( image, image->GetLargestPossibleRegion() );
+  for ( ; !it.IsAtEnd(); ++it )
+    {
+    const typename TImage::IndexType index = it.GetIndex();
+    it.Set( static_cast< typename TImage::PixelType >( index[0] * 3 + index[1] * 5 + index[2] * 7 ) );
+    }
+
+  typename WriterType::Pointer writer = WriterType::New();
+  writer->SetInput( image );
+  writer->SetFileName( fileName );
+  writer->SetUseCompression( compress );
+  if ( imageIO != nullptr )
+    {
+    writer->SetImageIO( imageIO );
+    }
+  TRY_EXPECT_NO_EXCEPTION( writer->Update() );
+
+  typename ReaderType::Pointer reader = ReaderType::New();
+  reader->SetFileName( fileName );
+  if ( imageIO != nullptr )
+    {
+    reader->SetImageIO( imageIO );
+    }
+  TRY_EXPECT_NO_EXCEPTION( reader->Update() );
+  TEST_EXPECT_TRUE( !reader->GetPixelDataMemoryMapped() );
+
+  typename ReaderType::Pointer mappingReader = ReaderType::New();
+  mappingReader->SetFileName( fileName );
+  if ( imageIO != nullptr )
+    {
+    mappingReader->SetImageIO( imageIO );
+    }
+  mappingReader->UseMemoryMappingOn();
+  TRY_EXPECT_NO_EXCEPTION( mappingReader->Update() );
+  TEST_EXPECT_EQUAL( mappingReader->GetPixelDataMemoryMapped(), expectMapped );
+
+  typename TImage::Pointer readImage = reader->GetOutput();
+  typename TImage::Pointer mappedImage = mappingReader->GetOutput();
+  TEST_EXPECT_EQUAL( readImage->GetBufferedRegion(), mappedImage->GetBufferedRegion() );
+
+  itk::SizeValueType numberOfDifferences = 0;
+  itk::ImageRegionIteratorWithIndex< TImage > rit( readImage, readImage->GetBufferedRegion() );
+  itk::ImageRegionIteratorWithIndex< TImage > mit( mappedImage, readImage->GetBufferedRegion() );
+  for ( it.GoToBegin(); !rit.IsAtEnd(); ++it, ++rit, ++mit )
+    {
+    numberOfDifferences += ( rit.Get() != it.Get() ) + ( mit.Get() != it.Get() );
+    }
+  TEST_EXPECT_EQUAL( numberOfDifferences, 0 );
+
+  // the mapping is private: the pixels written are not written to the file
+  mappedImage->FillBuffer( 0 );
+  mappedImage = nullptr;
+  mappingReader = nullptr;
+
+  reader->Modified();
+  TRY_EXPECT_NO_EXCEPTION( reader->Update() );
+  for ( it.GoToBegin(), rit.GoToBegin(); !it.IsAtEnd(); ++it, ++rit )
+    {
+    numberOfDifferences += ( rit.Get() != it.Get() );
+    }
+  TEST_EXPECT_EQUAL( numberOfDifferences, 0 );
+
+  return EXIT_SUCCESS;
+}
+}
+
+int itkImageFileReaderMemoryMappingTest( int argc, char* argv[] )
+{
+  if ( argc < 2 )
+    {
+    std::cerr << "Missing parameters." << std::endl;
+    std::cerr << "Usage: " << argv[0] << " OutputDirectory" << std::endl;
+    return EXIT_FAILURE;
+    }
+  const std::string outputDirectory = argv[1];
+
+  using ShortImageType = itk::Image< short, 3 >;
+  using UCharImageType = itk::Image< unsigned char, 3 >;
+  using FloatImageType = itk::Image< float, 3 >;
+
+  itk::ImageFileReader< ShortImageType >::Pointer reader = itk::ImageFileReader< ShortImageType >::New();
+  EXERCISE_BASIC_OBJECT_METHODS( reader, ImageFileReader, ImageSource );
+  TEST_SET_GET_BOOLEAN( reader, UseMemoryMapping, false );
+  TEST_SET_GET_BOOLEAN( reader, UseMemoryMapping, true );
+  TEST_EXPECT_TRUE( !reader->GetPixelDataMemoryMapped() );
+
+  const bool systemIsBigEndian = itk::ByteSwapper< short >::SystemIsBigEndian();
+  int        testStatus = EXIT_SUCCESS;
+
+  // The pixels are only mapped at an offset aligned on their size, which is
+  // not known for a header of variable length: unsigned char is used then.
+
+  // MetaImage: the pixel data following the header in the same file, in a
+  // separate file, and compressed, which is read as usual
+  testStatus |= CompareMappedAndReadImages< UCharImageType >( outputDirectory + "/MemoryMapping.mha", false, true );
+  testStatus |= CompareMappedAndReadImages< FloatImageType >( outputDirectory + "/MemoryMapping.mhd", false, true );
+  testStatus |=
+    CompareMappedAndReadImages< ShortImageType >( outputDirectory + "/MemoryMappingCompressed.mha", true, false );
+
+  // NIfTI: single and separate files, compressed, and floating point data,
+  // which may be rescaled
+  testStatus |= CompareMappedAndReadImages< ShortImageType >( outputDirectory + "/MemoryMapping.nii", false, true );
+  testStatus |= CompareMappedAndReadImages< ShortImageType >( outputDirectory + "/MemoryMapping.hdr", false, true );
+  testStatus |=
+    CompareMappedAndReadImages< ShortImageType >( outputDirectory + "/MemoryMappingCompressed.nii.gz", true, false );
+  testStatus |= CompareMappedAndReadImages< FloatImageType >( outputDirectory + "/MemoryMappingFloat.nii", false, false );
+
+  // NRRD: raw data in the header file or in a separate file, and gzip
+  // encoded data
+  testStatus |= CompareMappedAndReadImages< UCharImageType >( outputDirectory + "/MemoryMapping.nrrd", false, true );
+  testStatus |= CompareMappedAndReadImages< FloatImageType >( outputDirectory + "/MemoryMapping.nhdr", false, true );
+  testStatus |=
+    CompareMappedAndReadImages< ShortImageType >( outputDirectory + "/MemoryMappingCompressed.nrrd", true, false );
+
+  // VTK: the binary data is big endian
+  testStatus |= CompareMappedAndReadImages< UCharImageType >( outputDirectory + "/MemoryMapping.vtk", false, true );
+  testStatus |= CompareMappedAndReadImages< ShortImageType >( outputDirectory + "/MemoryMappingShort.vtk", false,
+                                                              systemIsBigEndian );
+
+  // RAW: only the data in the byte order of the system is mapped
+  using RawImageIOType = itk::RawImageIO< short, 3 >;
+  RawImageIOType::Pointer rawIO = RawImageIOType::New();
+  rawIO->SetFileDimensionality( 3 );
+  rawIO->SetByteOrder( systemIsBigEndian ? itk::ImageIOBase::BigEndian : itk::ImageIOBase::LittleEndian );
+  testStatus |=
+    CompareMappedAndReadImages< ShortImageType >( outputDirectory + "/MemoryMapping.raw", false, true, rawIO );
+  RawImageIOType::Pointer swappedRawIO = RawImageIOType::New();
+  swappedRawIO->SetFileDimensionality( 3 );
+  swappedRawIO->SetByteOrder( systemIsBigEndian ? itk::ImageIOBase::LittleEndian : itk::ImageIOBase::BigEndian );
+  testStatus |= CompareMappedAndReadImages< ShortImageType >( outputDirectory + "/MemoryMappingSwapped.raw", false,
+                                                              false, swappedRawIO );
+
+  std::cout << "Test finished." << std::endl;
+  return testStatus;
+}
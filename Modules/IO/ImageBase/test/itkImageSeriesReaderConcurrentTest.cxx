@@ -0,0 +1,109 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+#include "itkGDCMImageIO.h"
+#include "itkImageFileWriter.h"
+#include "itkImageSeriesReader.h"
+#include "itkSimpleFilterWatcher.h"
+#include "itkTestingMacros.h"
+
+// Reads the same series one file at a time and with concurrent reads, in
+// both orders, and writes the images, which are compared by the test driver.
+// The meta data dictionaries must be identical.
+int itkImageSeriesReaderConcurrentTest( int argc, char* argv[] )
+{
+  if ( argc < 6 )
+    {
+    std::cerr << "Missing parameters." << std::endl;
+    std::cerr << "Usage: " << argv[0]
+              << " serialOutputFileName concurrentOutputFileName"
+              << " reverseSerialOutputFileName reverseConcurrentOutputFileName inputFileName(s)" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  using ImageType = itk::Image< short, 3 >;
+  using ReaderType = itk::ImageSeriesReader< ImageType >;
+  using WriterType = itk::ImageFileWriter< ImageType >;
+
+  ReaderType::FileNamesContainer fileNames;
+  for ( int i = 5; i < argc; ++i )
+    {
+    fileNames.push_back( argv[i] );
+    }
+
+  ReaderType::Pointer reader = ReaderType::New();
+  EXERCISE_BASIC_OBJECT_METHODS( reader, ImageSeriesReader, ImageSource );
+  TEST_SET_GET_VALUE( 1u, reader->GetNumberOfConcurrentReads() );
+  reader->SetNumberOfConcurrentReads( 0 );
+  TEST_SET_GET_VALUE( 1u, reader->GetNumberOfConcurrentReads() );
+  reader->SetNumberOfConcurrentReads( 4 );
+  TEST_SET_GET_VALUE( 4u, reader->GetNumberOfConcurrentReads() );
+
+  for ( bool reverseOrder : { false, true } )
+    {
+    ReaderType::Pointer serialReader = ReaderType::New();
+    serialReader->SetFileNames( fileNames );
+    serialReader->SetImageIO( itk::GDCMImageIO::New() );
+    serialReader->SetReverseOrder( reverseOrder );
+
+    // the files are only read concurrently when each one gets its own ImageIO
+    ReaderType::Pointer concurrentReader = ReaderType::New();
+    concurrentReader->SetFileNames( fileNames );
+    concurrentReader->SetReverseOrder( reverseOrder );
+    concurrentReader->SetNumberOfConcurrentReads( 4 );
+    itk::SimpleFilterWatcher watcher( concurrentReader );
+    watcher.QuietOn();
+
+    WriterType::Pointer writer = WriterType::New();
+    writer->SetInput( serialReader->GetOutput() );
+    writer->SetFileName( argv[reverseOrder ? 3 : 1] );
+    TRY_EXPECT_NO_EXCEPTION( writer->Update() );
+
+    writer->SetInput( concurrentReader->GetOutput() );
+    writer->SetFileName( argv[reverseOrder ? 4 : 2] );
+    TRY_EXPECT_NO_EXCEPTION( writer->Update() );
+
+    // the progress is reported for each file
+    TEST_EXPECT_TRUE( watcher.GetSteps() >= static_cast< int >( fileNames.size() ) );
+
+    // the instance numbers must come in the same order
+    const ReaderType::DictionaryArrayType & serialDictionaries = *serialReader->GetMetaDataDictionaryArray();
+    const ReaderType::DictionaryArrayType & concurrentDictionaries = *concurrentReader->GetMetaDataDictionaryArray();
+    TEST_EXPECT_EQUAL( serialDictionaries.size(), concurrentDictionaries.size() );
+    const std::string instanceNumberTag = "0020|0013";
+    for ( size_t i = 0; i < serialDictionaries.size(); ++i )
+      {
+      std::string serialValue;
+      std::string concurrentValue;
+      itk::ExposeMetaData< std::string >( *serialDictionaries[i], instanceNumberTag, serialValue );
+      itk::ExposeMetaData< std::string >( *concurrentDictionaries[i], instanceNumberTag, concurrentValue );
+      TEST_EXPECT_EQUAL( serialValue, concurrentValue );
+      }
+    }
+
+  // a missing file in the middle of the series is only found while reading
+  // concurrently, and must be reported as with serial reading
+  fileNames.insert( fileNames.begin() + 1, "NonExistentFile.dcm" );
+  ReaderType::Pointer failingReader = ReaderType::New();
+  failingReader->SetFileNames( fileNames );
+  failingReader->SetNumberOfConcurrentReads( 4 );
+  TRY_EXPECT_EXCEPTION( failingReader->Update() );
+
+  std::cout << "Test finished." << std::endl;
+  return EXIT_SUCCESS;
+}
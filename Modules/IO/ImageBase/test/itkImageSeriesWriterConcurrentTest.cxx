@@ -0,0 +1,160 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+#include "itkImageSeriesWriter.h"
+#include "itkImageRegionIteratorWithIndex.h"
+#include "itkMetaImageIO.h"
+#include "itkNumericSeriesFileNames.h"
+#include "itkSimpleFilterWatcher.h"
+#include "itkTestingMacros.h"
+
+#include <fstream>
+#include <iterator>
+
+namespace
+{
+std::string
+ReadFileContents( const std::string & fileName )
+{
+  std::ifstream file( fileName.c_str(), std::ios::binary );
+  return std::string( std::istreambuf_iterator< char >( file ), std::istreambuf_iterator< char >() );
+}
+
+// Writes the series once one file at a time and once concurrently, and
+// checks that the files are identical.
+template< typename TWriter >
+int
+CompareSerialAndConcurrentWrites( TWriter * writer, const std::string & outputDirectory,
+                                  const std::string & extension, itk::ImageIOBase * serialImageIO,
+                                  itk::ImageIOBase * concurrentImageIO )
+{
+  const unsigned int numberOfFiles = writer->GetInput()->GetLargestPossibleRegion().GetSize()[2];
+
+  itk::NumericSeriesFileNames::Pointer serialNames = itk::NumericSeriesFileNames::New();
+  serialNames->SetStartIndex( 0 );
+  serialNames->SetEndIndex( numberOfFiles - 1 );
+  serialNames->SetSeriesFormat( outputDirectory + "/seriesSerial%03d." + extension );
+
+  itk::NumericSeriesFileNames::Pointer concurrentNames = itk::NumericSeriesFileNames::New();
+  concurrentNames->SetStartIndex( 0 );
+  concurrentNames->SetEndIndex( numberOfFiles - 1 );
+  concurrentNames->SetSeriesFormat( outputDirectory + "/seriesConcurrent%03d." + extension );
+
+  writer->SetImageIO( serialImageIO );
+  writer->SetNumberOfConcurrentWrites( 1 );
+  writer->SetFileNames( serialNames->GetFileNames() );
+  TRY_EXPECT_NO_EXCEPTION( writer->Update() );
+
+  writer->SetImageIO( concurrentImageIO );
+  writer->SetNumberOfConcurrentWrites( 4 );
+  writer->SetFileNames( concurrentNames->GetFileNames() );
+  itk::SimpleFilterWatcher watcher( writer );
+  watcher.QuietOn();
+  TRY_EXPECT_NO_EXCEPTION( writer->Update() );
+
+  int testStatus = EXIT_SUCCESS;
+
+  // the progress is reported for each file
+  if ( watcher.GetSteps() < static_cast< int >( numberOfFiles ) )
+    {
+    std::cerr << "Test failed!" << std::endl;
+    std::cerr << watcher.GetSteps() << " progress events for " << numberOfFiles << " files" << std::endl;
+    testStatus = EXIT_FAILURE;
+    }
+  for ( unsigned int i = 0; i < numberOfFiles; ++i )
+    {
+    const std::string serialFile = serialNames->GetFileNames()[i];
+    const std::string concurrentFile = concurrentNames->GetFileNames()[i];
+    const std::string serialContents = ReadFileContents( serialFile );
+    if ( serialContents.empty() || serialContents != ReadFileContents( concurrentFile ) )
+      {
+      std::cerr << "Test failed!" << std::endl;
+      std::cerr << concurrentFile << " differs from " << serialFile << std::endl;
+      testStatus = EXIT_FAILURE;
+      }
+    }
+  return testStatus;
+}
+}
+
+int itkImageSeriesWriterConcurrentTest( int argc, char* argv[] )
+{
+  if ( argc < 2 )
+    {
+    std::cerr << "Missing parameters." << std::endl;
+    std::cerr << "Usage: " << argv[0] << " OutputDirectory" << std::endl;
+    return EXIT_FAILURE;
+    }
+  const std::string outputDirectory = argv[1];
+
+  using InputImageType = itk::Image< unsigned char, 3 >;
+  using OutputImageType = itk::Image< unsigned char, 2 >;
+  using WriterType = itk::ImageSeriesWriter< InputImageType, OutputImageType >;
+
+  InputImageType::SizeType size = { { 64, 48, 20 } };
+  InputImageType::Pointer image = InputImageType::New();
+  image->SetRegions( size );
+  image->Allocate();
+  itk::ImageRegionIteratorWithIndex< InputImageType > it( image, image->GetLargestPossibleRegion() );
+  for ( ; !it.IsAtEnd(); ++it )
+    {
+    const InputImageType::IndexType index = it.GetIndex();
+    it.Set( static_cast< unsigned char >( ( index[0] * index[2] + index[1] ) % 256 ) );
+    }
+
+  WriterType::Pointer writer = WriterType::New();
+  EXERCISE_BASIC_OBJECT_METHODS( writer, ImageSeriesWriter, ProcessObject );
+
+  TEST_SET_GET_VALUE( 1u, writer->GetNumberOfConcurrentWrites() );
+  writer->SetNumberOfConcurrentWrites( 0 );
+  TEST_SET_GET_VALUE( 1u, writer->GetNumberOfConcurrentWrites() );
+  writer->SetNumberOfConcurrentWrites( 4 );
+  TEST_SET_GET_VALUE( 4u, writer->GetNumberOfConcurrentWrites() );
+
+  writer->SetInput( image );
+  writer->UseCompressionOn();
+
+  int testStatus = EXIT_SUCCESS;
+
+  // an ImageIO created by the factory for each file
+  if ( CompareSerialAndConcurrentWrites( writer.GetPointer(), outputDirectory, "png", nullptr, nullptr ) != EXIT_SUCCESS )
+    {
+    testStatus = EXIT_FAILURE;
+    }
+
+  // an ImageIO set by the user, whose settings can not be passed on to other
+  // instances: the files are written one after the other
+  itk::MetaImageIO::Pointer serialMetaIO = itk::MetaImageIO::New();
+  serialMetaIO->SetFileType( itk::ImageIOBase::ASCII );
+  itk::MetaImageIO::Pointer concurrentMetaIO = itk::MetaImageIO::New();
+  concurrentMetaIO->SetFileType( itk::ImageIOBase::ASCII );
+  if ( CompareSerialAndConcurrentWrites( writer.GetPointer(), outputDirectory, "mha",
+                                         serialMetaIO, concurrentMetaIO ) != EXIT_SUCCESS )
+    {
+    testStatus = EXIT_FAILURE;
+    }
+
+  // errors while writing concurrently are reported as with serial writing
+  WriterType::FileNamesContainer fileNames = writer->GetFileNames();
+  fileNames[1] = outputDirectory + "/NonExistentDirectory/series.mha";
+  writer->SetFileNames( fileNames );
+  TRY_EXPECT_EXCEPTION( writer->Update() );
+
+  std::cout << "Test finished." << std::endl;
+  return testStatus;
+}
@@ -21,6 +21,7 @@
 
 
 #include <fstream>
+#include <vector>
 #include "itkImageIOBase.h"
 #include "itkSingletonMacro.h"
 #include "metaObject.h"
@@ -126,13 +127,17 @@ public:
    *  CanRead must be called prior to this function. */
   bool CanStreamRead() override
   {
-    if ( m_MetaImage.CompressedData() )
+    if ( m_MetaImage.CompressedData() && m_ReadCompressedDataBlockSize == 0 )
       {
       return false;
       }
     return true;
   }
 
+  /** The pixel data can be memory mapped if it is binary, uncompressed, in
+   *  a single file and in the byte order of the system. */
+  bool GetPixelDataLocation(std::string & fileName, SizeValueType & offset) override;
+
   /** Determine if the ImageIO can stream writing to this
    *  file. Only time cannot stream read/write is if compression is used.
    *  Assumes file passes a CanRead call and its pixels are of the same
@@ -153,6 +158,22 @@ public:
   itkSetMacro(SubSamplingFactor, unsigned int);
   itkGetConstMacro(SubSamplingFactor, unsigned int);
 
+  /** Set/Get the number of uncompressed bytes in each of the blocks which
+   * are compressed independently when UseCompression is on. The default
+   * value of 0 compresses the whole image at once.
+   *
+   * With a positive value, the blocks are compressed in parallel, each one
+   * without references to the previous ones, and are concatenated in a
+   * single zlib stream, so that every MetaIO reader can read the file. The
+   * compressed sizes of the blocks are stored after the zlib stream, where
+   * the other readers ignore them; with this table, MetaImageIO decompresses
+   * the blocks in parallel, and streamed reads only decompress the blocks
+   * which overlap the requested region. Blocks are not used with ASCII
+   * files, or with data files given as a list or a file name pattern.
+   * Sizes larger than 2^30 bytes are clamped to 2^30. */
+  virtual void SetCompressedDataBlockSize(SizeValueType size);
+  itkGetConstMacro(CompressedDataBlockSize, SizeValueType);
+
   /**
    * Set the default precision when writing out the MetaImage header.
    * MetaImage header contains values stored in memory as double,
@@ -175,10 +196,45 @@ private:
   /** Only used to synchronize the global variable across static libraries.*/
   itkGetGlobalDeclarationMacro(unsigned int, DefaultDoublePrecision);
 
-  MetaImage m_MetaImage;
+  /** Read and write the image data as independently compressed blocks. */
+  void ReadCompressedDataBlocks(void *buffer);
+  void WriteCompressedDataBlocks(const void *buffer);
+
+  /** Look for the table of the compressed data blocks after the zlib stream
+   * of the file being read. */
+  void ReadCompressedDataBlockTable();
+
+  /** Returns the name of the file holding the image data. */
+  std::string GetElementDataFileName() const;
+
+  /** \class CompressedDataHeaderMetaImage
+   * A MetaImage which writes the CompressedData and CompressedDataSize
+   * fields of data compressed by MetaImageIO, without compressing the data
+   * again. */
+  class CompressedDataHeaderMetaImage : public MetaImage
+  {
+  public:
+    /** Write the header only, for compressed data of the given size. */
+    bool WriteCompressedDataHeader(const char *headerName, std::streamoff compressedDataSize);
+
+  protected:
+    void M_SetupWriteFields() override;
+
+  private:
+    std::streamoff m_HeaderCompressedDataSize{ 0 };
+  };
+
+  CompressedDataHeaderMetaImage m_MetaImage;
 
   unsigned int m_SubSamplingFactor;
 
+  SizeValueType m_CompressedDataBlockSize;
+
+  /** The size of the blocks of the file being read, 0 if its data is not
+   * compressed in blocks, and the offsets of the blocks in the data file. */
+  SizeValueType                 m_ReadCompressedDataBlockSize;
+  std::vector< std::streamoff > m_CompressedDataBlockOffsets;
+
   static unsigned int * m_DefaultDoublePrecision;
 };
 } // end namespace itk
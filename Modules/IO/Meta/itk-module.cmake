@@ -9,6 +9,8 @@ itk_module(ITKIOMeta
   DEPENDS
     ITKMetaIO
     ITKIOImageBase
+  PRIVATE_DEPENDS
+    ITKZLIB
   TEST_DEPENDS
     ITKTestKernel
     ITKSmoothing
@@ -23,6 +23,16 @@
 #include "itksys/SystemTools.hxx"
 #include "itkMath.h"
 #include "itkSingleton.h"
+#include "itkByteSwapper.h"
+#include "itkMultiThreaderBase.h"
+#include "itk_zlib.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <functional>
+#include <iterator>
+#include <sstream>
 
 namespace itk
 {
@@ -37,6 +47,8 @@ MetaImageIO::MetaImageIO()
   itkInitGlobalsMacro(DefaultDoublePrecision);
   m_FileType = Binary;
   m_SubSamplingFactor = 1;
+  m_CompressedDataBlockSize = 0;
+  m_ReadCompressedDataBlockSize = 0;
   if ( MET_SystemByteOrderMSB() )
     {
     m_ByteOrder = BigEndian;
@@ -62,6 +74,18 @@ void MetaImageIO::PrintSelf(std::ostream & os, Indent indent) const
   Superclass::PrintSelf(os, indent);
   m_MetaImage.PrintInfo();
   os << indent << "SubSamplingFactor: " << m_SubSamplingFactor << "\n";
+  os << indent << "CompressedDataBlockSize: " << m_CompressedDataBlockSize << "\n";
+}
+
+void MetaImageIO::SetCompressedDataBlockSize(SizeValueType size)
+{
+  const SizeValueType clampedSize = std::min( size, static_cast< SizeValueType >( 1 << 30 ) );
+  itkDebugMacro("setting CompressedDataBlockSize to " << clampedSize);
+  if ( m_CompressedDataBlockSize != clampedSize )
+    {
+    m_CompressedDataBlockSize = clampedSize;
+    this->Modified();
+    }
 }
 
 void MetaImageIO::SetDataFileName(const char *filename)
@@ -428,10 +452,18 @@ void MetaImageIO::ReadImageInformation()
     EncapsulateMetaData< std::string >(
       metaDict, ITK_ExperimentDate, std::string( m_MetaImage.AcquisitionDate() ) );
     }
+
+  this->ReadCompressedDataBlockTable();
 }
 
 void MetaImageIO::Read(void *buffer)
 {
+  if ( m_ReadCompressedDataBlockSize > 0 && m_SubSamplingFactor == 1 )
+    {
+    this->ReadCompressedDataBlocks(buffer);
+    return;
+    }
+
   const unsigned int nDims = this->GetNumberOfDimensions();
 
   // this will check to see if we are actually streaming
@@ -1075,6 +1107,14 @@ MetaImageIO
 
   m_MetaImage.CompressedData(m_UseCompression);
 
+  // the data is compressed in blocks only when MetaIO would have written it
+  // as a single zlib stream
+  const std::string elementDataFileName = m_MetaImage.ElementDataFileName();
+  const bool useCompressedDataBlocks = m_UseCompression && binaryData && m_CompressedDataBlockSize > 0
+    && this->GetImageSizeInBytes() > 0
+    && elementDataFileName.compare(0, 4, "LIST") != 0
+    && elementDataFileName.find('%') == std::string::npos;
+
   // this is a check to see if we are actually streaming
   // we initialize with m_IORegion to match dimensions
   ImageIORegion largestRegion(m_IORegion);
@@ -1118,6 +1158,14 @@ MetaImageIO
     delete[] indexMin;
     delete[] indexMax;
     }
+  else if ( useCompressedDataBlocks )
+    {
+    delete[] dSize;
+    delete[] eSpacing;
+    delete[] eOrigin;
+    this->WriteCompressedDataBlocks(buffer);
+    return;
+    }
   else
     {
     if ( !m_MetaImage.Write( m_FileName.c_str() ) )
@@ -1138,6 +1186,553 @@ MetaImageIO
   delete[] eOrigin;
 }
 
+std::string
+MetaImageIO
+::GetElementDataFileName() const
+{
+  const std::string elementDataFileName = m_MetaImage.ElementDataFileName();
+  if ( elementDataFileName == "LOCAL" )
+    {
+    return m_MetaImage.FileName();
+    }
+  if ( itksys::SystemTools::FileIsFullPath(elementDataFileName) )
+    {
+    return elementDataFileName;
+    }
+  // relative to the header, as in MetaIO
+  const std::string path = itksys::SystemTools::GetFilenamePath( m_MetaImage.FileName() );
+  if ( path.empty() )
+    {
+    return elementDataFileName;
+    }
+  return path + "/" + elementDataFileName;
+}
+
+bool
+MetaImageIO
+::GetPixelDataLocation(std::string & fileName, SizeValueType & offset)
+{
+  const std::string elementDataFileName = m_MetaImage.ElementDataFileName();
+  if ( !m_MetaImage.BinaryData() || m_MetaImage.CompressedData() || m_SubSamplingFactor != 1
+       || elementDataFileName.compare(0, 4, "LIST") == 0
+       || elementDataFileName.find('%') != std::string::npos )
+    {
+    return false;
+    }
+  if ( this->GetComponentSize() > 1
+       && m_MetaImage.BinaryDataByteOrderMSB() != ByteSwapper< int >::SystemIsBigEndian() )
+    {
+    return false;
+    }
+
+  fileName = this->GetElementDataFileName();
+  const SizeValueType imageSizeInBytes = this->GetImageSizeInBytes();
+  const auto          fileSize = static_cast< SizeValueType >( itksys::SystemTools::FileLength(fileName) );
+  if ( fileSize < imageSizeInBytes )
+    {
+    return false;
+    }
+  if ( m_MetaImage.HeaderSize() > 0 )
+    {
+    offset = m_MetaImage.HeaderSize();
+    }
+  else if ( m_MetaImage.HeaderSize() == -1 )
+    {
+    offset = fileSize - imageSizeInBytes;
+    }
+  else if ( elementDataFileName == "LOCAL" )
+    {
+    // the data follows the ElementDataFile line, which ends the header
+    std::ifstream file( fileName.c_str(), std::ios::in | std::ios::binary );
+    std::string   line;
+    offset = 0;
+    while ( offset == 0 && std::getline(file, line) )
+      {
+      const std::string::size_type start = line.find_first_not_of(" \t");
+      if ( start != std::string::npos && line.compare(start, 15, "ElementDataFile") == 0 )
+        {
+        offset = static_cast< SizeValueType >( file.tellg() );
+        }
+      }
+    if ( offset == 0 || fileSize - offset < imageSizeInBytes )
+      {
+      return false;
+      }
+    }
+  else
+    {
+    offset = 0;
+    }
+  return true;
+}
+
+namespace
+{
+// The compressed data blocks are followed by the table of their compressed
+// sizes, by the block size, the number of blocks and this signature, all as
+// unsigned 64 bit little endian integers.
+const char CompressedDataBlocksSignature[8] = { 'I', 'T', 'K', 'B', 'L', 'O', 'C', 'K' };
+constexpr std::streamoff CompressedDataBlocksTrailerSize =
+  2 * sizeof( uint64_t ) + sizeof( CompressedDataBlocksSignature );
+
+// The header of the zlib stream, for the default compression level, and the
+// size of its Adler-32 checksum.
+const unsigned char ZlibStreamHeader[2] = { 0x78, 0x9c };
+constexpr std::streamoff ZlibStreamChecksumSize = 4;
+}
+
+void
+MetaImageIO
+::ReadCompressedDataBlockTable()
+{
+  m_ReadCompressedDataBlockSize = 0;
+  m_CompressedDataBlockOffsets.clear();
+
+  const std::string elementDataFileName = m_MetaImage.ElementDataFileName();
+  if ( !m_MetaImage.BinaryData() || !m_MetaImage.CompressedData() || m_MetaImage.HeaderSize() != 0
+       || elementDataFileName.compare(0, 4, "LIST") == 0
+       || elementDataFileName.find('%') != std::string::npos )
+    {
+    return;
+    }
+
+  // A file without a consistent table is read by MetaIO as a single zlib
+  // stream.
+  std::ifstream file( this->GetElementDataFileName().c_str(), std::ios::in | std::ios::binary );
+  file.seekg( 0, std::ios::end );
+  const std::streamoff fileSize = file.tellg();
+  if ( !file.good() || fileSize < CompressedDataBlocksTrailerSize )
+    {
+    return;
+    }
+
+  uint64_t trailer[2];
+  char     signature[sizeof( CompressedDataBlocksSignature )];
+  file.seekg( fileSize - CompressedDataBlocksTrailerSize, std::ios::beg );
+  file.read( reinterpret_cast< char * >( trailer ), sizeof( trailer ) );
+  file.read( signature, sizeof( signature ) );
+  if ( !file.good() || std::memcmp( signature, CompressedDataBlocksSignature, sizeof( signature ) ) != 0 )
+    {
+    return;
+    }
+  ByteSwapper< uint64_t >::SwapRangeFromSystemToLittleEndian( trailer, 2 );
+  const uint64_t      blockSize = trailer[0];
+  const uint64_t      numberOfBlocks = trailer[1];
+  const SizeValueType imageSizeInBytes = this->GetImageSizeInBytes();
+  if ( blockSize == 0 || numberOfBlocks != ( imageSizeInBytes + blockSize - 1 ) / blockSize
+       || numberOfBlocks > static_cast< uint64_t >( fileSize ) / sizeof( uint64_t ) )
+    {
+    return;
+    }
+
+  const std::streamoff tableOffset = fileSize - CompressedDataBlocksTrailerSize
+    - static_cast< std::streamoff >( numberOfBlocks * sizeof( uint64_t ) );
+  if ( tableOffset < 0 )
+    {
+    return;
+    }
+  std::vector< uint64_t > compressedSizes( numberOfBlocks );
+  file.seekg( tableOffset, std::ios::beg );
+  file.read( reinterpret_cast< char * >( compressedSizes.data() ), numberOfBlocks * sizeof( uint64_t ) );
+  if ( !file.good() )
+    {
+    return;
+    }
+  ByteSwapper< uint64_t >::SwapRangeFromSystemToLittleEndian( compressedSizes.data(), numberOfBlocks );
+
+  std::streamoff streamSize = sizeof( ZlibStreamHeader ) + ZlibStreamChecksumSize;
+  for ( uint64_t compressedSize : compressedSizes )
+    {
+    if ( compressedSize > static_cast< uint64_t >( fileSize ) )
+      {
+      return;
+      }
+    streamSize += static_cast< std::streamoff >( compressedSize );
+    }
+  const std::streamoff streamOffset = tableOffset - streamSize;
+
+  // The zlib stream starts the data file, or follows the line feed which
+  // ends the header.
+  char previous = '\n';
+  if ( elementDataFileName == "LOCAL" && streamOffset > 0 )
+    {
+    file.seekg( streamOffset - 1, std::ios::beg );
+    file.get( previous );
+    }
+  else if ( streamOffset != 0 )
+    {
+    return;
+    }
+  unsigned char streamHeader[sizeof( ZlibStreamHeader )];
+  file.seekg( streamOffset, std::ios::beg );
+  file.read( reinterpret_cast< char * >( streamHeader ), sizeof( streamHeader ) );
+  if ( !file.good() || previous != '\n' || std::memcmp( streamHeader, ZlibStreamHeader, sizeof( streamHeader ) ) != 0 )
+    {
+    return;
+    }
+
+  m_CompressedDataBlockOffsets.resize( numberOfBlocks + 1 );
+  m_CompressedDataBlockOffsets[0] = streamOffset + sizeof( ZlibStreamHeader );
+  for ( SizeValueType block = 0; block < numberOfBlocks; ++block )
+    {
+    m_CompressedDataBlockOffsets[block + 1] =
+      m_CompressedDataBlockOffsets[block] + static_cast< std::streamoff >( compressedSizes[block] );
+    }
+  m_ReadCompressedDataBlockSize = blockSize;
+}
+
+void
+MetaImageIO
+::ReadCompressedDataBlocks(void *buffer)
+{
+  const std::string dataFileName = this->GetElementDataFileName();
+  std::ifstream     file( dataFileName.c_str(), std::ios::in | std::ios::binary );
+  if ( !file.is_open() )
+    {
+    itkExceptionMacro( "File cannot be read: "
+                       << dataFileName << " for reading."
+                       << std::endl
+                       << "Reason: "
+                       << itksys::SystemTools::GetLastSystemError() );
+    }
+
+  const unsigned int  nDims = this->GetNumberOfDimensions();
+  const SizeValueType pixelSize = this->GetComponentSize() * this->GetNumberOfComponents();
+  const SizeValueType imageSizeInBytes = this->GetImageSizeInBytes();
+  const SizeValueType blockSize = m_ReadCompressedDataBlockSize;
+  const SizeValueType numberOfBlocks = m_CompressedDataBlockOffsets.size() - 1;
+
+  // The requested region is copied row by row, a row being contiguous both
+  // in the file and in the buffer.
+  std::vector< SizeValueType > regionIndex( nDims, 0 );
+  std::vector< SizeValueType > regionSize( nDims, 1 );
+  std::vector< SizeValueType > fileStride( nDims, pixelSize );
+  bool                         wholeImage = true;
+  for ( unsigned int i = 0; i < nDims; i++ )
+    {
+    if ( i < m_IORegion.GetImageDimension() )
+      {
+      regionIndex[i] = m_IORegion.GetIndex()[i];
+      regionSize[i] = m_IORegion.GetSize()[i];
+      }
+    else
+      {
+      regionIndex[i] = 0;
+      regionSize[i] = 1;
+      }
+    wholeImage = wholeImage && regionIndex[i] == 0 && regionSize[i] == this->GetDimensions(i);
+    if ( i > 0 )
+      {
+      fileStride[i] = fileStride[i - 1] * this->GetDimensions(i - 1);
+      }
+    }
+  const SizeValueType rowSizeInBytes = regionSize[0] * pixelSize;
+
+  auto forEachRow = [&]( const std::function< void( SizeValueType, SizeValueType ) > & function )
+    {
+    std::vector< SizeValueType > rowIndex( regionIndex );
+    SizeValueType                bufferOffset = 0;
+    while ( true )
+      {
+      SizeValueType fileOffset = 0;
+      for ( unsigned int i = 0; i < nDims; i++ )
+        {
+        fileOffset += rowIndex[i] * fileStride[i];
+        }
+      function( fileOffset, bufferOffset );
+      bufferOffset += rowSizeInBytes;
+
+      unsigned int i = 1;
+      for ( ; i < nDims; i++ )
+        {
+        if ( ++rowIndex[i] < regionIndex[i] + regionSize[i] )
+          {
+          break;
+          }
+        rowIndex[i] = regionIndex[i];
+        }
+      if ( i >= nDims )
+        {
+        return;
+        }
+      }
+    };
+
+  std::vector< SizeValueType > blocksToRead;
+  if ( wholeImage )
+    {
+    for ( SizeValueType block = 0; block < numberOfBlocks; ++block )
+      {
+      blocksToRead.push_back( block );
+      }
+    }
+  else
+    {
+    std::vector< bool > blockIsNeeded( numberOfBlocks, false );
+    forEachRow( [&]( SizeValueType fileOffset, SizeValueType )
+      {
+        const SizeValueType lastBlock = ( fileOffset + rowSizeInBytes - 1 ) / blockSize;
+        for ( SizeValueType block = fileOffset / blockSize; block <= lastBlock; ++block )
+          {
+          blockIsNeeded[block] = true;
+          }
+      } );
+    for ( SizeValueType block = 0; block < numberOfBlocks; ++block )
+      {
+      if ( blockIsNeeded[block] )
+        {
+        blocksToRead.push_back( block );
+        }
+      }
+    }
+
+  // Read the needed blocks one after the other, and decompress them in
+  // parallel. The whole image is decompressed in place.
+  std::vector< std::vector< Bytef > > compressedBlocks( numberOfBlocks );
+  for ( SizeValueType block : blocksToRead )
+    {
+    compressedBlocks[block].resize(
+      static_cast< SizeValueType >( m_CompressedDataBlockOffsets[block + 1] - m_CompressedDataBlockOffsets[block] ) );
+    file.seekg( m_CompressedDataBlockOffsets[block], std::ios::beg );
+    file.read( reinterpret_cast< char * >( compressedBlocks[block].data() ), compressedBlocks[block].size() );
+    }
+  if ( !file.good() )
+    {
+    itkExceptionMacro( "File cannot be read: "
+                       << dataFileName << " for reading."
+                       << std::endl
+                       << "Reason: "
+                       << itksys::SystemTools::GetLastSystemError() );
+    }
+  file.close();
+
+  auto * output = static_cast< Bytef * >( buffer );
+  std::vector< std::vector< Bytef > > blocks( wholeImage ? 0 : numberOfBlocks );
+  std::atomic< bool > failed( false );
+  MultiThreaderBase::Pointer multiThreader = MultiThreaderBase::New();
+  multiThreader->ParallelizeArray(
+    0,
+    blocksToRead.size(),
+    [&]( SizeValueType i )
+    {
+      const SizeValueType block = blocksToRead[i];
+      const SizeValueType start = block * blockSize;
+      const SizeValueType length = std::min( blockSize, imageSizeInBytes - start );
+      Bytef *             destination = output + start;
+      if ( !wholeImage )
+        {
+        blocks[block].resize( length );
+        destination = blocks[block].data();
+        }
+
+      // each block is a raw deflate stream, and all but the last one end
+      // with a sync flush instead of the end of the zlib stream
+      z_stream stream;
+      stream.zalloc = nullptr;
+      stream.zfree = nullptr;
+      stream.opaque = nullptr;
+      stream.next_in = compressedBlocks[block].data();
+      stream.avail_in = static_cast< uInt >( compressedBlocks[block].size() );
+      if ( inflateInit2( &stream, -MAX_WBITS ) != Z_OK )
+        {
+        failed = true;
+        return;
+        }
+      stream.next_out = destination;
+      stream.avail_out = static_cast< uInt >( length );
+      const int status = inflate( &stream, Z_FINISH );
+      if ( ( status != Z_STREAM_END && status != Z_OK && status != Z_BUF_ERROR ) || stream.total_out != length )
+        {
+        failed = true;
+        }
+      inflateEnd( &stream );
+      std::vector< Bytef >().swap( compressedBlocks[block] );
+    },
+    nullptr );
+  if ( failed )
+    {
+    itkExceptionMacro( "Decompression of the compressed data blocks failed: " << dataFileName );
+    }
+
+  if ( !wholeImage )
+    {
+    forEachRow( [&]( SizeValueType fileOffset, SizeValueType bufferOffset )
+      {
+        SizeValueType copied = 0;
+        while ( copied < rowSizeInBytes )
+          {
+          const SizeValueType position = fileOffset + copied;
+          const SizeValueType block = position / blockSize;
+          const SizeValueType positionInBlock = position % blockSize;
+          const SizeValueType length = std::min( rowSizeInBytes - copied, blockSize - positionInBlock );
+          std::memcpy( output + bufferOffset + copied, blocks[block].data() + positionInBlock, length );
+          copied += length;
+          }
+      } );
+    }
+
+  m_MetaImage.ElementData( buffer, false );
+  m_MetaImage.ElementByteOrderFix( wholeImage ? this->GetImageSizeInPixels() : m_IORegion.GetNumberOfPixels() );
+}
+
+void
+MetaImageIO
+::WriteCompressedDataBlocks(const void *buffer)
+{
+  const SizeValueType imageSizeInBytes = this->GetImageSizeInBytes();
+  const SizeValueType blockSize = m_CompressedDataBlockSize;
+  const SizeValueType numberOfBlocks = ( imageSizeInBytes + blockSize - 1 ) / blockSize;
+  const auto *        data = static_cast< const Bytef * >( buffer );
+
+  // Each block is compressed without references to the previous ones, and
+  // all but the last one end with a sync flush, so that the blocks make a
+  // single deflate stream.
+  std::vector< std::vector< Bytef > > blocks( numberOfBlocks );
+  std::vector< uLong > checksums( numberOfBlocks );
+  std::atomic< bool > failed( false );
+  MultiThreaderBase::Pointer multiThreader = MultiThreaderBase::New();
+  multiThreader->ParallelizeArray(
+    0,
+    numberOfBlocks,
+    [&]( SizeValueType block )
+    {
+      const SizeValueType start = block * blockSize;
+      const auto          length = static_cast< uInt >( std::min( blockSize, imageSizeInBytes - start ) );
+      const bool          lastBlock = block + 1 == numberOfBlocks;
+
+      z_stream stream;
+      stream.zalloc = nullptr;
+      stream.zfree = nullptr;
+      stream.opaque = nullptr;
+      if ( deflateInit2( &stream, Z_DEFAULT_COMPRESSION, Z_DEFLATED, -MAX_WBITS, 8, Z_DEFAULT_STRATEGY ) != Z_OK )
+        {
+        failed = true;
+        return;
+        }
+      // with room for the sync flush marker
+      blocks[block].resize( deflateBound( &stream, length ) + 16 );
+      stream.next_in = const_cast< Bytef * >( data + start );
+      stream.avail_in = length;
+      stream.next_out = blocks[block].data();
+      stream.avail_out = static_cast< uInt >( blocks[block].size() );
+      const int status = deflate( &stream, lastBlock ? Z_FINISH : Z_SYNC_FLUSH );
+      if ( status != ( lastBlock ? Z_STREAM_END : Z_OK ) || stream.avail_in != 0 || stream.avail_out == 0 )
+        {
+        failed = true;
+        }
+      blocks[block].resize( stream.total_out );
+      deflateEnd( &stream );
+
+      checksums[block] = adler32( adler32( 0L, Z_NULL, 0 ), data + start, length );
+    },
+    nullptr );
+  if ( failed )
+    {
+    itkExceptionMacro( "Compression of the image data failed for: " << this->GetFileName() );
+    }
+
+  std::vector< uint64_t > compressedSizes( numberOfBlocks );
+  uLong                   checksum = adler32( 0L, Z_NULL, 0 );
+  std::streamoff          streamSize = sizeof( ZlibStreamHeader ) + ZlibStreamChecksumSize;
+  for ( SizeValueType block = 0; block < numberOfBlocks; ++block )
+    {
+    const SizeValueType start = block * blockSize;
+    checksum = adler32_combine( checksum, checksums[block],
+                                static_cast< z_off_t >( std::min( blockSize, imageSizeInBytes - start ) ) );
+    compressedSizes[block] = blocks[block].size();
+    streamSize += static_cast< std::streamoff >( blocks[block].size() );
+    }
+  ByteSwapper< uint64_t >::SwapRangeFromSystemToLittleEndian( compressedSizes.data(), numberOfBlocks );
+  uint64_t trailer[2] = { blockSize, numberOfBlocks };
+  ByteSwapper< uint64_t >::SwapRangeFromSystemToLittleEndian( trailer, 2 );
+  const unsigned char streamChecksum[ZlibStreamChecksumSize] = {
+    static_cast< unsigned char >( checksum >> 24 ), static_cast< unsigned char >( checksum >> 16 ),
+    static_cast< unsigned char >( checksum >> 8 ), static_cast< unsigned char >( checksum ) };
+
+  // Write the header, naming the data file as MetaIO would, then append
+  // the data to the header or write it to the data file.
+  const bool userDataFileName = strlen( m_MetaImage.ElementDataFileName() ) > 0;
+  if ( !userDataFileName )
+    {
+    if ( itksys::SystemTools::GetFilenameLastExtension(m_FileName) == ".mha" )
+      {
+      m_MetaImage.ElementDataFileName("LOCAL");
+      }
+    else
+      {
+      const std::string zrawFileName = itksys::SystemTools::GetFilenameWithoutLastExtension(m_FileName) + ".zraw";
+      m_MetaImage.ElementDataFileName( zrawFileName.c_str() );
+      }
+    }
+  const bool        headerWritten = m_MetaImage.WriteCompressedDataHeader( m_FileName.c_str(), streamSize );
+  const bool        local = !strcmp( m_MetaImage.ElementDataFileName(), "LOCAL" );
+  const std::string dataFileName = this->GetElementDataFileName();
+  if ( !userDataFileName )
+    {
+    m_MetaImage.ElementDataFileName("");
+    }
+  if ( !headerWritten )
+    {
+    itkExceptionMacro( "File cannot be written: "
+                       << this->GetFileName()
+                       << std::endl
+                       << "Reason: "
+                       << itksys::SystemTools::GetLastSystemError() );
+    }
+
+  std::ofstream file( dataFileName.c_str(),
+                      std::ios::out | std::ios::binary | ( local ? std::ios::app : std::ios::trunc ) );
+  file.write( reinterpret_cast< const char * >( ZlibStreamHeader ), sizeof( ZlibStreamHeader ) );
+  for ( SizeValueType block = 0; block < numberOfBlocks; ++block )
+    {
+    file.write( reinterpret_cast< const char * >( blocks[block].data() ), blocks[block].size() );
+    }
+  file.write( reinterpret_cast< const char * >( streamChecksum ), sizeof( streamChecksum ) );
+  file.write( reinterpret_cast< const char * >( compressedSizes.data() ), numberOfBlocks * sizeof( uint64_t ) );
+  file.write( reinterpret_cast< const char * >( trailer ), sizeof( trailer ) );
+  file.write( CompressedDataBlocksSignature, sizeof( CompressedDataBlocksSignature ) );
+  if ( !file.good() )
+    {
+    itkExceptionMacro( "File cannot be written: "
+                       << dataFileName
+                       << std::endl
+                       << "Reason: "
+                       << itksys::SystemTools::GetLastSystemError() );
+    }
+}
+
+bool
+MetaImageIO::CompressedDataHeaderMetaImage
+::WriteCompressedDataHeader(const char *headerName, std::streamoff compressedDataSize)
+{
+  // MetaImage::Write would compress the whole image again to write the
+  // header of compressed data, so the header is written as for uncompressed
+  // data, and M_SetupWriteFields() adds the fields of the compressed data.
+  const bool compressedData = this->CompressedData();
+  this->CompressedData(false);
+  m_HeaderCompressedDataSize = compressedDataSize;
+  const bool written = this->Write( headerName, nullptr, false );
+  m_HeaderCompressedDataSize = 0;
+  this->CompressedData(compressedData);
+  return written;
+}
+
+void
+MetaImageIO::CompressedDataHeaderMetaImage
+::M_SetupWriteFields()
+{
+  if ( m_HeaderCompressedDataSize == 0 )
+    {
+    MetaImage::M_SetupWriteFields();
+    return;
+    }
+  m_CompressedData = true;
+  m_CompressedDataSize = m_HeaderCompressedDataSize;
+  MetaImage::M_SetupWriteFields();
+  m_CompressedData = false;
+  m_CompressedDataSize = 0;
+}
+
 /** Given a requested region, determine what could be the region that we can
  * read from the file. This is called the streamable region, which will be
  * smaller than the LargestPossibleRegion and greater or equal to the
@@ -0,0 +1,143 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#include "itkImageFileReader.h"
+#include "itkImageFileWriter.h"
+#include "itkImageRegionConstIterator.h"
+#include "itkImageRegionIteratorWithIndex.h"
+#include "itkMetaImageIO.h"
+#include "itkTestingMacros.h"
+
+#include <algorithm>
+
+/* Writes the image with compressed data blocks of several sizes. The files
+ * are compared with the uncompressed image by the test driver; this test
+ * reads them back with MetaIO, and streams a region which straddles several
+ * blocks.
+ */
+
+namespace
+{
+using ImageType = itk::Image< short, 3 >;
+
+int
+WriteAndReadCompressedBlocks( const ImageType * image, const std::string & fileName,
+                              itk::SizeValueType blockSize )
+{
+  using WriterType = itk::ImageFileWriter< ImageType >;
+  using ReaderType = itk::ImageFileReader< ImageType >;
+
+  itk::MetaImageIO::Pointer writeIO = itk::MetaImageIO::New();
+  writeIO->SetCompressedDataBlockSize( blockSize );
+  WriterType::Pointer writer = WriterType::New();
+  writer->SetInput( image );
+  writer->SetFileName( fileName );
+  writer->SetImageIO( writeIO );
+  writer->UseCompressionOn();
+  TRY_EXPECT_NO_EXCEPTION( writer->Update() );
+
+  // the blocks make a single zlib stream, which MetaIO reads by itself
+  MetaImage metaImage;
+  TEST_EXPECT_TRUE( metaImage.Read( fileName.c_str() ) );
+  const ImageType::PixelType * elementData = static_cast< const ImageType::PixelType * >( metaImage.ElementData() );
+  TEST_EXPECT_TRUE( std::equal( elementData, elementData + image->GetPixelContainer()->Size(),
+                                image->GetBufferPointer() ) );
+
+  itk::MetaImageIO::Pointer readIO = itk::MetaImageIO::New();
+  TEST_EXPECT_TRUE( readIO->CanReadFile( fileName.c_str() ) );
+  readIO->SetFileName( fileName );
+  readIO->ReadImageInformation();
+  TEST_EXPECT_EQUAL( readIO->CanStreamRead(), blockSize > 0 );
+
+  ImageType::RegionType region;
+  region.SetIndex( 0, 7 );
+  region.SetIndex( 1, 5 );
+  region.SetIndex( 2, 3 );
+  region.SetSize( 0, 31 );
+  region.SetSize( 1, 40 );
+  region.SetSize( 2, 9 );
+
+  ReaderType::Pointer streamingReader = ReaderType::New();
+  streamingReader->SetFileName( fileName );
+  streamingReader->SetImageIO( readIO );
+  streamingReader->UseStreamingOn();
+  streamingReader->GetOutput()->SetRequestedRegion( region );
+  TRY_EXPECT_NO_EXCEPTION( streamingReader->Update() );
+  TEST_EXPECT_TRUE( streamingReader->GetOutput()->GetBufferedRegion().IsInside( region ) );
+
+  itk::ImageRegionConstIterator< ImageType > eit( image, region );
+  itk::ImageRegionConstIterator< ImageType > it( streamingReader->GetOutput(), region );
+  for ( ; !eit.IsAtEnd(); ++eit, ++it )
+    {
+    TEST_EXPECT_EQUAL( it.Get(), eit.Get() );
+    }
+
+  return EXIT_SUCCESS;
+}
+}
+
+int itkMetaImageIOCompressedBlocksTest( int argc, char* argv[] )
+{
+  if ( argc < 2 )
+    {
+    std::cerr << "Missing parameters." << std::endl;
+    std::cerr << "Usage: " << argv[0] << " OutputDirectory" << std::endl;
+    return EXIT_FAILURE;
+    }
+  const std::string outputDirectory = argv[1];
+
+  itk::MetaImageIO::Pointer metaIO = itk::MetaImageIO::New();
+  TEST_SET_GET_VALUE( 0, metaIO->GetCompressedDataBlockSize() );
+  metaIO->SetCompressedDataBlockSize( 65536 );
+  TEST_SET_GET_VALUE( 65536, metaIO->GetCompressedDataBlockSize() );
+
+  ImageType::SizeType size = { { 71, 64, 23 } };
+  ImageType::Pointer image = ImageType::New();
+  image->SetRegions( size );
+  image->Allocate();
+  itk::ImageRegionIteratorWithIndex< ImageType > it( image, image->GetLargestPossibleRegion() );
+  for ( ; !it.IsAtEnd(); ++it )
+    {
+    const ImageType::IndexType index = it.GetIndex();
+    it.Set( static_cast< short >( index[0] * index[2] - 7 * index[1] ) );
+    }
+
+  // the uncompressed image, to which the test driver compares the others
+  using WriterType = itk::ImageFileWriter< ImageType >;
+  WriterType::Pointer writer = WriterType::New();
+  writer->SetInput( image );
+  writer->SetFileName( outputDirectory + "/MetaImageIOUncompressed.mha" );
+  TRY_EXPECT_NO_EXCEPTION( writer->Update() );
+
+  // the block size does not divide the size of the image, so that the
+  // last block is shorter than the others
+  TEST_EXPECT_EQUAL( WriteAndReadCompressedBlocks( image, outputDirectory + "/MetaImageIOCompressedBlocks.mha",
+                                                   10000 ), EXIT_SUCCESS );
+  TEST_EXPECT_EQUAL( WriteAndReadCompressedBlocks( image, outputDirectory + "/MetaImageIOCompressedBlocks.mhd",
+                                                   65536 ), EXIT_SUCCESS );
+
+  // a single block for the whole image
+  TEST_EXPECT_EQUAL( WriteAndReadCompressedBlocks( image, outputDirectory + "/MetaImageIOCompressedOneBlock.mha",
+                                                   1 << 20 ), EXIT_SUCCESS );
+
+  // the default compresses the image at once
+  TEST_EXPECT_EQUAL( WriteAndReadCompressedBlocks( image, outputDirectory + "/MetaImageIOCompressedNoBlocks.mha",
+                                                   0 ), EXIT_SUCCESS );
+
+  std::cout << "Test finished." << std::endl;
+  return EXIT_SUCCESS;
+}
@@ -23,7 +23,7 @@
 
 #include <fstream>
 #include <memory>
-#include "itkImageIOBase.h"
+#include "itkStreamingImageIOBase.h"
 
 namespace itk
 {
@@ -36,17 +36,23 @@ namespace itk
  * The specification for this file format is taken from the
  * web site http://analyzedirect.com/support/10.0Documents/Analyze_Resource_01.pdf
  *
+ * Any region of the image can be read: only the requested voxels are
+ * read from uncompressed and BGZF compressed files, while other
+ * compressed files are decompressed up to the last requested voxel.
+ * Regions of uncompressed files can also be written, and pasted into
+ * existing files.
+ *
  * \ingroup IOFilters
  * \ingroup ITKIONIFTI
  */
-class ITKIONIFTI_EXPORT NiftiImageIO:public ImageIOBase
+class ITKIONIFTI_EXPORT NiftiImageIO:public StreamingImageIOBase
 {
 public:
   ITK_DISALLOW_COPY_AND_ASSIGN(NiftiImageIO);
 
   /** Standard class type aliases. */
   using Self = NiftiImageIO;
-  using Superclass = ImageIOBase;
+  using Superclass = StreamingImageIOBase;
   using Pointer = SmartPointer< Self >;
 
   /** Method for creation through the object factory. */
@@ -92,6 +98,12 @@ public:
   /** Reads the data from disk into the memory buffer provided. */
   void Read(void *buffer) override;
 
+  /** The pixel data can be memory mapped if it is uncompressed, in the byte
+   * order of the system and neither rescaled nor reordered on reading.
+   * Floating point data is always read, since NaNs and infinities are
+   * replaced by zero on reading. */
+  bool GetPixelDataLocation(std::string & fileName, SizeValueType & offset) override;
+
   //-------- This part of the interfaces deals with writing data. -----
 
   /** Determine if the file can be written with this ImageIO implementation.
@@ -112,10 +124,8 @@ public:
    * that the IORegions has been set properly. */
   void Write(const void *buffer) override;
 
-  /** Calculate the region of the image that can be efficiently read
-   *  in response to a given requested region. */
-  ImageIORegion
-  GenerateStreamableReadRegionFromRequestedRegion(const ImageIORegion & requestedRegion) const override;
+  /** Regions of the image can only be written into uncompressed files. */
+  bool CanStreamWrite() override;
 
   /** Set the slope and intercept for voxel value rescaling. */
   itkSetMacro(RescaleSlope, double);
@@ -128,11 +138,26 @@ public:
   itkSetMacro(LegacyAnalyze75Mode, bool);
   itkGetConstMacro(LegacyAnalyze75Mode, bool);
 
+  /** Write compressed files (.nii.gz, .img.gz) as a series of independent
+   * gzip members in the BGZF layout instead of a single gzip stream. The
+   * members are compressed in parallel, and the files remain readable by
+   * gunzip and other NIfTI readers. Such files, whichever tool wrote them,
+   * are always decompressed in parallel on reading, and streaming a region
+   * only decompresses the members that hold it.
+   * By default this is set to false.
+   */
+  itkSetMacro(UseBlockedGzip, bool);
+  itkGetConstMacro(UseBlockedGzip, bool);
+  itkBooleanMacro(UseBlockedGzip);
+
 protected:
   NiftiImageIO();
   ~NiftiImageIO() override;
   void PrintSelf(std::ostream & os, Indent indent) const override;
 
+  /** Returns the offset of the voxel data in the image file. */
+  SizeType GetHeaderSize() const override;
+
   virtual bool GetUseLegacyModeForTwoFileWriting() const { return false; }
 
 private:
@@ -153,6 +178,25 @@ private:
 
   void  SetImageIOMetadataFromNIfTI();
 
+  /** Reads a region of the voxel data from a BGZF compressed file, in the
+   * nifti layout. Returns a buffer allocated with malloc, or nullptr if the
+   * file is not BGZF compressed. */
+  void * ReadBlockedGzipRegion(const int *origin, const int *size);
+
+  /** Reads a region of the voxel data, in the nifti layout, seeking to
+   * each contiguous run of voxels. Returns a buffer allocated with
+   * malloc. */
+  void * ReadRegion(const int *origin, const int *size);
+
+  /** Writes a region of the voxel data, in the nifti layout, into the
+   * image file, which is created along with the header if it does not
+   * exist yet. */
+  void  WriteRegion(const void *data, const int *origin, const int *size);
+
+  /** Writes the header and the voxel data, compressed in parallel when
+   * UseBlockedGzip is on. */
+  void  WriteNiftiImage(const void *data);
+
   //This proxy class provides a nifti_image pointer interface to the internal implementation
   //of itk::NiftiImageIO, while hiding the niftilib interface from the external ITK interface.
   class NiftiImageProxy;
@@ -170,6 +214,8 @@ private:
 
   bool m_LegacyAnalyze75Mode{true};
 
+  bool m_UseBlockedGzip{false};
+
 };
 } // end namespace itk
 
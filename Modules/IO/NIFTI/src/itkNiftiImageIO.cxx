@@ -19,8 +19,18 @@
 #include "itkIOCommon.h"
 #include "itkMetaDataObject.h"
 #include "itkSpatialOrientationAdapter.h"
+#include "itkMultiThreaderBase.h"
+#include "itksys/SystemTools.hxx"
+#include "itk_zlib.h"
 #include <nifti1_io.h>
 
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <fstream>
+#include <functional>
+#include <vector>
+
 namespace itk
 {
 //#define ITK_USE_VERY_VERBOSE_NIFTI_DEBUGGING
@@ -379,11 +389,12 @@ int SymMatDim(int count)
   return dim;
 }
 
-ImageIORegion
+bool
 NiftiImageIO
-::GenerateStreamableReadRegionFromRequestedRegion(const ImageIORegion & requestedRegion) const
+::CanStreamWrite()
 {
-  return requestedRegion;
+  // compressed files are written whole
+  return nifti_is_gzfile( this->GetFileName() ) == 0;
 }
 
 
@@ -435,12 +446,21 @@ NiftiImageIO::~NiftiImageIO()
   nifti_image_free(this->m_NiftiImage);
 }
 
+StreamingImageIOBase::SizeType
+NiftiImageIO
+::GetHeaderSize() const
+{
+  const nifti_image *nim = this->m_NiftiImage;
+  return ( nim != nullptr && nim->iname_offset > 0 ) ? static_cast< SizeType >( nim->iname_offset ) : 0;
+}
+
 void
 NiftiImageIO
 ::PrintSelf(std::ostream & os, Indent indent) const
 {
   Superclass::PrintSelf(os, indent);
   os << indent << "LegacyAnalyze75Mode: " << this->m_LegacyAnalyze75Mode << std::endl;
+  os << indent << "UseBlockedGzip: " << this->m_UseBlockedGzip << std::endl;
 }
 
 bool
@@ -487,6 +507,642 @@ CastCopy(float *to, const void *from, size_t pixelcount)
     }
 }
 
+namespace
+{
+// BGZF is a series of gzip members of at most 64 KiB, each with an extra
+// field "BC" holding the compressed size of the member, so that the members
+// can be located without decompressing them.
+constexpr size_t BlockedGzipMaximumBlockSize = 0xff00;
+constexpr size_t BlockedGzipHeaderSize = 18;
+constexpr size_t BlockedGzipFooterSize = 8;
+constexpr size_t BlockedGzipBatchSize = 1024;
+const unsigned char BlockedGzipEndOfFile[28] =
+{
+  0x1f, 0x8b, 0x08, 0x04, 0x00, 0x00, 0x00, 0x00, 0x00, 0xff, 0x06, 0x00, 0x42, 0x43,
+  0x02, 0x00, 0x1b, 0x00, 0x03, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00
+};
+
+struct GzipMember
+{
+  std::streamoff compressedOffset;
+  size_t         compressedSize;
+  size_t         uncompressedOffset;
+  size_t         uncompressedSize;
+};
+
+inline unsigned int
+ReadLittleEndian(const unsigned char *bytes, unsigned int numberOfBytes)
+{
+  unsigned int value = 0;
+  for ( unsigned int i = numberOfBytes; i > 0; --i )
+    {
+    value = ( value << 8 ) | bytes[i - 1];
+    }
+  return value;
+}
+
+inline void
+WriteLittleEndian(unsigned char *bytes, unsigned int value, unsigned int numberOfBytes)
+{
+  for ( unsigned int i = 0; i < numberOfBytes; ++i )
+    {
+    bytes[i] = static_cast< unsigned char >( value >> ( 8 * i ) );
+    }
+}
+
+// Compresses one block into a BGZF member.
+bool
+CompressBlockedGzipMember(const Bytef *data, size_t length, std::vector< Bytef > & member)
+{
+  member.resize( BlockedGzipHeaderSize + compressBound( static_cast< uLong >( length ) ) + BlockedGzipFooterSize );
+  z_stream stream = {};
+  if ( deflateInit2(&stream, Z_DEFAULT_COMPRESSION, Z_DEFLATED, -15, 8, Z_DEFAULT_STRATEGY) != Z_OK )
+    {
+    return false;
+    }
+  stream.next_in = const_cast< Bytef * >( data );
+  stream.avail_in = static_cast< uInt >( length );
+  stream.next_out = member.data() + BlockedGzipHeaderSize;
+  stream.avail_out = static_cast< uInt >( member.size() - BlockedGzipHeaderSize - BlockedGzipFooterSize );
+  const int result = deflate(&stream, Z_FINISH);
+  const size_t compressedLength = stream.total_out;
+  deflateEnd(&stream);
+  const size_t memberSize = BlockedGzipHeaderSize + compressedLength + BlockedGzipFooterSize;
+  if ( result != Z_STREAM_END || memberSize > 0x10000 )
+    {
+    return false;
+    }
+
+  member.resize(memberSize);
+  std::copy(BlockedGzipEndOfFile, BlockedGzipEndOfFile + BlockedGzipHeaderSize, member.begin());
+  WriteLittleEndian( &member[16], static_cast< unsigned int >( memberSize - 1 ), 2 );
+  WriteLittleEndian( &member[memberSize - 8],
+                     static_cast< unsigned int >( crc32( crc32(0L, Z_NULL, 0), data, static_cast< uInt >( length ) ) ), 4 );
+  WriteLittleEndian( &member[memberSize - 4], static_cast< unsigned int >( length ), 4 );
+  return true;
+}
+
+// Decompresses a whole gzip member, whose uncompressed size is known.
+bool
+InflateGzipMember(const Bytef *member, size_t memberSize, Bytef *output, size_t outputSize)
+{
+  z_stream stream = {};
+  if ( inflateInit2(&stream, 15 + 16) != Z_OK )
+    {
+    return false;
+    }
+  stream.next_in = const_cast< Bytef * >( member );
+  stream.avail_in = static_cast< uInt >( memberSize );
+  stream.next_out = output;
+  stream.avail_out = static_cast< uInt >( outputSize );
+  const int result = inflate(&stream, Z_FINISH);
+  const bool complete = ( result == Z_STREAM_END && stream.total_out == outputSize );
+  inflateEnd(&stream);
+  return complete;
+}
+
+// Locates the gzip members of a BGZF file. Only the first member may be a
+// plain gzip member, as written by niftilib for the header of a .nii.gz,
+// provided that it holds no more than headerSize bytes. Returns false for
+// any other file, which is then read through niftilib.
+bool
+IndexBlockedGzipFile(const char *fileName, size_t headerSize, std::vector< GzipMember > & members)
+{
+  std::ifstream file(fileName, std::ios::in | std::ios::binary);
+  if ( !file.is_open() )
+    {
+    return false;
+    }
+  file.seekg(0, std::ios::end);
+  const std::streamoff fileSize = file.tellg();
+
+  std::streamoff position = 0;
+  size_t         uncompressedOffset = 0;
+  while ( position < fileSize )
+    {
+    unsigned char header[12];
+    file.seekg(position, std::ios::beg);
+    file.read(reinterpret_cast< char * >( header ), sizeof( header ));
+    if ( !file.good() || header[0] != 0x1f || header[1] != 0x8b || header[2] != Z_DEFLATED )
+      {
+      return false;
+      }
+
+    size_t blockSize = 0;
+    if ( header[3] & 0x04 )
+      {
+      std::vector< unsigned char > extra( ReadLittleEndian(header + 10, 2) );
+      file.read(reinterpret_cast< char * >( extra.data() ), extra.size());
+      for ( size_t i = 0; file.good() && i + 4 <= extra.size(); i += 4 + ReadLittleEndian(&extra[i + 2], 2) )
+        {
+        if ( extra[i] == 'B' && extra[i + 1] == 'C' && ReadLittleEndian(&extra[i + 2], 2) == 2 && i + 6 <= extra.size() )
+          {
+          blockSize = ReadLittleEndian(&extra[i + 4], 2) + 1;
+          break;
+          }
+        }
+      }
+
+    GzipMember member = { position, blockSize, uncompressedOffset, 0 };
+    if ( blockSize > 0 )
+      {
+      unsigned char inputSize[4];
+      file.seekg(position + static_cast< std::streamoff >( blockSize ) - 4, std::ios::beg);
+      file.read(reinterpret_cast< char * >( inputSize ), sizeof( inputSize ));
+      if ( !file.good() )
+        {
+        return false;
+        }
+      member.uncompressedSize = ReadLittleEndian(inputSize, 4);
+      }
+    else if ( position == 0 )
+      {
+      // inflate the first member, and give up as soon as it turns out to
+      // hold more than the header
+      std::vector< Bytef > input(16384);
+      std::vector< Bytef > output(headerSize + 1);
+      z_stream             stream = {};
+      if ( inflateInit2(&stream, 15 + 16) != Z_OK )
+        {
+        return false;
+        }
+      stream.next_out = output.data();
+      stream.avail_out = static_cast< uInt >( output.size() );
+      file.seekg(0, std::ios::beg);
+      int result = Z_OK;
+      while ( result == Z_OK && stream.avail_out > 0 )
+        {
+        if ( stream.avail_in == 0 )
+          {
+          file.read(reinterpret_cast< char * >( input.data() ), input.size());
+          stream.next_in = input.data();
+          stream.avail_in = static_cast< uInt >( file.gcount() );
+          if ( stream.avail_in == 0 )
+            {
+            break;
+            }
+          }
+        result = inflate(&stream, Z_NO_FLUSH);
+        }
+      member.compressedSize = stream.total_in;
+      member.uncompressedSize = stream.total_out;
+      inflateEnd(&stream);
+      file.clear();
+      if ( result != Z_STREAM_END )
+        {
+        return false;
+        }
+      }
+    else
+      {
+      return false;
+      }
+
+    if ( member.uncompressedSize > 0 )
+      {
+      members.push_back(member);
+      }
+    position += static_cast< std::streamoff >( member.compressedSize );
+    uncompressedOffset += member.uncompressedSize;
+    }
+  return !members.empty();
+}
+
+// Applies what nifti_read_buffer does to the data read from the file.
+void
+FixNiftiData(nifti_image *nim, void *data, size_t numberOfBytes)
+{
+  if ( nim->swapsize > 1 && nim->byteorder != nifti_short_order() )
+    {
+    nifti_swap_Nbytes(numberOfBytes / nim->swapsize, nim->swapsize, data);
+    }
+  if ( nim->datatype == NIFTI_TYPE_FLOAT32 || nim->datatype == NIFTI_TYPE_COMPLEX64 )
+    {
+    auto * values = static_cast< float * >( data );
+    std::replace_if(values, values + numberOfBytes / sizeof( float ),
+                    [](float value) { return !std::isfinite(value); }, 0.0f);
+    }
+  else if ( nim->datatype == NIFTI_TYPE_FLOAT64 || nim->datatype == NIFTI_TYPE_COMPLEX128 )
+    {
+    auto * values = static_cast< double * >( data );
+    std::replace_if(values, values + numberOfBytes / sizeof( double ),
+                    [](double value) { return !std::isfinite(value); }, 0.0);
+    }
+}
+} // end anonymous namespace
+
+void *
+NiftiImageIO
+::ReadBlockedGzipRegion(const int *origin, const int *size)
+{
+  nifti_image *nim = this->m_NiftiImage;
+  if ( nim->iname == nullptr || !nifti_is_gzfile(nim->iname) )
+    {
+    return nullptr;
+    }
+  std::vector< GzipMember > members;
+  if ( !IndexBlockedGzipFile(nim->iname, nim->iname_offset, members) )
+    {
+    return nullptr;
+    }
+
+  // the region is read row by row, in the order of nifti_read_subregion_image
+  const size_t pixelSize = nim->nbyper;
+  size_t       stride[7];
+  int          rowOrigin[7];
+  int          rowSize[7];
+  size_t       numberOfBytes = pixelSize;
+  bool         wholeImage = true;
+  for ( unsigned int i = 0; i < 7; ++i )
+    {
+    const size_t dimension = ( static_cast< int >( i ) < nim->ndim ) ? std::max(nim->dim[i + 1], 1) : 1;
+    stride[i] = ( i == 0 ) ? pixelSize : stride[i - 1] * ( static_cast< int >( i ) <= nim->ndim ? std::max(nim->dim[i], 1) : 1 );
+    rowOrigin[i] = ( static_cast< int >( i ) < nim->ndim ) ? origin[i] : 0;
+    rowSize[i] = ( static_cast< int >( i ) < nim->ndim ) ? size[i] : 1;
+    numberOfBytes *= rowSize[i];
+    wholeImage = wholeImage && rowOrigin[i] == 0 && static_cast< size_t >( rowSize[i] ) == dimension;
+    }
+  const size_t rowSizeInBytes = rowSize[0] * pixelSize;
+  const size_t dataOffset = nim->iname_offset;
+  const GzipMember & lastMember = members.back();
+  if ( lastMember.uncompressedOffset + lastMember.uncompressedSize < dataOffset + nifti_get_volsize(nim) )
+    {
+    itkExceptionMacro( << "The data is truncated in file: " << nim->iname );
+    }
+
+  auto * output = static_cast< Bytef * >( malloc(numberOfBytes) );
+  if ( output == nullptr )
+    {
+    itkExceptionMacro( << "Failed to allocate " << numberOfBytes << " bytes to read " << nim->iname );
+    }
+  auto findMember = [&members](size_t offset)
+    {
+      return std::upper_bound(members.begin(), members.end(), offset,
+                              [](size_t value, const GzipMember & member)
+                              { return value < member.uncompressedOffset; }) - members.begin() - 1;
+    };
+  auto forEachRow = [&](const std::function< void(size_t, size_t) > & function)
+    {
+      int    index[7];
+      size_t outputOffset = 0;
+      std::copy(rowOrigin, rowOrigin + 7, index);
+      while ( true )
+        {
+        size_t offset = dataOffset;
+        for ( unsigned int i = 0; i < 7; ++i )
+          {
+          offset += index[i] * stride[i];
+          }
+        function(offset, outputOffset);
+        outputOffset += rowSizeInBytes;
+
+        unsigned int i = 1;
+        for ( ; i < 7; ++i )
+          {
+          if ( ++index[i] < rowOrigin[i] + rowSize[i] )
+            {
+            break;
+            }
+          index[i] = rowOrigin[i];
+          }
+        if ( i == 7 )
+          {
+          return;
+          }
+        }
+    };
+
+  std::vector< size_t > membersToRead;
+  if ( wholeImage )
+    {
+    for ( auto member = findMember(dataOffset); member <= findMember(dataOffset + numberOfBytes - 1); ++member )
+      {
+      membersToRead.push_back(member);
+      }
+    }
+  else
+    {
+    std::vector< bool > memberIsNeeded( members.size(), false );
+    forEachRow([&](size_t offset, size_t)
+      {
+        for ( auto member = findMember(offset); member <= findMember(offset + rowSizeInBytes - 1); ++member )
+          {
+          memberIsNeeded[member] = true;
+          }
+      });
+    for ( size_t member = 0; member < members.size(); ++member )
+      {
+      if ( memberIsNeeded[member] )
+        {
+        membersToRead.push_back(member);
+        }
+      }
+    }
+
+  // Read the members in batches, and decompress each batch in parallel. The
+  // whole image is copied to the output while decompressing, a region once
+  // all the members it overlaps are decompressed.
+  std::ifstream file(nim->iname, std::ios::in | std::ios::binary);
+  std::vector< std::vector< Bytef > > uncompressedMembers( wholeImage ? 0 : members.size() );
+  std::atomic< bool >        failed( false );
+  MultiThreaderBase::Pointer multiThreader = MultiThreaderBase::New();
+  for ( size_t batchStart = 0; batchStart < membersToRead.size() && !failed; batchStart += BlockedGzipBatchSize )
+    {
+    const size_t batchSize = std::min(BlockedGzipBatchSize, membersToRead.size() - batchStart);
+    std::vector< std::vector< Bytef > > compressedMembers(batchSize);
+    for ( size_t i = 0; i < batchSize; ++i )
+      {
+      const GzipMember & member = members[membersToRead[batchStart + i]];
+      compressedMembers[i].resize(member.compressedSize);
+      file.seekg(member.compressedOffset, std::ios::beg);
+      file.read(reinterpret_cast< char * >( compressedMembers[i].data() ), member.compressedSize);
+      }
+    if ( !file.good() )
+      {
+      failed = true;
+      break;
+      }
+    multiThreader->ParallelizeArray(
+      0,
+      batchSize,
+      [&](SizeValueType i)
+      {
+        const size_t       memberIndex = membersToRead[batchStart + i];
+        const GzipMember & member = members[memberIndex];
+        std::vector< Bytef > uncompressed(member.uncompressedSize);
+        if ( !InflateGzipMember(compressedMembers[i].data(), compressedMembers[i].size(),
+                                uncompressed.data(), uncompressed.size()) )
+          {
+          failed = true;
+          return;
+          }
+        if ( wholeImage )
+          {
+          const size_t start = std::max(member.uncompressedOffset, dataOffset);
+          const size_t end = std::min(member.uncompressedOffset + member.uncompressedSize, dataOffset + numberOfBytes);
+          if ( start < end )
+            {
+            std::copy(uncompressed.begin() + ( start - member.uncompressedOffset ),
+                      uncompressed.begin() + ( end - member.uncompressedOffset ),
+                      output + ( start - dataOffset ));
+            }
+          }
+        else
+          {
+          uncompressedMembers[memberIndex].swap(uncompressed);
+          }
+      },
+      nullptr);
+    }
+  if ( failed )
+    {
+    free(output);
+    itkExceptionMacro( << "Decompression failed for file: " << nim->iname );
+    }
+
+  if ( !wholeImage )
+    {
+    forEachRow([&](size_t offset, size_t outputOffset)
+      {
+        size_t copied = 0;
+        while ( copied < rowSizeInBytes )
+          {
+          const GzipMember & member = members[findMember(offset + copied)];
+          const size_t positionInMember = offset + copied - member.uncompressedOffset;
+          const size_t length = std::min(rowSizeInBytes - copied, member.uncompressedSize - positionInMember);
+          const std::vector< Bytef > & uncompressed = uncompressedMembers[&member - members.data()];
+          std::copy(uncompressed.begin() + positionInMember, uncompressed.begin() + positionInMember + length,
+                    output + outputOffset + copied);
+          copied += length;
+          }
+      });
+    }
+
+  FixNiftiData(nim, output, numberOfBytes);
+  return output;
+}
+
+void *
+NiftiImageIO
+::ReadRegion(const int *origin, const int *size)
+{
+  nifti_image *nim = this->m_NiftiImage;
+  const size_t pixelSize = nim->nbyper;
+  size_t       dimension[7];
+  size_t       stride[7];
+  size_t       numberOfBytes = pixelSize;
+  for ( unsigned int i = 0; i < 7; ++i )
+    {
+    dimension[i] = ( static_cast< int >( i ) < nim->ndim ) ? std::max(nim->dim[i + 1], 1) : 1;
+    stride[i] = ( i == 0 ) ? pixelSize : stride[i - 1] * dimension[i - 1];
+    if ( origin[i] < 0 || size[i] < 1 || static_cast< size_t >( origin[i] + size[i] ) > dimension[i] )
+      {
+      itkExceptionMacro( << "The region to read is outside of the image in file: " << this->GetFileName() );
+      }
+    numberOfBytes *= size[i];
+    }
+
+  // the voxels are contiguous in the file along the first dimensions that
+  // are read whole, and along the next one
+  unsigned int chunkDimensions = 0;
+  size_t       chunkSize = pixelSize;
+  do
+    {
+    chunkSize *= size[chunkDimensions];
+    ++chunkDimensions;
+    }
+  while ( chunkDimensions < 7
+          && origin[chunkDimensions - 1] == 0
+          && static_cast< size_t >( size[chunkDimensions - 1] ) == dimension[chunkDimensions - 1] );
+
+  char *imageName = nifti_findimgname(nim->iname, nim->nifti_type);
+  if ( imageName == nullptr )
+    {
+    itkExceptionMacro( << "No image file found for: " << this->GetFileName() );
+    }
+  const bool compressed = nifti_is_gzfile(imageName) != 0;
+  size_t     dataOffset = nim->iname_offset;
+  if ( nim->iname_offset < 0 )
+    {
+    // a negative offset means that the data is at the end of the file
+    const auto fileSize = static_cast< size_t >( std::max(nifti_get_filesize(imageName), 0) );
+    const size_t volumeSize = nifti_get_volsize(nim);
+    dataOffset = ( compressed || fileSize < volumeSize ) ? 0 : fileSize - volumeSize;
+    }
+  znzFile file = znzopen(imageName, "rb", compressed);
+  free(imageName);
+  if ( znz_isnull(file) )
+    {
+    itkExceptionMacro( << "Cannot open the image file of: " << this->GetFileName() );
+    }
+
+  auto * output = static_cast< char * >( malloc(numberOfBytes) );
+  if ( output == nullptr )
+    {
+    znzclose(file);
+    itkExceptionMacro( << "Failed to allocate " << numberOfBytes << " bytes to read " << this->GetFileName() );
+    }
+
+  // the chunks are read in increasing order in the file, so that
+  // compressed files are only decompressed once
+  int    index[7];
+  char * chunk = output;
+  std::copy(origin, origin + 7, index);
+  while ( true )
+    {
+    size_t offset = dataOffset;
+    for ( unsigned int i = 0; i < 7; ++i )
+      {
+      offset += index[i] * stride[i];
+      }
+    if ( znzseek(file, static_cast< long >( offset ), SEEK_SET) < 0
+         || nifti_read_buffer(file, chunk, chunkSize, nim) != chunkSize )
+      {
+      znzclose(file);
+      free(output);
+      itkExceptionMacro( << "Failed to read " << chunkSize << " bytes at offset " << offset
+                         << " in the image file of: " << this->GetFileName() );
+      }
+    chunk += chunkSize;
+
+    unsigned int i = chunkDimensions;
+    for ( ; i < 7; ++i )
+      {
+      if ( ++index[i] < origin[i] + size[i] )
+        {
+        break;
+        }
+      index[i] = origin[i];
+      }
+    if ( i == 7 )
+      {
+      break;
+      }
+    }
+  znzclose(file);
+  return output;
+}
+
+void
+NiftiImageIO
+::WriteRegion(const void *data, const int *origin, const int *size)
+{
+  if ( !this->CanStreamWrite() )
+    {
+    itkExceptionMacro( << "Cannot write a region of the compressed file: " << this->GetFileName() );
+    }
+
+  nifti_image *nim = this->m_NiftiImage;
+  const bool   newFile = !itksys::SystemTools::FileExists(nim->fname)
+                         || !itksys::SystemTools::FileExists(nim->iname);
+  if ( newFile )
+    {
+    // niftilib writes the header, followed by the padding up to the data in
+    // a single file
+    znzFile headerFile = nifti_image_write_hdr_img(nim, 2, "wb");
+    if ( znz_isnull(headerFile) )
+      {
+      itkExceptionMacro( << "Could not write the header of file: " << this->GetFileName() );
+      }
+    znzclose(headerFile);
+    }
+
+  // the header of the file tells where the voxels are, and in which byte order
+  nifti_image *header = nifti_image_read(nim->fname, false);
+  if ( header == nullptr )
+    {
+    itkExceptionMacro( << "nifti_image_read (just header) failed for file: " << nim->fname );
+    }
+  const std::string imageName = header->iname;
+  const bool        twoFiles = header->nifti_type != NIFTI_FTYPE_NIFTI1_1;
+  const size_t      pixelSize = header->nbyper;
+  const int         swapSize = ( header->byteorder != nifti_short_order() ) ? header->swapsize : 0;
+  const size_t      dataOffset = std::max(header->iname_offset, 0);
+  const size_t      volumeSize = nifti_get_volsize(header);
+  size_t            dimension[7];
+  size_t            stride[7];
+  for ( unsigned int i = 0; i < 7; ++i )
+    {
+    dimension[i] = ( static_cast< int >( i ) < header->ndim ) ? std::max(header->dim[i + 1], 1) : 1;
+    stride[i] = ( i == 0 ) ? pixelSize : stride[i - 1] * dimension[i - 1];
+    }
+  nifti_image_free(header);
+
+  for ( unsigned int i = 0; i < 7; ++i )
+    {
+    if ( origin[i] < 0 || size[i] < 1 || static_cast< size_t >( origin[i] + size[i] ) > dimension[i] )
+      {
+      itkExceptionMacro( << "The region to write is outside of the image in file: " << this->GetFileName() );
+      }
+    }
+
+  unsigned int chunkDimensions = 0;
+  size_t       chunkSize = pixelSize;
+  do
+    {
+    chunkSize *= size[chunkDimensions];
+    ++chunkDimensions;
+    }
+  while ( chunkDimensions < 7
+          && origin[chunkDimensions - 1] == 0
+          && static_cast< size_t >( size[chunkDimensions - 1] ) == dimension[chunkDimensions - 1] );
+
+  std::ofstream file;
+  this->OpenFileForWriting(file, imageName, newFile && twoFiles);
+  if ( newFile )
+    {
+    // write one byte at the end of the data to allocate it, which only
+    // allocates the last block on file systems supporting sparse files
+    file.seekp(static_cast< std::streamoff >( dataOffset + volumeSize - 1 ), std::ios::beg);
+    file.write("\0", 1);
+    }
+
+  // the chunks are written in increasing order in the file
+  std::vector< char > swapped( swapSize > 1 ? chunkSize : 0 );
+  int                 index[7];
+  const auto *        chunk = static_cast< const char * >( data );
+  std::copy(origin, origin + 7, index);
+  while ( file.good() )
+    {
+    size_t offset = dataOffset;
+    for ( unsigned int i = 0; i < 7; ++i )
+      {
+      offset += index[i] * stride[i];
+      }
+    file.seekp(static_cast< std::streamoff >( offset ), std::ios::beg);
+    if ( swapSize > 1 )
+      {
+      std::copy(chunk, chunk + chunkSize, swapped.begin());
+      nifti_swap_Nbytes(chunkSize / swapSize, swapSize, swapped.data());
+      file.write(swapped.data(), chunkSize);
+      }
+    else
+      {
+      file.write(chunk, chunkSize);
+      }
+    chunk += chunkSize;
+
+    unsigned int i = chunkDimensions;
+    for ( ; i < 7; ++i )
+      {
+      if ( ++index[i] < origin[i] + size[i] )
+        {
+        break;
+        }
+      index[i] = origin[i];
+      }
+    if ( i == 7 )
+      {
+      break;
+      }
+    }
+  if ( !file.good() )
+    {
+    itkExceptionMacro( << "Could not write file: " << imageName << std::endl
+                       << "Reason: " << itksys::SystemTools::GetLastSystemError() );
+    }
+}
+
 void NiftiImageIO::Read(void *buffer)
 {
   void *data = nullptr;
@@ -523,6 +1179,9 @@ void NiftiImageIO::Read(void *buffer)
     _size[5] = _size[4];
     // sizes = x y z t vecsize
     _size[4] = numComponents;
+    _origin[6] = _origin[5];
+    _origin[5] = _origin[4];
+    _origin[4] = 0;
     }
   // Free memory if any was occupied already (incase of re-using the IO filter).
   nifti_image_free(this->m_NiftiImage);
@@ -550,24 +1209,19 @@ void NiftiImageIO::Read(void *buffer)
   // all data as a block
   if ( i == this->GetNumberOfDimensions() )
     {
-    if ( nifti_image_load(this->m_NiftiImage) == -1 )
+    this->m_NiftiImage->data = this->ReadBlockedGzipRegion(_origin, _size);
+    if ( this->m_NiftiImage->data == nullptr
+         && nifti_image_load(this->m_NiftiImage) == -1 )
       {
       itkExceptionMacro( << "nifti_image_load failed for file: "
                          << this->GetFileName() );
       }
     data = this->m_NiftiImage->data;
     }
-  else
+  else if ( ( data = this->ReadBlockedGzipRegion(_origin, _size) ) == nullptr )
     {
     // read in a subregion
-    if ( nifti_read_subregion_image(this->m_NiftiImage,
-                                    _origin,
-                                    _size,
-                                    &data) == -1 )
-      {
-      itkExceptionMacro( << "nifti_read_subregion_image failed for file: "
-                         << this->GetFileName() );
-      }
+    data = this->ReadRegion(_origin, _size);
     }
   unsigned int pixelSize = this->m_NiftiImage->nbyper;
   //
@@ -657,10 +1311,11 @@ void NiftiImageIO::Read(void *buffer)
     // vec x y z t l m o
     const auto * niftibuf = (const char *)data;
     auto * itkbuf = (char *)buffer;
-    const size_t rowdist = this->m_NiftiImage->dim[1];
-    const size_t slicedist = rowdist * this->m_NiftiImage->dim[2];
-    const size_t volumedist = slicedist * this->m_NiftiImage->dim[3];
-    const size_t seriesdist = volumedist * this->m_NiftiImage->dim[4];
+    // the sizes of the region read, which may be a subregion
+    const size_t rowdist = _size[0];
+    const size_t slicedist = rowdist * _size[1];
+    const size_t volumedist = slicedist * _size[2];
+    const size_t seriesdist = volumedist * _size[3];
     //
     // as per ITK bug 0007485
     // NIfTI is lower triangular, ITK is upper triangular.
@@ -679,13 +1334,13 @@ void NiftiImageIO::Read(void *buffer)
         vecOrder[i] = i;
         }
       }
-    for ( int t = 0; t < this->m_NiftiImage->dim[4]; t++ )
+    for ( int t = 0; t < _size[3]; t++ )
       {
-      for ( int z = 0; z < this->m_NiftiImage->dim[3]; z++ )
+      for ( int z = 0; z < _size[2]; z++ )
         {
-        for ( int y = 0; y < this->m_NiftiImage->dim[2]; y++ )
+        for ( int y = 0; y < _size[1]; y++ )
           {
-          for ( int x = 0; x < this->m_NiftiImage->dim[1]; x++ )
+          for ( int x = 0; x < _size[0]; x++ )
             {
             for ( unsigned int c = 0; c < numComponents; c++ )
               {
@@ -791,6 +1446,40 @@ void NiftiImageIO::Read(void *buffer)
     }
 }
 
+bool
+NiftiImageIO
+::GetPixelDataLocation(std::string & fileName, SizeValueType & offset)
+{
+  const unsigned int numComponents = this->GetNumberOfComponents();
+  if ( this->MustRescale()
+       || this->m_ComponentType != this->m_OnDiskComponentType
+       || this->m_ComponentType == FLOAT
+       || this->m_ComponentType == DOUBLE
+       || !( numComponents == 1
+             || this->GetPixelType() == RGB
+             || this->GetPixelType() == RGBA ) )
+    {
+    return false;
+    }
+
+  nifti_image *nim = nifti_image_read(this->GetFileName(), false);
+  if ( nim == nullptr )
+    {
+    return false;
+    }
+  const bool mappable = nim->iname != nullptr
+    && nim->nifti_type != NIFTI_FTYPE_ASCII
+    && !nifti_is_gzfile(nim->iname)
+    && ( nim->swapsize <= 1 || nim->byteorder == nifti_short_order() );
+  if ( mappable )
+    {
+    fileName = nim->iname;
+    offset = nim->iname_offset;
+    }
+  nifti_image_free(nim);
+  return mappable;
+}
+
 NiftiImageIO::FileType
 NiftiImageIO::DetermineFileType(const char *FileNameToRead)
 {
@@ -1957,24 +2646,108 @@ NiftiImageIO::SetNIfTIOrientationFromImageIO(unsigned short int origdims, unsign
   //  this->m_NiftiImage->sform_code = 0;
 }
 
+void
+NiftiImageIO
+::WriteNiftiImage(const void *data)
+{
+  nifti_image *nim = this->m_NiftiImage;
+
+  // Need a const cast here so that we don't have to copy the memory
+  // for writing.
+  nim->data = const_cast< void * >( data );
+  if ( !this->m_UseBlockedGzip || !nifti_is_gzfile(nim->iname) )
+    {
+    nifti_image_write(nim);
+    nim->data = nullptr; // if left pointing to data buffer
+    // nifti_image_free will try and free this memory
+    return;
+    }
+  nim->data = nullptr;
+
+  // niftilib writes the header, followed by the padding up to the data in a
+  // single file, and the data is appended as BGZF members
+  znzFile headerFile = nifti_image_write_hdr_img(nim, 2, "wb");
+  if ( znz_isnull(headerFile) )
+    {
+    itkExceptionMacro( << "Could not write the header of file: " << this->GetFileName() );
+    }
+  znzclose(headerFile);
+
+  std::ofstream file(nim->iname,
+                     nim->nifti_type == NIFTI_FTYPE_NIFTI1_1
+                     ? std::ios::out | std::ios::binary | std::ios::app
+                     : std::ios::out | std::ios::binary | std::ios::trunc);
+  const auto * bytes = static_cast< const Bytef * >( data );
+  const size_t numberOfBytes = nifti_get_volsize(nim);
+  const size_t numberOfBlocks = ( numberOfBytes + BlockedGzipMaximumBlockSize - 1 ) / BlockedGzipMaximumBlockSize;
+  std::atomic< bool >        failed( false );
+  MultiThreaderBase::Pointer multiThreader = MultiThreaderBase::New();
+  for ( size_t batchStart = 0; batchStart < numberOfBlocks && file.good(); batchStart += BlockedGzipBatchSize )
+    {
+    const size_t batchSize = std::min(BlockedGzipBatchSize, numberOfBlocks - batchStart);
+    std::vector< std::vector< Bytef > > members(batchSize);
+    multiThreader->ParallelizeArray(
+      0,
+      batchSize,
+      [&](SizeValueType i)
+      {
+        const size_t start = ( batchStart + i ) * BlockedGzipMaximumBlockSize;
+        if ( !CompressBlockedGzipMember(bytes + start,
+                                        std::min(BlockedGzipMaximumBlockSize, numberOfBytes - start),
+                                        members[i]) )
+          {
+          failed = true;
+          }
+      },
+      nullptr);
+    if ( failed )
+      {
+      itkExceptionMacro( << "Compression failed for file: " << this->GetFileName() );
+      }
+    for ( const auto & member : members )
+      {
+      file.write(reinterpret_cast< const char * >( member.data() ), member.size());
+      }
+    }
+  file.write(reinterpret_cast< const char * >( BlockedGzipEndOfFile ), sizeof( BlockedGzipEndOfFile ));
+  if ( !file.good() )
+    {
+    itkExceptionMacro( << "Could not write file: " << nim->iname << std::endl
+                       << "Reason: " << itksys::SystemTools::GetLastSystemError() );
+    }
+}
+
 void
 NiftiImageIO
 ::Write(const void *buffer)
 {
   // Write the image Information before writing data
   this->WriteImageInformation();
+
+  // the region to write, in the nifti dimensions
+  const ImageIORegion & region = this->GetIORegion();
+  int                   _origin[7];
+  int                   _size[7];
+  for ( unsigned int i = 0; i < 7; i++ )
+    {
+    _origin[i] = ( i < region.GetImageDimension() ) ? static_cast< int >( region.GetIndex(i) ) : 0;
+    _size[i] = ( i < region.GetImageDimension() ) ? static_cast< int >( region.GetSize(i) ) : 1;
+    }
+
   const unsigned int numComponents = this->GetNumberOfComponents();
   if ( numComponents == 1
        || ( numComponents == 2 && this->GetPixelType() == COMPLEX )
        || ( numComponents == 3 && this->GetPixelType() == RGB )
        || ( numComponents == 4 && this->GetPixelType() == RGBA ) )
     {
-    // Need a const cast here so that we don't have to copy the memory
-    // for writing.
-    this->m_NiftiImage->data = const_cast< void * >( buffer );
-    nifti_image_write(this->m_NiftiImage);
-    this->m_NiftiImage->data = nullptr; // if left pointing to data buffer
-    // nifti_image_free will try and free this memory
+    if ( this->RequestedToStream() )
+      {
+      this->WriteRegion(buffer, _origin, _size);
+      }
+    else
+      {
+      this->WriteNiftiImage(buffer);
+      }
     }
   else  ///Image intent is vector image
     {
@@ -1985,24 +2758,33 @@ NiftiImageIO
         this->m_NiftiImage->dim[i] = 1;
         }
       }
+    // nifti always sticks vec size in dim 4, so have to shove
+    // other dims out of the way
+    _size[6] = _size[5];
+    _size[5] = _size[4];
+    _size[4] = numComponents;
+    _origin[6] = _origin[5];
+    _origin[5] = _origin[4];
+    _origin[4] = 0;
+
     const size_t numVoxels =
-      size_t(this->m_NiftiImage->dim[1])
-      * size_t(this->m_NiftiImage->dim[2])
-      * size_t(this->m_NiftiImage->dim[3])
-      * size_t(this->m_NiftiImage->dim[4]);
+      size_t(_size[0])
+      * size_t(_size[1])
+      * size_t(_size[2])
+      * size_t(_size[3]);
     const size_t buffer_size =
       numVoxels
       * numComponents //Number of componenets
       * this->m_NiftiImage->nbyper;
 
-    auto * nifti_buf = new char[buffer_size];
+    std::vector< char > nifti_buf( buffer_size );
     const auto *const itkbuf = (const char *)buffer;
     // Data must be rearranged to meet nifti organzation.
     // nifti_layout[vec][t][z][y][x] = itk_layout[t][z][y][z][vec]
-    const size_t rowdist = m_NiftiImage->dim[1];
-    const size_t slicedist = rowdist * m_NiftiImage->dim[2];
-    const size_t volumedist = slicedist * m_NiftiImage->dim[3];
-    const size_t seriesdist = volumedist * m_NiftiImage->dim[4];
+    const size_t rowdist = _size[0];
+    const size_t slicedist = rowdist * _size[1];
+    const size_t volumedist = slicedist * _size[2];
+    const size_t seriesdist = volumedist * _size[3];
     //
     // as per ITK bug 0007485
     // NIfTI is lower triangular, ITK is upper triangular.
@@ -2027,13 +2809,13 @@ NiftiImageIO
         vecOrder[i] = i;
         }
       }
-    for ( int t = 0; t < this->m_NiftiImage->dim[4]; t++ )
+    for ( int t = 0; t < _size[3]; t++ )
       {
-      for ( int z = 0; z < this->m_NiftiImage->dim[3]; z++ )
+      for ( int z = 0; z < _size[2]; z++ )
         {
-        for ( int y = 0; y < this->m_NiftiImage->dim[2]; y++ )
+        for ( int y = 0; y < _size[1]; y++ )
           {
-          for ( int x = 0; x < this->m_NiftiImage->dim[1]; x++ )
+          for ( int x = 0; x < _size[0]; x++ )
             {
             for ( unsigned int c = 0; c < numComponents; c++ )
               {
@@ -2054,12 +2836,14 @@ NiftiImageIO
       }
     delete[] vecOrder;
     dumpdata(buffer);
-    //Need a const cast here so that we don't have to copy the memory for
-    //writing.
-    this->m_NiftiImage->data = static_cast<void *>(nifti_buf);
-    nifti_image_write(this->m_NiftiImage);
-    this->m_NiftiImage->data = nullptr; // if left pointing to data buffer
-    delete[] nifti_buf;
+    if ( this->RequestedToStream() )
+      {
+      this->WriteRegion(nifti_buf.data(), _origin, _size);
+      }
+    else
+      {
+      this->WriteNiftiImage(nifti_buf.data());
+      }
     }
 }
 } // end namespace itk
@@ -0,0 +1,158 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+#include "itkNiftiImageIOTest.h"
+#include "itkImageRegionConstIterator.h"
+#include "itkImageRegionIteratorWithIndex.h"
+#include "itkTestingMacros.h"
+#include "itk_zlib.h"
+
+/* Writes images as BGZF, checks that gzread sees the whole files, and streams
+ * a region of them. The test driver compares the files with the images
+ * written uncompressed.
+ */
+
+namespace
+{
+template< typename TImage >
+int
+WriteAndReadBlockedGzip( const TImage * image, const std::string & fileName, const std::string & dataFileName,
+                         size_t expectedDataSize )
+{
+  using ReaderType = itk::ImageFileReader< TImage >;
+  using WriterType = itk::ImageFileWriter< TImage >;
+
+  itk::NiftiImageIO::Pointer writeIO = itk::NiftiImageIO::New();
+  writeIO->UseBlockedGzipOn();
+  typename WriterType::Pointer writer = WriterType::New();
+  writer->SetInput( image );
+  writer->SetFileName( fileName );
+  writer->SetImageIO( writeIO );
+  TRY_EXPECT_NO_EXCEPTION( writer->Update() );
+
+  // a multi-member gzip file decompresses as a whole
+  gzFile gzfile = gzopen( dataFileName.c_str(), "rb" );
+  TEST_EXPECT_TRUE( gzfile != nullptr );
+  std::vector< char > contents( 1 << 16 );
+  size_t uncompressedSize = 0;
+  int bytesRead;
+  while ( ( bytesRead = gzread( gzfile, contents.data(), static_cast< unsigned >( contents.size() ) ) ) > 0 )
+    {
+    uncompressedSize += bytesRead;
+    }
+  gzclose( gzfile );
+  TEST_EXPECT_EQUAL( bytesRead, 0 );
+  TEST_EXPECT_TRUE( uncompressedSize >= expectedDataSize );
+
+  typename TImage::RegionType region;
+  region.SetIndex( 0, 7 );
+  region.SetIndex( 1, 5 );
+  region.SetIndex( 2, 3 );
+  region.SetSize( 0, 31 );
+  region.SetSize( 1, 40 );
+  region.SetSize( 2, 9 );
+
+  typename ReaderType::Pointer streamingReader = ReaderType::New();
+  streamingReader->SetFileName( fileName );
+  streamingReader->UseStreamingOn();
+  streamingReader->GetOutput()->SetRequestedRegion( region );
+  TRY_EXPECT_NO_EXCEPTION( streamingReader->Update() );
+  itk::ImageRegionConstIterator< TImage > eit( image, region );
+  itk::ImageRegionConstIterator< TImage > it( streamingReader->GetOutput(), region );
+  for ( ; !eit.IsAtEnd(); ++eit, ++it )
+    {
+    TEST_EXPECT_EQUAL( it.Get(), eit.Get() );
+    }
+
+  return EXIT_SUCCESS;
+}
+}
+
+int itkNiftiImageIOBlockedGzipTest( int argc, char* argv[] )
+{
+  if ( argc < 2 )
+    {
+    std::cerr << "Missing parameters." << std::endl;
+    std::cerr << "Usage: " << argv[0] << " OutputDirectory" << std::endl;
+    return EXIT_FAILURE;
+    }
+  const std::string outputDirectory = argv[1];
+
+  itk::NiftiImageIO::Pointer niftiIO = itk::NiftiImageIO::New();
+  TEST_SET_GET_BOOLEAN( niftiIO, UseBlockedGzip, false );
+  TEST_SET_GET_BOOLEAN( niftiIO, UseBlockedGzip, true );
+
+  using ImageType = itk::Image< short, 3 >;
+  ImageType::SizeType size = { { 71, 64, 23 } };
+  ImageType::Pointer image = ImageType::New();
+  image->SetRegions( size );
+  image->Allocate();
+  itk::ImageRegionIteratorWithIndex< ImageType > it( image, image->GetLargestPossibleRegion() );
+  for ( ; !it.IsAtEnd(); ++it )
+    {
+    const ImageType::IndexType index = it.GetIndex();
+    it.Set( static_cast< short >( index[0] * index[2] - 7 * index[1] ) );
+    }
+
+  using VectorImageType = itk::Image< itk::Vector< float, 3 >, 3 >;
+  VectorImageType::Pointer vectorImage = VectorImageType::New();
+  vectorImage->SetRegions( size );
+  vectorImage->Allocate();
+  itk::ImageRegionIteratorWithIndex< VectorImageType > vit( vectorImage, vectorImage->GetLargestPossibleRegion() );
+  for ( ; !vit.IsAtEnd(); ++vit )
+    {
+    const VectorImageType::IndexType index = vit.GetIndex();
+    VectorImageType::PixelType value;
+    value[0] = index[0] * 0.5f;
+    value[1] = index[1] - 3.0f * index[2];
+    value[2] = index[0] * index[1] * 0.25f;
+    vit.Set( value );
+    }
+
+  // the uncompressed images, to which the test driver compares the others
+  using WriterType = itk::ImageFileWriter< ImageType >;
+  WriterType::Pointer writer = WriterType::New();
+  writer->SetInput( image );
+  writer->SetFileName( outputDirectory + "/NiftiUncompressed.nii" );
+  TRY_EXPECT_NO_EXCEPTION( writer->Update() );
+  using VectorWriterType = itk::ImageFileWriter< VectorImageType >;
+  VectorWriterType::Pointer vectorWriter = VectorWriterType::New();
+  vectorWriter->SetInput( vectorImage );
+  vectorWriter->SetFileName( outputDirectory + "/NiftiUncompressedVector.nii" );
+  TRY_EXPECT_NO_EXCEPTION( vectorWriter->Update() );
+
+  const size_t numberOfPixels = image->GetLargestPossibleRegion().GetNumberOfPixels();
+
+  // single file, with the data appended to the header written by niftilib
+  const std::string singleFileName = outputDirectory + "/NiftiBlockedGzip.nii.gz";
+  TEST_EXPECT_EQUAL( WriteAndReadBlockedGzip< ImageType >( image, singleFileName, singleFileName,
+                                                           numberOfPixels * sizeof( short ) ), EXIT_SUCCESS );
+
+  // header and data files
+  const std::string dataFileName = outputDirectory + "/NiftiBlockedGzip.img.gz";
+  TEST_EXPECT_EQUAL( WriteAndReadBlockedGzip< ImageType >( image, dataFileName, dataFileName,
+                                                           numberOfPixels * sizeof( short ) ), EXIT_SUCCESS );
+
+  // vector pixels are stored one component after the other
+  const std::string vectorFileName = outputDirectory + "/NiftiBlockedGzipVector.nii.gz";
+  TEST_EXPECT_EQUAL( WriteAndReadBlockedGzip< VectorImageType >( vectorImage, vectorFileName, vectorFileName,
+                                                                 numberOfPixels * 3 * sizeof( float ) ), EXIT_SUCCESS );
+
+  std::cout << "Test finished." << std::endl;
+  return EXIT_SUCCESS;
+}
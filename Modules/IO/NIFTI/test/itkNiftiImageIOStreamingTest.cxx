@@ -0,0 +1,176 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#include "itkNiftiImageIOTest.h"
+#include "itkExtractImageFilter.h"
+#include "itkImageRegionConstIterator.h"
+#include "itkImageRegionIteratorWithIndex.h"
+#include "itkTestingMacros.h"
+
+/* Writes images in the NIfTI and Analyze formats, and reads regions of them
+ * back, checking that only the requested region is buffered. The block
+ * streamed from each file is compared by the test driver with the block
+ * extracted from the image in memory.
+ */
+
+namespace
+{
+// a region which is not contiguous in the file
+template< typename TImage >
+typename TImage::RegionType
+BlockRegion( const TImage * image )
+{
+  const typename TImage::RegionType largestRegion = image->GetLargestPossibleRegion();
+  typename TImage::RegionType block = largestRegion;
+  for ( unsigned int i = 0; i < TImage::ImageDimension; ++i )
+    {
+    block.SetIndex( i, 1 + i );
+    block.SetSize( i, largestRegion.GetSize( i ) - 2 - i );
+    }
+  return block;
+}
+
+template< typename TImage >
+int
+WriteBlock( const TImage * image, const std::string & blockFileName )
+{
+  using ExtractType = itk::ExtractImageFilter< TImage, TImage >;
+  using WriterType = itk::ImageFileWriter< TImage >;
+
+  typename ExtractType::Pointer extract = ExtractType::New();
+  extract->SetInput( image );
+  extract->SetExtractionRegion( BlockRegion( image ) );
+  typename WriterType::Pointer writer = WriterType::New();
+  writer->SetInput( extract->GetOutput() );
+  writer->SetFileName( blockFileName );
+  TRY_EXPECT_NO_EXCEPTION( writer->Update() );
+  return EXIT_SUCCESS;
+}
+
+template< typename TImage >
+int
+WriteAndStreamRegions( const TImage * image, const std::string & fileName, const std::string & blockFileName )
+{
+  using ReaderType = itk::ImageFileReader< TImage >;
+  using WriterType = itk::ImageFileWriter< TImage >;
+  using ExtractType = itk::ExtractImageFilter< TImage, TImage >;
+
+  typename WriterType::Pointer writer = WriterType::New();
+  writer->SetInput( image );
+  writer->SetFileName( fileName );
+  TRY_EXPECT_NO_EXCEPTION( writer->Update() );
+
+  const typename TImage::RegionType largestRegion = image->GetLargestPossibleRegion();
+  const typename TImage::RegionType block = BlockRegion( image );
+
+  // a region which is contiguous in the file
+  typename TImage::RegionType slab = largestRegion;
+  slab.SetIndex( TImage::ImageDimension - 1, 2 );
+  slab.SetSize( TImage::ImageDimension - 1, 3 );
+
+  typename ReaderType::Pointer slabReader = ReaderType::New();
+  slabReader->SetFileName( fileName );
+  slabReader->GetOutput()->SetRequestedRegion( slab );
+  TRY_EXPECT_NO_EXCEPTION( slabReader->Update() );
+  TEST_EXPECT_TRUE( slabReader->GetImageIO()->CanStreamRead() );
+  TEST_EXPECT_EQUAL( slabReader->GetOutput()->GetBufferedRegion(), slab );
+  itk::ImageRegionConstIterator< TImage > eit( image, slab );
+  itk::ImageRegionConstIterator< TImage > it( slabReader->GetOutput(), slab );
+  for ( ; !eit.IsAtEnd(); ++eit, ++it )
+    {
+    TEST_EXPECT_EQUAL( it.Get(), eit.Get() );
+    }
+
+  typename ReaderType::Pointer blockReader = ReaderType::New();
+  blockReader->SetFileName( fileName );
+  typename ExtractType::Pointer extract = ExtractType::New();
+  extract->SetInput( blockReader->GetOutput() );
+  extract->SetExtractionRegion( block );
+  typename WriterType::Pointer blockWriter = WriterType::New();
+  blockWriter->SetInput( extract->GetOutput() );
+  blockWriter->SetFileName( blockFileName );
+  TRY_EXPECT_NO_EXCEPTION( blockWriter->Update() );
+  TEST_EXPECT_EQUAL( blockReader->GetOutput()->GetBufferedRegion(), block );
+
+  // without streaming, the whole image is read
+  typename ReaderType::Pointer reader = ReaderType::New();
+  reader->SetFileName( fileName );
+  reader->UseStreamingOff();
+  reader->GetOutput()->SetRequestedRegion( block );
+  TRY_EXPECT_NO_EXCEPTION( reader->Update() );
+  TEST_EXPECT_EQUAL( reader->GetOutput()->GetBufferedRegion(), largestRegion );
+
+  return EXIT_SUCCESS;
+}
+}
+
+int itkNiftiImageIOStreamingTest( int argc, char* argv[] )
+{
+  if ( argc < 2 )
+    {
+    std::cerr << "Missing parameters." << std::endl;
+    std::cerr << "Usage: " << argv[0] << " OutputDirectory" << std::endl;
+    return EXIT_FAILURE;
+    }
+  const std::string outputDirectory = argv[1];
+
+  using ImageType = itk::Image< float, 4 >;
+  ImageType::SizeType size = { { 23, 19, 17, 7 } };
+  ImageType::Pointer image = ImageType::New();
+  image->SetRegions( size );
+  image->Allocate();
+  itk::ImageRegionIteratorWithIndex< ImageType > it( image, image->GetLargestPossibleRegion() );
+  for ( ; !it.IsAtEnd(); ++it )
+    {
+    const ImageType::IndexType index = it.GetIndex();
+    it.Set( static_cast< float >( index[0] + 100 * index[1] - 3 * index[2] * index[3] ) );
+    }
+
+  using VectorImageType = itk::Image< itk::Vector< short, 2 >, 3 >;
+  VectorImageType::SizeType vectorSize = { { 23, 19, 17 } };
+  VectorImageType::Pointer vectorImage = VectorImageType::New();
+  vectorImage->SetRegions( vectorSize );
+  vectorImage->Allocate();
+  itk::ImageRegionIteratorWithIndex< VectorImageType > vit( vectorImage, vectorImage->GetLargestPossibleRegion() );
+  for ( ; !vit.IsAtEnd(); ++vit )
+    {
+    const VectorImageType::IndexType index = vit.GetIndex();
+    VectorImageType::PixelType value;
+    value[0] = static_cast< short >( index[0] * index[1] );
+    value[1] = static_cast< short >( index[2] - index[0] );
+    vit.Set( value );
+    }
+
+  TEST_EXPECT_EQUAL( WriteBlock< ImageType >( image, outputDirectory + "/NiftiStreamingBlock.nii" ), EXIT_SUCCESS );
+  TEST_EXPECT_EQUAL( WriteBlock< VectorImageType >( vectorImage, outputDirectory + "/NiftiStreamingVectorBlock.nii" ),
+                     EXIT_SUCCESS );
+
+  const char * const formats[][2] = { { ".nii", "Nii" }, { ".nii.gz", "NiiGz" }, { ".hdr", "Hdr" },
+                                      { ".img.gz", "ImgGz" } };
+  for ( const auto & format : formats )
+    {
+    TEST_EXPECT_EQUAL( WriteAndStreamRegions< ImageType >( image,
+                         outputDirectory + "/NiftiStreaming" + format[0],
+                         outputDirectory + "/NiftiStreamingBlock" + format[1] + ".nii" ), EXIT_SUCCESS );
+    TEST_EXPECT_EQUAL( WriteAndStreamRegions< VectorImageType >( vectorImage,
+                         outputDirectory + "/NiftiStreamingVector" + format[0],
+                         outputDirectory + "/NiftiStreamingVectorBlock" + format[1] + ".nii" ), EXIT_SUCCESS );
+    }
+
+  std::cout << "Test finished." << std::endl;
+  return EXIT_SUCCESS;
+}
@@ -20,7 +20,7 @@
 #include "ITKIONRRDExport.h"
 
 
-#include "itkImageIOBase.h"
+#include "itkStreamingImageIOBase.h"
 #include <fstream>
 
 namespace itk
@@ -34,21 +34,21 @@ namespace itk
  *  \ingroup IOFilters
  * \ingroup ITKIONRRD
  */
-class ITKIONRRD_EXPORT NrrdImageIO:public ImageIOBase
+class ITKIONRRD_EXPORT NrrdImageIO:public StreamingImageIOBase
 {
 public:
   ITK_DISALLOW_COPY_AND_ASSIGN(NrrdImageIO);
 
   /** Standard class type aliases. */
   using Self = NrrdImageIO;
-  using Superclass = ImageIOBase;
+  using Superclass = StreamingImageIOBase;
   using Pointer = SmartPointer< Self >;
 
   /** Method for creation through the object factory. */
   itkNewMacro(Self);
 
   /** Run-time type information (and related methods). */
-  itkTypeMacro(NrrdImageIO, ImageIOBase);
+  itkTypeMacro(NrrdImageIO, StreamingImageIOBase);
 
   /** The different types of ImageIO's can support data of varying
    * dimensionality. For example, some file formats are strictly 2D
@@ -67,6 +67,22 @@ public:
   /** Reads the data from disk into the memory buffer provided. */
   void Read(void *buffer) override;
 
+  /** Any region of the image can be read from raw and gzip encoded data
+   * stored in a single file, with the components of each pixel stored
+   * together. Only the requested region of raw data is read, while gzip
+   * encoded data is decompressed up to the end of the region. This is
+   * known once the header of the file has been read. */
+  bool CanStreamRead() override;
+
+  /** The pixel data can be memory mapped if it is raw encoded in a single
+   * file, in the byte order of the system. */
+  bool GetPixelDataLocation(std::string & fileName, SizeValueType & offset) override;
+
+  /** A region of the image can be written, into a new file or pasted into
+   * an existing one, when the data is raw encoded, that is, neither
+   * compressed nor ASCII. */
+  bool CanStreamWrite() override;
+
   /** Determine the file type. Returns true if this ImageIO can write the
    * file specified. */
   bool CanWriteFile(const char *) override;
@@ -88,6 +104,29 @@ protected:
   int ITKToNrrdComponentType(const ImageIOBase::IOComponentType) const;
 
   ImageIOBase::IOComponentType NrrdToITKComponentType(const int) const;
+
+  /** Returns the offset of the data in the data file. */
+  SizeType GetHeaderSize() const override;
+
+private:
+  /** Reads the IORegion from the data file, when it is not the whole
+   * image. */
+  void ReadRegion(void *buffer);
+
+  /** Reads the IORegion from gzip encoded data, decompressing the data
+   * from its start and discarding what is outside of the region. */
+  void StreamReadGzipBuffer(std::istream & file, void *buffer);
+
+  /** Writes the IORegion into the data file, which is allocated when the
+   * header has just been written. */
+  void WriteRegion(const void *buffer, bool newFile);
+
+  // The file holding the data, if it can be streamed, and the position
+  // of the data in it. Gzip encoded data may skip bytes once decompressed.
+  std::string m_StreamableDataFileName;
+  SizeType    m_DataPosition{ 0 };
+  SizeType    m_DataByteSkip{ 0 };
+  bool        m_DataIsGzipEncoded{ false };
 };
 } // end namespace itk
 
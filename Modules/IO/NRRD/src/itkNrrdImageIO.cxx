@@ -22,11 +22,38 @@
 #include "itkMetaDataObject.h"
 #include "itkIOCommon.h"
 #include "itkFloatingPointExceptions.h"
+#include "itkByteSwapper.h"
+#include "itksys/SystemTools.hxx"
+#include "itk_zlib.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <vector>
 
 namespace itk
 {
 #define KEY_PREFIX "NRRD_"
 
+namespace
+{
+// Swaps the bytes of the components of a buffer read from or written to
+// data in the given byte order, when it is not the one of the system.
+void
+SwapBytesIfNeeded(void *buffer, int nrrdComponentType, size_t numberOfComponents, ImageIOBase::ByteOrder byteOrder)
+{
+  if ( nrrdTypeSize[nrrdComponentType] > 1
+       && byteOrder != ImageIOBase::OrderNotApplicable
+       && ( byteOrder == ImageIOBase::BigEndian ) != ( airMyEndian() == airEndianBig ) )
+    {
+    Nrrd *nrrd = nrrdNew();
+    nrrdWrap_va(nrrd, buffer, nrrdComponentType, 1, numberOfComponents);
+    nrrdSwapEndian(nrrd);
+    nrrdNix(nrrd);
+    }
+}
+} // end anonymous namespace
+
 NrrdImageIO::NrrdImageIO()
 {
   this->SetNumberOfDimensions(3);
@@ -60,6 +87,47 @@ bool NrrdImageIO::SupportsDimension(unsigned long dim)
 void NrrdImageIO::PrintSelf(std::ostream & os, Indent indent) const
 {
   Superclass::PrintSelf(os, indent);
+  os << indent << "StreamableDataFileName: " << m_StreamableDataFileName << std::endl;
+  os << indent << "DataPosition: " << m_DataPosition << std::endl;
+  os << indent << "DataByteSkip: " << m_DataByteSkip << std::endl;
+  os << indent << "DataIsGzipEncoded: " << m_DataIsGzipEncoded << std::endl;
+}
+
+bool NrrdImageIO::CanStreamRead()
+{
+  return !m_StreamableDataFileName.empty();
+}
+
+bool NrrdImageIO::GetPixelDataLocation(std::string & fileName, SizeValueType & offset)
+{
+  if ( !this->CanStreamRead() || m_DataIsGzipEncoded )
+    {
+    return false;
+    }
+  if ( this->GetComponentSize() > 1
+       && ( this->GetByteOrder() == BigEndian ) != ByteSwapper< int >::SystemIsBigEndian() )
+    {
+    return false;
+    }
+  const auto fileSize = static_cast< SizeValueType >( itksys::SystemTools::FileLength(m_StreamableDataFileName) );
+  if ( fileSize < static_cast< SizeValueType >( m_DataPosition + this->GetImageSizeInBytes() ) )
+    {
+    return false;
+    }
+
+  fileName = m_StreamableDataFileName;
+  offset = m_DataPosition;
+  return true;
+}
+
+bool NrrdImageIO::CanStreamWrite()
+{
+  return !this->GetUseCompression() && this->GetFileType() != ASCII;
+}
+
+NrrdImageIO::SizeType NrrdImageIO::GetHeaderSize() const
+{
+  return m_DataPosition;
 }
 
 ImageIOBase::IOComponentType
@@ -222,6 +290,11 @@ void NrrdImageIO::ReadImageInformation()
   Nrrd *       nrrd = nrrdNew();
   NrrdIoState *nio = nrrdIoStateNew();
 
+  m_StreamableDataFileName.clear();
+  m_DataPosition = 0;
+  m_DataByteSkip = 0;
+  m_DataIsGzipEncoded = false;
+
   try
     {
     // nrrd causes exceptions on purpose, so mask them
@@ -235,6 +308,9 @@ void NrrdImageIO::ReadImageInformation()
     // this is the mechanism by which we tell nrrdLoad to read
     // just the header, and none of the data
     nrrdIoStateSet(nio, nrrdIoStateSkipData, 1);
+    // keep a single data file open at the start of the data, which tells
+    // where to read a region from
+    nrrdIoStateSet(nio, nrrdIoStateKeepNrrdDataFileOpen, 1);
     if ( nrrdLoad(nrrd, this->GetFileName(), nio) != 0 )
       {
       char *err = biffGetDone(NRRD);
@@ -254,6 +330,12 @@ void NrrdImageIO::ReadImageInformation()
       FloatingPointExceptions::SetEnabled(saveFPEState);
       }
 
+    long dataPosition = -1;
+    if ( nio->dataFile != nullptr )
+      {
+      dataPosition = ftell(nio->dataFile);
+      nio->dataFile = airFclose(nio->dataFile);
+      }
 
     if ( nrrdTypeBlock == nrrd->type )
       {
@@ -673,12 +755,53 @@ void NrrdImageIO::ReadImageInformation()
                                                                   msrFrame);
       }
 
+    // The data can be streamed when it is stored in a single file, either
+    // raw or gzip encoded, with the components of each pixel together.
+    // Gzip encoded data skips bytes once decompressed.
+    size_t numberOfElements = this->GetNumberOfComponents();
+    for ( unsigned int axii = 0; axii < domainAxisNum; axii++ )
+      {
+      numberOfElements *= this->GetDimensions(axii);
+      }
+    if ( dataPosition >= 0
+         && ( nio->encoding == nrrdEncodingRaw
+              || ( nio->encoding == nrrdEncodingGzip && nio->byteSkip >= 0 ) )
+         && ( 0 == rangeAxisNum || 0 == rangeAxisIdx[0] )
+         && nrrdElementNumber(nrrd) == numberOfElements
+         && nio->dataFNFormat == nullptr )
+      {
+      if ( 0 == nio->dataFNArr->len )
+        {
+        m_StreamableDataFileName = this->GetFileName();
+        }
+      else if ( 1 == nio->dataFNArr->len && strcmp(nio->dataFN[0], "-") != 0 )
+        {
+        // the data file name is relative to the header
+        m_StreamableDataFileName = nio->dataFN[0];
+        if ( !itksys::SystemTools::FileIsFullPath(m_StreamableDataFileName) && airStrlen(nio->path) )
+          {
+          m_StreamableDataFileName = std::string(nio->path) + "/" + m_StreamableDataFileName;
+          }
+        }
+      m_DataPosition = static_cast< SizeType >( dataPosition );
+      if ( nio->encoding == nrrdEncodingGzip )
+        {
+        m_DataIsGzipEncoded = true;
+        m_DataByteSkip = static_cast< SizeType >( nio->byteSkip );
+        }
+      }
+
     nrrd = nrrdNix(nrrd);
     nio = nrrdIoStateNix(nio);
     }
   catch (...)
     {
     // clean up from an exception
+    if ( nio->dataFile != nullptr )
+      {
+      nio->dataFile = airFclose(nio->dataFile);
+      }
+    m_StreamableDataFileName.clear();
     nrrd = nrrdNix(nrrd);
     nio = nrrdIoStateNix(nio);
 
@@ -687,8 +810,152 @@ void NrrdImageIO::ReadImageInformation()
     }
 }
 
+void NrrdImageIO::ReadRegion(void *buffer)
+{
+  if ( !this->CanStreamRead() )
+    {
+    itkExceptionMacro("Read: Cannot read a region of " << this->GetFileName()
+                      << ", its data is not raw or gzip encoded in a single file");
+    }
+
+  std::ifstream file;
+  this->OpenFileForReading(file, m_StreamableDataFileName);
+  if ( m_DataIsGzipEncoded )
+    {
+    this->StreamReadGzipBuffer(file, buffer);
+    }
+  else if ( !this->StreamReadBufferAsBinary(file, buffer) )
+    {
+    itkExceptionMacro("Read: Error reading " << m_StreamableDataFileName);
+    }
+
+  SwapBytesIfNeeded(buffer, this->ITKToNrrdComponentType(this->m_ComponentType),
+                    static_cast< size_t >( m_IORegion.GetNumberOfPixels() * this->GetNumberOfComponents() ),
+                    this->GetByteOrder());
+}
+
+void NrrdImageIO::StreamReadGzipBuffer(std::istream & file, void *buffer)
+{
+  z_stream stream = {};
+  // decode the gzip header
+  if ( inflateInit2(&stream, 15 + 16) != Z_OK )
+    {
+    itkExceptionMacro("Read: Cannot initialize the decompression of " << m_StreamableDataFileName);
+    }
+  file.seekg(this->GetDataPosition(), std::ios::beg);
+
+  std::vector< Bytef > input(65536);
+  std::vector< Bytef > discarded(65536);
+  bool                 endOfFile = false;
+
+  // decompresses length bytes to output, or discards them if output is null
+  auto inflateTo = [&](char *output, SizeType length) -> bool
+    {
+      while ( length > 0 )
+        {
+        if ( stream.avail_in == 0 && !endOfFile )
+          {
+          file.read(reinterpret_cast< char * >( input.data() ), input.size());
+          stream.next_in = input.data();
+          stream.avail_in = static_cast< uInt >( file.gcount() );
+          endOfFile = !file.good();
+          }
+        const SizeType outputSize = output ? std::min< SizeType >(length, 1u << 30)
+                                           : std::min< SizeType >(length, discarded.size());
+        stream.next_out = output ? reinterpret_cast< Bytef * >( output ) : discarded.data();
+        stream.avail_out = static_cast< uInt >( outputSize );
+        const int result = inflate(&stream, Z_NO_FLUSH);
+        const SizeType decompressed = outputSize - stream.avail_out;
+        length -= decompressed;
+        if ( output )
+          {
+          output += decompressed;
+          }
+        if ( result == Z_STREAM_END )
+          {
+          // the data may be made of several gzip members
+          if ( length > 0 && inflateReset(&stream) != Z_OK )
+            {
+            return false;
+            }
+          }
+        else if ( result != Z_OK && !( result == Z_BUF_ERROR && stream.avail_in == 0 && !endOfFile ) )
+          {
+          return false;
+          }
+        if ( decompressed == 0 && stream.avail_in == 0 && endOfFile )
+          {
+          return false;
+          }
+        }
+      return true;
+    };
+
+  // compute the number of continuous bytes to be read, as
+  // StreamReadBufferAsBinary does
+  SizeType     sizeOfChunk = 1;
+  unsigned int movingDirection = 0;
+  do
+    {
+    sizeOfChunk *= m_IORegion.GetSize(movingDirection);
+    ++movingDirection;
+    }
+  while ( movingDirection < m_IORegion.GetImageDimension()
+          && m_IORegion.GetSize(movingDirection - 1) == this->GetDimensions(movingDirection - 1) );
+  sizeOfChunk *= this->GetPixelSize();
+
+  // the chunks are in increasing order in the data
+  auto *                   output = static_cast< char * >( buffer );
+  SizeType                 position = 0;
+  bool                     failed = !inflateTo(nullptr, m_DataByteSkip);
+  ImageIORegion::IndexType currentIndex = m_IORegion.GetIndex();
+  while ( !failed && m_IORegion.IsInside(currentIndex) )
+    {
+    SizeType chunkPosition = 0;
+    SizeType subDimensionQuantity = 1;
+    for ( unsigned int i = 0; i < m_IORegion.GetImageDimension(); ++i )
+      {
+      chunkPosition += subDimensionQuantity * this->GetPixelSize() * currentIndex[i];
+      subDimensionQuantity *= this->GetDimensions(i);
+      }
+
+    failed = !inflateTo(nullptr, chunkPosition - position) || !inflateTo(output, sizeOfChunk);
+    output += sizeOfChunk;
+    position = chunkPosition + sizeOfChunk;
+
+    if ( movingDirection == m_IORegion.GetImageDimension() )
+      {
+      break;
+      }
+
+    // increment index to next chunk
+    ++currentIndex[movingDirection];
+    for ( unsigned int i = movingDirection; i < m_IORegion.GetImageDimension() - 1; ++i )
+      {
+      if ( static_cast< ImageIORegion::SizeValueType >( currentIndex[i] - m_IORegion.GetIndex(i) ) >=
+           m_IORegion.GetSize(i) )
+        {
+        currentIndex[i] = m_IORegion.GetIndex(i);
+        ++currentIndex[i + 1];
+        }
+      }
+    }
+  inflateEnd(&stream);
+
+  if ( failed )
+    {
+    itkExceptionMacro("Read: Error decompressing " << m_StreamableDataFileName);
+    }
+}
+
 void NrrdImageIO::Read(void *buffer)
 {
+  if ( this->RequestedToStream() )
+    {
+    this->ReadRegion(buffer);
+    return;
+    }
+
   Nrrd *       nrrd = nrrdNew();
   bool         nrrdAllocated;
 
@@ -845,8 +1112,67 @@ void NrrdImageIO::WriteImageInformation()
   // Nothing needs doing here.
 }
 
+void NrrdImageIO::WriteRegion(const void *buffer, bool newFile)
+{
+  if ( !this->CanStreamWrite() )
+    {
+    itkExceptionMacro("Write: Cannot write a region of " << this->GetFileName()
+                      << " with compressed or ASCII data");
+    }
+
+  // find where the data is, and in which byte order, as reading would
+  Pointer headerIO = Self::New();
+  headerIO->SetFileName( this->GetFileName() );
+  headerIO->ReadImageInformation();
+  if ( !headerIO->CanStreamRead() || headerIO->m_DataIsGzipEncoded )
+    {
+    itkExceptionMacro("Write: Cannot write a region into " << this->GetFileName()
+                      << ", its data is not raw encoded in a single file");
+    }
+  m_DataPosition = headerIO->m_DataPosition;
+
+  std::ofstream file;
+  const std::string & dataFileName = headerIO->m_StreamableDataFileName;
+  this->OpenFileForWriting(file, dataFileName, false);
+  if ( newFile )
+    {
+    // write one byte at the end of the data to allocate it, which only
+    // allocates the last block on file systems supporting sparse files
+    file.seekp(static_cast< std::streamoff >( m_DataPosition + this->GetImageSizeInBytes() - 1 ), std::ios::beg);
+    file.write("\0", 1);
+    }
+
+  const auto numberOfComponents =
+    static_cast< size_t >( m_IORegion.GetNumberOfPixels() * this->GetNumberOfComponents() );
+  const int nrrdComponentType = this->ITKToNrrdComponentType(this->m_ComponentType);
+  const ImageIOBase::ByteOrder fileByteOrder = headerIO->GetByteOrder();
+  std::vector< char > swapped;
+  if ( nrrdTypeSize[nrrdComponentType] > 1 && fileByteOrder != OrderNotApplicable
+       && ( fileByteOrder == BigEndian ) != ( airMyEndian() == airEndianBig ) )
+    {
+    swapped.assign( static_cast< const char * >( buffer ),
+                    static_cast< const char * >( buffer ) + numberOfComponents * nrrdTypeSize[nrrdComponentType] );
+    SwapBytesIfNeeded(swapped.data(), nrrdComponentType, numberOfComponents, fileByteOrder);
+    buffer = swapped.data();
+    }
+  if ( file.fail() || !this->StreamWriteBufferAsBinary(file, buffer) )
+    {
+    itkExceptionMacro("Write: Error writing " << dataFileName);
+    }
+}
+
 void NrrdImageIO::Write(const void *buffer)
 {
+  // The header is written along with the first region streamed into a new
+  // file. GetActualNumberOfSplitsForWriting removes the file before
+  // streaming, unless a region is pasted into it.
+  const bool streaming = this->RequestedToStream();
+  if ( streaming && itksys::SystemTools::FileExists( m_FileName.c_str() ) )
+    {
+    this->WriteRegion(buffer, false);
+    return;
+    }
+
   Nrrd *       nrrd = nrrdNew();
   NrrdIoState *nio = nrrdIoStateNew();
   int          kind[NRRD_DIM_MAX];
@@ -1096,6 +1422,12 @@ void NrrdImageIO::Write(const void *buffer)
       break;
     }
 
+  // only write the header when streaming
+  if ( streaming )
+    {
+    nrrdIoStateSet(nio, nrrdIoStateSkipData, 1);
+    }
+
   // Write the nrrd to file.
   if ( nrrdSave(this->GetFileName(), nrrd, nio) )
     {
@@ -1104,9 +1436,23 @@ void NrrdImageIO::Write(const void *buffer)
                       << this->GetFileName() << ":\n" << err);
     }
 
+  // create the empty data file the detached header refers to
+  if ( streaming && nio->detachedHeader && nio->dataFNArr->len == 1 )
+    {
+    const std::string dataFileName = itksys::SystemTools::CollapseFullPath(
+      nio->dataFN[0], itksys::SystemTools::GetFilenamePath(m_FileName) );
+    std::ofstream dataFile;
+    this->OpenFileForWriting(dataFile, dataFileName, true);
+    }
+
   // Free the nrrd struct but don't touch nrrd->data
   nrrdNix(nrrd);
   nrrdIoStateNix(nio);
+
+  if ( streaming )
+    {
+    this->WriteRegion(buffer, true);
+    }
 }
 
 } // end namespace itk
@@ -108,6 +108,10 @@ public:
   /** Reads the data from disk into the memory buffer provided. */
   void Read(void *buffer) override;
 
+  /** The pixel data can be memory mapped if the file is binary and in the
+   * byte order of the system. */
+  bool GetPixelDataLocation(std::string & fileName, SizeValueType & offset) override;
+
   /** Set/Get the Data mask. */
   itkGetConstReferenceMacro(ImageMask, unsigned short);
   void SetImageMask(unsigned long val)
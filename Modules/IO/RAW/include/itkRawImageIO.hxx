@@ -170,6 +170,24 @@ void RawImageIO< TPixel, VImageDimension >
   else if itkReadRawBytesAfterSwappingMacro(double, DOUBLE)
 }
 
+template< typename TPixel, unsigned int VImageDimension >
+bool RawImageIO< TPixel, VImageDimension >
+::GetPixelDataLocation(std::string & fileName, SizeValueType & offset)
+{
+  const ByteOrder systemByteOrder =
+    ByteSwapperType::SystemIsBigEndian() ? BigEndian : LittleEndian;
+  if ( m_FileType != Binary
+       || ( this->GetComponentSize() > 1
+            && m_ByteOrder != systemByteOrder
+            && m_ByteOrder != OrderNotApplicable ) )
+    {
+    return false;
+    }
+  fileName = m_FileName;
+  offset = this->GetHeaderSize();
+  return true;
+}
+
 template< typename TPixel, unsigned int VImageDimension >
 bool RawImageIO< TPixel, VImageDimension >
 ::CanWriteFile(const char *fname)
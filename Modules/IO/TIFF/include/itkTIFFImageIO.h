@@ -74,6 +74,16 @@ public:
   /** Reads 3D data from multi-pages tiff. */
   virtual void ReadVolume(void *buffer);
 
+  /** Regions of the image can be read when its pixels are not converted
+   * to RGBA: only the strips or tiles holding the region are decoded, in
+   * parallel. */
+  bool CanStreamRead() override;
+
+  /** Returns the requested region when UseStreamedReading is on and the
+   * image can be read region-wise, and the whole image otherwise. */
+  ImageIORegion
+  GenerateStreamableReadRegionFromRequestedRegion(const ImageIORegion & requestedRegion) const override;
+
   /*-------- This part of the interfaces deals with writing data. ----- */
 
   /** Determine the file type. Returns true if this ImageIO can read the
@@ -88,6 +98,16 @@ public:
    * that the IORegion has been set properly. */
   void Write(const void *buffer) override;
 
+  /** Regions of the image can be written, and pasted into an existing
+   * file, when it is not compressed. */
+  bool CanStreamWrite() override;
+
+  /** Removes the file before streaming a new image into it, like
+   * StreamingImageIOBase. */
+  unsigned int GetActualNumberOfSplitsForWriting(unsigned int numberOfRequestedSplits,
+                                                 const ImageIORegion & pasteRegion,
+                                                 const ImageIORegion & largestPossibleRegion) override;
+
   enum { NOFORMAT, RGB_, GRAYSCALE, PALETTE_RGB, PALETTE_GRAYSCALE, OTHER };
 
   //BTX
@@ -133,6 +153,21 @@ public:
   itkSetClampMacro(JPEGQuality, int, 1, 100);
   itkGetConstMacro(JPEGQuality, int);
 
+  /** Set/Get the width and height of the tiles in which the pages are
+    * written. They must be multiples of 16. The pages are written in
+    * strips when either is 0, which is the default. */
+  itkSetMacro(TileWidth, unsigned int);
+  itkGetConstMacro(TileWidth, unsigned int);
+  itkSetMacro(TileHeight, unsigned int);
+  itkGetConstMacro(TileHeight, unsigned int);
+
+  /** Set/Get whether files are written in the BigTIFF format, whose
+    * offsets are 64 bits. Files larger than 2 GiB are always written as
+    * BigTIFF. Default is false. */
+  itkSetMacro(UseBigTIFF, bool);
+  itkGetConstMacro(UseBigTIFF, bool);
+  itkBooleanMacro(UseBigTIFF);
+
   /** Get a const ref to the palette of the image. In the case of non palette
     * image or ExpandRGBPalette set to true, a vector of size
     * 0 is returned.
@@ -144,8 +179,14 @@ protected:
   ~TIFFImageIO() override;
   void PrintSelf(std::ostream & os, Indent indent) const override;
 
+  /** Writes the whole image. The pixels are written as zero when the
+   * buffer is nullptr. */
   void InternalWrite(const void *buffer);
 
+  /** Writes the IORegion into the strips of the uncompressed file, which
+   * is first created with zero pixels if it does not exist. */
+  void InternalWriteRegion(const void *buffer);
+
   void InitializeColors();
 
   void ReadGenericImage(void *out,
@@ -179,15 +220,23 @@ protected:
   int m_Compression{ TIFFImageIO::PackBits };
   int m_JPEGQuality{ 75 };
 
+  unsigned int m_TileWidth{ 0 };
+  unsigned int m_TileHeight{ 0 };
+  bool         m_UseBigTIFF{ false };
+
   PaletteType m_ColorPalette;
 
 private:
   void ReadCurrentPage(void *out, size_t pixelOffset);
 
+  /** Reads a region of each of the given directories, one page after the
+   * other, decoding the strips or tiles which hold it. */
+  void ReadPages(void *out, const std::vector< uint16_t > & directories,
+                 const uint32_t start[2], const uint32_t size[2]);
+
   template <typename TComponent>
-  void ReadGenericImage(void *out,
-                        unsigned int width,
-                        unsigned int height);
+  void ReadGenericPages(void *out, const std::vector< uint16_t > & directories,
+                        const uint32_t start[2], const uint32_t size[2]);
 
   template <typename TComponent>
     void RGBAImageToBuffer( void *out, const uint32_t *tempImage );
@@ -223,6 +272,7 @@ private:
   unsigned short *m_ColorBlue;
   int             m_TotalColors{ -1 };
   unsigned int    m_ImageFormat{ TIFFImageIO::NOFORMAT };
+  bool            m_CanStreamRead{ false };
 };
 } // end namespace itk
 
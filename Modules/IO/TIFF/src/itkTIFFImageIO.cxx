@@ -21,8 +21,15 @@
 #include "itksys/SystemTools.hxx"
 #include "itkMetaDataObject.h"
 
+#include "itkMultiThreaderBase.h"
 #include "itk_tiff.h"
 
+#include <algorithm>
+#include <atomic>
+#include <fstream>
+#include <utility>
+#include <vector>
+
 namespace itk
 {
 
@@ -54,26 +61,34 @@ void TIFFImageIO::ReadGenericImage(void *out,
                                    unsigned int width,
                                    unsigned int height)
 {
+  const std::vector< uint16_t > directories( 1, TIFFCurrentDirectory(m_InternalImage->m_Image) );
+  const uint32_t                start[2] = { 0, 0 };
+  const uint32_t                size[2] = { width, height };
+  this->ReadPages(out, directories, start, size);
+}
 
+void TIFFImageIO::ReadPages(void *out, const std::vector< uint16_t > & directories,
+                            const uint32_t start[2], const uint32_t size[2])
+{
   if ( m_ComponentType == UCHAR )
     {
-    this->ReadGenericImage<unsigned char>(out, width, height);
+    this->ReadGenericPages<unsigned char>(out, directories, start, size);
     }
   else if ( m_ComponentType == CHAR )
     {
-    this->ReadGenericImage<char>(out, width, height);
+    this->ReadGenericPages<char>(out, directories, start, size);
     }
   else if ( m_ComponentType == USHORT )
     {
-    this->ReadGenericImage<unsigned short>(out, width, height);
+    this->ReadGenericPages<unsigned short>(out, directories, start, size);
     }
   else if ( m_ComponentType == SHORT )
     {
-    this->ReadGenericImage<short>(out, width, height);
+    this->ReadGenericPages<short>(out, directories, start, size);
     }
   else if ( m_ComponentType == FLOAT )
     {
-    this->ReadGenericImage<float>(out, width, height);
+    this->ReadGenericPages<float>(out, directories, start, size);
     }
 }
 
@@ -192,10 +207,48 @@ void TIFFImageIO::Read(void *buffer)
       }
     }
 
-  // The IO region should be of dimensions 3 otherwise we read only the first
-  // page
-  if ( m_InternalImage->m_NumberOfPages > 0
-       && this->GetIORegion().GetImageDimension() > 2 )
+  if ( m_InternalImage->CanRead() )
+    {
+    // The pages of the IO region, after skipping the reduced images and
+    // the masks. The IO region should be of dimensions 3 otherwise we
+    // read only the first page.
+    const ImageIORegion & region = this->GetIORegion();
+    std::vector< uint16_t > pages;
+    for ( uint16_t directory = 0; directory < m_InternalImage->m_NumberOfPages; ++directory )
+      {
+      int32 subfiletype = 0;
+      if ( m_InternalImage->m_IgnoredSubFiles > 0
+           && TIFFSetDirectory(m_InternalImage->m_Image, directory)
+           && TIFFGetField(m_InternalImage->m_Image, TIFFTAG_SUBFILETYPE, &subfiletype)
+           && ( subfiletype & FILETYPE_REDUCEDIMAGE || subfiletype & FILETYPE_MASK ) )
+        {
+        continue;
+        }
+      pages.push_back(directory);
+      }
+    TIFFSetDirectory(m_InternalImage->m_Image, pages.front());
+
+    std::vector< uint16_t > directories( 1, pages.front() );
+    if ( region.GetImageDimension() > 2 )
+      {
+      if ( region.GetIndex(2) < 0
+           || static_cast< size_t >( region.GetIndex(2) + region.GetSize(2) ) > pages.size() )
+        {
+        itkExceptionMacro(<< "The region to read is outside of the pages of " << m_FileName);
+        }
+      directories.assign(pages.begin() + region.GetIndex(2),
+                         pages.begin() + region.GetIndex(2) + region.GetSize(2));
+      }
+    const uint32_t start[2] = { static_cast< uint32_t >( region.GetIndex(0) ),
+                                static_cast< uint32_t >( region.GetIndex(1) ) };
+    const uint32_t size[2] = { static_cast< uint32_t >( region.GetSize(0) ),
+                               static_cast< uint32_t >( region.GetSize(1) ) };
+
+    this->InitializeColors();
+    this->ReadPages(buffer, directories, start, size);
+    }
+  else if ( m_InternalImage->m_NumberOfPages > 0
+            && this->GetIORegion().GetImageDimension() > 2 )
     {
     this->ReadVolume(buffer);
     }
@@ -207,6 +260,21 @@ void TIFFImageIO::Read(void *buffer)
   m_InternalImage->Clean();
 }
 
+bool TIFFImageIO::CanStreamRead()
+{
+  return m_CanStreamRead;
+}
+
+ImageIORegion
+TIFFImageIO::GenerateStreamableReadRegionFromRequestedRegion(const ImageIORegion & requestedRegion) const
+{
+  if ( !m_UseStreamedReading || !m_CanStreamRead )
+    {
+    return Superclass::GenerateStreamableReadRegionFromRequestedRegion(requestedRegion);
+    }
+  return requestedRegion;
+}
+
 TIFFImageIO::TIFFImageIO() :
   m_ColorPalette( 0 )
 
@@ -252,6 +320,9 @@ void TIFFImageIO::PrintSelf(std::ostream & os, Indent indent) const
 
   os << indent << "Compression: " << m_Compression << std::endl;
   os << indent << "JPEGQuality: " << m_JPEGQuality << std::endl;
+  os << indent << "TileWidth: " << m_TileWidth << std::endl;
+  os << indent << "TileHeight: " << m_TileHeight << std::endl;
+  os << indent << "UseBigTIFF: " << ( m_UseBigTIFF ? "On" : "Off" ) << std::endl;
   if( !m_ColorPalette.empty()  )
     {
     os << indent << "Image RGB palette:" << "\n";
@@ -487,6 +558,7 @@ void TIFFImageIO::ReadImageInformation()
       }
     }
 
+  m_CanStreamRead = ( m_InternalImage->CanRead() != 0 );
 }
 
 bool TIFFImageIO::CanWriteFile(const char *name)
@@ -509,7 +581,19 @@ void TIFFImageIO::Write(const void *buffer)
 {
   if ( m_NumberOfDimensions == 2 || m_NumberOfDimensions == 3 )
     {
-    this->InternalWrite(buffer);
+    SizeValueType numberOfPixels = 1;
+    for ( unsigned int i = 0; i < m_NumberOfDimensions; ++i )
+      {
+      numberOfPixels *= m_Dimensions[i];
+      }
+    if ( m_UseStreamedWriting && m_IORegion.GetNumberOfPixels() != numberOfPixels )
+      {
+      this->InternalWriteRegion(buffer);
+      }
+    else
+      {
+      this->InternalWrite(buffer);
+      }
     }
   else
     {
@@ -517,6 +601,170 @@ void TIFFImageIO::Write(const void *buffer)
     }
 }
 
+bool TIFFImageIO::CanStreamWrite()
+{
+  return !m_UseCompression || m_Compression == NoCompression;
+}
+
+unsigned int
+TIFFImageIO::GetActualNumberOfSplitsForWriting(unsigned int numberOfRequestedSplits,
+                                               const ImageIORegion & pasteRegion,
+                                               const ImageIORegion & largestPossibleRegion)
+{
+  // the file may not match the image being streamed, unless pasting
+  if ( this->CanStreamWrite()
+       && numberOfRequestedSplits != 1
+       && pasteRegion == largestPossibleRegion
+       && itksys::SystemTools::FileExists( m_FileName.c_str() )
+       && !itksys::SystemTools::RemoveFile( m_FileName.c_str() ) )
+    {
+    itkExceptionMacro("Unable to remove file for streaming: " << m_FileName);
+    }
+  return Superclass::GetActualNumberOfSplitsForWriting(numberOfRequestedSplits, pasteRegion, largestPossibleRegion);
+}
+
+void TIFFImageIO::InternalWriteRegion(const void *buffer)
+{
+  if ( !this->CanStreamWrite() )
+    {
+    itkExceptionMacro(<< "Cannot write a region of the compressed file: " << m_FileName);
+    }
+  if ( !itksys::SystemTools::FileExists( m_FileName.c_str() ) )
+    {
+    this->InternalWrite(nullptr);
+    }
+
+  TIFF *tif = TIFFOpen(m_FileName.c_str(), "r");
+  if ( !tif )
+    {
+    itkExceptionMacro( "Error while trying to open file for writing: "
+                       << this->GetFileName()
+                       << std::endl
+                       << "Reason: "
+                       << itksys::SystemTools::GetLastSystemError() );
+    }
+
+  const unsigned int pages = ( m_NumberOfDimensions == 3 ) ? m_Dimensions[2] : 1;
+  const SizeValueType componentSize = this->GetComponentSize();
+  const SizeValueType pixelSize = componentSize * this->GetNumberOfComponents();
+  const SizeValueType scanlineSize = m_Dimensions[0] * pixelSize;
+  const bool swap = TIFFIsByteSwapped(tif) && componentSize > 1;
+  const ImageIORegion & region = this->GetIORegion();
+  const SizeValueType firstPage = ( region.GetImageDimension() > 2 ) ? region.GetIndex(2) : 0;
+  const SizeValueType numberOfPages = ( region.GetImageDimension() > 2 ) ? region.GetSize(2) : 1;
+
+  // the rows of the region are found in the strips or the tiles of each
+  // page, and are split at the tile boundaries
+  std::vector< std::pair< std::streamoff, SizeValueType > > segments;
+  segments.reserve( numberOfPages * region.GetSize(1) );
+  bool compatible = TIFFNumberOfDirectories(tif) == pages;
+  for ( SizeValueType page = firstPage; compatible && page < firstPage + numberOfPages; ++page )
+    {
+    uint32 width = 0;
+    uint32 height = 0;
+    uint32 rowsPerStrip = 0;
+    uint32 tileWidth = 0;
+    uint32 tileHeight = 0;
+    uint16 samplesPerPixel = 0;
+    uint16 bitsPerSample = 0;
+    uint16 compression = 0;
+    uint16 planarConfig = 0;
+    toff_t *blockOffsets = nullptr;
+    compatible = TIFFSetDirectory(tif, static_cast< uint16 >( page ) );
+    const bool tiled = compatible && TIFFIsTiled(tif);
+    if ( tiled )
+      {
+      compatible = TIFFGetField(tif, TIFFTAG_TILEWIDTH, &tileWidth)
+                   && TIFFGetField(tif, TIFFTAG_TILELENGTH, &tileHeight)
+                   && TIFFGetField(tif, TIFFTAG_TILEOFFSETS, &blockOffsets)
+                   && tileWidth > 0
+                   && tileHeight > 0;
+      }
+    else if ( compatible )
+      {
+      compatible = TIFFGetFieldDefaulted(tif, TIFFTAG_ROWSPERSTRIP, &rowsPerStrip)
+                   && TIFFGetField(tif, TIFFTAG_STRIPOFFSETS, &blockOffsets)
+                   && rowsPerStrip > 0;
+      }
+    compatible = compatible
+                 && TIFFGetField(tif, TIFFTAG_IMAGEWIDTH, &width)
+                 && TIFFGetField(tif, TIFFTAG_IMAGELENGTH, &height)
+                 && TIFFGetFieldDefaulted(tif, TIFFTAG_SAMPLESPERPIXEL, &samplesPerPixel)
+                 && TIFFGetFieldDefaulted(tif, TIFFTAG_BITSPERSAMPLE, &bitsPerSample)
+                 && TIFFGetFieldDefaulted(tif, TIFFTAG_COMPRESSION, &compression)
+                 && TIFFGetFieldDefaulted(tif, TIFFTAG_PLANARCONFIG, &planarConfig)
+                 && width == m_Dimensions[0]
+                 && height == m_Dimensions[1]
+                 && samplesPerPixel == this->GetNumberOfComponents()
+                 && bitsPerSample == 8 * componentSize
+                 && compression == COMPRESSION_NONE
+                 && ( planarConfig == PLANARCONFIG_CONTIG || samplesPerPixel == 1 );
+    const SizeValueType endX = region.GetIndex(0) + region.GetSize(0);
+    for ( SizeValueType y = region.GetIndex(1); compatible && y < region.GetIndex(1) + region.GetSize(1); ++y )
+      {
+      if ( !tiled )
+        {
+        segments.emplace_back( static_cast< std::streamoff >( blockOffsets[y / rowsPerStrip]
+                                                              + ( y % rowsPerStrip ) * scanlineSize
+                                                              + region.GetIndex(0) * pixelSize ),
+                               region.GetSize(0) * pixelSize );
+        continue;
+        }
+      for ( SizeValueType x = region.GetIndex(0); x < endX; x = ( x / tileWidth + 1 ) * tileWidth )
+        {
+        const ttile_t tile = TIFFComputeTile(tif, static_cast< uint32 >( x ), static_cast< uint32 >( y ), 0, 0);
+        const SizeValueType columns = std::min< SizeValueType >( ( x / tileWidth + 1 ) * tileWidth, endX ) - x;
+        segments.emplace_back( static_cast< std::streamoff >( blockOffsets[tile]
+                                                              + ( y % tileHeight ) * tileWidth * pixelSize
+                                                              + ( x % tileWidth ) * pixelSize ),
+                               columns * pixelSize );
+        }
+      }
+    }
+  TIFFClose(tif);
+  if ( !compatible )
+    {
+    itkExceptionMacro(<< "Cannot write a region into " << m_FileName
+                      << ", which is compressed or does not match the image");
+    }
+
+  std::ofstream file;
+  this->OpenFileForWriting(file, m_FileName, false);
+  const SizeValueType regionRowLength = region.GetSize(0) * pixelSize;
+  const auto *        row = static_cast< const char * >( buffer );
+  std::vector< char > swapped( swap ? regionRowLength : 0 );
+  for ( const auto & segment : segments )
+    {
+    const SizeValueType length = segment.second;
+    file.seekp(segment.first, std::ios::beg);
+    if ( swap )
+      {
+      std::copy(row, row + length, swapped.begin());
+      if ( componentSize == 2 )
+        {
+        TIFFSwabArrayOfShort(reinterpret_cast< uint16 * >( swapped.data() ), length / 2);
+        }
+      else
+        {
+        TIFFSwabArrayOfLong(reinterpret_cast< uint32 * >( swapped.data() ), length / 4);
+        }
+      file.write(swapped.data(), length);
+      }
+    else
+      {
+      file.write(row, length);
+      }
+    row += length;
+    }
+  if ( !file.good() )
+    {
+    itkExceptionMacro( "Error while writing file: " << m_FileName
+                       << std::endl
+                       << "Reason: "
+                       << itksys::SystemTools::GetLastSystemError() );
+    }
+}
+
 void TIFFImageIO::InternalWrite(const void *buffer)
 {
   const auto * outPtr = (const char *)buffer;
@@ -562,6 +810,13 @@ void TIFFImageIO::InternalWrite(const void *buffer)
 
   uint16_t predictor;
 
+  const bool tiled = m_TileWidth != 0 && m_TileHeight != 0;
+  if ( tiled && ( m_TileWidth % 16 != 0 || m_TileHeight % 16 != 0 ) )
+    {
+    itkExceptionMacro( << "The tile width and height must be multiples of 16, not "
+                       << m_TileWidth << " and " << m_TileHeight );
+    }
+
   const char *mode = "w";
 
   // If the size of the image is greater than 2 GiB then use big tiff
@@ -570,7 +825,7 @@ void TIFFImageIO::InternalWrite(const void *buffer)
   const SizeType oneGibiByte = 1024 * oneMebiByte;
   const SizeType twoGibiBytes = 2 * oneGibiByte;
 
-  if ( this->GetImageSizeInBytes() > twoGibiBytes )
+  if ( m_UseBigTIFF || this->GetImageSizeInBytes() > twoGibiBytes )
     {
 #ifdef TIFF_INT64_T  // detect if libtiff4
     // Adding the "8" option enables the use of big tiff
@@ -710,15 +965,23 @@ void TIFFImageIO::InternalWrite(const void *buffer)
       {
       itkExceptionMacro("TIFFScanlineSize returned 0");
       }
-    rowsperstrip = (uint32_t)(1024*1024 / scanlinesize );
-    if ( rowsperstrip < 1 )
+    if ( tiled )
       {
-      rowsperstrip = 1;
+      TIFFSetField(tif, TIFFTAG_TILEWIDTH, m_TileWidth);
+      TIFFSetField(tif, TIFFTAG_TILELENGTH, m_TileHeight);
       }
+    else
+      {
+      rowsperstrip = (uint32_t)(1024*1024 / scanlinesize );
+      if ( rowsperstrip < 1 )
+        {
+        rowsperstrip = 1;
+        }
 
-    TIFFSetField( tif,
-                  TIFFTAG_ROWSPERSTRIP,
-                  TIFFDefaultStripSize(tif, rowsperstrip) );
+      TIFFSetField( tif,
+                    TIFFTAG_ROWSPERSTRIP,
+                    TIFFDefaultStripSize(tif, rowsperstrip) );
+      }
 
     if ( resolution_x > 0 && resolution_y > 0 )
       {
@@ -761,14 +1024,57 @@ void TIFFImageIO::InternalWrite(const void *buffer)
     rowLength *= this->GetNumberOfComponents();
     rowLength *= width;
 
+    if ( tiled )
+      {
+      // the tiles on the right and bottom edges are padded with zeros
+      const SizeValueType pixelLength = rowLength / width;
+      const SizeValueType tileRowLength = m_TileWidth * pixelLength;
+      std::vector< char > tile( tileRowLength * m_TileHeight );
+      for ( uint32 y = 0; y < h; y += m_TileHeight )
+        {
+        for ( uint32 x = 0; x < w; x += m_TileWidth )
+          {
+          std::fill(tile.begin(), tile.end(), 0);
+          if ( outPtr != nullptr )
+            {
+            const SizeValueType columns = std::min< SizeValueType >( m_TileWidth, width - x );
+            const SizeValueType rows = std::min< SizeValueType >( m_TileHeight, height - y );
+            for ( SizeValueType r = 0; r < rows; ++r )
+              {
+              const char *from = outPtr + ( y + r ) * rowLength + x * pixelLength;
+              std::copy(from, from + columns * pixelLength, tile.begin() + r * tileRowLength);
+              }
+            }
+          if ( TIFFWriteEncodedTile(tif, TIFFComputeTile(tif, x, y, 0, 0), tile.data(), tile.size()) < 0 )
+            {
+            itkExceptionMacro(<< "TIFFImageIO: error out of disk space");
+            }
+          }
+        }
+      if ( outPtr != nullptr )
+        {
+        outPtr += rowLength * height;
+        }
+      if ( m_NumberOfDimensions == 3 )
+        {
+        TIFFWriteDirectory(tif);
+        }
+      continue;
+      }
+
+    std::vector< char > zeroRow( outPtr == nullptr ? rowLength : 0 );
     int row = 0;
     for ( unsigned int idx2 = 0; idx2 < height; idx2++ )
       {
-      if ( TIFFWriteScanline(tif, const_cast< char * >( outPtr ), row, 0) < 0 )
+      char *scanline = ( outPtr == nullptr ) ? zeroRow.data() : const_cast< char * >( outPtr );
+      if ( TIFFWriteScanline(tif, scanline, row, 0) < 0 )
         {
         itkExceptionMacro(<< "TIFFImageIO: error out of disk space");
         }
-      outPtr += rowLength;
+      if ( outPtr != nullptr )
+        {
+        outPtr += rowLength;
+        }
       ++row;
       }
 
@@ -1217,24 +1523,14 @@ void TIFFImageIO::ReadCurrentPage(void *buffer, size_t pixelOffset)
 }
 
 template <typename TComponent>
-void TIFFImageIO::ReadGenericImage(void *_out,
-                                   unsigned int width,
-                                   unsigned int height)
+void TIFFImageIO::ReadGenericPages(void *_out, const std::vector< uint16_t > & directories,
+                                   const uint32_t start[2], const uint32_t size[2])
 {
   using ComponentType = TComponent;
 
-#ifdef TIFF_INT64_T // detect if libtiff4
-  uint64_t isize = TIFFScanlineSize64(m_InternalImage->m_Image);
-#else
-  tsize_t isize = TIFFScanlineSize(m_InternalImage->m_Image);
-#endif
-
-  size_t         inc;
-  tdata_t        buf = _TIFFmalloc(isize);
-  isize /= sizeof(ComponentType);
-
-  auto * out = static_cast< ComponentType* >( _out );
-  ComponentType *image;
+  TIFF *         tif = m_InternalImage->m_Image;
+  const uint32_t width = m_InternalImage->m_Width;
+  const uint32_t height = m_InternalImage->m_Height;
 
   if ( m_InternalImage->m_PlanarConfig != PLANARCONFIG_CONTIG
     && m_InternalImage->m_SamplesPerPixel != 1 )
@@ -1248,7 +1544,12 @@ void TIFFImageIO::ReadGenericImage(void *_out,
     itkExceptionMacro(<< "This reader can only do ORIENTATION_TOPLEFT and  ORIENTATION_BOTLEFT.");
     }
 
+  if ( start[0] + size[0] > width || start[1] + size[1] > height )
+    {
+    itkExceptionMacro(<< "The region to read is outside of the image in file: " << m_FileName);
+    }
 
+  size_t inc;
   switch ( this->GetFormat() )
     {
     case TIFFImageIO::GRAYSCALE:
@@ -1275,90 +1576,196 @@ void TIFFImageIO::ReadGenericImage(void *_out,
       break;
     }
 
-  for ( int row = 0; row < (int)height; ++row )
+  // The pages are divided into blocks, the tiles or the strips, which are
+  // decoded whole. The blocks holding the rows of the region are listed
+  // first, in the order of the file.
+  const bool     tiled = TIFFIsTiled(tif) != 0;
+  uint32_t       blockWidth = width;
+  uint32_t       blockHeight = height;
+  if ( tiled )
     {
-    if ( TIFFReadScanline(m_InternalImage->m_Image, buf, row, 0) <= 0 )
-      {
-      itkExceptionMacro(<< "Problem reading the row: " << row);
-      }
+    blockWidth = m_InternalImage->m_TileWidth;
+    blockHeight = m_InternalImage->m_TileHeight;
+    }
+  else
+    {
+    TIFFGetFieldDefaulted(tif, TIFFTAG_ROWSPERSTRIP, &blockHeight);
+    blockHeight = std::max(std::min(blockHeight, height), uint32_t{ 1 });
+    }
+  const size_t pixelSize = static_cast< size_t >( m_InternalImage->m_SamplesPerPixel )
+                           * ( m_InternalImage->m_BitsPerSample / 8 );
+  const size_t blockRowSize = blockWidth * pixelSize;
+  const uint32_t blocksAcross = ( width + blockWidth - 1 ) / blockWidth;
 
-    if ( m_InternalImage->m_Orientation == ORIENTATION_TOPLEFT )
-      {
-      image = out + (size_t) (row) * width * inc;
-      }
-    else // bottom left
+  // the rows of the region in the file
+  const bool     bottomLeft = m_InternalImage->m_Orientation == ORIENTATION_BOTLEFT;
+  const uint32_t firstRow = bottomLeft ? height - start[1] - size[1] : start[1];
+  const uint32_t endRow = firstRow + size[1];
+
+  struct Block
+  {
+    size_t   page;
+    uint32_t number;
+    uint32_t column;
+    uint32_t row;
+  };
+  std::vector< Block > blocks;
+  for ( size_t page = 0; page < directories.size(); ++page )
+    {
+    for ( uint32_t row = firstRow / blockHeight * blockHeight; row < endRow; row += blockHeight )
       {
-      image = out + (size_t) (width) * inc * ( height - ( row + 1 ) );
+      for ( uint32_t column = start[0] / blockWidth * blockWidth; column < start[0] + size[0]; column += blockWidth )
+        {
+        blocks.push_back( { page, row / blockHeight * blocksAcross + column / blockWidth, column, row } );
+        }
       }
+    }
 
-    switch ( this->GetFormat() )
-      {
-      case TIFFImageIO::GRAYSCALE:
-        // check inverted
-        PutGrayscale<ComponentType>(image, static_cast< ComponentType * >( buf ), width, 1, 0, 0);
-        break;
-      case TIFFImageIO::RGB_:
-        PutRGB_<ComponentType>(image, static_cast< ComponentType * >( buf ), width, 1, 0, 0);
-        break;
+  const size_t pageSize = static_cast< size_t >( size[0] ) * size[1] * inc;
+  auto * out = static_cast< ComponentType * >( _out );
 
-      case TIFFImageIO::PALETTE_GRAYSCALE:
-        switch ( m_InternalImage->m_BitsPerSample )
+  // Decodes the blocks from first to last with the file handle, and copies
+  // the pixels of the region they hold to the output.
+  const auto readBlocks = [&]( TIFF * handle, size_t first, size_t last, bool initializeColors ) -> bool
+    {
+    const tmsize_t blockSize = tiled ? TIFFTileSize(handle) : TIFFStripSize(handle);
+    std::vector< char > decoded( static_cast< size_t >( std::max(blockSize, tmsize_t{ 0 }) ) );
+    for ( size_t b = first; b < last; ++b )
+      {
+      const Block & block = blocks[b];
+      if ( TIFFCurrentDirectory(handle) != directories[block.page] )
+        {
+        if ( !TIFFSetDirectory(handle, directories[block.page]) )
           {
-          case 8:
-            PutPaletteGrayscale<ComponentType, unsigned char>(image, static_cast< unsigned char * >( buf ), width, 1, 0, 0);
-            break;
-          case 16:
-            PutPaletteGrayscale<ComponentType, unsigned short>(image, static_cast< unsigned short * >( buf ), width, 1, 0, 0);
-            break;
-          default:
-            itkExceptionMacro(<<  "Sorry, can not handle image with "
-                              << m_InternalImage->m_BitsPerSample
-                              << "-bit samples with palette.");
+          return false;
           }
-        break;
-      case TIFFImageIO::PALETTE_RGB:
-        if ( !this->GetIsReadAsScalarPlusPalette() )
+        if ( initializeColors )
           {
-          switch ( m_InternalImage->m_BitsPerSample )
-            {
-            case 8:
-              PutPaletteRGB<ComponentType, unsigned char>(image, static_cast< unsigned char * >( buf ), width, 1, 0, 0);
-              break;
-            case 16:
-              PutPaletteRGB<ComponentType, unsigned short>(image, static_cast< unsigned short * >( buf ), width, 1, 0, 0);
-              break;
-            default:
-              itkExceptionMacro(<<  "Sorry, can not handle image with "
-                                << m_InternalImage->m_BitsPerSample
-                                << "-bit samples with palette.");
-            }
+          this->InitializeColors();
           }
-        else
-          {
-          switch ( m_InternalImage->m_BitsPerSample )
-            {
-            case 8:
-               PutPaletteScalar<ComponentType, unsigned char>(image, static_cast< unsigned char * >( buf ), width, 1, 0, 0);
-              break;
-            case 16:
-               PutPaletteScalar<ComponentType, unsigned short>(image, static_cast< unsigned short * >( buf ), width, 1, 0, 0);
-              break;
-            default:
-              itkExceptionMacro(<<  "Sorry, can not handle image with "
-                                << m_InternalImage->m_BitsPerSample
-                                << "-bit samples with palette.");
-            }
+        }
+      const tmsize_t decodedSize = tiled
+        ? TIFFReadEncodedTile(handle, block.number, decoded.data(), blockSize)
+        : TIFFReadEncodedStrip(handle, block.number, decoded.data(), blockSize);
+      if ( decodedSize < 0 )
+        {
+        return false;
+        }
 
+      const uint32_t column = std::max(block.column, start[0]);
+      const uint32_t columns = std::min(block.column + blockWidth, start[0] + size[0]) - column;
+      const uint32_t lastRow = std::min( { block.row + blockHeight, endRow, height } );
+      for ( uint32_t row = std::max(block.row, firstRow); row < lastRow; ++row )
+        {
+        if ( static_cast< size_t >( row - block.row + 1 ) * blockRowSize > static_cast< size_t >( decodedSize ) )
+          {
+          return false;
           }
-        break;
+        char * from = decoded.data() + ( row - block.row ) * blockRowSize + ( column - block.column ) * pixelSize;
+        const uint32_t imageRow = bottomLeft ? height - 1 - row : row;
+        ComponentType * image = out + block.page * pageSize
+                                + ( static_cast< size_t >( imageRow - start[1] ) * size[0] + ( column - start[0] ) ) * inc;
 
-      default:
-        itkExceptionMacro("Logic Error: Unexpected format!");
+        switch ( this->GetFormat() )
+          {
+          case TIFFImageIO::GRAYSCALE:
+            PutGrayscale<ComponentType>(image, reinterpret_cast< ComponentType * >( from ), columns, 1, 0, 0);
+            break;
+          case TIFFImageIO::RGB_:
+            PutRGB_<ComponentType>(image, reinterpret_cast< ComponentType * >( from ), columns, 1, 0, 0);
+            break;
+          case TIFFImageIO::PALETTE_GRAYSCALE:
+            if ( m_InternalImage->m_BitsPerSample == 8 )
+              {
+              PutPaletteGrayscale<ComponentType, unsigned char>(image, reinterpret_cast< unsigned char * >( from ), columns, 1, 0, 0);
+              }
+            else
+              {
+              PutPaletteGrayscale<ComponentType, unsigned short>(image, reinterpret_cast< unsigned short * >( from ), columns, 1, 0, 0);
+              }
+            break;
+          case TIFFImageIO::PALETTE_RGB:
+            if ( !this->GetIsReadAsScalarPlusPalette() )
+              {
+              if ( m_InternalImage->m_BitsPerSample == 8 )
+                {
+                PutPaletteRGB<ComponentType, unsigned char>(image, reinterpret_cast< unsigned char * >( from ), columns, 1, 0, 0);
+                }
+              else
+                {
+                PutPaletteRGB<ComponentType, unsigned short>(image, reinterpret_cast< unsigned short * >( from ), columns, 1, 0, 0);
+                }
+              }
+            else
+              {
+              if ( m_InternalImage->m_BitsPerSample == 8 )
+                {
+                PutPaletteScalar<ComponentType, unsigned char>(image, reinterpret_cast< unsigned char * >( from ), columns, 1, 0, 0);
+                }
+              else
+                {
+                PutPaletteScalar<ComponentType, unsigned short>(image, reinterpret_cast< unsigned short * >( from ), columns, 1, 0, 0);
+                }
+              }
+            break;
+          default:
+            return false;
+          }
+        }
       }
+    return true;
+    };
 
+  const unsigned int format = this->GetFormat();
+  if ( ( format == TIFFImageIO::PALETTE_GRAYSCALE || format == TIFFImageIO::PALETTE_RGB )
+       && m_InternalImage->m_BitsPerSample != 8 && m_InternalImage->m_BitsPerSample != 16 )
+    {
+    itkExceptionMacro(<<  "Sorry, can not handle image with "
+                      << m_InternalImage->m_BitsPerSample
+                      << "-bit samples with palette.");
     }
 
-  _TIFFfree(buf);
+  // The blocks are decoded in parallel, each work unit opening the file,
+  // except for palette images whose colors are those of the current page.
+  MultiThreaderBase::Pointer multiThreader = MultiThreaderBase::New();
+  const size_t numberOfChunks = std::min(blocks.size(), static_cast< size_t >( multiThreader->GetNumberOfWorkUnits() ));
+  const uint16_t currentDirectory = TIFFCurrentDirectory(tif);
+  bool succeeded = true;
+  if ( numberOfChunks <= 1 || format == TIFFImageIO::PALETTE_GRAYSCALE || format == TIFFImageIO::PALETTE_RGB )
+    {
+    succeeded = readBlocks(tif, 0, blocks.size(), true);
+    if ( TIFFCurrentDirectory(tif) != currentDirectory )
+      {
+      TIFFSetDirectory(tif, currentDirectory);
+      this->InitializeColors();
+      }
+    }
+  else
+    {
+    std::atomic< bool > failed( false );
+    multiThreader->ParallelizeArray(
+      0,
+      numberOfChunks,
+      [&](SizeValueType chunk)
+      {
+        TIFF *handle = TIFFOpen(m_FileName.c_str(), "r");
+        if ( handle == nullptr
+             || !readBlocks(handle, blocks.size() * chunk / numberOfChunks, blocks.size() * ( chunk + 1 ) / numberOfChunks, false) )
+          {
+          failed = true;
+          }
+        if ( handle != nullptr )
+          {
+          TIFFClose(handle);
+          }
+      },
+      nullptr);
+    succeeded = !failed;
+    }
+  if ( !succeeded )
+    {
+    itkExceptionMacro(<< "Problem reading the strips or tiles of " << m_FileName);
+    }
 }
 
 // iso component scalar
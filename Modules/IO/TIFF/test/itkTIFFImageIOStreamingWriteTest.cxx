@@ -0,0 +1,165 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+#include "itkImageAlgorithm.h"
+#include "itkImageFileReader.h"
+#include "itkImageFileWriter.h"
+#include "itkImageRegionIteratorWithIndex.h"
+#include "itkRGBPixel.h"
+#include "itkTIFFImageIO.h"
+#include "itkTestingMacros.h"
+
+/* Streams images into TIFF files, pastes regions of other images into
+ * them, and checks that compressed files can only be written whole. The
+ * test driver compares the files with the expected images written whole.
+ */
+
+namespace
+{
+template< typename TImage >
+int
+WriteWhole( const TImage * image, const std::string & fileName )
+{
+  using WriterType = itk::ImageFileWriter< TImage >;
+  typename WriterType::Pointer writer = WriterType::New();
+  writer->SetInput( image );
+  writer->SetFileName( fileName );
+  TRY_EXPECT_NO_EXCEPTION( writer->Update() );
+  return EXIT_SUCCESS;
+}
+
+template< typename TImage >
+int
+StreamAndPaste( const TImage * image, const TImage * otherImage, const std::string & baseName )
+{
+  using WriterType = itk::ImageFileWriter< TImage >;
+  const typename TImage::RegionType largestRegion = image->GetLargestPossibleRegion();
+
+  itk::TIFFImageIO::Pointer tiffIO = itk::TIFFImageIO::New();
+  TEST_EXPECT_TRUE( tiffIO->CanStreamWrite() );
+
+  TEST_EXPECT_EQUAL( WriteWhole< TImage >( image, baseName + "Reference.tif" ), EXIT_SUCCESS );
+
+  typename WriterType::Pointer writer = WriterType::New();
+  writer->SetInput( image );
+  writer->SetImageIO( tiffIO );
+  writer->SetNumberOfStreamDivisions( 5 );
+  writer->SetFileName( baseName + ".tif" );
+  TRY_EXPECT_NO_EXCEPTION( writer->Update() );
+  writer->SetFileName( baseName + "Pasted.tif" );
+  TRY_EXPECT_NO_EXCEPTION( writer->Update() );
+
+  typename TImage::RegionType pasteRegion = largestRegion;
+  for ( unsigned int i = 0; i < TImage::ImageDimension; ++i )
+    {
+    pasteRegion.SetIndex( i, 1 + i );
+    pasteRegion.SetSize( i, largestRegion.GetSize( i ) / 2 );
+    }
+  itk::ImageIORegion pasteIORegion( TImage::ImageDimension );
+  itk::ImageIORegionAdaptor< TImage::ImageDimension >::Convert( pasteRegion, pasteIORegion,
+                                                                largestRegion.GetIndex() );
+
+  // only the paste region of the other image is buffered, as a streamed
+  // pipeline would provide it
+  typename TImage::Pointer pasteImage = TImage::New();
+  pasteImage->SetLargestPossibleRegion( largestRegion );
+  pasteImage->SetBufferedRegion( pasteRegion );
+  pasteImage->SetRequestedRegion( pasteRegion );
+  pasteImage->Allocate();
+  itk::ImageAlgorithm::Copy( otherImage, pasteImage.GetPointer(), pasteRegion, pasteRegion );
+
+  typename WriterType::Pointer pasteWriter = WriterType::New();
+  pasteWriter->SetInput( pasteImage );
+  pasteWriter->SetFileName( baseName + "Pasted.tif" );
+  pasteWriter->SetImageIO( tiffIO );
+  pasteWriter->SetIORegion( pasteIORegion );
+  pasteWriter->SetNumberOfStreamDivisions( 2 );
+  TRY_EXPECT_NO_EXCEPTION( pasteWriter->Update() );
+  TEST_EXPECT_EQUAL( pasteImage->GetBufferedRegion(), pasteRegion );
+
+  typename TImage::Pointer pastedImage = TImage::New();
+  pastedImage->SetRegions( largestRegion );
+  pastedImage->Allocate();
+  itk::ImageAlgorithm::Copy( image, pastedImage.GetPointer(), largestRegion, largestRegion );
+  itk::ImageAlgorithm::Copy( otherImage, pastedImage.GetPointer(), pasteRegion, pasteRegion );
+  TEST_EXPECT_EQUAL( WriteWhole< TImage >( pastedImage, baseName + "PastedReference.tif" ), EXIT_SUCCESS );
+
+  tiffIO->SetCompressionToPackBits();
+  TEST_EXPECT_TRUE( !tiffIO->CanStreamWrite() );
+  pasteWriter->SetUseCompression( true );
+  TRY_EXPECT_EXCEPTION( pasteWriter->Update() );
+
+  return EXIT_SUCCESS;
+}
+}
+
+int itkTIFFImageIOStreamingWriteTest( int argc, char* argv[] )
+{
+  if ( argc < 2 )
+    {
+    std::cerr << "Missing parameters." << std::endl;
+    std::cerr << "Usage: " << argv[0] << " OutputDirectory" << std::endl;
+    return EXIT_FAILURE;
+    }
+  const std::string outputDirectory = argv[1];
+
+  using ImageType = itk::Image< short, 3 >;
+  ImageType::SizeType size = { { 37, 29, 11 } };
+  ImageType::Pointer image = ImageType::New();
+  ImageType::Pointer otherImage = ImageType::New();
+  image->SetRegions( size );
+  image->Allocate();
+  otherImage->SetRegions( size );
+  otherImage->Allocate();
+  itk::ImageRegionIteratorWithIndex< ImageType > it( image, image->GetLargestPossibleRegion() );
+  for ( ; !it.IsAtEnd(); ++it )
+    {
+    const ImageType::IndexType index = it.GetIndex();
+    it.Set( static_cast< short >( index[0] + 100 * index[1] - 300 * index[2] ) );
+    otherImage->SetPixel( index, static_cast< short >( -it.Get() - 1 ) );
+    }
+
+  using RGBImageType = itk::Image< itk::RGBPixel< unsigned char >, 2 >;
+  RGBImageType::SizeType rgbSize = { { 41, 27 } };
+  RGBImageType::Pointer rgbImage = RGBImageType::New();
+  RGBImageType::Pointer otherRGBImage = RGBImageType::New();
+  rgbImage->SetRegions( rgbSize );
+  rgbImage->Allocate();
+  otherRGBImage->SetRegions( rgbSize );
+  otherRGBImage->Allocate();
+  itk::ImageRegionIteratorWithIndex< RGBImageType > rit( rgbImage, rgbImage->GetLargestPossibleRegion() );
+  for ( ; !rit.IsAtEnd(); ++rit )
+    {
+    const RGBImageType::IndexType index = rit.GetIndex();
+    RGBImageType::PixelType value;
+    value[0] = static_cast< unsigned char >( index[0] );
+    value[1] = static_cast< unsigned char >( index[1] * 3 );
+    value[2] = static_cast< unsigned char >( index[0] + index[1] );
+    rit.Set( value );
+    value[2] = 255;
+    otherRGBImage->SetPixel( index, value );
+    }
+
+  TEST_EXPECT_EQUAL( StreamAndPaste< ImageType >( image, otherImage, outputDirectory + "/TIFFStreamingWrite" ),
+                     EXIT_SUCCESS );
+  TEST_EXPECT_EQUAL( StreamAndPaste< RGBImageType >( rgbImage, otherRGBImage,
+                                                     outputDirectory + "/TIFFStreamingWriteRGB" ), EXIT_SUCCESS );
+
+  std::cout << "Test finished." << std::endl;
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,225 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+#include "itkImageFileReader.h"
+#include "itkImageFileWriter.h"
+#include "itkImageRegionConstIteratorWithIndex.h"
+#include "itkImageRegionIteratorWithIndex.h"
+#include "itkRGBPixel.h"
+#include "itkTIFFImageIO.h"
+#include "itkTestingMacros.h"
+#include "itksys/SystemTools.hxx"
+
+/* Writes images in tiles, and reads regions of them back. The test driver
+ * compares the tiled files with the images written in strips.
+ */
+
+namespace
+{
+// Reads the region of the file and checks that only the region is read,
+// with the pixels of the image.
+template< typename TImage >
+int
+CheckRegion( const std::string & fileName, const TImage * image, const typename TImage::RegionType & region )
+{
+  using ReaderType = itk::ImageFileReader< TImage >;
+  typename ReaderType::Pointer reader = ReaderType::New();
+  reader->SetFileName( fileName );
+  reader->SetImageIO( itk::TIFFImageIO::New() );
+  reader->UseStreamingOn();
+  reader->GetOutput()->SetRequestedRegion( region );
+  TRY_EXPECT_NO_EXCEPTION( reader->Update() );
+  TEST_EXPECT_TRUE( reader->GetImageIO()->CanStreamRead() );
+  TEST_EXPECT_EQUAL( reader->GetOutput()->GetBufferedRegion(), region );
+
+  itk::ImageRegionConstIteratorWithIndex< TImage > it( reader->GetOutput(), region );
+  for ( ; !it.IsAtEnd(); ++it )
+    {
+    TEST_EXPECT_EQUAL( it.Get(), image->GetPixel( it.GetIndex() ) );
+    }
+  return EXIT_SUCCESS;
+}
+
+// Writes the image in tiles, and reads it back by a region that crosses the
+// tiles, and by a region of a single row.
+template< typename TImage >
+int
+WriteAndReadTiles( const TImage * image, const std::string & fileName, unsigned int tileSize,
+                   bool useBigTIFF, bool useCompression )
+{
+  itk::TIFFImageIO::Pointer tiffIO = itk::TIFFImageIO::New();
+  tiffIO->SetTileWidth( tileSize );
+  tiffIO->SetTileHeight( tileSize );
+  tiffIO->SetUseBigTIFF( useBigTIFF );
+  tiffIO->SetCompressionToDeflate();
+
+  using WriterType = itk::ImageFileWriter< TImage >;
+  typename WriterType::Pointer writer = WriterType::New();
+  writer->SetInput( image );
+  writer->SetFileName( fileName );
+  writer->SetImageIO( tiffIO );
+  writer->SetUseCompression( useCompression );
+  TRY_EXPECT_NO_EXCEPTION( writer->Update() );
+
+  const typename TImage::RegionType largestRegion = image->GetLargestPossibleRegion();
+  typename TImage::RegionType region = largestRegion;
+  region.SetIndex( 0, 3 );
+  region.SetSize( 0, largestRegion.GetSize( 0 ) / 2 );
+  region.SetIndex( 1, 14 );
+  region.SetSize( 1, 20 );
+  TEST_EXPECT_EQUAL( CheckRegion< TImage >( fileName, image, region ), EXIT_SUCCESS );
+
+  region.SetIndex( 1, largestRegion.GetSize( 1 ) - 1 );
+  region.SetSize( 1, 1 );
+  if ( TImage::ImageDimension > 2 )
+    {
+    region.SetIndex( 2, 1 );
+    region.SetSize( 2, 2 );
+    }
+  TEST_EXPECT_EQUAL( CheckRegion< TImage >( fileName, image, region ), EXIT_SUCCESS );
+  return EXIT_SUCCESS;
+}
+
+template< typename TImage >
+int
+WriteStrips( const TImage * image, const std::string & fileName )
+{
+  using WriterType = itk::ImageFileWriter< TImage >;
+  typename WriterType::Pointer writer = WriterType::New();
+  writer->SetInput( image );
+  writer->SetFileName( fileName );
+  TRY_EXPECT_NO_EXCEPTION( writer->Update() );
+  return EXIT_SUCCESS;
+}
+}
+
+int itkTIFFImageIOTiledTest( int argc, char* argv[] )
+{
+  if ( argc < 2 )
+    {
+    std::cerr << "Missing parameters." << std::endl;
+    std::cerr << "Usage: " << argv[0] << " OutputDirectory" << std::endl;
+    return EXIT_FAILURE;
+    }
+  const std::string outputDirectory = argv[1];
+
+  itk::TIFFImageIO::Pointer tiffIO = itk::TIFFImageIO::New();
+  TEST_SET_GET_VALUE( 0u, tiffIO->GetTileWidth() );
+  TEST_SET_GET_VALUE( 0u, tiffIO->GetTileHeight() );
+  TEST_SET_GET_BOOLEAN( tiffIO, UseBigTIFF, false );
+  tiffIO->UseBigTIFFOn();
+  TEST_SET_GET_BOOLEAN( tiffIO, UseBigTIFF, true );
+  tiffIO->SetTileWidth( 32 );
+  TEST_SET_GET_VALUE( 32u, tiffIO->GetTileWidth() );
+  tiffIO->SetTileHeight( 48 );
+  TEST_SET_GET_VALUE( 48u, tiffIO->GetTileHeight() );
+
+  using ImageType = itk::Image< short, 3 >;
+  ImageType::SizeType size = { { 75, 53, 4 } };
+  ImageType::Pointer image = ImageType::New();
+  image->SetRegions( size );
+  image->Allocate();
+  itk::ImageRegionIteratorWithIndex< ImageType > it( image, image->GetLargestPossibleRegion() );
+  for ( ; !it.IsAtEnd(); ++it )
+    {
+    const ImageType::IndexType index = it.GetIndex();
+    it.Set( static_cast< short >( index[0] + 100 * index[1] - 300 * index[2] ) );
+    }
+
+  using RGBImageType = itk::Image< itk::RGBPixel< unsigned char >, 2 >;
+  RGBImageType::SizeType rgbSize = { { 41, 67 } };
+  RGBImageType::Pointer rgbImage = RGBImageType::New();
+  rgbImage->SetRegions( rgbSize );
+  rgbImage->Allocate();
+  itk::ImageRegionIteratorWithIndex< RGBImageType > rit( rgbImage, rgbImage->GetLargestPossibleRegion() );
+  for ( ; !rit.IsAtEnd(); ++rit )
+    {
+    const RGBImageType::IndexType index = rit.GetIndex();
+    RGBImageType::PixelType value;
+    value[0] = static_cast< unsigned char >( index[0] );
+    value[1] = static_cast< unsigned char >( index[1] * 3 );
+    value[2] = static_cast< unsigned char >( index[0] + index[1] );
+    rit.Set( value );
+    }
+
+  TEST_EXPECT_EQUAL( WriteStrips< ImageType >( image, outputDirectory + "/TIFFStrips.tif" ), EXIT_SUCCESS );
+  TEST_EXPECT_EQUAL( WriteStrips< RGBImageType >( rgbImage, outputDirectory + "/TIFFStripsRGB.tif" ), EXIT_SUCCESS );
+
+  TEST_EXPECT_EQUAL( WriteAndReadTiles< ImageType >( image, outputDirectory + "/TIFFTiled.tif", 16, false, false ),
+                     EXIT_SUCCESS );
+  TEST_EXPECT_EQUAL( WriteAndReadTiles< ImageType >( image, outputDirectory + "/TIFFTiledBig.tif", 32, true, true ),
+                     EXIT_SUCCESS );
+  TEST_EXPECT_EQUAL( WriteAndReadTiles< RGBImageType >( rgbImage, outputDirectory + "/TIFFTiledRGB.tif", 16, true,
+                                                        false ), EXIT_SUCCESS );
+  // the strips of an image written without tiles are read the same way
+  TEST_EXPECT_EQUAL( WriteAndReadTiles< RGBImageType >( rgbImage, outputDirectory + "/TIFFStripsCompressedRGB.tif", 0,
+                                                        false, true ), EXIT_SUCCESS );
+
+  // a region of an uncompressed tiled file can be pasted, and the writer
+  // would write the whole of a fully buffered image
+  using WriterType = itk::ImageFileWriter< ImageType >;
+  ImageType::RegionType pasteRegion( { { 5, 9, 1 } }, { { 40, 30, 2 } } );
+  ImageType::Pointer pasteImage = ImageType::New();
+  pasteImage->SetLargestPossibleRegion( image->GetLargestPossibleRegion() );
+  pasteImage->SetBufferedRegion( pasteRegion );
+  pasteImage->SetRequestedRegion( pasteRegion );
+  pasteImage->Allocate();
+  pasteImage->FillBuffer( -7 );
+  itk::ImageIORegion pasteIORegion( 3 );
+  itk::ImageIORegionAdaptor< 3 >::Convert( pasteRegion, pasteIORegion, image->GetLargestPossibleRegion().GetIndex() );
+  tiffIO = itk::TIFFImageIO::New();
+  tiffIO->SetTileWidth( 16 );
+  tiffIO->SetTileHeight( 16 );
+  WriterType::Pointer pasteWriter = WriterType::New();
+  pasteWriter->SetInput( pasteImage );
+  pasteWriter->SetImageIO( tiffIO );
+  pasteWriter->SetIORegion( pasteIORegion );
+  pasteWriter->SetNumberOfStreamDivisions( 2 );
+  pasteWriter->SetFileName( outputDirectory + "/TIFFTiled.tif" );
+  TRY_EXPECT_NO_EXCEPTION( pasteWriter->Update() );
+
+  // pasting into a new file first writes a file of zeros
+  pasteWriter->SetFileName( outputDirectory + "/TIFFTiledPaste.tif" );
+  itksys::SystemTools::RemoveFile( outputDirectory + "/TIFFTiledPaste.tif" );
+  TRY_EXPECT_NO_EXCEPTION( pasteWriter->Update() );
+
+  ImageType::Pointer zeroImage = ImageType::New();
+  zeroImage->SetRegions( size );
+  zeroImage->Allocate( true );
+  for ( it.GoToBegin(); !it.IsAtEnd(); ++it )
+    {
+    if ( pasteRegion.IsInside( it.GetIndex() ) )
+      {
+      it.Set( -7 );
+      zeroImage->SetPixel( it.GetIndex(), -7 );
+      }
+    }
+  TEST_EXPECT_EQUAL( WriteStrips< ImageType >( image, outputDirectory + "/TIFFStripsPasted.tif" ), EXIT_SUCCESS );
+  TEST_EXPECT_EQUAL( WriteStrips< ImageType >( zeroImage, outputDirectory + "/TIFFStripsPaste.tif" ), EXIT_SUCCESS );
+
+  // the tiles must be multiples of 16
+  tiffIO->SetTileWidth( 10 );
+  WriterType::Pointer writer = WriterType::New();
+  writer->SetInput( image );
+  writer->SetFileName( outputDirectory + "/TIFFTiledInvalid.tif" );
+  writer->SetImageIO( tiffIO );
+  TRY_EXPECT_EXCEPTION( writer->Update() );
+
+  std::cout << "Test finished." << std::endl;
+  return EXIT_SUCCESS;
+}
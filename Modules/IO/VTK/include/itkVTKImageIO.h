@@ -87,6 +87,10 @@ public:
   /** Reads the data from disk into the memory buffer provided. */
   void Read(void *buffer) override;
 
+  /** The pixel data can be memory mapped if it is binary, and either made
+   * of bytes or read on a big endian system. */
+  bool GetPixelDataLocation(std::string & fileName, SizeValueType & offset) override;
+
   /*-------- This part of the interfaces deals with writing data. ----- */
 
   /** Determine the file type. Returns true if this ImageIO can read the
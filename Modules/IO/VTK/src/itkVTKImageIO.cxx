@@ -112,6 +112,20 @@ bool VTKImageIO::CanStreamRead()
   return canStreamRead;
 }
 
+bool VTKImageIO::GetPixelDataLocation(std::string & fileName, SizeValueType & offset)
+{
+  // binary data is stored big endian
+  if ( !this->CanStreamRead()
+       || this->GetHeaderSize() == 0
+       || ( this->GetComponentSize() > 1 && !ByteSwapper< uint16_t >::SystemIsBigEndian() ) )
+    {
+    return false;
+    }
+  fileName = m_FileName;
+  offset = this->GetHeaderSize();
+  return true;
+}
+
 bool VTKImageIO::CanStreamWrite()
 {
   bool canStreamWrite = true;
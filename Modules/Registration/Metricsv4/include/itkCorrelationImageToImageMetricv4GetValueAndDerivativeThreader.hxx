@@ -204,7 +204,8 @@ CorrelationImageToImageMetricv4GetValueAndDerivativeThreader<TDomainPartitioner,
 
   try
     {
-    pointIsValid = this->m_CorrelationAssociate->TransformAndEvaluateMovingPoint( virtualPoint, mappedMovingPoint, mappedMovingPixelValue );
+    pointIsValid = this->m_CorrelationAssociate->TransformAndEvaluateMovingPoint( virtualPoint, mappedMovingPoint, mappedMovingPixelValue,
+      this->m_GetValueAndDerivativePerThreadVariables[threadId].SampleIdentifier );
     if( pointIsValid &&
         this->m_CorrelationAssociate->GetComputeDerivative() &&
         this->m_CorrelationAssociate->GetGradientSourceIncludesMoving() )
@@ -295,10 +296,7 @@ CorrelationImageToImageMetricv4GetValueAndDerivativeThreader<TDomainPartitioner,
     JacobianReferenceType jacobianPositional = this->m_GetValueAndDerivativePerThreadVariables[threadId].MovingTransformJacobianPositional;
 
     /** For dense transforms, this returns identity */
-    this->m_CorrelationAssociate->GetMovingTransform()->
-      ComputeJacobianWithRespectToParametersCachedTemporaries(virtualPoint,
-                                                              jacobian,
-                                                              jacobianPositional);
+    this->ComputeMovingTransformJacobian( virtualPoint, jacobian, jacobianPositional, threadId );
 
     for (unsigned int par = 0; par < this->m_CorrelationAssociate->GetNumberOfLocalParameters(); par++)
       {
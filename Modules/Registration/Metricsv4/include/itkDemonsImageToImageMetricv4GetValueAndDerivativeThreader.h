@@ -68,7 +68,9 @@ public:
 protected:
   DemonsImageToImageMetricv4GetValueAndDerivativeThreader() :
     m_DemonsAssociate(nullptr)
-  {}
+  {
+    this->m_TransformsMovingPointsInBatches = true;
+  }
 
   /** Overload.
    *  Get pointer to metric object.
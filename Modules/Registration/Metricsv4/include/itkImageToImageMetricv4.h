@@ -18,6 +18,8 @@
 #ifndef itkImageToImageMetricv4_h
 #define itkImageToImageMetricv4_h
 
+#include "itkBSplineTransform.h"
+#include "itkCompositeTransform.h"
 #include "itkCovariantVector.h"
 #include "itkImageFunction.h"
 #include "itkObjectToObjectMetric.h"
@@ -108,6 +110,28 @@ namespace itk
  * use a gradient image filter for it because it will only be
  * calculated once.
  *
+ * B-spline Weights Caching
+ *
+ * When the moving transform is a third order BSplineTransform, or a
+ * CompositeTransform which applies such a transform first and only
+ * optimizes it, as the one of ImageRegistrationMethodv4, the
+ * interpolation weights of the B-spline transform at each virtual domain
+ * sample depend only on the sample and the transform grid. With
+ * SetUseCachingOfBSplineWeights, they are computed once, together with
+ * the start index of their support region, and reused to transform the
+ * sample and compute the Jacobian in every later evaluation, until
+ * Initialize() is called again, a new virtual sampled point set is set or
+ * the fixed parameters of the B-spline transform change.
+ * SetMaximumNumberOfBSplineWeightsCachePoints bounds the memory used by
+ * the cache.
+ *
+ * The Jacobian of such a transform is only non-zero for the parameters in
+ * the support region of the point. The threaders of the metrics which
+ * support it, e.g. MeanSquaresImageToImageMetricv4, then only compute and
+ * accumulate the derivatives of these parameters, and each thread only
+ * stores the sums of the parameters it touches instead of a copy of the
+ * whole derivative.
+ *
  * Vector Images
  *
  * To support vector images, the class must be declared using the
@@ -416,8 +440,9 @@ public:
   itkSetConstObjectMacro(FixedSampledPointSet, FixedSampledPointSetType);
   itkGetConstObjectMacro(FixedSampledPointSet, FixedSampledPointSetType);
 
-  /** Set/Get the virtual image domain sampling point set */
-  itkSetObjectMacro(VirtualSampledPointSet, VirtualPointSetType);
+  /** Set/Get the virtual image domain sampling point set. The samples may
+   * be replaced between evaluations without calling Initialize(). */
+  virtual void SetVirtualSampledPointSet( VirtualPointSetType * pointSet );
   itkGetConstObjectMacro(VirtualSampledPointSet, VirtualPointSetType);
 
   /** Set/Get flag to use a domain sampling point set */
@@ -554,6 +579,20 @@ public:
   itkSetMacro( FloatingPointCorrectionResolution, DerivativeValueType );
   itkGetConstMacro( FloatingPointCorrectionResolution, DerivativeValueType );
 
+  /** Set/Get the option for caching the interpolation weights of the moving
+   * transform at the virtual domain samples, when it is a third order
+   * BSplineTransform. False by default. See the main documentation. */
+  itkSetMacro(UseCachingOfBSplineWeights, bool);
+  itkGetConstReferenceMacro(UseCachingOfBSplineWeights, bool);
+  itkBooleanMacro(UseCachingOfBSplineWeights);
+
+  /** Set/Get the maximum number of virtual domain samples whose B-spline
+   * weights are cached. Each sample takes (SplineOrder + 1)^Dimension weights
+   * and a grid index. The weights of the samples beyond this number are
+   * evaluated as usual. Default is 262144. */
+  itkSetMacro(MaximumNumberOfBSplineWeightsCachePoints, SizeValueType);
+  itkGetConstMacro(MaximumNumberOfBSplineWeightsCachePoints, SizeValueType);
+
   /* Initialize the metric before calling GetValue or GetDerivative.
    * Derived classes must call this Superclass version if they override
    * this to perform their own initialization.
@@ -632,11 +671,76 @@ protected:
                          FixedImagePointType & mappedFixedPoint,
                          FixedImagePixelType & mappedFixedPixelValue ) const;
 
-  /** Transform and evaluate a point from VirtualImage domain to MovingImage domain. */
+  /** Transform and evaluate a point from VirtualImage domain to MovingImage domain.
+   * \c sampleIdentifier is the offset of the point in the virtual region for
+   * dense sampling, or its identifier in the virtual sampled point set for
+   * sparse sampling. It is used to look up the cached B-spline weights of the
+   * point; the default value means the point is not a sample. */
   bool TransformAndEvaluateMovingPoint(
                          const VirtualPointType & virtualPoint,
                          MovingImagePointType & mappedMovingPoint,
-                         MovingImagePixelType & mappedMovingPixelValue ) const;
+                         MovingImagePixelType & mappedMovingPixelValue,
+                         SizeValueType sampleIdentifier = NumericTraits< SizeValueType >::max() ) const;
+
+  /** Transform a batch of points from VirtualImage domain to MovingImage
+   * domain in place, as TransformAndEvaluateMovingPoint does for each of
+   * them. The points are the consecutive samples \c firstSampleIdentifier
+   * and on. The points whose B-spline weights are not cached are transformed
+   * with one TransformPoints call of the moving transform. */
+  void TransformMovingPoints( MovingOutputPointType * points,
+                              SizeValueType numberOfPoints,
+                              SizeValueType firstSampleIdentifier ) const;
+
+  /** Evaluate the moving image at a point mapped by TransformMovingPoints.
+   * The point is checked against the moving image mask and buffer as in
+   * TransformAndEvaluateMovingPoint, which returns the same validity. */
+  bool EvaluateMovingPoint( const MovingImagePointType & mappedMovingPoint,
+                            MovingImagePixelType & mappedMovingPixelValue ) const;
+
+  /** Compute the Jacobian of the moving transform with respect to its
+   * parameters at a virtual point, using the cached B-spline weights of the
+   * sample \c sampleIdentifier when they are available.
+   * \sa TransformAndEvaluateMovingPoint */
+  void ComputeMovingTransformJacobian( const VirtualPointType & virtualPoint,
+                                       JacobianType & jacobian,
+                                       JacobianType & jacobianPositional,
+                                       SizeValueType sampleIdentifier ) const;
+
+  /** Types of a moving CompositeTransform, and of its transforms. */
+  using MovingCompositeTransformType = CompositeTransform< TInternalComputationValueType, MovingImageDimension >;
+  using MovingCompositeTransformBaseType = typename MovingCompositeTransformType::TransformType;
+  using MovingJacobianPositionType = typename MovingCompositeTransformBaseType::JacobianPositionType;
+
+  /** Find the B-spline transform whose weights are cached, and whose
+   * derivatives the threaders accumulate sparsely: the moving
+   * transform if it is a third order BSplineTransform, or the first applied
+   * (last to be added) transform of a moving CompositeTransform if it is such
+   * a BSplineTransform and the only transform the composite optimizes, as in
+   * ImageRegistrationMethodv4. Called by InitializeForIteration.
+   * \sa m_MovingBSplineTransform */
+  void UpdateMovingBSplineTransform() const;
+
+  /** Transform a virtual point with the cached B-spline weights of the
+   * sample \c sampleIdentifier, then through the transforms the moving
+   * composite transform applies after the B-spline transform. */
+  MovingOutputPointType TransformPointWithCachedBSplineWeights( const MovingOutputPointType & virtualPoint,
+                                                                SizeValueType sampleIdentifier ) const;
+
+  /** Map a point mapped by m_MovingBSplineTransform through the transforms
+   * the moving composite transform applies after it. If
+   * \c jacobianWithRespectToPosition is not nullptr, it is set to the
+   * Jacobian of these transforms with respect to the position at the point. */
+  void TransformPointAfterMovingBSplineTransform(
+                         typename MovingTransformType::OutputPointType & point,
+                         MovingJacobianPositionType * jacobianWithRespectToPosition ) const;
+
+  /** Compute the B-spline weights of the virtual domain samples, unless they
+   * are already cached for the current moving B-spline transform and its
+   * fixed parameters. Called by InitializeForIteration. */
+  void UpdateBSplineWeightsCache() const;
+
+  /** Release the memory of the B-spline weights cache. */
+  void ReleaseBSplineWeightsCache() const;
 
   /** Compute image derivatives for a Fixed point. */
   virtual void ComputeFixedImageGradientAtPoint( const FixedImagePointType & mappedPoint, FixedImageGradientType & gradient ) const;
@@ -733,6 +837,29 @@ protected:
   FixedSampledPointSet */
   bool                                    m_UseVirtualSampledPointSet;
 
+  /** Type of the moving transform whose weights are cached. */
+  using MovingBSplineTransformType = BSplineTransform< TInternalComputationValueType, MovingImageDimension, 3 >;
+  using BSplineWeightsType = typename MovingBSplineTransformType::WeightsType;
+  using BSplineWeightsValueType = typename BSplineWeightsType::ValueType;
+  using BSplineIndexType = typename MovingBSplineTransformType::IndexType;
+
+  /** The B-spline moving transform, and the transforms the moving composite
+   * transform applies after it, in the order they are applied. Set by
+   * UpdateMovingBSplineTransform. */
+  mutable const MovingBSplineTransformType *                       m_MovingBSplineTransform;
+  mutable std::vector< const MovingCompositeTransformBaseType * > m_TransformsAfterMovingBSplineTransform;
+
+  /** B-spline weights cache. The weights of the cached samples are stored
+   * contiguously, GetNumberOfWeights() values per sample. */
+  bool                                    m_UseCachingOfBSplineWeights;
+  SizeValueType                           m_MaximumNumberOfBSplineWeightsCachePoints;
+  mutable typename MovingBSplineTransformType::ConstPointer m_BSplineWeightsCacheTransform;
+  mutable typename MovingBSplineTransformType::FixedParametersType m_BSplineWeightsCacheFixedParameters;
+  mutable SizeValueType                   m_NumberOfBSplineWeightsCachePoints;
+  mutable std::vector< BSplineWeightsValueType > m_BSplineWeightsCacheWeights;
+  mutable std::vector< BSplineIndexType > m_BSplineWeightsCacheSupportIndices;
+  mutable std::vector< unsigned char >    m_BSplineWeightsCacheInside;
+
   ImageToImageMetricv4();
   ~ImageToImageMetricv4() override = default;
 
@@ -25,6 +25,8 @@
 #include "itkLinearInterpolateImageFunction.h"
 #include "itkIdentityTransform.h"
 
+#include <algorithm>
+
 namespace itk
 {
 
@@ -69,6 +71,11 @@ ImageToImageMetricv4<TFixedImage, TMovingImage, TVirtualImage, TInternalComputat
   this->m_FloatingPointCorrectionResolution = 1e6;
   this->m_UseFloatingPointCorrection = false;
 
+  this->m_UseCachingOfBSplineWeights = false;
+  this->m_MaximumNumberOfBSplineWeightsCachePoints = 262144;
+  this->m_NumberOfBSplineWeightsCachePoints = 0;
+  this->m_MovingBSplineTransform = nullptr;
+
   this->m_HaveMadeGetValueWarning = false;
   this->m_NumberOfSkippedFixedSampledPoints = 0;
 
@@ -145,6 +152,9 @@ ImageToImageMetricv4<TFixedImage, TMovingImage, TVirtualImage, TInternalComputat
     this->MapFixedSampledPointSetToVirtual();
     }
 
+  /* The samples may have changed. */
+  this->ReleaseBSplineWeightsCache();
+
   /* Inititialize interpolators. */
   itkDebugMacro("Initialize Interpolators");
   this->m_FixedInterpolator->SetInputImage( this->m_FixedImage );
@@ -262,6 +272,16 @@ void
 ImageToImageMetricv4<TFixedImage, TMovingImage, TVirtualImage, TInternalComputationValueType, TMetricTraits>
 ::InitializeForIteration() const
 {
+  this->UpdateMovingBSplineTransform();
+  if( this->m_UseCachingOfBSplineWeights )
+    {
+    this->UpdateBSplineWeightsCache();
+    }
+  else
+    {
+    this->ReleaseBSplineWeightsCache();
+    }
+
   if( this->m_ComputeDerivative )
     {
     /* This size always comes from the active transform */
@@ -319,11 +339,9 @@ ImageToImageMetricv4<TFixedImage, TMovingImage, TVirtualImage, TInternalComputat
 ::TransformAndEvaluateMovingPoint(
                          const VirtualPointType & virtualPoint,
                          MovingImagePointType & mappedMovingPoint,
-                         MovingImagePixelType & mappedMovingPixelValue ) const
+                         MovingImagePixelType & mappedMovingPixelValue,
+                         SizeValueType sampleIdentifier ) const
 {
-  bool pointIsValid = true;
-  mappedMovingPixelValue = NumericTraits<MovingImagePixelType>::ZeroValue();
-
   // map the point into moving space
 
   // Before transforming points, we should convert their types from the ImagePointType (aka Point<double, dim>)
@@ -334,9 +352,52 @@ ImageToImageMetricv4<TFixedImage, TMovingImage, TVirtualImage, TInternalComputat
   localVirtualPoint.CastFrom(virtualPoint);
   localMappedMovingPoint.CastFrom(mappedMovingPoint);
 
-  localMappedMovingPoint = this->m_MovingTransform->TransformPoint( localVirtualPoint );
+  if( sampleIdentifier < this->m_NumberOfBSplineWeightsCachePoints )
+    {
+    localMappedMovingPoint = this->TransformPointWithCachedBSplineWeights( localVirtualPoint, sampleIdentifier );
+    }
+  else
+    {
+    localMappedMovingPoint = this->m_MovingTransform->TransformPoint( localVirtualPoint );
+    }
   mappedMovingPoint.CastFrom(localMappedMovingPoint);
 
+  return this->EvaluateMovingPoint( mappedMovingPoint, mappedMovingPixelValue );
+}
+
+template<typename TFixedImage,typename TMovingImage,typename TVirtualImage, typename TInternalComputationValueType, typename TMetricTraits>
+void
+ImageToImageMetricv4<TFixedImage, TMovingImage, TVirtualImage, TInternalComputationValueType, TMetricTraits>
+::TransformMovingPoints( MovingOutputPointType * points,
+                         SizeValueType numberOfPoints,
+                         SizeValueType firstSampleIdentifier ) const
+{
+  // The samples whose B-spline weights are cached come first
+  SizeValueType numberOfCachedPoints = 0;
+  if( firstSampleIdentifier < this->m_NumberOfBSplineWeightsCachePoints )
+    {
+    numberOfCachedPoints = std::min( numberOfPoints, this->m_NumberOfBSplineWeightsCachePoints - firstSampleIdentifier );
+    }
+  for( SizeValueType n = 0; n < numberOfCachedPoints; ++n )
+    {
+    points[n] = this->TransformPointWithCachedBSplineWeights( points[n], firstSampleIdentifier + n );
+    }
+  if( numberOfCachedPoints < numberOfPoints )
+    {
+    this->m_MovingTransform->TransformPoints( points + numberOfCachedPoints, points + numberOfCachedPoints,
+                                              numberOfPoints - numberOfCachedPoints );
+    }
+}
+
+template<typename TFixedImage,typename TMovingImage,typename TVirtualImage, typename TInternalComputationValueType, typename TMetricTraits>
+bool
+ImageToImageMetricv4<TFixedImage, TMovingImage, TVirtualImage, TInternalComputationValueType, TMetricTraits>
+::EvaluateMovingPoint( const MovingImagePointType & mappedMovingPoint,
+                       MovingImagePixelType & mappedMovingPixelValue ) const
+{
+  bool pointIsValid = true;
+  mappedMovingPixelValue = NumericTraits<MovingImagePixelType>::ZeroValue();
+
   // check against the mask if one is assigned
   if ( this->m_MovingImageMask )
     {
@@ -362,6 +423,236 @@ ImageToImageMetricv4<TFixedImage, TMovingImage, TVirtualImage, TInternalComputat
   return pointIsValid;
 }
 
+template<typename TFixedImage,typename TMovingImage,typename TVirtualImage, typename TInternalComputationValueType, typename TMetricTraits>
+void
+ImageToImageMetricv4<TFixedImage, TMovingImage, TVirtualImage, TInternalComputationValueType, TMetricTraits>
+::ComputeMovingTransformJacobian( const VirtualPointType & virtualPoint,
+                                  JacobianType & jacobian,
+                                  JacobianType & jacobianPositional,
+                                  SizeValueType sampleIdentifier ) const
+{
+  if( sampleIdentifier < this->m_NumberOfBSplineWeightsCachePoints )
+    {
+    const SizeValueType numberOfWeights = this->m_BSplineWeightsCacheTransform->GetNumberOfWeights();
+    const BSplineWeightsType weights( &this->m_BSplineWeightsCacheWeights[sampleIdentifier * numberOfWeights],
+                                      numberOfWeights, false );
+    const BSplineIndexType & supportIndex = this->m_BSplineWeightsCacheSupportIndices[sampleIdentifier];
+    const bool               inside = this->m_BSplineWeightsCacheInside[sampleIdentifier] != 0;
+    this->m_BSplineWeightsCacheTransform->ComputeJacobianWithRespectToParametersWithBSplineWeights( weights,
+      supportIndex, inside, jacobian );
+    if( !this->m_TransformsAfterMovingBSplineTransform.empty() && inside )
+      {
+      /* Left multiply the columns of the supported parameters by the
+       * Jacobian of the transforms applied after the B-spline transform
+       * with respect to the position, as the composite transform does. */
+      typename MovingTransformType::InputPointType  localVirtualPoint;
+      typename MovingTransformType::OutputPointType point;
+      localVirtualPoint.CastFrom( virtualPoint );
+      this->m_BSplineWeightsCacheTransform->TransformPointWithBSplineWeights( localVirtualPoint, weights,
+        supportIndex, inside, point );
+      MovingJacobianPositionType jacobianWithRespectToPosition;
+      this->TransformPointAfterMovingBSplineTransform( point, &jacobianWithRespectToPosition );
+
+      typename MovingBSplineTransformType::ParameterIndexArrayType indices( numberOfWeights );
+      this->m_BSplineWeightsCacheTransform->ComputeParameterIndicesWithBSplineWeights( supportIndex, indices );
+      const NumberOfParametersType numberOfParametersPerDimension =
+        this->m_BSplineWeightsCacheTransform->GetNumberOfParametersPerDimension();
+      for( unsigned int dim = 0; dim < MovingImageDimension; ++dim )
+        {
+        for( SizeValueType k = 0; k < numberOfWeights; ++k )
+          {
+          const NumberOfParametersType column = dim * numberOfParametersPerDimension + indices[k];
+          const typename JacobianType::ValueType weight = jacobian( dim, column );
+          for( unsigned int r = 0; r < MovingImageDimension; ++r )
+            {
+            jacobian( r, column ) = jacobianWithRespectToPosition( r, dim ) * weight;
+            }
+          }
+        }
+      }
+    }
+  else
+    {
+    this->m_MovingTransform->ComputeJacobianWithRespectToParametersCachedTemporaries( virtualPoint,
+                                                                                     jacobian,
+                                                                                     jacobianPositional );
+    }
+}
+
+template<typename TFixedImage,typename TMovingImage,typename TVirtualImage, typename TInternalComputationValueType, typename TMetricTraits>
+void
+ImageToImageMetricv4<TFixedImage, TMovingImage, TVirtualImage, TInternalComputationValueType, TMetricTraits>
+::UpdateMovingBSplineTransform() const
+{
+  this->m_TransformsAfterMovingBSplineTransform.clear();
+  this->m_MovingBSplineTransform = dynamic_cast< const MovingBSplineTransformType * >( this->m_MovingTransform.GetPointer() );
+  if( this->m_MovingBSplineTransform != nullptr )
+    {
+    return;
+    }
+
+  // If it's a CompositeTransform, get the last transform (1st applied),
+  // which must be the only one to optimize.
+  const auto * compositeTransform = dynamic_cast< const MovingCompositeTransformType * >( this->m_MovingTransform.GetPointer() );
+  if( compositeTransform == nullptr || compositeTransform->IsTransformQueueEmpty() )
+    {
+    return;
+    }
+  const SizeValueType numberOfTransforms = compositeTransform->GetNumberOfTransforms();
+  for( SizeValueType n = 0; n < numberOfTransforms; ++n )
+    {
+    if( compositeTransform->GetNthTransformToOptimize( n ) != ( n == numberOfTransforms - 1 ) )
+      {
+      return;
+      }
+    }
+  this->m_MovingBSplineTransform =
+    dynamic_cast< const MovingBSplineTransformType * >( compositeTransform->GetBackTransform() );
+  if( this->m_MovingBSplineTransform == nullptr )
+    {
+    return;
+    }
+  for( SizeValueType n = numberOfTransforms - 1; n > 0; --n )
+    {
+    this->m_TransformsAfterMovingBSplineTransform.push_back( compositeTransform->GetNthTransformConstPointer( n - 1 ) );
+    }
+}
+
+template<typename TFixedImage,typename TMovingImage,typename TVirtualImage, typename TInternalComputationValueType, typename TMetricTraits>
+typename ImageToImageMetricv4<TFixedImage, TMovingImage, TVirtualImage, TInternalComputationValueType, TMetricTraits>::MovingOutputPointType
+ImageToImageMetricv4<TFixedImage, TMovingImage, TVirtualImage, TInternalComputationValueType, TMetricTraits>
+::TransformPointWithCachedBSplineWeights( const MovingOutputPointType & virtualPoint,
+                                          SizeValueType sampleIdentifier ) const
+{
+  const SizeValueType numberOfWeights = this->m_BSplineWeightsCacheTransform->GetNumberOfWeights();
+  const BSplineWeightsType weights( &this->m_BSplineWeightsCacheWeights[sampleIdentifier * numberOfWeights],
+                                    numberOfWeights, false );
+  MovingOutputPointType mappedPoint;
+  this->m_BSplineWeightsCacheTransform->TransformPointWithBSplineWeights( virtualPoint, weights,
+    this->m_BSplineWeightsCacheSupportIndices[sampleIdentifier],
+    this->m_BSplineWeightsCacheInside[sampleIdentifier] != 0, mappedPoint );
+  if( !this->m_TransformsAfterMovingBSplineTransform.empty() )
+    {
+    this->TransformPointAfterMovingBSplineTransform( mappedPoint, nullptr );
+    }
+  return mappedPoint;
+}
+
+template<typename TFixedImage,typename TMovingImage,typename TVirtualImage, typename TInternalComputationValueType, typename TMetricTraits>
+void
+ImageToImageMetricv4<TFixedImage, TMovingImage, TVirtualImage, TInternalComputationValueType, TMetricTraits>
+::TransformPointAfterMovingBSplineTransform( typename MovingTransformType::OutputPointType & point,
+                                             MovingJacobianPositionType * jacobianWithRespectToPosition ) const
+{
+  if( jacobianWithRespectToPosition != nullptr )
+    {
+    jacobianWithRespectToPosition->set_identity();
+    }
+  for( const MovingCompositeTransformBaseType * transform : this->m_TransformsAfterMovingBSplineTransform )
+    {
+    if( jacobianWithRespectToPosition != nullptr )
+      {
+      MovingJacobianPositionType transformJacobian;
+      transform->ComputeJacobianWithRespectToPosition( point, transformJacobian );
+      *jacobianWithRespectToPosition = transformJacobian * ( *jacobianWithRespectToPosition );
+      }
+    point = transform->TransformPoint( point );
+    }
+}
+
+template<typename TFixedImage,typename TMovingImage,typename TVirtualImage, typename TInternalComputationValueType, typename TMetricTraits>
+void
+ImageToImageMetricv4<TFixedImage, TMovingImage, TVirtualImage, TInternalComputationValueType, TMetricTraits>
+::UpdateBSplineWeightsCache() const
+{
+  const MovingBSplineTransformType * transform = this->m_MovingBSplineTransform;
+  if( transform == nullptr )
+    {
+    this->ReleaseBSplineWeightsCache();
+    return;
+    }
+
+  /* The weights depend on the samples, which only change in Initialize and
+   * SetVirtualSampledPointSet, and on the grid of the transform. */
+  if( transform == this->m_BSplineWeightsCacheTransform.GetPointer() &&
+      transform->GetFixedParameters() == this->m_BSplineWeightsCacheFixedParameters &&
+      this->m_NumberOfBSplineWeightsCachePoints > 0 )
+    {
+    return;
+    }
+
+  const SizeValueType numberOfPoints = std::min( this->GetNumberOfDomainPoints(),
+                                                 this->m_MaximumNumberOfBSplineWeightsCachePoints );
+  const SizeValueType numberOfWeights = transform->GetNumberOfWeights();
+
+  this->ReleaseBSplineWeightsCache();
+  this->m_BSplineWeightsCacheWeights.resize( numberOfPoints * numberOfWeights );
+  this->m_BSplineWeightsCacheSupportIndices.resize( numberOfPoints );
+  this->m_BSplineWeightsCacheInside.resize( numberOfPoints );
+
+  /* Each sample writes its own entries, so the samples can be processed
+   * in parallel. */
+  const VirtualImageType * virtualImage = this->GetVirtualImage();
+  const VirtualPointSetType * virtualSampledPointSet = this->m_VirtualSampledPointSet.GetPointer();
+  const bool useSampledPointSet = this->m_UseSampledPointSet;
+  this->m_DenseGetValueAndDerivativeThreader->GetMultiThreader()->ParallelizeArray( 0, numberOfPoints,
+    [&]( SizeValueType sampleIdentifier )
+    {
+      VirtualPointType virtualPoint;
+      if( useSampledPointSet )
+        {
+        virtualPoint = virtualSampledPointSet->GetPoint( sampleIdentifier );
+        }
+      else
+        {
+        virtualImage->TransformIndexToPhysicalPoint( virtualImage->ComputeIndex( sampleIdentifier ), virtualPoint );
+        }
+      typename MovingBSplineTransformType::InputPointType point;
+      point.CastFrom( virtualPoint );
+
+      BSplineWeightsType weights( &this->m_BSplineWeightsCacheWeights[sampleIdentifier * numberOfWeights],
+                                  numberOfWeights, false );
+      bool inside;
+      transform->ComputeBSplineWeights( point, weights, this->m_BSplineWeightsCacheSupportIndices[sampleIdentifier],
+                                        inside );
+      this->m_BSplineWeightsCacheInside[sampleIdentifier] = inside;
+    },
+    nullptr );
+
+  this->m_BSplineWeightsCacheTransform = transform;
+  this->m_BSplineWeightsCacheFixedParameters = transform->GetFixedParameters();
+  this->m_NumberOfBSplineWeightsCachePoints = numberOfPoints;
+}
+
+template<typename TFixedImage,typename TMovingImage,typename TVirtualImage, typename TInternalComputationValueType, typename TMetricTraits>
+void
+ImageToImageMetricv4<TFixedImage, TMovingImage, TVirtualImage, TInternalComputationValueType, TMetricTraits>
+::SetVirtualSampledPointSet( VirtualPointSetType * pointSet )
+{
+  if( this->m_VirtualSampledPointSet != pointSet )
+    {
+    this->m_VirtualSampledPointSet = pointSet;
+    /* The cached weights belong to the previous samples. */
+    this->ReleaseBSplineWeightsCache();
+    this->Modified();
+    }
+}
+
+template<typename TFixedImage,typename TMovingImage,typename TVirtualImage, typename TInternalComputationValueType, typename TMetricTraits>
+void
+ImageToImageMetricv4<TFixedImage, TMovingImage, TVirtualImage, TInternalComputationValueType, TMetricTraits>
+::ReleaseBSplineWeightsCache() const
+{
+  this->m_NumberOfBSplineWeightsCachePoints = 0;
+  this->m_BSplineWeightsCacheTransform = nullptr;
+  this->m_BSplineWeightsCacheWeights.clear();
+  this->m_BSplineWeightsCacheWeights.shrink_to_fit();
+  this->m_BSplineWeightsCacheSupportIndices.clear();
+  this->m_BSplineWeightsCacheSupportIndices.shrink_to_fit();
+  this->m_BSplineWeightsCacheInside.clear();
+  this->m_BSplineWeightsCacheInside.shrink_to_fit();
+}
+
 template<typename TFixedImage,typename TMovingImage,typename TVirtualImage, typename TInternalComputationValueType, typename TMetricTraits>
 void
 ImageToImageMetricv4<TFixedImage, TMovingImage, TVirtualImage, TInternalComputationValueType, TMetricTraits>
@@ -591,7 +882,9 @@ ImageToImageMetricv4<TFixedImage, TMovingImage, TVirtualImage, TInternalComputat
      << indent << "GetUseFixedImageGradientFilter: " << this->GetUseFixedImageGradientFilter() << std::endl
      << indent << "GetUseMovingImageGradientFilter: " << this->GetUseMovingImageGradientFilter() << std::endl
      << indent << "UseFloatingPointCorrection: " << this->GetUseFloatingPointCorrection() << std::endl
-     << indent << "FloatingPointCorrectionResolution: " << this->GetFloatingPointCorrectionResolution() << std::endl;
+     << indent << "FloatingPointCorrectionResolution: " << this->GetFloatingPointCorrectionResolution() << std::endl
+     << indent << "UseCachingOfBSplineWeights: " << this->GetUseCachingOfBSplineWeights() << std::endl
+     << indent << "MaximumNumberOfBSplineWeightsCachePoints: " << this->GetMaximumNumberOfBSplineWeightsCachePoints() << std::endl;
 
   itkPrintSelfObjectMacro( FixedImage );
   itkPrintSelfObjectMacro( MovingImage );
@@ -165,6 +165,10 @@ public:
   using InternalComputationValueType = typename Superclass::InternalComputationValueType;
   using NumberOfParametersType = typename Superclass::NumberOfParametersType;
 
+  /** Number of samples mapped into the moving space at once when the
+   * moving points are transformed in batches. */
+  static constexpr SizeValueType BatchSize = 256;
+
 protected:
   /** Constructor. */
   ImageToImageMetricv4GetValueAndDerivativeThreader() = default;
@@ -21,6 +21,8 @@
 #include "itkImageRegionConstIteratorWithIndex.h"
 #include "itkImageToImageMetricv4GetValueAndDerivativeThreader.h"
 
+#include <algorithm>
+
 namespace itk
 {
 
@@ -32,12 +34,34 @@ ImageToImageMetricv4GetValueAndDerivativeThreader< ThreadedImageRegionPartitione
 {
   typename VirtualImageType::ConstPointer virtualImage = this->m_Associate->GetVirtualImage();
   using IteratorType = ImageRegionConstIteratorWithIndex< VirtualImageType >;
-  VirtualPointType virtualPoint;
-  for( IteratorType it( virtualImage, imageSubRegion ); !it.IsAtEnd(); ++it )
+  if( this->m_TransformsMovingPointsInBatches )
+    {
+    // Process the region scanline by scanline, whose samples are consecutive
+    const SizeValueType lineLength = imageSubRegion.GetSize( 0 );
+    std::vector< VirtualIndexType > virtualIndices( lineLength );
+    std::vector< VirtualPointType > virtualPoints( lineLength );
+    IteratorType it( virtualImage, imageSubRegion );
+    while( !it.IsAtEnd() )
+      {
+      const SizeValueType firstSampleIdentifier = virtualImage->ComputeOffset( it.GetIndex() );
+      for( SizeValueType n = 0; n < lineLength; ++n, ++it )
+        {
+        virtualIndices[n] = it.GetIndex();
+        virtualImage->TransformIndexToPhysicalPoint( virtualIndices[n], virtualPoints[n] );
+        }
+      this->ProcessVirtualPoints( virtualIndices, virtualPoints, firstSampleIdentifier, threadId );
+      }
+    }
+  else
     {
-    const VirtualIndexType & virtualIndex = it.GetIndex();
-    virtualImage->TransformIndexToPhysicalPoint( virtualIndex, virtualPoint );
-    this->ProcessVirtualPoint( virtualIndex, virtualPoint, threadId );
+    VirtualPointType virtualPoint;
+    for( IteratorType it( virtualImage, imageSubRegion ); !it.IsAtEnd(); ++it )
+      {
+      const VirtualIndexType & virtualIndex = it.GetIndex();
+      virtualImage->TransformIndexToPhysicalPoint( virtualIndex, virtualPoint );
+      this->m_GetValueAndDerivativePerThreadVariables[threadId].SampleIdentifier = virtualImage->ComputeOffset( virtualIndex );
+      this->ProcessVirtualPoint( virtualIndex, virtualPoint, threadId );
+      }
     }
   //Finalize per thread actions
   this->m_Associate->FinalizeThread( threadId );
@@ -55,11 +79,33 @@ ImageToImageMetricv4GetValueAndDerivativeThreader< ThreadedIndexedContainerParti
   const ElementIdentifierType end   = indexSubRange[1];
   VirtualIndexType virtualIndex;
   typename VirtualImageType::ConstPointer virtualImage = this->m_Associate->GetVirtualImage();
-  for( ElementIdentifierType i = begin; i <= end; ++i )
+  if( this->m_TransformsMovingPointsInBatches )
+    {
+    // Process the samples in blocks of BatchSize
+    std::vector< VirtualIndexType > virtualIndices;
+    std::vector< VirtualPointType > virtualPoints;
+    for( ElementIdentifierType first = begin; first <= end; first += BatchSize )
+      {
+      const ElementIdentifierType last = std::min( end, first + BatchSize - 1 );
+      virtualIndices.resize( last - first + 1 );
+      virtualPoints.resize( last - first + 1 );
+      for( ElementIdentifierType i = first; i <= last; ++i )
+        {
+        virtualPoints[i - first] = virtualSampledPointSet->GetPoint( i );
+        virtualImage->TransformPhysicalPointToIndex( virtualPoints[i - first], virtualIndices[i - first] );
+        }
+      this->ProcessVirtualPoints( virtualIndices, virtualPoints, first, threadId );
+      }
+    }
+  else
     {
-    const VirtualPointType & virtualPoint = virtualSampledPointSet->GetPoint( i );
-    virtualImage->TransformPhysicalPointToIndex( virtualPoint, virtualIndex );
-    this->ProcessVirtualPoint( virtualIndex, virtualPoint, threadId );
+    for( ElementIdentifierType i = begin; i <= end; ++i )
+      {
+      const VirtualPointType & virtualPoint = virtualSampledPointSet->GetPoint( i );
+      virtualImage->TransformPhysicalPointToIndex( virtualPoint, virtualIndex );
+      this->m_GetValueAndDerivativePerThreadVariables[threadId].SampleIdentifier = i;
+      this->ProcessVirtualPoint( virtualIndex, virtualPoint, threadId );
+      }
     }
   //Finalize per thread actions
   this->m_Associate->FinalizeThread( threadId );
@@ -20,6 +20,7 @@
 
 #include "itkDomainThreader.h"
 #include "itkCompensatedSummation.h"
+#include "itkBSplineTransform.h"
 
 namespace itk
 {
@@ -116,6 +117,16 @@ protected:
                                     const VirtualPointType & virtualPoint,
                                     const ThreadIdType threadId );
 
+  /** Process the given virtual points, the consecutive samples
+   * \c firstSampleIdentifier and on, with \c ProcessVirtualPoint, after
+   * mapping them into the moving space at once with the
+   * \c TransformMovingPoints of the metric. Called by the threaders when
+   * m_TransformsMovingPointsInBatches is true. */
+  void ProcessVirtualPoints( const std::vector< VirtualIndexType > & virtualIndices,
+                             const std::vector< VirtualPointType > & virtualPoints,
+                             const SizeValueType firstSampleIdentifier,
+                             const ThreadIdType threadId );
+
   /** Method to calculate the metric value and derivative
    * given a point, value and image derivative for both fixed and moving
    * spaces. The provided values have been calculated from \c virtualPoint,
@@ -158,12 +169,31 @@ protected:
         const ThreadIdType                threadId ) const = 0;
 
 
+  /** Compute the Jacobian of the moving transform with respect to its
+   * parameters at the virtual point processed by thread \c threadId. This
+   * uses the B-spline weights that the metric may have cached for the point.
+   * When the derivatives are accumulated sparsely, the Jacobian only holds
+   * the columns of the parameters supported at the point, one per local
+   * derivative.
+   * \sa ImageToImageMetricv4::SetUseCachingOfBSplineWeights */
+  void ComputeMovingTransformJacobian( const VirtualPointType & virtualPoint,
+                                       JacobianType & jacobian,
+                                       JacobianType & jacobianPositional,
+                                       const ThreadIdType threadId ) const;
+
   /** Store derivative result from a single point calculation.
    * \warning If this method is overridden or otherwise not used
    * in a derived class, be sure to *accumulate* results. */
   virtual void StorePointDerivativeResult( const VirtualIndexType & virtualIndex,
                                            const ThreadIdType threadId );
 
+  /** Types of the B-spline moving transform, whose Jacobian is only
+   * non-zero for the parameters in the support region of the point. */
+  using MovingBSplineTransformType = BSplineTransform< InternalComputationValueType,
+                                                      ImageToImageMetricv4Type::MovingImageDimension, 3 >;
+  using BSplineWeightsType = typename MovingBSplineTransformType::WeightsType;
+  using BSplineParameterIndexArrayType = typename MovingBSplineTransformType::ParameterIndexArrayType;
+
   struct GetValueAndDerivativePerThreadStruct
     {
     /** Intermediary threaded metric value storage. */
@@ -180,6 +210,28 @@ protected:
      * classes for efficiency. */
     JacobianType                 MovingTransformJacobian;
     JacobianType                 MovingTransformJacobianPositional;
+    /** Identifier of the virtual domain sample being processed, set by
+     * ThreadedExecution: its offset in the virtual region for dense sampling,
+     * or its identifier in the virtual sampled point set for sparse sampling. */
+    SizeValueType                SampleIdentifier;
+    /** Moving points of the virtual points processed by
+     * ProcessVirtualPoints, and the one of the point being processed, or
+     * nullptr when ProcessVirtualPoint maps the point itself. */
+    std::vector< MovingOutputPointType > MappedMovingPoints;
+    const MovingOutputPointType *        MappedMovingPoint;
+    /** Sparse derivative accumulation storage, used instead of
+     * CompensatedDerivatives with a B-spline moving transform. The parameters
+     * supported at the current point are given by SupportedParameterIndices
+     * for the zeroth dimension. SparseDerivatives holds, for each dimension,
+     * the sums of the SparseDerivativesSize parameters starting at
+     * SparseDerivativesStart, the range of parameters the thread has
+     * touched. */
+    BSplineWeightsType             BSplineWeights;
+    BSplineParameterIndexArrayType SupportedParameterIndices;
+    bool                           PointIsSupported;
+    CompensatedDerivativeType      SparseDerivatives;
+    NumberOfParametersType         SparseDerivativesStart;
+    NumberOfParametersType         SparseDerivativesSize;
     };
   itkPadStruct( ITK_CACHE_LINE_ALIGNMENT, GetValueAndDerivativePerThreadStruct,
                                             PaddedGetValueAndDerivativePerThreadStruct);
@@ -191,6 +243,35 @@ protected:
    *  These will only be set once threading has been started. */
   mutable NumberOfParametersType                      m_CachedNumberOfParameters;
   mutable NumberOfParametersType                      m_CachedNumberOfLocalParameters;
+
+  /** Derived classes set this to true in their constructor when their
+   * ProcessPoint computes one local derivative for each column of the
+   * Jacobian returned by ComputeMovingTransformJacobian(), for as many
+   * columns as \c localDerivativeReturn holds. For a B-spline moving
+   * transform, the derivatives are then only computed and accumulated for
+   * the parameters supported at each point, and the per-thread sums cover
+   * only the parameters touched by the thread. Defaults to false. */
+  bool                                                m_SupportsSparseDerivatives;
+
+  /** Derived classes set this to true in their constructor when they
+   * process the points with the ProcessVirtualPoint() of this class. The
+   * threaders then map the virtual points of each scanline, or of each block
+   * of samples, into the moving space with one TransformPoints call of the
+   * moving transform, instead of one TransformPoint call per point. Defaults
+   * to false. */
+  bool                                                m_TransformsMovingPointsInBatches;
+
+  /** The B-spline moving transform, or the B-spline transform a composite
+   * moving transform applies first, when the derivatives are accumulated
+   * sparsely, otherwise nullptr. Set by BeforeThreadedExecution. */
+  const MovingBSplineTransformType *                  m_SparseDerivativeTransform;
+
+private:
+  /** Extend the range of parameters of the sparse derivatives of a thread to
+   * cover the parameters \c first to \c last of the zeroth dimension. */
+  void ResizeSparseDerivatives( const ThreadIdType threadId,
+                                const NumberOfParametersType first,
+                                const NumberOfParametersType last );
 };
 
 } // end namespace itk
@@ -21,6 +21,8 @@
 #include "itkImageToImageMetricv4GetValueAndDerivativeThreaderBase.h"
 #include "itkNumericTraits.h"
 
+#include <algorithm>
+
 namespace itk
 {
 
@@ -29,7 +31,10 @@ ImageToImageMetricv4GetValueAndDerivativeThreaderBase< TDomainPartitioner, TImag
 ::ImageToImageMetricv4GetValueAndDerivativeThreaderBase():
   m_GetValueAndDerivativePerThreadVariables( nullptr ),
   m_CachedNumberOfParameters( 0 ),
-  m_CachedNumberOfLocalParameters( 0 )
+  m_CachedNumberOfLocalParameters( 0 ),
+  m_SupportsSparseDerivatives( false ),
+  m_TransformsMovingPointsInBatches( false ),
+  m_SparseDerivativeTransform( nullptr )
 {
 }
 
@@ -57,7 +62,33 @@ ImageToImageMetricv4GetValueAndDerivativeThreaderBase< TDomainPartitioner, TImag
   delete[] m_GetValueAndDerivativePerThreadVariables;
   this->m_GetValueAndDerivativePerThreadVariables = new AlignedGetValueAndDerivativePerThreadStruct[ numThreadsUsed ];
 
-  if( this->m_Associate->GetComputeDerivative() )
+  /* The Jacobian of a B-spline transform is only non-zero for the parameters
+   * in the support region of the point, so derived classes which support it
+   * only compute and accumulate the derivatives of these parameters. This
+   * holds as well for the B-spline transform a composite transform applies
+   * first and only optimizes, found by the metric. */
+  this->m_SparseDerivativeTransform = nullptr;
+  if( this->m_SupportsSparseDerivatives && this->m_Associate->GetComputeDerivative() &&
+      this->m_Associate->m_MovingTransform->GetTransformCategory() != MovingTransformType::DisplacementField )
+    {
+    this->m_SparseDerivativeTransform = this->m_Associate->m_MovingBSplineTransform;
+    }
+
+  if( this->m_SparseDerivativeTransform != nullptr )
+    {
+    itkDebugMacro( "ImageToImageMetricv4::Initialize: transform is a B-spline transform, derivatives are sparse\n" );
+    const NumberOfParametersType numberOfWeights = this->m_SparseDerivativeTransform->GetNumberOfWeights();
+    const NumberOfParametersType numberOfSupportedParameters = MovingBSplineTransformType::SpaceDimension * numberOfWeights;
+    for (ThreadIdType i = 0; i < numThreadsUsed; ++i)
+      {
+      this->m_GetValueAndDerivativePerThreadVariables[i].LocalDerivatives.SetSize( numberOfSupportedParameters );
+      this->m_GetValueAndDerivativePerThreadVariables[i].MovingTransformJacobian.SetSize(
+        MovingBSplineTransformType::SpaceDimension, numberOfSupportedParameters );
+      this->m_GetValueAndDerivativePerThreadVariables[i].BSplineWeights.SetSize( numberOfWeights );
+      this->m_GetValueAndDerivativePerThreadVariables[i].SupportedParameterIndices.SetSize( numberOfWeights );
+      }
+    }
+  else if( this->m_Associate->GetComputeDerivative() )
     {
     for (ThreadIdType i = 0; i < numThreadsUsed; ++i)
       {
@@ -98,8 +129,13 @@ ImageToImageMetricv4GetValueAndDerivativeThreaderBase< TDomainPartitioner, TImag
   for (ThreadIdType thread = 0; thread < numThreadsUsed; ++thread)
     {
     this->m_GetValueAndDerivativePerThreadVariables[thread].NumberOfValidPoints = NumericTraits< SizeValueType >::ZeroValue();
+    this->m_GetValueAndDerivativePerThreadVariables[thread].SampleIdentifier = NumericTraits< SizeValueType >::max();
+    this->m_GetValueAndDerivativePerThreadVariables[thread].MappedMovingPoint = nullptr;
     this->m_GetValueAndDerivativePerThreadVariables[thread].Measure = NumericTraits< InternalComputationValueType >::ZeroValue();
-    if( this->m_Associate->GetComputeDerivative() )
+    this->m_GetValueAndDerivativePerThreadVariables[thread].PointIsSupported = false;
+    this->m_GetValueAndDerivativePerThreadVariables[thread].SparseDerivativesStart = 0;
+    this->m_GetValueAndDerivativePerThreadVariables[thread].SparseDerivativesSize = 0;
+    if( this->m_Associate->GetComputeDerivative() && this->m_SparseDerivativeTransform == nullptr )
       {
       if ( this->m_Associate->m_MovingTransform->GetTransformCategory() != MovingTransformType::DisplacementField )
         {
@@ -133,7 +169,39 @@ ImageToImageMetricv4GetValueAndDerivativeThreaderBase< TDomainPartitioner, TImag
   /* For global transforms, sum the derivatives from each region. */
   if( this->m_Associate->GetComputeDerivative() )
     {
-    if ( this->m_Associate->m_MovingTransform->GetTransformCategory() != MovingTransformType::DisplacementField )
+    if( this->m_SparseDerivativeTransform != nullptr )
+      {
+      /* Each thread only holds the sums of the parameters it has touched.
+       * Sum them over the threads in parallel over the parameters, always in
+       * the order of the threads, so that the result does not depend on the
+       * scheduling. */
+      const AlignedGetValueAndDerivativePerThreadStruct * perThreadVariables = this->m_GetValueAndDerivativePerThreadVariables;
+      DerivativeType & derivativeResult = *(this->m_Associate->m_DerivativeResult);
+      const NumberOfParametersType numberOfParametersPerDimension =
+        this->m_SparseDerivativeTransform->GetNumberOfParametersPerDimension();
+
+      this->GetMultiThreader()->ParallelizeArray( 0, numberOfParametersPerDimension,
+        [perThreadVariables, numThreadsUsed, numberOfParametersPerDimension, &derivativeResult]( SizeValueType p )
+        {
+        for( unsigned int dim = 0; dim < MovingBSplineTransformType::SpaceDimension; ++dim )
+          {
+          CompensatedDerivativeValueType sum;
+          sum.ResetToZero();
+          for (ThreadIdType i = 0; i < numThreadsUsed; ++i)
+            {
+            const NumberOfParametersType start = perThreadVariables[i].SparseDerivativesStart;
+            const NumberOfParametersType size = perThreadVariables[i].SparseDerivativesSize;
+            if( p >= start && p < start + size )
+              {
+              sum += perThreadVariables[i].SparseDerivatives[dim * size + ( p - start )].GetSum();
+              }
+            }
+          derivativeResult[dim * numberOfParametersPerDimension + p] += sum.GetSum();
+          }
+        },
+        nullptr );
+      }
+    else if ( this->m_Associate->m_MovingTransform->GetTransformCategory() != MovingTransformType::DisplacementField )
       {
       for (NumberOfParametersType p = 0; p < this->m_Associate->GetNumberOfParameters(); p++ )
         {
@@ -217,7 +285,18 @@ ImageToImageMetricv4GetValueAndDerivativeThreaderBase< TDomainPartitioner, TImag
 
   try
     {
-    pointIsValid = this->m_Associate->TransformAndEvaluateMovingPoint( virtualPoint, mappedMovingPoint, mappedMovingPixelValue );
+    const MovingOutputPointType * batchedMappedMovingPoint =
+      this->m_GetValueAndDerivativePerThreadVariables[threadId].MappedMovingPoint;
+    if( batchedMappedMovingPoint != nullptr )
+      {
+      mappedMovingPoint.CastFrom( *batchedMappedMovingPoint );
+      pointIsValid = this->m_Associate->EvaluateMovingPoint( mappedMovingPoint, mappedMovingPixelValue );
+      }
+    else
+      {
+      pointIsValid = this->m_Associate->TransformAndEvaluateMovingPoint( virtualPoint, mappedMovingPoint, mappedMovingPixelValue,
+        this->m_GetValueAndDerivativePerThreadVariables[threadId].SampleIdentifier );
+      }
     if( pointIsValid &&
         this->m_Associate->GetComputeDerivative() &&
         this->m_Associate->GetGradientSourceIncludesMoving() )
@@ -239,6 +318,7 @@ ImageToImageMetricv4GetValueAndDerivativeThreaderBase< TDomainPartitioner, TImag
 
   /* Call the user method in derived classes to do the specific
    * calculations for value and derivative. */
+  this->m_GetValueAndDerivativePerThreadVariables[threadId].PointIsSupported = false;
   try
     {
     pointIsValid = this->ProcessPoint(
@@ -273,6 +353,121 @@ ImageToImageMetricv4GetValueAndDerivativeThreaderBase< TDomainPartitioner, TImag
   return pointIsValid;
 }
 
+template< typename TDomainPartitioner, typename TImageToImageMetricv4 >
+void
+ImageToImageMetricv4GetValueAndDerivativeThreaderBase< TDomainPartitioner, TImageToImageMetricv4 >
+::ProcessVirtualPoints( const std::vector< VirtualIndexType > & virtualIndices,
+                        const std::vector< VirtualPointType > & virtualPoints,
+                        const SizeValueType firstSampleIdentifier,
+                        const ThreadIdType threadId )
+{
+  AlignedGetValueAndDerivativePerThreadStruct & perThreadVariables = this->m_GetValueAndDerivativePerThreadVariables[threadId];
+  const SizeValueType numberOfPoints = virtualPoints.size();
+  std::vector< MovingOutputPointType > & mappedMovingPoints = perThreadVariables.MappedMovingPoints;
+  mappedMovingPoints.resize( numberOfPoints );
+  for( SizeValueType n = 0; n < numberOfPoints; ++n )
+    {
+    mappedMovingPoints[n].CastFrom( virtualPoints[n] );
+    }
+  try
+    {
+    this->m_Associate->TransformMovingPoints( mappedMovingPoints.data(), numberOfPoints, firstSampleIdentifier );
+    }
+  catch( ExceptionObject & exc )
+    {
+    std::string msg("Caught exception: \n");
+    msg += exc.what();
+    ExceptionObject err(__FILE__, __LINE__, msg);
+    throw err;
+    }
+
+  for( SizeValueType n = 0; n < numberOfPoints; ++n )
+    {
+    perThreadVariables.SampleIdentifier = firstSampleIdentifier + n;
+    perThreadVariables.MappedMovingPoint = &mappedMovingPoints[n];
+    this->ProcessVirtualPoint( virtualIndices[n], virtualPoints[n], threadId );
+    }
+  perThreadVariables.MappedMovingPoint = nullptr;
+}
+
+template< typename TDomainPartitioner, typename TImageToImageMetricv4 >
+void
+ImageToImageMetricv4GetValueAndDerivativeThreaderBase< TDomainPartitioner, TImageToImageMetricv4 >
+::ComputeMovingTransformJacobian( const VirtualPointType & virtualPoint,
+                                  JacobianType & jacobian,
+                                  JacobianType & jacobianPositional,
+                                  const ThreadIdType threadId ) const
+{
+  if( this->m_SparseDerivativeTransform == nullptr )
+    {
+    this->m_Associate->ComputeMovingTransformJacobian( virtualPoint, jacobian, jacobianPositional,
+      this->m_GetValueAndDerivativePerThreadVariables[threadId].SampleIdentifier );
+    return;
+    }
+
+  /* Jacobian restricted to the parameters supported at the point: the
+   * column of the k-th weight of dimension dim is dim * numberOfWeights + k. */
+  AlignedGetValueAndDerivativePerThreadStruct & perThreadVariables = this->m_GetValueAndDerivativePerThreadVariables[threadId];
+  const SizeValueType sampleIdentifier = perThreadVariables.SampleIdentifier;
+  const NumberOfParametersType numberOfWeights = perThreadVariables.BSplineWeights.Size();
+
+  BSplineWeightsType                               cachedWeights;
+  const BSplineWeightsType *                       weights = &perThreadVariables.BSplineWeights;
+  typename MovingBSplineTransformType::IndexType   supportIndex;
+  bool                                             inside;
+  if( sampleIdentifier < this->m_Associate->m_NumberOfBSplineWeightsCachePoints )
+    {
+    cachedWeights.SetData( &this->m_Associate->m_BSplineWeightsCacheWeights[sampleIdentifier * numberOfWeights],
+                           numberOfWeights, false );
+    weights = &cachedWeights;
+    supportIndex = this->m_Associate->m_BSplineWeightsCacheSupportIndices[sampleIdentifier];
+    inside = this->m_Associate->m_BSplineWeightsCacheInside[sampleIdentifier] != 0;
+    }
+  else
+    {
+    this->m_SparseDerivativeTransform->ComputeBSplineWeights( virtualPoint, perThreadVariables.BSplineWeights,
+                                                              supportIndex, inside );
+    }
+
+  jacobian.Fill( NumericTraits< typename JacobianType::ValueType >::ZeroValue() );
+  perThreadVariables.PointIsSupported = inside;
+  if( !inside )
+    {
+    return;
+    }
+  this->m_SparseDerivativeTransform->ComputeParameterIndicesWithBSplineWeights( supportIndex,
+                                                                               perThreadVariables.SupportedParameterIndices );
+  if( this->m_Associate->m_TransformsAfterMovingBSplineTransform.empty() )
+    {
+    for( unsigned int dim = 0; dim < MovingBSplineTransformType::SpaceDimension; ++dim )
+      {
+      for( NumberOfParametersType k = 0; k < numberOfWeights; ++k )
+        {
+        jacobian( dim, dim * numberOfWeights + k ) = ( *weights )[k];
+        }
+      }
+    return;
+    }
+
+  /* Left multiplied by the Jacobian of the transforms applied after the
+   * B-spline transform with respect to the position. */
+  typename MovingBSplineTransformType::OutputPointType point;
+  this->m_SparseDerivativeTransform->TransformPointWithBSplineWeights( virtualPoint, *weights, supportIndex, inside,
+                                                                      point );
+  typename AssociateType::MovingJacobianPositionType jacobianWithRespectToPosition;
+  this->m_Associate->TransformPointAfterMovingBSplineTransform( point, &jacobianWithRespectToPosition );
+  for( unsigned int dim = 0; dim < MovingBSplineTransformType::SpaceDimension; ++dim )
+    {
+    for( NumberOfParametersType k = 0; k < numberOfWeights; ++k )
+      {
+      for( unsigned int r = 0; r < MovingBSplineTransformType::SpaceDimension; ++r )
+        {
+        jacobian( r, dim * numberOfWeights + k ) = jacobianWithRespectToPosition( r, dim ) * ( *weights )[k];
+        }
+      }
+    }
+}
+
 template< typename TDomainPartitioner, typename TImageToImageMetricv4 >
 void
 ImageToImageMetricv4GetValueAndDerivativeThreaderBase< TDomainPartitioner, TImageToImageMetricv4 >
@@ -284,7 +479,7 @@ ImageToImageMetricv4GetValueAndDerivativeThreaderBase< TDomainPartitioner, TImag
     if ( this->m_Associate->GetUseFloatingPointCorrection() )
       {
       DerivativeValueType correctionResolution = this->m_Associate->GetFloatingPointCorrectionResolution();
-      for (NumberOfParametersType p = 0; p < this->m_CachedNumberOfParameters; p++ )
+      for (NumberOfParametersType p = 0; p < this->m_GetValueAndDerivativePerThreadVariables[threadId].LocalDerivatives.Size(); p++ )
         {
         auto test = static_cast< intmax_t >(
           this->m_GetValueAndDerivativePerThreadVariables[threadId].LocalDerivatives[p] * correctionResolution
@@ -292,9 +487,39 @@ ImageToImageMetricv4GetValueAndDerivativeThreaderBase< TDomainPartitioner, TImag
         this->m_GetValueAndDerivativePerThreadVariables[threadId].LocalDerivatives[p] = static_cast<DerivativeValueType>( test / correctionResolution );
         }
       }
-    for (NumberOfParametersType p = 0; p < this->m_CachedNumberOfParameters; p++ )
+    if( this->m_SparseDerivativeTransform != nullptr )
+      {
+      /* Only the parameters supported at the point */
+      AlignedGetValueAndDerivativePerThreadStruct & perThreadVariables = this->m_GetValueAndDerivativePerThreadVariables[threadId];
+      if( !perThreadVariables.PointIsSupported )
+        {
+        return;
+        }
+      const BSplineParameterIndexArrayType & indices = perThreadVariables.SupportedParameterIndices;
+      const NumberOfParametersType numberOfWeights = indices.Size();
+      /* The indices increase along the support region */
+      if( indices[0] < perThreadVariables.SparseDerivativesStart ||
+          indices[numberOfWeights - 1] >= perThreadVariables.SparseDerivativesStart + perThreadVariables.SparseDerivativesSize )
+        {
+        this->ResizeSparseDerivatives( threadId, indices[0], indices[numberOfWeights - 1] );
+        }
+      const NumberOfParametersType start = perThreadVariables.SparseDerivativesStart;
+      const NumberOfParametersType size = perThreadVariables.SparseDerivativesSize;
+      for( unsigned int dim = 0; dim < MovingBSplineTransformType::SpaceDimension; ++dim )
+        {
+        for( NumberOfParametersType k = 0; k < numberOfWeights; ++k )
+          {
+          perThreadVariables.SparseDerivatives[dim * size + ( indices[k] - start )] +=
+            perThreadVariables.LocalDerivatives[dim * numberOfWeights + k];
+          }
+        }
+      }
+    else
       {
-      this->m_GetValueAndDerivativePerThreadVariables[threadId].CompensatedDerivatives[p] += this->m_GetValueAndDerivativePerThreadVariables[threadId].LocalDerivatives[p];
+      for (NumberOfParametersType p = 0; p < this->m_CachedNumberOfParameters; p++ )
+        {
+        this->m_GetValueAndDerivativePerThreadVariables[threadId].CompensatedDerivatives[p] += this->m_GetValueAndDerivativePerThreadVariables[threadId].LocalDerivatives[p];
+        }
       }
     }
   else
@@ -323,6 +548,51 @@ ImageToImageMetricv4GetValueAndDerivativeThreaderBase< TDomainPartitioner, TImag
     }
 }
 
+template< typename TDomainPartitioner, typename TImageToImageMetricv4 >
+void
+ImageToImageMetricv4GetValueAndDerivativeThreaderBase< TDomainPartitioner, TImageToImageMetricv4 >
+::ResizeSparseDerivatives( const ThreadIdType threadId,
+                           const NumberOfParametersType first,
+                           const NumberOfParametersType last )
+{
+  AlignedGetValueAndDerivativePerThreadStruct & perThreadVariables = this->m_GetValueAndDerivativePerThreadVariables[threadId];
+  const NumberOfParametersType numberOfParametersPerDimension =
+    this->m_SparseDerivativeTransform->GetNumberOfParametersPerDimension();
+  const NumberOfParametersType oldStart = perThreadVariables.SparseDerivativesStart;
+  const NumberOfParametersType oldSize = perThreadVariables.SparseDerivativesSize;
+
+  NumberOfParametersType newStart = first;
+  NumberOfParametersType newEnd = last + 1;
+  if( oldSize > 0 )
+    {
+    newStart = std::min( newStart, oldStart );
+    newEnd = std::max( newEnd, oldStart + oldSize );
+    }
+  /* Grow geometrically, since a thread usually sweeps its part of the domain
+   * in one direction, and extend the range in that direction. */
+  const NumberOfParametersType newSize =
+    std::min( numberOfParametersPerDimension, std::max( newEnd - newStart, 2 * oldSize ) );
+  if( oldSize > 0 && first < oldStart )
+    {
+    newStart = ( newEnd > newSize ) ? newEnd - newSize : 0;
+    }
+  else
+    {
+    newStart = std::min( newStart, numberOfParametersPerDimension - newSize );
+    }
+
+  CompensatedDerivativeType sparseDerivatives( MovingBSplineTransformType::SpaceDimension * newSize );
+  for( unsigned int dim = 0; oldSize > 0 && dim < MovingBSplineTransformType::SpaceDimension; ++dim )
+    {
+    std::copy( perThreadVariables.SparseDerivatives.begin() + dim * oldSize,
+               perThreadVariables.SparseDerivatives.begin() + ( dim + 1 ) * oldSize,
+               sparseDerivatives.begin() + dim * newSize + ( oldStart - newStart ) );
+    }
+  perThreadVariables.SparseDerivatives.swap( sparseDerivatives );
+  perThreadVariables.SparseDerivativesStart = newStart;
+  perThreadVariables.SparseDerivativesSize = newSize;
+}
+
 template< typename TDomainPartitioner, typename TImageToImageMetricv4 >
 bool
 ImageToImageMetricv4GetValueAndDerivativeThreaderBase< TDomainPartitioner, TImageToImageMetricv4 >
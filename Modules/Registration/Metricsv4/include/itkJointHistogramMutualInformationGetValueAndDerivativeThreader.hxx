@@ -28,7 +28,10 @@ JointHistogramMutualInformationGetValueAndDerivativeThreader< TDomainPartitioner
 ::JointHistogramMutualInformationGetValueAndDerivativeThreader() :
   m_JointHistogramMIPerThreadVariables( nullptr ),
   m_JointAssociate( nullptr )
-{}
+{
+  this->m_SupportsSparseDerivatives = true;
+  this->m_TransformsMovingPointsInBatches = true;
+}
 
 
 template< typename TDomainPartitioner, typename TImageToImageMetric, typename TJointHistogramMetric >
@@ -158,12 +161,9 @@ JointHistogramMutualInformationGetValueAndDerivativeThreader< TDomainPartitioner
   JacobianReferenceType jacobianPositional = this->m_GetValueAndDerivativePerThreadVariables[threadId].MovingTransformJacobianPositional;
 
   /** For dense transforms, this returns identity */
-  this->m_JointAssociate->GetMovingTransform()->
-    ComputeJacobianWithRespectToParametersCachedTemporaries(virtualPoint,
-                                                            jacobian,
-                                                            jacobianPositional);
+  this->ComputeMovingTransformJacobian( virtualPoint, jacobian, jacobianPositional, threadId );
 
-  for ( NumberOfParametersType par = 0; par < this->GetCachedNumberOfLocalParameters(); par++ )
+  for ( NumberOfParametersType par = 0; par < localDerivativeReturn.Size(); par++ )
     {
     InternalComputationValueType sum = NumericTraits< InternalComputationValueType >::ZeroValue();
     for ( SizeValueType dim = 0; dim < TImageToImageMetric::MovingImageDimension; dim++ )
@@ -414,22 +414,31 @@ MattesMutualInformationImageToImageMetricv4<TFixedImage, TMovingImage, TVirtualI
 {
   const ThreadIdType localNumberOfWorkUnitsUsed = this->GetNumberOfWorkUnitsUsed();
 
-  const SizeValueType numberOfVoxels = this->m_NumberOfHistogramBins* this->m_NumberOfHistogramBins;
+  const SizeValueType numberOfBins = this->m_NumberOfHistogramBins;
+  const SizeValueType numberOfVoxels = numberOfBins * numberOfBins;
   JointPDFValueType * const pdfPtrStart = this->m_ThreaderJointPDF[0]->GetBufferPointer();
 
-  for( unsigned int t = 1; t < localNumberOfWorkUnitsUsed; ++t )
+  // Sum the per-thread PDFs into the first one, in parallel over the fixed
+  // image bins, each row of the joint PDF summed in the order of the threads.
+  if( localNumberOfWorkUnitsUsed > 1 )
     {
-    JointPDFValueType *             pdfPtr = pdfPtrStart;
-    JointPDFValueType const *       tPdfPtr = this->m_ThreaderJointPDF[t]->GetBufferPointer();
-    JointPDFValueType const * const tPdfPtrEnd = tPdfPtr + numberOfVoxels;
-    while( tPdfPtr < tPdfPtrEnd )
+    this->m_DenseGetValueAndDerivativeThreader->GetMultiThreader()->ParallelizeArray( 0, numberOfBins,
+      [this, localNumberOfWorkUnitsUsed, numberOfBins, pdfPtrStart]( SizeValueType fixedIndex )
       {
-      *( pdfPtr++ ) += *( tPdfPtr++ );
-      }
-    for( SizeValueType i = 0; i < this->m_NumberOfHistogramBins; ++i )
-      {
-      this->m_ThreaderFixedImageMarginalPDF[0][i] += this->m_ThreaderFixedImageMarginalPDF[t][i];
-      }
+      JointPDFValueType * const pdfRowPtr = pdfPtrStart + fixedIndex * numberOfBins;
+      for( ThreadIdType t = 1; t < localNumberOfWorkUnitsUsed; ++t )
+        {
+        JointPDFValueType *             pdfPtr = pdfRowPtr;
+        JointPDFValueType const *       tPdfPtr = this->m_ThreaderJointPDF[t]->GetBufferPointer() + fixedIndex * numberOfBins;
+        JointPDFValueType const * const tPdfPtrEnd = tPdfPtr + numberOfBins;
+        while( tPdfPtr < tPdfPtrEnd )
+          {
+          *( pdfPtr++ ) += *( tPdfPtr++ );
+          }
+        this->m_ThreaderFixedImageMarginalPDF[0][fixedIndex] += this->m_ThreaderFixedImageMarginalPDF[t][fixedIndex];
+        }
+      },
+      nullptr );
     }
 
   // Sum of this threads domain into the this->m_JointPDFSum that covers that part of the domain.
@@ -88,7 +88,9 @@ public:
 protected:
   MattesMutualInformationImageToImageMetricv4GetValueAndDerivativeThreader() :
     m_MattesAssociate(nullptr)
-  {}
+  {
+    this->m_TransformsMovingPointsInBatches = true;
+  }
 
   void BeforeThreadedExecution() override;
 
@@ -117,6 +119,15 @@ protected:
                              const PDFValueType &            cubicBSplineDerivativeValue,
                              DerivativeValueType *           localSupportDerivativeResultPtr) const;
 
+  /** Compute the cubic B-spline Parzen window and its derivative at the
+   * four moving image bins which a sample affects, from the offset \c t in
+   * [0, 1) of the sample's window term from its window index. All four
+   * values are evaluated together with the closed form polynomials of the
+   * spline segments, without the branches of the kernel functions. */
+  static void ComputeCubicBSplineParzenWindow( const PDFValueType t,
+                                               PDFValueType values[4],
+                                               PDFValueType derivatives[4] );
+
 private:
   /** Internal pointer to the Mattes metric object in use by this threader.
    *  This will avoid costly dynamic casting in tight loops. */
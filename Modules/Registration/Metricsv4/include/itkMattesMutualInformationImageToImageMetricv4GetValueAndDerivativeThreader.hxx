@@ -304,7 +304,7 @@ MattesMutualInformationImageToImageMetricv4GetValueAndDerivativeThreader< TDomai
     * zero-th (column) dimension and the fixed image bins corresponds
     * to the first (row) dimension.
     */
-  PDFValueType movingImageParzenWindowArg = static_cast<PDFValueType>( pdfMovingIndex ) - static_cast<PDFValueType>( movingImageParzenWindowTerm );
+  const PDFValueType movingImageParzenWindowArg = static_cast<PDFValueType>( pdfMovingIndex ) - static_cast<PDFValueType>( movingImageParzenWindowTerm );
 
   // Pointer to affected bin to be updated
   JointPDFValueType *pdfPtr = this->m_MattesAssociate->m_ThreaderJointPDF[threadId]->GetBufferPointer()
@@ -331,10 +331,31 @@ MattesMutualInformationImageToImageMetricv4GetValueAndDerivativeThreader< TDomai
   if( doComputeDerivative )
     {
     JacobianReferenceType jacobianPositional = this->m_GetValueAndDerivativePerThreadVariables[threadId].MovingTransformJacobianPositional;
-    this->m_MattesAssociate->GetMovingTransform()->
-      ComputeJacobianWithRespectToParametersCachedTemporaries(virtualPoint,
-                                                              jacobian,
-                                                              jacobianPositional);
+    this->ComputeMovingTransformJacobian( virtualPoint, jacobian, jacobianPositional, threadId );
+    }
+
+  // Evaluate the Parzen window at the four affected bins. Unless the window
+  // index was clamped for an extreme value, the window argument of the first
+  // bin is -1 - t with t in [0, 1), and the four values have a closed form.
+  PDFValueType parzenWindowValues[4];
+  PDFValueType parzenWindowDerivatives[4];
+  const PDFValueType movingImageParzenWindowOffset = movingImageParzenWindowTerm - static_cast<PDFValueType>( movingImageParzenWindowIndex );
+  if( movingImageParzenWindowOffset >= 0.0 && movingImageParzenWindowOffset < 1.0 )
+    {
+    Self::ComputeCubicBSplineParzenWindow( movingImageParzenWindowOffset, parzenWindowValues, parzenWindowDerivatives );
+    }
+  else
+    {
+    for( unsigned int bin = 0; bin < 4; ++bin )
+      {
+      parzenWindowValues[bin] = static_cast<PDFValueType>(
+        this->m_MattesAssociate->m_CubicBSplineKernel->Evaluate( movingImageParzenWindowArg + bin ) );
+      if( doComputeDerivative )
+        {
+        parzenWindowDerivatives[bin] = static_cast<PDFValueType>(
+          this->m_MattesAssociate->m_CubicBSplineDerivativeKernel->Evaluate( movingImageParzenWindowArg + bin ) );
+        }
+      }
     }
 
   SizeValueType movingParzenBin = 0;
@@ -342,14 +363,11 @@ MattesMutualInformationImageToImageMetricv4GetValueAndDerivativeThreader< TDomai
   const bool transformIsDisplacement = this->m_MattesAssociate->m_MovingTransform->GetTransformCategory() == MovingTransformType::DisplacementField;
   while( pdfMovingIndex <= pdfMovingIndexMax )
     {
-    const auto val = static_cast<PDFValueType>(
-      this->m_MattesAssociate->m_CubicBSplineKernel ->Evaluate( movingImageParzenWindowArg) );
-    *( pdfPtr++ ) += val;
+    *( pdfPtr++ ) += parzenWindowValues[movingParzenBin];
 
     if( doComputeDerivative )
       {
-      // Compute the cubicBSplineDerivative for later repeated use.
-      const PDFValueType cubicBSplineDerivativeValue = this->m_MattesAssociate->m_CubicBSplineDerivativeKernel->Evaluate(movingImageParzenWindowArg);
+      const PDFValueType cubicBSplineDerivativeValue = parzenWindowDerivatives[movingParzenBin];
 
 
       if( transformIsDisplacement )
@@ -392,7 +410,6 @@ MattesMutualInformationImageToImageMetricv4GetValueAndDerivativeThreader< TDomai
         }
       }
 
-    movingImageParzenWindowArg += 1.0;
     ++pdfMovingIndex;
     ++movingParzenBin;
     }
@@ -404,6 +421,30 @@ MattesMutualInformationImageToImageMetricv4GetValueAndDerivativeThreader< TDomai
   return false;
 }
 
+template< typename TDomainPartitioner, typename TImageToImageMetric, typename TMattesMutualInformationMetric >
+void
+MattesMutualInformationImageToImageMetricv4GetValueAndDerivativeThreader< TDomainPartitioner, TImageToImageMetric, TMattesMutualInformationMetric >
+::ComputeCubicBSplineParzenWindow( const PDFValueType t,
+                                   PDFValueType values[4],
+                                   PDFValueType derivatives[4] )
+{
+  // Window arguments -1 - t, -t, 1 - t and 2 - t
+  const PDFValueType s = 1.0 - t;
+  const PDFValueType t2 = t * t;
+  const PDFValueType t3 = t2 * t;
+  const PDFValueType s2 = s * s;
+
+  values[0] = s2 * s / 6.0;
+  values[1] = ( 4.0 - 6.0 * t2 + 3.0 * t3 ) / 6.0;
+  values[2] = ( 4.0 - 6.0 * s2 + 3.0 * s2 * s ) / 6.0;
+  values[3] = t3 / 6.0;
+
+  derivatives[0] = 0.5 * s2;
+  derivatives[1] = 2.0 * t - 1.5 * t2;
+  derivatives[2] = -2.0 * s + 1.5 * s2;
+  derivatives[3] = -0.5 * t2;
+}
+
 template< typename TDomainPartitioner, typename TImageToImageMetric, typename TMattesMutualInformationMetric >
 void
 MattesMutualInformationImageToImageMetricv4GetValueAndDerivativeThreader< TDomainPartitioner, TImageToImageMetric, TMattesMutualInformationMetric >
@@ -451,11 +492,9 @@ MattesMutualInformationImageToImageMetricv4GetValueAndDerivativeThreader< TDomai
     {
     // This entire block of code is used to accumulate the per-thread buffers
     // into 1 thread.
-    // For this thread, how many histogram elements are there?
+    // How many histogram elements are there for each fixed image bin?
     const NumberOfParametersType rowSize = this->GetCachedNumberOfLocalParameters()
       * this->m_MattesAssociate->m_NumberOfHistogramBins;
-    const SizeValueType histogramTotalElementsSize = rowSize
-      * this->m_MattesAssociate->m_NumberOfHistogramBins;
 
     // NOTE:  Negative 1 so that accumulators can all be positive accumulators
     const PDFValueType nFactor = -1.0
@@ -463,13 +502,18 @@ MattesMutualInformationImageToImageMetricv4GetValueAndDerivativeThreader< TDomai
 
     JointPDFDerivativesValueType *const accumulatorPdfDPtrStart =
       this->m_MattesAssociate->m_JointPDFDerivatives->GetBufferPointer();
-    JointPDFDerivativesValueType *             accumulatorPdfDPtr = accumulatorPdfDPtrStart;
-    JointPDFDerivativesValueType const * const tempThreadPdfDPtrEnd = accumulatorPdfDPtrStart
-      + histogramTotalElementsSize;
-    while( accumulatorPdfDPtr < tempThreadPdfDPtrEnd )
+    // Scale in parallel over the fixed image bins
+    this->GetMultiThreader()->ParallelizeArray( 0, this->m_MattesAssociate->m_NumberOfHistogramBins,
+      [accumulatorPdfDPtrStart, rowSize, nFactor]( SizeValueType fixedIndex )
       {
-      *( accumulatorPdfDPtr++ ) *= nFactor;
-      }
+      JointPDFDerivativesValueType *             accumulatorPdfDPtr = accumulatorPdfDPtrStart + fixedIndex * rowSize;
+      JointPDFDerivativesValueType const * const tempThreadPdfDPtrEnd = accumulatorPdfDPtr + rowSize;
+      while( accumulatorPdfDPtr < tempThreadPdfDPtrEnd )
+        {
+        *( accumulatorPdfDPtr++ ) *= nFactor;
+        }
+      },
+      nullptr );
     }
 
   // Collect and compute results.
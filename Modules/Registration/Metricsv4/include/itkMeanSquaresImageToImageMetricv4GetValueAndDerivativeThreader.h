@@ -64,7 +64,11 @@ public:
   using NumberOfParametersType = typename Superclass::NumberOfParametersType;
 
 protected:
-  MeanSquaresImageToImageMetricv4GetValueAndDerivativeThreader() = default;
+  MeanSquaresImageToImageMetricv4GetValueAndDerivativeThreader()
+  {
+    this->m_SupportsSparseDerivatives = true;
+    this->m_TransformsMovingPointsInBatches = true;
+  }
 
   /** This function computes the local voxel-wise contribution of
    *  the metric to the global integral of the metric/derivative.
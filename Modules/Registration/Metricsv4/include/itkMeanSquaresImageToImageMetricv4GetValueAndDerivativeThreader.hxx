@@ -61,12 +61,9 @@ MeanSquaresImageToImageMetricv4GetValueAndDerivativeThreader< TDomainPartitioner
   JacobianReferenceType jacobianPositional = this->m_GetValueAndDerivativePerThreadVariables[threadId].MovingTransformJacobianPositional;
 
   /** For dense transforms, this returns identity */
-  this->m_Associate->GetMovingTransform()->
-    ComputeJacobianWithRespectToParametersCachedTemporaries(virtualPoint,
-                                                            jacobian,
-                                                            jacobianPositional);
+  this->ComputeMovingTransformJacobian( virtualPoint, jacobian, jacobianPositional, threadId );
 
-  for ( unsigned int par = 0; par < this->GetCachedNumberOfLocalParameters(); par++ )
+  for ( unsigned int par = 0; par < localDerivativeReturn.Size(); par++ )
     {
     localDerivativeReturn[par] = NumericTraits<DerivativeValueType>::ZeroValue();
     for ( unsigned int nc = 0; nc < nComponents; nc++ )
@@ -22,6 +22,8 @@
 #include "itkIdentityTransform.h"
 #include "itkCompensatedSummation.h"
 
+#include <vector>
+
 namespace itk
 {
 
@@ -434,23 +436,37 @@ PointSetToPointSetMetricv4<TFixedPointSet, TMovingPointSet, TInternalComputation
     this->m_MovingTransformedPointSet = MovingTransformedPointSetType::New();
     this->m_MovingTransformedPointSet->Initialize();
 
-    typename MovingTransformType::InverseTransformBasePointer inverseTransform =
-      this->m_MovingTransform->GetInverseTransform();
-
-    typename MovingPointsContainer::ConstIterator It = this->m_MovingPointSet->GetPoints()->Begin();
-    while( It != this->m_MovingPointSet->GetPoints()->End() )
+    const MovingPointsContainer * movingPoints = this->m_MovingPointSet->GetPoints();
+    if( this->m_CalculateValueAndDerivativeInTangentSpace == true )
       {
-      if( this->m_CalculateValueAndDerivativeInTangentSpace == true )
+      using InverseTransformBaseType = typename MovingTransformType::InverseTransformBaseType;
+      typename MovingTransformType::InverseTransformBasePointer inverseTransform =
+        this->m_MovingTransform->GetInverseTransform();
+
+      // txf all the points at once into virtual space
+      std::vector< typename InverseTransformBaseType::InputPointType > inputPoints;
+      inputPoints.reserve( movingPoints->Size() );
+      for( typename MovingPointsContainer::ConstIterator It = movingPoints->Begin(); It != movingPoints->End(); ++It )
+        {
+        inputPoints.push_back( It.Value() );
+        }
+      std::vector< typename InverseTransformBaseType::OutputPointType > virtualPoints( inputPoints.size() );
+      inverseTransform->TransformPoints( inputPoints.data(), virtualPoints.data(), inputPoints.size() );
+
+      SizeValueType n = 0;
+      for( typename MovingPointsContainer::ConstIterator It = movingPoints->Begin(); It != movingPoints->End(); ++It )
         {
-        PointType point = inverseTransform->TransformPoint( It.Value() );
+        const PointType point( virtualPoints[n++] );
         this->m_MovingTransformedPointSet->SetPoint( It.Index(), point );
         }
-      else
+      }
+    else
+      {
+      // evaluation is perfomed in moving space, so just copy
+      for( typename MovingPointsContainer::ConstIterator It = movingPoints->Begin(); It != movingPoints->End(); ++It )
         {
-        // evaluation is perfomed in moving space, so just copy
         this->m_MovingTransformedPointSet->SetPoint( It.Index(), It.Value() );
         }
-      ++It;
       }
     this->m_MovingTransformedPointSetTime = this->GetMTime();
     }
@@ -474,28 +490,48 @@ PointSetToPointSetMetricv4<TFixedPointSet, TMovingPointSet, TInternalComputation
     this->m_VirtualTransformedPointSet = VirtualPointSetType::New();
     this->m_VirtualTransformedPointSet->Initialize();
 
+    using InverseTransformBaseType = typename FixedTransformType::InverseTransformBaseType;
     typename FixedTransformType::InverseTransformBasePointer inverseTransform = this->m_FixedTransform->GetInverseTransform();
 
-    typename FixedPointsContainer::ConstIterator It = this->m_FixedPointSet->GetPoints()->Begin();
-    while( It != this->m_FixedPointSet->GetPoints()->End() )
+    // txf all the points at once into virtual space
+    const FixedPointsContainer * fixedPoints = this->m_FixedPointSet->GetPoints();
+    std::vector< typename InverseTransformBaseType::InputPointType > inputPoints;
+    inputPoints.reserve( fixedPoints->Size() );
+    for( typename FixedPointsContainer::ConstIterator It = fixedPoints->Begin(); It != fixedPoints->End(); ++It )
       {
+      inputPoints.push_back( It.Value() );
+      }
+    std::vector< typename InverseTransformBaseType::OutputPointType > virtualPoints( inputPoints.size() );
+    inverseTransform->TransformPoints( inputPoints.data(), virtualPoints.data(), inputPoints.size() );
+
+    SizeValueType n = 0;
+    for( typename FixedPointsContainer::ConstIterator It = fixedPoints->Begin(); It != fixedPoints->End(); ++It, ++n )
+      {
+      const PointType point( virtualPoints[n] );
+      this->m_VirtualTransformedPointSet->SetPoint( It.Index(), point );
       if( this->m_CalculateValueAndDerivativeInTangentSpace == true )
         {
-        // txf into virtual space
-        PointType point = inverseTransform->TransformPoint( It.Value() );
-        this->m_VirtualTransformedPointSet->SetPoint( It.Index(), point );
         this->m_FixedTransformedPointSet->SetPoint( It.Index(), point );
         }
       else
         {
-        // txf into virtual space
-        PointType point = inverseTransform->TransformPoint( It.Value() );
-        this->m_VirtualTransformedPointSet->SetPoint( It.Index(), point );
-        // txf into moving space
-        point = this->m_MovingTransform->TransformPoint( point );
+        // the moving transform maps the points as they are stored
+        virtualPoints[n] = point;
+        }
+      }
+
+    if( this->m_CalculateValueAndDerivativeInTangentSpace == false )
+      {
+      // txf all the points at once into moving space
+      std::vector< typename MovingTransformType::OutputPointType > movingPoints( virtualPoints.size() );
+      this->m_MovingTransform->TransformPoints( virtualPoints.data(), movingPoints.data(), virtualPoints.size() );
+
+      n = 0;
+      for( typename FixedPointsContainer::ConstIterator It = fixedPoints->Begin(); It != fixedPoints->End(); ++It )
+        {
+        const PointType point( movingPoints[n++] );
         this->m_FixedTransformedPointSet->SetPoint( It.Index(), point );
         }
-      ++It;
       }
     this->m_FixedTransformedPointSetTime = this->GetMTime();
     }
@@ -0,0 +1,320 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+#include <atomic>
+#include <cmath>
+#include <iostream>
+
+#include "itkAffineTransform.h"
+#include "itkBSplineTransform.h"
+#include "itkCompositeTransform.h"
+#include "itkImageRegionIteratorWithIndex.h"
+#include "itkMattesMutualInformationImageToImageMetricv4.h"
+#include "itkMeanSquaresImageToImageMetricv4.h"
+#include "itkTestingMacros.h"
+
+/* ImageToImageMetricv4 value and derivative through a B-spline transform
+ * with the B-spline weights of the samples cached, compared to the value and
+ * derivative with the weights evaluated at every sample, for dense and
+ * sparse sampling, and for a composite transform which applies the
+ * B-spline transform first. The transform counts the points it transforms and the
+ * Jacobians it computes, which must be skipped for the cached samples.
+ */
+
+namespace
+{
+constexpr unsigned int Dimension = 2;
+
+class CountingBSplineTransform : public itk::BSplineTransform< double, Dimension, 3 >
+{
+public:
+  ITK_DISALLOW_COPY_AND_ASSIGN(CountingBSplineTransform);
+
+  using Self = CountingBSplineTransform;
+  using Superclass = itk::BSplineTransform< double, Dimension, 3 >;
+  using Pointer = itk::SmartPointer< Self >;
+  using ConstPointer = itk::SmartPointer< const Self >;
+
+  itkNewMacro(Self);
+  itkTypeMacro(CountingBSplineTransform, BSplineTransform);
+
+  using Superclass::TransformPoint;
+  OutputPointType TransformPoint( const InputPointType & point ) const override
+  {
+    ++m_NumberOfTransformedPoints;
+    return Superclass::TransformPoint( point );
+  }
+
+  void ComputeJacobianWithRespectToParameters( const InputPointType & point, JacobianType & jacobian ) const override
+  {
+    ++m_NumberOfJacobians;
+    Superclass::ComputeJacobianWithRespectToParameters( point, jacobian );
+  }
+
+  itk::SizeValueType GetNumberOfTransformedPoints() const
+  {
+    return m_NumberOfTransformedPoints;
+  }
+
+  itk::SizeValueType GetNumberOfJacobians() const
+  {
+    return m_NumberOfJacobians;
+  }
+
+  void ResetCounts()
+  {
+    m_NumberOfTransformedPoints = 0;
+    m_NumberOfJacobians = 0;
+  }
+
+protected:
+  CountingBSplineTransform() = default;
+  ~CountingBSplineTransform() override = default;
+
+private:
+  mutable std::atomic< itk::SizeValueType > m_NumberOfTransformedPoints{ 0 };
+  mutable std::atomic< itk::SizeValueType > m_NumberOfJacobians{ 0 };
+};
+
+using ImageType = itk::Image< double, Dimension >;
+using AffineTransformType = itk::AffineTransform< double, Dimension >;
+using CompositeTransformType = itk::CompositeTransform< double, Dimension >;
+
+ImageType::Pointer
+CreateImage( double shift )
+{
+  ImageType::SizeType size;
+  size.Fill( 32 );
+  ImageType::Pointer image = ImageType::New();
+  image->SetRegions( size );
+  image->Allocate();
+
+  itk::ImageRegionIteratorWithIndex< ImageType > it( image, image->GetLargestPossibleRegion() );
+  for ( ; !it.IsAtEnd(); ++it )
+    {
+    const double x = it.GetIndex()[0] - 15.5 - shift;
+    const double y = it.GetIndex()[1] - 15.5;
+    it.Set( 100.0 * std::exp( -( x * x + 2.0 * y * y ) / 60.0 ) );
+    }
+  return image;
+}
+
+void
+SetDeformation( CountingBSplineTransform * transform, double amplitude )
+{
+  CountingBSplineTransform::ParametersType parameters( transform->GetNumberOfParameters() );
+  for ( unsigned int n = 0; n < parameters.Size(); ++n )
+    {
+    parameters[n] = amplitude * std::sin( 0.9 * n );
+    }
+  transform->SetParametersByValue( parameters );
+}
+
+void
+SetMeshSize( CountingBSplineTransform * transform, unsigned int meshSize )
+{
+  CountingBSplineTransform::PhysicalDimensionsType physicalDimensions;
+  physicalDimensions.Fill( 31.0 );
+  CountingBSplineTransform::MeshSizeType mesh;
+  mesh.Fill( meshSize );
+  transform->SetTransformDomainPhysicalDimensions( physicalDimensions );
+  transform->SetTransformDomainMeshSize( mesh );
+  SetDeformation( transform, 0.5 );
+}
+
+template< typename TMetric >
+bool
+CompareMetrics( TMetric * cachedMetric, TMetric * metric, CountingBSplineTransform * transform,
+                itk::SizeValueType expectedNumberOfTransformedPoints )
+{
+  typename TMetric::MeasureType    cachedValue;
+  typename TMetric::DerivativeType cachedDerivative;
+  transform->ResetCounts();
+  cachedMetric->GetValueAndDerivative( cachedValue, cachedDerivative );
+  const itk::SizeValueType numberOfTransformedPoints = transform->GetNumberOfTransformedPoints();
+  const itk::SizeValueType numberOfJacobians = transform->GetNumberOfJacobians();
+
+  typename TMetric::MeasureType    value;
+  typename TMetric::DerivativeType derivative;
+  metric->GetValueAndDerivative( value, derivative );
+
+  if ( numberOfTransformedPoints != expectedNumberOfTransformedPoints )
+    {
+    std::cerr << "Test failed!" << std::endl;
+    std::cerr << "The transform was evaluated at " << numberOfTransformedPoints << " points instead of "
+              << expectedNumberOfTransformedPoints << std::endl;
+    return false;
+    }
+  // The Jacobian is computed at the valid samples only
+  if ( expectedNumberOfTransformedPoints == 0 && numberOfJacobians != 0 )
+    {
+    std::cerr << "Test failed!" << std::endl;
+    std::cerr << "The Jacobian was computed at " << numberOfJacobians << " points with all weights cached" << std::endl;
+    return false;
+    }
+  if ( cachedMetric->GetNumberOfValidPoints() != metric->GetNumberOfValidPoints() )
+    {
+    std::cerr << "Test failed!" << std::endl;
+    std::cerr << "Number of valid points " << cachedMetric->GetNumberOfValidPoints() << " instead of "
+              << metric->GetNumberOfValidPoints() << std::endl;
+    return false;
+    }
+  if ( std::abs( cachedValue - value ) > 1e-12 * std::abs( value ) )
+    {
+    std::cerr << "Test failed!" << std::endl;
+    std::cerr << "Value " << cachedValue << " instead of " << value << std::endl;
+    return false;
+    }
+  for ( unsigned int n = 0; n < derivative.Size(); ++n )
+    {
+    if ( std::abs( cachedDerivative[n] - derivative[n] ) > 1e-12 * ( 1.0 + std::abs( derivative[n] ) ) )
+      {
+      std::cerr << "Test failed!" << std::endl;
+      std::cerr << "Derivative [" << n << "] " << cachedDerivative[n] << " instead of " << derivative[n] << std::endl;
+      return false;
+      }
+    }
+  return true;
+}
+
+template< typename TMetric >
+bool
+TestMetric( const char * name )
+{
+  std::cout << name << std::endl;
+
+  ImageType::Pointer fixedImage = CreateImage( 0.0 );
+  ImageType::Pointer movingImage = CreateImage( 1.5 );
+
+  CountingBSplineTransform::Pointer transform = CountingBSplineTransform::New();
+  SetMeshSize( transform, 4 );
+
+  typename TMetric::Pointer cachedMetric = TMetric::New();
+  TEST_SET_GET_BOOLEAN( cachedMetric, UseCachingOfBSplineWeights, false );
+  TEST_SET_GET_BOOLEAN( cachedMetric, UseCachingOfBSplineWeights, true );
+  typename TMetric::Pointer metric = TMetric::New();
+  for ( TMetric * m : { cachedMetric.GetPointer(), metric.GetPointer() } )
+    {
+    m->SetFixedImage( fixedImage );
+    m->SetMovingImage( movingImage );
+    m->SetMovingTransform( transform );
+    m->Initialize();
+    }
+
+  const itk::SizeValueType numberOfPixels = fixedImage->GetLargestPossibleRegion().GetNumberOfPixels();
+  bool testPassed = true;
+
+  std::cout << "  Dense sampling" << std::endl;
+  testPassed &= CompareMetrics< TMetric >( cachedMetric, metric, transform, 0 );
+  SetDeformation( transform, -1.0 );
+  testPassed &= CompareMetrics< TMetric >( cachedMetric, metric, transform, 0 );
+
+  std::cout << "  Dense sampling, finer mesh" << std::endl;
+  SetMeshSize( transform, 6 );
+  testPassed &= CompareMetrics< TMetric >( cachedMetric, metric, transform, 0 );
+
+  std::cout << "  Dense sampling, bounded cache" << std::endl;
+  cachedMetric->SetMaximumNumberOfBSplineWeightsCachePoints( 100 );
+  cachedMetric->Initialize();
+  testPassed &= CompareMetrics< TMetric >( cachedMetric, metric, transform, numberOfPixels - 100 );
+
+  std::cout << "  Sparse sampling" << std::endl;
+  using PointSetType = typename TMetric::FixedSampledPointSetType;
+  typename PointSetType::Pointer pointSet = PointSetType::New();
+  itk::ImageRegionIteratorWithIndex< ImageType > it( fixedImage, fixedImage->GetLargestPossibleRegion() );
+  itk::SizeValueType numberOfSamples = 0;
+  for ( itk::SizeValueType n = 0; !it.IsAtEnd(); ++it, ++n )
+    {
+    if ( n % 3 == 0 )
+      {
+      typename PointSetType::PointType point;
+      fixedImage->TransformIndexToPhysicalPoint( it.GetIndex(), point );
+      pointSet->SetPoint( numberOfSamples++, point );
+      }
+    }
+  cachedMetric->SetMaximumNumberOfBSplineWeightsCachePoints( numberOfSamples / 2 );
+  for ( TMetric * m : { cachedMetric.GetPointer(), metric.GetPointer() } )
+    {
+    m->SetFixedSampledPointSet( pointSet );
+    m->UseSampledPointSetOn();
+    m->Initialize();
+    }
+  testPassed &= CompareMetrics< TMetric >( cachedMetric, metric, transform,
+                                           numberOfSamples - numberOfSamples / 2 );
+  SetDeformation( transform, 0.8 );
+  testPassed &= CompareMetrics< TMetric >( cachedMetric, metric, transform,
+                                           numberOfSamples - numberOfSamples / 2 );
+
+  std::cout << "  Without the cache" << std::endl;
+  cachedMetric->UseCachingOfBSplineWeightsOff();
+  testPassed &= CompareMetrics< TMetric >( cachedMetric, metric, transform, numberOfSamples );
+
+  // As in ImageRegistrationMethodv4, the composite transform applies the
+  // B-spline transform first, and only optimizes it
+  std::cout << "  Composite transform" << std::endl;
+  CompositeTransformType::Pointer compositeTransform = CompositeTransformType::New();
+  compositeTransform->AddTransform( transform );
+  cachedMetric->UseCachingOfBSplineWeightsOn();
+  for ( TMetric * m : { cachedMetric.GetPointer(), metric.GetPointer() } )
+    {
+    m->SetMovingTransform( compositeTransform );
+    m->Initialize();
+    }
+  testPassed &= CompareMetrics< TMetric >( cachedMetric, metric, transform,
+                                           numberOfSamples - numberOfSamples / 2 );
+
+  std::cout << "  Composite transform, applying an affine transform after the B-spline transform" << std::endl;
+  AffineTransformType::Pointer affineTransform = AffineTransformType::New();
+  affineTransform->Rotate2D( 0.05 );
+  AffineTransformType::OutputVectorType translation;
+  translation.Fill( -0.5 );
+  affineTransform->Translate( translation );
+  compositeTransform->ClearTransformQueue();
+  compositeTransform->AddTransform( affineTransform );
+  compositeTransform->AddTransform( transform );
+  compositeTransform->SetOnlyMostRecentTransformToOptimizeOn();
+  // The composite transform also transforms the points to compute its
+  // Jacobian, hence all the samples are cached
+  cachedMetric->SetMaximumNumberOfBSplineWeightsCachePoints( numberOfSamples );
+  for ( TMetric * m : { cachedMetric.GetPointer(), metric.GetPointer() } )
+    {
+    m->Initialize();
+    }
+  testPassed &= CompareMetrics< TMetric >( cachedMetric, metric, transform, 0 );
+
+  return testPassed;
+}
+}
+
+int itkImageToImageMetricv4BSplineWeightsCacheTest( int , char *[] )
+{
+  bool testPassed = true;
+
+  using MeanSquaresMetricType = itk::MeanSquaresImageToImageMetricv4< ImageType, ImageType >;
+  testPassed &= TestMetric< MeanSquaresMetricType >( "MeanSquaresImageToImageMetricv4" );
+
+  using MattesMetricType = itk::MattesMutualInformationImageToImageMetricv4< ImageType, ImageType >;
+  testPassed &= TestMetric< MattesMetricType >( "MattesMutualInformationImageToImageMetricv4" );
+
+  if ( !testPassed )
+    {
+    return EXIT_FAILURE;
+    }
+  std::cout << "Test finished." << std::endl;
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,257 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+#include <cmath>
+#include <iostream>
+
+#include "itkAffineTransform.h"
+#include "itkBSplineTransform.h"
+#include "itkCompositeTransform.h"
+#include "itkIdentityTransform.h"
+#include "itkImageRegionIteratorWithIndex.h"
+#include "itkJointHistogramMutualInformationImageToImageMetricv4.h"
+#include "itkMeanSquaresImageToImageMetricv4.h"
+
+/* ImageToImageMetricv4 derivative through a B-spline transform, which is
+ * accumulated only for the parameters supported at each sample, compared to
+ * the derivative through a composite transform holding the same B-spline
+ * transform and an identity transform, both optimized, which is accumulated
+ * for all the parameters. For dense and sparse sampling, with and without the
+ * cached B-spline weights, and with one and several work units. The same
+ * for a composite transform applying an affine transform after the B-spline
+ * transform, and only optimizing the latter, as in ImageRegistrationMethodv4.
+ */
+
+namespace
+{
+constexpr unsigned int Dimension = 2;
+
+using ImageType = itk::Image< double, Dimension >;
+using BSplineTransformType = itk::BSplineTransform< double, Dimension, 3 >;
+using CompositeTransformType = itk::CompositeTransform< double, Dimension >;
+using AffineTransformType = itk::AffineTransform< double, Dimension >;
+using IdentityTransformType = itk::IdentityTransform< double, Dimension >;
+
+ImageType::Pointer
+CreateImage( double shift )
+{
+  ImageType::SizeType size;
+  size.Fill( 40 );
+  ImageType::Pointer image = ImageType::New();
+  image->SetRegions( size );
+  image->Allocate();
+
+  itk::ImageRegionIteratorWithIndex< ImageType > it( image, image->GetLargestPossibleRegion() );
+  for ( ; !it.IsAtEnd(); ++it )
+    {
+    const double x = it.GetIndex()[0] - 19.5 - shift;
+    const double y = it.GetIndex()[1] - 19.5;
+    it.Set( 100.0 * std::exp( -( x * x + 2.0 * y * y ) / 80.0 ) );
+    }
+  return image;
+}
+
+template< typename TMetric >
+bool
+CompareMetrics( TMetric * sparseMetric, TMetric * metric )
+{
+  typename TMetric::MeasureType    sparseValue;
+  typename TMetric::DerivativeType sparseDerivative;
+  sparseMetric->GetValueAndDerivative( sparseValue, sparseDerivative );
+
+  typename TMetric::MeasureType    value;
+  typename TMetric::DerivativeType derivative;
+  metric->GetValueAndDerivative( value, derivative );
+
+  if ( sparseMetric->GetNumberOfValidPoints() != metric->GetNumberOfValidPoints() )
+    {
+    std::cerr << "Test failed!" << std::endl;
+    std::cerr << "Number of valid points " << sparseMetric->GetNumberOfValidPoints() << " instead of "
+              << metric->GetNumberOfValidPoints() << std::endl;
+    return false;
+    }
+  if ( std::abs( sparseValue - value ) > 1e-12 * std::abs( value ) )
+    {
+    std::cerr << "Test failed!" << std::endl;
+    std::cerr << "Value " << sparseValue << " instead of " << value << std::endl;
+    return false;
+    }
+  if ( sparseDerivative.Size() != derivative.Size() )
+    {
+    std::cerr << "Test failed!" << std::endl;
+    std::cerr << "Derivative size " << sparseDerivative.Size() << " instead of " << derivative.Size() << std::endl;
+    return false;
+    }
+  const double derivativeMagnitude = derivative.inf_norm();
+  if ( derivativeMagnitude == 0.0 )
+    {
+    std::cerr << "Test failed!" << std::endl;
+    std::cerr << "Zero derivative" << std::endl;
+    return false;
+    }
+  for ( unsigned int n = 0; n < derivative.Size(); ++n )
+    {
+    if ( std::abs( sparseDerivative[n] - derivative[n] ) > 1e-10 * derivativeMagnitude )
+      {
+      std::cerr << "Test failed!" << std::endl;
+      std::cerr << "Derivative [" << n << "] " << sparseDerivative[n] << " instead of " << derivative[n] << std::endl;
+      return false;
+      }
+    }
+  return true;
+}
+
+template< typename TMetric >
+bool
+TestTransforms( ImageType * fixedImage,
+                ImageType * movingImage,
+                typename TMetric::MovingTransformType * sparseTransform,
+                typename TMetric::MovingTransformType * transform )
+{
+  typename TMetric::Pointer sparseMetric = TMetric::New();
+  sparseMetric->SetMovingTransform( sparseTransform );
+  typename TMetric::Pointer metric = TMetric::New();
+  metric->SetMovingTransform( transform );
+  for ( TMetric * m : { sparseMetric.GetPointer(), metric.GetPointer() } )
+    {
+    m->SetFixedImage( fixedImage );
+    m->SetMovingImage( movingImage );
+    m->Initialize();
+    }
+
+  bool testPassed = true;
+
+  std::cout << "  Dense sampling" << std::endl;
+  testPassed &= CompareMetrics< TMetric >( sparseMetric, metric );
+
+  std::cout << "  Dense sampling, one work unit" << std::endl;
+  sparseMetric->SetMaximumNumberOfWorkUnits( 1 );
+  testPassed &= CompareMetrics< TMetric >( sparseMetric, metric );
+  sparseMetric->SetMaximumNumberOfWorkUnits( 4 );
+
+  std::cout << "  Dense sampling, cached weights" << std::endl;
+  sparseMetric->UseCachingOfBSplineWeightsOn();
+  testPassed &= CompareMetrics< TMetric >( sparseMetric, metric );
+
+  std::cout << "  Sparse sampling, cached weights" << std::endl;
+  using PointSetType = typename TMetric::FixedSampledPointSetType;
+  typename PointSetType::Pointer pointSet = PointSetType::New();
+  itk::ImageRegionIteratorWithIndex< ImageType > it( fixedImage, fixedImage->GetLargestPossibleRegion() );
+  itk::SizeValueType numberOfSamples = 0;
+  for ( itk::SizeValueType n = 0; !it.IsAtEnd(); ++it, ++n )
+    {
+    // Samples in decreasing order, so that threads also extend their
+    // parameter ranges downwards
+    if ( n % 3 == 0 )
+      {
+      typename PointSetType::PointType point;
+      fixedImage->TransformIndexToPhysicalPoint( it.GetIndex(), point );
+      point[0] = 39.0 - point[0];
+      point[1] = 39.0 - point[1];
+      pointSet->SetPoint( numberOfSamples++, point );
+      }
+    }
+  for ( TMetric * m : { sparseMetric.GetPointer(), metric.GetPointer() } )
+    {
+    m->SetFixedSampledPointSet( pointSet );
+    m->UseSampledPointSetOn();
+    m->Initialize();
+    }
+  testPassed &= CompareMetrics< TMetric >( sparseMetric, metric );
+
+  std::cout << "  Sparse sampling" << std::endl;
+  sparseMetric->UseCachingOfBSplineWeightsOff();
+  testPassed &= CompareMetrics< TMetric >( sparseMetric, metric );
+
+  return testPassed;
+}
+
+template< typename TMetric >
+bool
+TestMetric( const char * name )
+{
+  std::cout << name << std::endl;
+
+  ImageType::Pointer fixedImage = CreateImage( 0.0 );
+  ImageType::Pointer movingImage = CreateImage( 2.0 );
+
+  BSplineTransformType::Pointer transform = BSplineTransformType::New();
+  BSplineTransformType::PhysicalDimensionsType physicalDimensions;
+  physicalDimensions.Fill( 39.0 );
+  BSplineTransformType::MeshSizeType meshSize;
+  meshSize.Fill( 7 );
+  transform->SetTransformDomainPhysicalDimensions( physicalDimensions );
+  transform->SetTransformDomainMeshSize( meshSize );
+  BSplineTransformType::ParametersType parameters( transform->GetNumberOfParameters() );
+  for ( unsigned int n = 0; n < parameters.Size(); ++n )
+    {
+    parameters[n] = 0.6 * std::sin( 0.7 * n );
+    }
+  transform->SetParametersByValue( parameters );
+
+  // The metric only finds a B-spline transform in a composite transform
+  // which optimizes nothing else, so this one hides it, without parameters
+  // or Jacobian of its own.
+  CompositeTransformType::Pointer hiddenTransform = CompositeTransformType::New();
+  hiddenTransform->AddTransform( IdentityTransformType::New() );
+  hiddenTransform->AddTransform( transform );
+  hiddenTransform->SetAllTransformsToOptimizeOn();
+
+  bool testPassed = true;
+
+  std::cout << " B-spline transform" << std::endl;
+  testPassed &= TestTransforms< TMetric >( fixedImage, movingImage, transform, hiddenTransform );
+
+  std::cout << " Composite transform, applying an affine transform after the B-spline transform" << std::endl;
+  AffineTransformType::Pointer affineTransform = AffineTransformType::New();
+  affineTransform->Rotate2D( 0.1 );
+  AffineTransformType::OutputVectorType scale;
+  scale[0] = 1.1;
+  scale[1] = 0.9;
+  affineTransform->Scale( scale );
+  CompositeTransformType::Pointer compositeTransform = CompositeTransformType::New();
+  compositeTransform->AddTransform( affineTransform );
+  compositeTransform->AddTransform( transform );
+  compositeTransform->SetOnlyMostRecentTransformToOptimizeOn();
+  CompositeTransformType::Pointer hiddenCompositeTransform = CompositeTransformType::New();
+  hiddenCompositeTransform->AddTransform( affineTransform );
+  hiddenCompositeTransform->AddTransform( hiddenTransform );
+  hiddenCompositeTransform->SetOnlyMostRecentTransformToOptimizeOn();
+  testPassed &= TestTransforms< TMetric >( fixedImage, movingImage, compositeTransform, hiddenCompositeTransform );
+
+  return testPassed;
+}
+}
+
+int itkImageToImageMetricv4SparseDerivativeTest( int , char *[] )
+{
+  bool testPassed = true;
+
+  using MeanSquaresMetricType = itk::MeanSquaresImageToImageMetricv4< ImageType, ImageType >;
+  testPassed &= TestMetric< MeanSquaresMetricType >( "MeanSquaresImageToImageMetricv4" );
+
+  using JointHistogramMetricType = itk::JointHistogramMutualInformationImageToImageMetricv4< ImageType, ImageType >;
+  testPassed &= TestMetric< JointHistogramMetricType >( "JointHistogramMutualInformationImageToImageMetricv4" );
+
+  if ( !testPassed )
+    {
+    return EXIT_FAILURE;
+    }
+  std::cout << "Test finished." << std::endl;
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,201 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+#include <atomic>
+#include <cmath>
+#include <iostream>
+
+#include "itkAffineTransform.h"
+#include "itkCorrelationImageToImageMetricv4.h"
+#include "itkImageRegionIteratorWithIndex.h"
+#include "itkJointHistogramMutualInformationImageToImageMetricv4.h"
+#include "itkMattesMutualInformationImageToImageMetricv4.h"
+#include "itkMeanSquaresImageToImageMetricv4.h"
+
+/* The threaders of the metrics which process the points with the
+ * ProcessVirtualPoint of ImageToImageMetricv4GetValueAndDerivativeThreaderBase
+ * map the virtual points into the moving space in batches, with
+ * TransformPoints. The number of points given to TransformPoints is counted,
+ * for dense and sparse sampling. The correlation metric, whose threaders
+ * process the points themselves, still maps them one at a time.
+ */
+
+namespace
+{
+constexpr unsigned int Dimension = 2;
+
+class CountingAffineTransform : public itk::AffineTransform< double, Dimension >
+{
+public:
+  ITK_DISALLOW_COPY_AND_ASSIGN(CountingAffineTransform);
+
+  using Self = CountingAffineTransform;
+  using Superclass = itk::AffineTransform< double, Dimension >;
+  using Pointer = itk::SmartPointer< Self >;
+  using ConstPointer = itk::SmartPointer< const Self >;
+
+  itkNewMacro(Self);
+  itkTypeMacro(CountingAffineTransform, AffineTransform);
+
+  void TransformPoints( const InputPointType * inputPoints,
+                        OutputPointType * outputPoints,
+                        itk::SizeValueType numberOfPoints ) const override
+  {
+    m_NumberOfBatchedPoints += numberOfPoints;
+    Superclass::TransformPoints( inputPoints, outputPoints, numberOfPoints );
+  }
+
+  itk::SizeValueType GetNumberOfBatchedPoints() const
+  {
+    return m_NumberOfBatchedPoints;
+  }
+
+  void ResetNumberOfBatchedPoints()
+  {
+    m_NumberOfBatchedPoints = 0;
+  }
+
+protected:
+  CountingAffineTransform() = default;
+  ~CountingAffineTransform() override = default;
+
+  // TransformPoint is inherited, so the points are batched as for the
+  // superclass
+  itkTransformPointsBatchedMacro(Self);
+
+private:
+  mutable std::atomic< itk::SizeValueType > m_NumberOfBatchedPoints{ 0 };
+};
+
+using ImageType = itk::Image< double, Dimension >;
+
+ImageType::Pointer
+CreateImage( double shift )
+{
+  ImageType::SizeType size;
+  size.Fill( 32 );
+  ImageType::Pointer image = ImageType::New();
+  image->SetRegions( size );
+  image->Allocate();
+
+  itk::ImageRegionIteratorWithIndex< ImageType > it( image, image->GetLargestPossibleRegion() );
+  for ( ; !it.IsAtEnd(); ++it )
+    {
+    const double x = it.GetIndex()[0] - 15.5 - shift;
+    const double y = it.GetIndex()[1] - 15.5;
+    it.Set( 100.0 * std::exp( -( x * x + 2.0 * y * y ) / 60.0 ) );
+    }
+  return image;
+}
+
+template< typename TMetric >
+bool
+TestMetric( const char * name, bool expectBatches )
+{
+  std::cout << name << std::endl;
+
+  ImageType::Pointer fixedImage = CreateImage( 0.0 );
+  ImageType::Pointer movingImage = CreateImage( 1.5 );
+
+  CountingAffineTransform::Pointer transform = CountingAffineTransform::New();
+  transform->Rotate2D( 0.05 );
+
+  typename TMetric::Pointer metric = TMetric::New();
+  metric->SetFixedImage( fixedImage );
+  metric->SetMovingImage( movingImage );
+  metric->SetMovingTransform( transform );
+  metric->Initialize();
+
+  bool testPassed = true;
+  for ( bool sparse : { false, true } )
+    {
+    itk::SizeValueType numberOfSamples = fixedImage->GetLargestPossibleRegion().GetNumberOfPixels();
+    if ( sparse )
+      {
+      using PointSetType = typename TMetric::FixedSampledPointSetType;
+      typename PointSetType::Pointer pointSet = PointSetType::New();
+      itk::ImageRegionIteratorWithIndex< ImageType > it( fixedImage, fixedImage->GetLargestPossibleRegion() );
+      numberOfSamples = 0;
+      for ( itk::SizeValueType n = 0; !it.IsAtEnd(); ++it, ++n )
+        {
+        if ( n % 3 == 0 )
+          {
+          typename PointSetType::PointType point;
+          fixedImage->TransformIndexToPhysicalPoint( it.GetIndex(), point );
+          pointSet->SetPoint( numberOfSamples++, point );
+          }
+        }
+      metric->SetFixedSampledPointSet( pointSet );
+      metric->UseSampledPointSetOn();
+      metric->Initialize();
+      }
+
+    transform->ResetNumberOfBatchedPoints();
+    typename TMetric::MeasureType    value;
+    typename TMetric::DerivativeType derivative;
+    metric->GetValueAndDerivative( value, derivative );
+
+    const itk::SizeValueType numberOfBatchedPoints = transform->GetNumberOfBatchedPoints();
+    std::cout << ( sparse ? "  Sparse" : "  Dense" ) << " sampling: value " << value << ", " << numberOfBatchedPoints
+              << " batched points for " << numberOfSamples << " samples" << std::endl;
+    if ( expectBatches && numberOfBatchedPoints != numberOfSamples )
+      {
+      std::cerr << "Test failed!" << std::endl;
+      std::cerr << "The samples were not transformed in batches" << std::endl;
+      testPassed = false;
+      }
+    if ( !expectBatches && numberOfBatchedPoints != 0 )
+      {
+      std::cerr << "Test failed!" << std::endl;
+      std::cerr << "Unexpected batched points" << std::endl;
+      testPassed = false;
+      }
+    if ( metric->GetNumberOfValidPoints() == 0 || derivative.inf_norm() == 0.0 )
+      {
+      std::cerr << "Test failed!" << std::endl;
+      std::cerr << "No valid point, or zero derivative" << std::endl;
+      testPassed = false;
+      }
+    }
+  return testPassed;
+}
+}
+
+int itkImageToImageMetricv4TransformPointsTest( int , char *[] )
+{
+  bool testPassed = true;
+
+  using MeanSquaresMetricType = itk::MeanSquaresImageToImageMetricv4< ImageType, ImageType >;
+  testPassed &= TestMetric< MeanSquaresMetricType >( "MeanSquaresImageToImageMetricv4", true );
+
+  using MattesMetricType = itk::MattesMutualInformationImageToImageMetricv4< ImageType, ImageType >;
+  testPassed &= TestMetric< MattesMetricType >( "MattesMutualInformationImageToImageMetricv4", true );
+
+  using JointHistogramMetricType = itk::JointHistogramMutualInformationImageToImageMetricv4< ImageType, ImageType >;
+  testPassed &= TestMetric< JointHistogramMetricType >( "JointHistogramMutualInformationImageToImageMetricv4", true );
+
+  using CorrelationMetricType = itk::CorrelationImageToImageMetricv4< ImageType, ImageType >;
+  testPassed &= TestMetric< CorrelationMetricType >( "CorrelationImageToImageMetricv4", false );
+
+  if ( !testPassed )
+    {
+    return EXIT_FAILURE;
+    }
+  std::cout << "Test finished." << std::endl;
+  return EXIT_SUCCESS;
+}
@@ -411,6 +411,38 @@ int TestMattesMetricWithAffineTransform(
       }
     }
 
+//---------------------------------------------------------
+// Compare to the value and derivative computed by a single
+// work unit, whose joint PDF is not reduced
+//---------------------------------------------------------
+  transformer->SetParameters( parameters );
+  metric->GetValueAndDerivative( metricValueWithDerivative, derivative );
+  typename MetricType::MeasureType    singleWorkUnitValue;
+  typename MetricType::DerivativeType singleWorkUnitDerivative( numberOfParameters );
+  const itk::ThreadIdType numberOfWorkUnits = metric->GetMaximumNumberOfWorkUnits();
+  metric->SetMaximumNumberOfWorkUnits( 1 );
+  metric->GetValueAndDerivative( singleWorkUnitValue, singleWorkUnitDerivative );
+  metric->SetMaximumNumberOfWorkUnits( numberOfWorkUnits );
+  std::cout << "Single work unit value: " << singleWorkUnitValue << " derivative: " << singleWorkUnitDerivative;
+  bool singleWorkUnitPassed =
+    itk::Math::abs( singleWorkUnitValue - metricValueWithDerivative ) <= 1e-10 * itk::Math::abs( metricValueWithDerivative );
+  for( unsigned int j = 0; j < numberOfParameters; ++j )
+    {
+    if( itk::Math::abs( singleWorkUnitDerivative[j] - derivative[j] ) > 1e-10 * ( 1.0 + itk::Math::abs( derivative[j] ) ) )
+      {
+      singleWorkUnitPassed = false;
+      }
+    }
+  if( singleWorkUnitPassed )
+    {
+    std::cout << "\t[PASSED]" << std::endl;
+    }
+  else
+    {
+    std::cout << "\t[FAILED] value and derivative differ from " << metricValueWithDerivative << " " << derivative << std::endl;
+    testFailed = true;
+    }
+
   if( testFailed )
     {
     return EXIT_FAILURE;
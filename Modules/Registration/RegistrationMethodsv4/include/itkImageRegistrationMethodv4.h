@@ -26,6 +26,7 @@
 #include "itkObjectToObjectMultiMetricv4.h"
 #include "itkObjectToObjectOptimizerBase.h"
 #include "itkImageToImageMetricv4.h"
+#include "itkMersenneTwisterRandomVariateGenerator.h"
 #include "itkPointSetToPointSetMetricv4.h"
 #include "itkShrinkImageFilter.h"
 #include "itkIdentityTransform.h"
@@ -79,6 +80,17 @@ namespace itk
  * given stage so typical use will be to assign the base adaptor class to
  * level 0 of all stages but we leave that open to the user.
  *
+ * Metric sampling: with the REGULAR or RANDOM metric sampling strategy,
+ * the image metrics are evaluated at a subset of the virtual domain, whose
+ * size is given by the metric sampling percentage of the level.  By default
+ * the samples are drawn once per level.  With
+ * ResampleMetricSamplesEachIteration on, a new set of samples is drawn
+ * in parallel before every iteration of the optimizer, so that a small
+ * sampling percentage yields a stochastic (mini-batch) gradient descent,
+ * e.g. with the GradientDescentOptimizerv4 or the
+ * RegularStepGradientDescentOptimizerv4.  The samples are reproducible
+ * for a given seed, whatever the number of threads.
+ *
  * Output: The output is the updated transform.
  *
  * \author Nick Tustison
@@ -279,6 +291,22 @@ public:
   void MetricSamplingReinitializeSeed();
   void MetricSamplingReinitializeSeed(int seed);
 
+  /** Set/Get whether the metric samples are drawn again before each
+   * iteration of the optimizer, rather than once per level.  Only used with
+   * the REGULAR and RANDOM metric sampling strategies.  The REGULAR samples
+   * are perturbed anew around the same voxels, whereas the RANDOM samples
+   * are drawn uniformly over the virtual domain.  Default is off. */
+  itkSetMacro( ResampleMetricSamplesEachIteration, bool );
+  itkGetConstMacro( ResampleMetricSamplesEachIteration, bool );
+  itkBooleanMacro( ResampleMetricSamplesEachIteration );
+
+  /** Set/Get the number of metric samples drawn by each block, when they are
+   * drawn again before each iteration.  Each block has its own generator, so
+   * the samples depend on this number, but not on the number of threads.
+   * Default is 4096. */
+  itkSetClampMacro( NumberOfMetricSamplesPerBlock, SizeValueType, 1, NumericTraits<SizeValueType>::max() );
+  itkGetConstMacro( NumberOfMetricSamplesPerBlock, SizeValueType );
+
   /** Set the metric sampling percentage. Valid values are in (0.0, 1.0] */
   void SetMetricSamplingPercentage( const RealType );
 
@@ -460,6 +488,15 @@ protected:
   /** Get metric samples. */
   virtual void SetMetricSamplePoints();
 
+  using RandomizerType = Statistics::MersenneTwisterRandomVariateGenerator;
+
+  /** Draw the metric samples of the current level in parallel.  The samples
+   * are drawn in blocks of NumberOfMetricSamplesPerBlock samples, each with
+   * its own generator seeded from the given one, so that they do not depend
+   * on the number of threads. */
+  virtual void GenerateMetricSamplePointsInParallel( const VirtualImageType * virtualImage,
+    const FixedImageMaskType * fixedMaskImage, RandomizerType * randomizer, MetricSamplePointSetType * samplePointSet );
+
   SizeValueType                                                   m_CurrentLevel;
   SizeValueType                                                   m_NumberOfLevels;
   SizeValueType                                                   m_CurrentIteration;
@@ -484,6 +521,8 @@ protected:
   MetricPointer                                                   m_Metric;
   MetricSamplingStrategyType                                      m_MetricSamplingStrategy;
   MetricSamplingPercentageArrayType                               m_MetricSamplingPercentagePerLevel;
+  bool                                                            m_ResampleMetricSamplesEachIteration;
+  SizeValueType                                                   m_NumberOfMetricSamplesPerBlock;
   SizeValueType                                                   m_NumberOfMetrics;
   int                                                             m_FirstImageMetricIndex;
   std::vector<ShrinkFactorsPerDimensionContainerType>             m_ShrinkFactorsPerLevel;
@@ -24,6 +24,7 @@
 #include "itkGradientDescentOptimizerv4.h"
 #include "itkImageRandomConstIteratorWithIndex.h"
 #include "itkImageRegionConstIteratorWithIndex.h"
+#include "itkCommand.h"
 #include "itkImageToImageMetricv4.h"
 #include "itkIterationReporter.h"
 #include "itkMattesMutualInformationImageToImageMetricv4.h"
@@ -128,6 +129,8 @@ ImageRegistrationMethodv4<TFixedImage, TMovingImage, TTransform, TVirtualImage,
   this->m_MetricSamplingStrategy = NONE;
   this->m_MetricSamplingPercentagePerLevel.SetSize( this->m_NumberOfLevels );
   this->m_MetricSamplingPercentagePerLevel.Fill( 1.0 );
+  this->m_ResampleMetricSamplesEachIteration = false;
+  this->m_NumberOfMetricSamplesPerBlock = 4096;
 }
 
 template<typename TFixedImage, typename TMovingImage, typename TTransform, typename TVirtualImage, typename TPointSet>
@@ -799,13 +802,42 @@ ImageRegistrationMethodv4<TFixedImage, TMovingImage, TTransform, TVirtualImage,
   // Ensure the same seed is used for each update
   this->m_CurrentRandomSeed = this->m_RandomSeed;
 
-  for( this->m_CurrentLevel = 0; this->m_CurrentLevel < this->m_NumberOfLevels; this->m_CurrentLevel++ )
+  // Draw new metric samples after each iteration of the optimizer, which
+  // the optimizer reports once the transform has been updated
+  const bool resampleEachIteration =
+    this->m_ResampleMetricSamplesEachIteration && this->m_MetricSamplingStrategy != NONE;
+  unsigned long resampleObserverTag = 0;
+  if( resampleEachIteration )
     {
-    this->InitializeRegistrationAtEachLevel( this->m_CurrentLevel );
+    using ResampleCommandType = SimpleMemberCommand<Self>;
+    typename ResampleCommandType::Pointer resampleCommand = ResampleCommandType::New();
+    resampleCommand->SetCallbackFunction( this, &Self::SetMetricSamplePoints );
+    resampleObserverTag = this->m_Optimizer->AddObserver( IterationEvent(), resampleCommand );
+    }
+
+  try
+    {
+    for( this->m_CurrentLevel = 0; this->m_CurrentLevel < this->m_NumberOfLevels; this->m_CurrentLevel++ )
+      {
+      this->InitializeRegistrationAtEachLevel( this->m_CurrentLevel );
+
+      this->m_Metric->Initialize();
 
-    this->m_Metric->Initialize();
+      this->m_Optimizer->StartOptimization();
+      }
+    }
+  catch( ... )
+    {
+    if( resampleEachIteration )
+      {
+      this->m_Optimizer->RemoveObserver( resampleObserverTag );
+      }
+    throw;
+    }
 
-    this->m_Optimizer->StartOptimization();
+  if( resampleEachIteration )
+    {
+    this->m_Optimizer->RemoveObserver( resampleObserverTag );
     }
 }
 
@@ -941,7 +973,6 @@ ImageRegistrationMethodv4<TFixedImage, TMovingImage, TTransform, TVirtualImage,
 
     using SamplePointType = typename MetricSamplePointSetType::PointType;
 
-    using RandomizerType = Statistics::MersenneTwisterRandomVariateGenerator;
     typename RandomizerType::Pointer randomizer = RandomizerType::New();
     if (m_ReseedIterator)
       {
@@ -953,26 +984,69 @@ ImageRegistrationMethodv4<TFixedImage, TMovingImage, TTransform, TVirtualImage,
       }
 
 
-    unsigned long index = 0;
-
-    switch( this->m_MetricSamplingStrategy )
+    if( this->m_ResampleMetricSamplesEachIteration )
+      {
+      this->GenerateMetricSamplePointsInParallel( virtualImage, fixedMaskImage, randomizer, samplePointSet );
+      }
+    else
       {
-      case REGULAR:
+      unsigned long index = 0;
+
+      switch( this->m_MetricSamplingStrategy )
         {
-        const auto sampleCount = static_cast<unsigned long>(
-          std::ceil( 1.0 / this->m_MetricSamplingPercentagePerLevel[this->m_CurrentLevel] ) );
-        unsigned long count = sampleCount; //Start at sampleCount to keep behavior backwards identical, using first element.
-        ImageRegionConstIteratorWithIndex<VirtualDomainImageType> It( virtualImage, virtualDomainRegion );
-        for( It.GoToBegin(); !It.IsAtEnd(); ++It )
+        case REGULAR:
+          {
+          const auto sampleCount = static_cast<unsigned long>(
+            std::ceil( 1.0 / this->m_MetricSamplingPercentagePerLevel[this->m_CurrentLevel] ) );
+          unsigned long count = sampleCount; //Start at sampleCount to keep behavior backwards identical, using first element.
+          ImageRegionConstIteratorWithIndex<VirtualDomainImageType> It( virtualImage, virtualDomainRegion );
+          for( It.GoToBegin(); !It.IsAtEnd(); ++It )
+            {
+            if( count == sampleCount )
+              {
+              count=0; //Reset counter
+              SamplePointType point;
+              virtualImage->TransformIndexToPhysicalPoint( It.GetIndex(), point );
+
+              // randomly perturb the point within a voxel (approximately)
+              for( SizeValueType d = 0; d < ImageDimension; d++ )
+                {
+                point[d] += randomizer->GetNormalVariate() * oneThirdVirtualSpacing[d];
+                }
+              if( !fixedMaskImage || fixedMaskImage->IsInsideInWorldSpace(
+                  point ) )
+                {
+                samplePointSet->SetPoint( index, point );
+                ++index;
+                }
+              }
+            ++count;
+            }
+          break;
+          }
+        case RANDOM:
           {
-          if( count == sampleCount )
+          const unsigned long totalVirtualDomainVoxels = virtualDomainRegion.GetNumberOfPixels();
+          const auto sampleCount = static_cast<unsigned long>(
+           static_cast<float>( totalVirtualDomainVoxels )
+                 * this->m_MetricSamplingPercentagePerLevel[this->m_CurrentLevel] );
+          ImageRandomConstIteratorWithIndex<VirtualDomainImageType> ItR( virtualImage, virtualDomainRegion );
+          if (m_ReseedIterator)
+            {
+            ItR.ReinitializeSeed();
+            }
+          else
+            {
+            ItR.ReinitializeSeed( m_CurrentRandomSeed++ );
+            }
+          ItR.SetNumberOfSamples( sampleCount );
+          for( ItR.GoToBegin(); !ItR.IsAtEnd(); ++ItR )
             {
-            count=0; //Reset counter
             SamplePointType point;
-            virtualImage->TransformIndexToPhysicalPoint( It.GetIndex(), point );
+            virtualImage->TransformIndexToPhysicalPoint( ItR.GetIndex(), point );
 
             // randomly perturb the point within a voxel (approximately)
-            for( SizeValueType d = 0; d < ImageDimension; d++ )
+            for ( unsigned int d = 0; d < ImageDimension; d++ )
               {
               point[d] += randomizer->GetNormalVariate() * oneThirdVirtualSpacing[d];
               }
@@ -983,48 +1057,12 @@ ImageRegistrationMethodv4<TFixedImage, TMovingImage, TTransform, TVirtualImage,
               ++index;
               }
             }
-          ++count;
-          }
-        break;
-        }
-      case RANDOM:
-        {
-        const unsigned long totalVirtualDomainVoxels = virtualDomainRegion.GetNumberOfPixels();
-        const auto sampleCount = static_cast<unsigned long>(
-         static_cast<float>( totalVirtualDomainVoxels )
-               * this->m_MetricSamplingPercentagePerLevel[this->m_CurrentLevel] );
-        ImageRandomConstIteratorWithIndex<VirtualDomainImageType> ItR( virtualImage, virtualDomainRegion );
-        if (m_ReseedIterator)
-          {
-          ItR.ReinitializeSeed();
+          break;
           }
-        else
+        default:
           {
-          ItR.ReinitializeSeed( m_CurrentRandomSeed++ );
+          itkExceptionMacro( "Invalid sampling strategy requested." );
           }
-        ItR.SetNumberOfSamples( sampleCount );
-        for( ItR.GoToBegin(); !ItR.IsAtEnd(); ++ItR )
-          {
-          SamplePointType point;
-          virtualImage->TransformIndexToPhysicalPoint( ItR.GetIndex(), point );
-
-          // randomly perturb the point within a voxel (approximately)
-          for ( unsigned int d = 0; d < ImageDimension; d++ )
-            {
-            point[d] += randomizer->GetNormalVariate() * oneThirdVirtualSpacing[d];
-            }
-          if( !fixedMaskImage || fixedMaskImage->IsInsideInWorldSpace(
-              point ) )
-            {
-            samplePointSet->SetPoint( index, point );
-            ++index;
-            }
-          }
-        break;
-        }
-      default:
-        {
-        itkExceptionMacro( "Invalid sampling strategy requested." );
         }
       }
 
@@ -1043,6 +1081,119 @@ ImageRegistrationMethodv4<TFixedImage, TMovingImage, TTransform, TVirtualImage,
     }
 }
 
+/**
+ * Draw the metric samples in parallel
+ */
+template<typename TFixedImage, typename TMovingImage, typename TTransform, typename TVirtualImage, typename TPointSet>
+void
+ImageRegistrationMethodv4<TFixedImage, TMovingImage, TTransform, TVirtualImage, TPointSet>
+::GenerateMetricSamplePointsInParallel( const VirtualImageType * virtualImage, const FixedImageMaskType * fixedMaskImage,
+  RandomizerType * randomizer, MetricSamplePointSetType * samplePointSet )
+{
+  using SamplePointType = typename MetricSamplePointSetType::PointType;
+  using ContinuousIndexType = ContinuousIndex<typename SamplePointType::ValueType, ImageDimension>;
+
+  const typename VirtualImageType::RegionType & virtualDomainRegion = virtualImage->GetRequestedRegion();
+  const typename VirtualImageType::SpacingType oneThirdVirtualSpacing = virtualImage->GetSpacing() / 3.0;
+  const SizeValueType totalVirtualDomainVoxels = virtualDomainRegion.GetNumberOfPixels();
+  const RealType samplingPercentage = this->m_MetricSamplingPercentagePerLevel[this->m_CurrentLevel];
+
+  // The REGULAR samples are taken every sampleStride voxels, starting with
+  // the first one, as in SetMetricSamplePoints.
+  SizeValueType numberOfSamples = 0;
+  SizeValueType sampleStride = 1;
+  switch( this->m_MetricSamplingStrategy )
+    {
+    case REGULAR:
+      {
+      sampleStride = static_cast<SizeValueType>( std::ceil( 1.0 / samplingPercentage ) );
+      numberOfSamples = ( totalVirtualDomainVoxels + sampleStride - 1 ) / sampleStride;
+      break;
+      }
+    case RANDOM:
+      {
+      numberOfSamples = static_cast<SizeValueType>( static_cast<float>( totalVirtualDomainVoxels ) * samplingPercentage );
+      break;
+      }
+    default:
+      {
+      itkExceptionMacro( "Invalid sampling strategy requested." );
+      }
+    }
+
+  const SizeValueType samplesPerBlock = this->m_NumberOfMetricSamplesPerBlock;
+  const SizeValueType numberOfBlocks = ( numberOfSamples + samplesPerBlock - 1 ) / samplesPerBlock;
+  std::vector<RandomizerType::IntegerType> blockSeeds( numberOfBlocks );
+  for( SizeValueType block = 0; block < numberOfBlocks; ++block )
+    {
+    blockSeeds[block] = randomizer->GetIntegerVariate();
+    }
+
+  std::vector<std::vector<SamplePointType> > blockPoints( numberOfBlocks );
+  const bool regularSampling = ( this->m_MetricSamplingStrategy == REGULAR );
+
+  this->GetMultiThreader()->ParallelizeArray( 0, numberOfBlocks,
+    [&]( SizeValueType block )
+    {
+      typename RandomizerType::Pointer blockRandomizer = RandomizerType::New();
+      blockRandomizer->SetSeed( blockSeeds[block] );
+
+      const SizeValueType firstSample = block * samplesPerBlock;
+      const SizeValueType lastSample = std::min( firstSample + samplesPerBlock, numberOfSamples );
+      std::vector<SamplePointType> & points = blockPoints[block];
+      points.reserve( lastSample - firstSample );
+
+      for( SizeValueType sample = firstSample; sample < lastSample; ++sample )
+        {
+        SamplePointType point;
+        if( regularSampling )
+          {
+          typename VirtualImageType::IndexType index;
+          SizeValueType offset = sample * sampleStride;
+          for( unsigned int d = 0; d < ImageDimension; d++ )
+            {
+            index[d] = virtualDomainRegion.GetIndex()[d] +
+              static_cast<IndexValueType>( offset % virtualDomainRegion.GetSize()[d] );
+            offset /= virtualDomainRegion.GetSize()[d];
+            }
+          virtualImage->TransformIndexToPhysicalPoint( index, point );
+
+          // randomly perturb the point within a voxel (approximately)
+          for( unsigned int d = 0; d < ImageDimension; d++ )
+            {
+            point[d] += blockRandomizer->GetNormalVariate() * oneThirdVirtualSpacing[d];
+            }
+          }
+        else
+          {
+          // uniformly distributed over the voxels of the region
+          ContinuousIndexType index;
+          for( unsigned int d = 0; d < ImageDimension; d++ )
+            {
+            index[d] = virtualDomainRegion.GetIndex()[d] - 0.5 +
+              blockRandomizer->GetVariateWithOpenUpperRange() * virtualDomainRegion.GetSize()[d];
+            }
+          virtualImage->TransformContinuousIndexToPhysicalPoint( index, point );
+          }
+        if( !fixedMaskImage || fixedMaskImage->IsInsideInWorldSpace( point ) )
+          {
+          points.push_back( point );
+          }
+        }
+    },
+    nullptr );
+
+  unsigned long index = 0;
+  for( SizeValueType block = 0; block < numberOfBlocks; ++block )
+    {
+    for( const SamplePointType & point : blockPoints[block] )
+      {
+      samplePointSet->SetPoint( index, point );
+      ++index;
+      }
+    }
+}
+
 template<typename TFixedImage, typename TMovingImage, typename TTransform, typename TVirtualImage, typename TPointSet>
 void
 ImageRegistrationMethodv4<TFixedImage, TMovingImage, TTransform, TVirtualImage, TPointSet>
@@ -1166,6 +1317,10 @@ ImageRegistrationMethodv4<TFixedImage, TMovingImage, TTransform, TVirtualImage,
     }
   os << std::endl;
 
+  os << indent << "ResampleMetricSamplesEachIteration: "
+     << ( this->m_ResampleMetricSamplesEachIteration ? "On" : "Off" ) << std::endl;
+  os << indent << "NumberOfMetricSamplesPerBlock: " << this->m_NumberOfMetricSamplesPerBlock << std::endl;
+
   os << indent << "ReseedIterator: " << m_ReseedIterator << std::endl;
   os << indent << "RandomSeed: " << m_RandomSeed << std::endl;
   os << indent << "CurrentRandomSeed: " << m_CurrentRandomSeed << std::endl;
@@ -0,0 +1,231 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+#include <atomic>
+#include <cmath>
+#include <iostream>
+
+#include "itkAffineTransform.h"
+#include "itkBSplineTransform.h"
+#include "itkGradientDescentOptimizerv4.h"
+#include "itkImageRegionIteratorWithIndex.h"
+#include "itkImageRegistrationMethodv4.h"
+#include "itkMeanSquaresImageToImageMetricv4.h"
+#include "itkTestingMacros.h"
+
+/* B-spline registration with ImageRegistrationMethodv4, whose metric is given
+ * the composite transform of the method, which applies the B-spline transform
+ * first, then the moving initial transform. With the B-spline weights of the
+ * samples cached by the metric, the B-spline transform must neither transform
+ * a point nor compute a Jacobian, and the registration must give the same
+ * transform as without the cache. Without the cache, the metric derivative is
+ * accumulated sparsely, from the B-spline weights, so no Jacobian must be
+ * computed either.
+ */
+
+namespace
+{
+constexpr unsigned int Dimension = 2;
+
+class CountingBSplineTransform : public itk::BSplineTransform< double, Dimension, 3 >
+{
+public:
+  ITK_DISALLOW_COPY_AND_ASSIGN(CountingBSplineTransform);
+
+  using Self = CountingBSplineTransform;
+  using Superclass = itk::BSplineTransform< double, Dimension, 3 >;
+  using Pointer = itk::SmartPointer< Self >;
+  using ConstPointer = itk::SmartPointer< const Self >;
+
+  itkNewMacro(Self);
+  itkTypeMacro(CountingBSplineTransform, BSplineTransform);
+
+  using Superclass::TransformPoint;
+  OutputPointType TransformPoint( const InputPointType & point ) const override
+  {
+    ++m_NumberOfTransformedPoints;
+    return Superclass::TransformPoint( point );
+  }
+
+  void ComputeJacobianWithRespectToParameters( const InputPointType & point, JacobianType & jacobian ) const override
+  {
+    ++m_NumberOfJacobians;
+    Superclass::ComputeJacobianWithRespectToParameters( point, jacobian );
+  }
+
+  itk::SizeValueType GetNumberOfTransformedPoints() const
+  {
+    return m_NumberOfTransformedPoints;
+  }
+
+  itk::SizeValueType GetNumberOfJacobians() const
+  {
+    return m_NumberOfJacobians;
+  }
+
+protected:
+  CountingBSplineTransform() = default;
+  ~CountingBSplineTransform() override = default;
+
+private:
+  mutable std::atomic< itk::SizeValueType > m_NumberOfTransformedPoints{ 0 };
+  mutable std::atomic< itk::SizeValueType > m_NumberOfJacobians{ 0 };
+};
+
+using ImageType = itk::Image< double, Dimension >;
+using BSplineTransformType = itk::BSplineTransform< double, Dimension, 3 >;
+using AffineTransformType = itk::AffineTransform< double, Dimension >;
+using RegistrationType = itk::ImageRegistrationMethodv4< ImageType, ImageType, BSplineTransformType >;
+using MetricType = itk::MeanSquaresImageToImageMetricv4< ImageType, ImageType >;
+
+ImageType::Pointer
+CreateImage( double shift )
+{
+  ImageType::SizeType size;
+  size.Fill( 32 );
+  ImageType::Pointer image = ImageType::New();
+  image->SetRegions( size );
+  image->Allocate();
+
+  itk::ImageRegionIteratorWithIndex< ImageType > it( image, image->GetLargestPossibleRegion() );
+  for ( ; !it.IsAtEnd(); ++it )
+    {
+    const double x = it.GetIndex()[0] - 15.5 - shift;
+    const double y = it.GetIndex()[1] - 15.5;
+    it.Set( 100.0 * std::exp( -( x * x + 2.0 * y * y ) / 60.0 ) );
+    }
+  return image;
+}
+
+int
+Register( MetricType * metric, CountingBSplineTransform * transform )
+{
+  ImageType::Pointer fixedImage = CreateImage( 0.0 );
+  ImageType::Pointer movingImage = CreateImage( 1.5 );
+
+  CountingBSplineTransform::PhysicalDimensionsType physicalDimensions;
+  physicalDimensions.Fill( 31.0 );
+  CountingBSplineTransform::MeshSizeType meshSize;
+  meshSize.Fill( 4 );
+  transform->SetTransformDomainPhysicalDimensions( physicalDimensions );
+  transform->SetTransformDomainMeshSize( meshSize );
+  transform->SetIdentity();
+
+  AffineTransformType::Pointer movingInitialTransform = AffineTransformType::New();
+  movingInitialTransform->Rotate2D( 0.02 );
+
+  using OptimizerType = itk::GradientDescentOptimizerv4;
+  OptimizerType::Pointer optimizer = OptimizerType::New();
+  optimizer->SetLearningRate( 0.01 );
+  optimizer->SetNumberOfIterations( 10 );
+  optimizer->SetDoEstimateLearningRateOnce( false );
+  optimizer->SetDoEstimateLearningRateAtEachIteration( false );
+
+  RegistrationType::ShrinkFactorsArrayType shrinkFactorsPerLevel;
+  shrinkFactorsPerLevel.SetSize( 1 );
+  shrinkFactorsPerLevel[0] = 1;
+  RegistrationType::SmoothingSigmasArrayType smoothingSigmasPerLevel;
+  smoothingSigmasPerLevel.SetSize( 1 );
+  smoothingSigmasPerLevel[0] = 0;
+
+  RegistrationType::Pointer registration = RegistrationType::New();
+  registration->SetFixedImage( fixedImage );
+  registration->SetMovingImage( movingImage );
+  registration->SetMetric( metric );
+  registration->SetOptimizer( optimizer );
+  registration->SetNumberOfLevels( 1 );
+  registration->SetShrinkFactorsPerLevel( shrinkFactorsPerLevel );
+  registration->SetSmoothingSigmasPerLevel( smoothingSigmasPerLevel );
+  registration->SetMovingInitialTransform( movingInitialTransform );
+  registration->SetInitialTransform( transform );
+  registration->InPlaceOn();
+  TRY_EXPECT_NO_EXCEPTION( registration->Update() );
+
+  std::cout << "  Metric value: " << optimizer->GetCurrentMetricValue() << ", transformed points: "
+            << transform->GetNumberOfTransformedPoints() << ", Jacobians: " << transform->GetNumberOfJacobians()
+            << std::endl;
+  return EXIT_SUCCESS;
+}
+}
+
+int itkBSplineWeightsCacheImageRegistrationTest( int, char *[] )
+{
+  bool testPassed = true;
+
+  std::cout << "Without the cache" << std::endl;
+  MetricType::Pointer metric = MetricType::New();
+  CountingBSplineTransform::Pointer transform = CountingBSplineTransform::New();
+  if ( Register( metric, transform ) == EXIT_FAILURE )
+    {
+    return EXIT_FAILURE;
+    }
+  if ( transform->GetNumberOfTransformedPoints() == 0 )
+    {
+    std::cerr << "Test failed!" << std::endl;
+    std::cerr << "The B-spline transform was not used by the registration" << std::endl;
+    testPassed = false;
+    }
+  if ( transform->GetNumberOfJacobians() != 0 )
+    {
+    std::cerr << "Test failed!" << std::endl;
+    std::cerr << "The metric derivative was not accumulated sparsely" << std::endl;
+    testPassed = false;
+    }
+
+  std::cout << "With the cache" << std::endl;
+  MetricType::Pointer cachedMetric = MetricType::New();
+  cachedMetric->UseCachingOfBSplineWeightsOn();
+  CountingBSplineTransform::Pointer cachedTransform = CountingBSplineTransform::New();
+  if ( Register( cachedMetric, cachedTransform ) == EXIT_FAILURE )
+    {
+    return EXIT_FAILURE;
+    }
+  if ( cachedTransform->GetNumberOfTransformedPoints() != 0 || cachedTransform->GetNumberOfJacobians() != 0 )
+    {
+    std::cerr << "Test failed!" << std::endl;
+    std::cerr << "The cached B-spline weights were not used by the metric" << std::endl;
+    testPassed = false;
+    }
+
+  const CountingBSplineTransform::ParametersType & parameters = transform->GetParameters();
+  const CountingBSplineTransform::ParametersType & cachedParameters = cachedTransform->GetParameters();
+  const double parametersMagnitude = parameters.inf_norm();
+  if ( parametersMagnitude == 0.0 )
+    {
+    std::cerr << "Test failed!" << std::endl;
+    std::cerr << "The registration did not change the B-spline transform" << std::endl;
+    testPassed = false;
+    }
+  for ( unsigned int n = 0; n < parameters.Size(); ++n )
+    {
+    if ( std::abs( cachedParameters[n] - parameters[n] ) > 1e-10 * parametersMagnitude )
+      {
+      std::cerr << "Test failed!" << std::endl;
+      std::cerr << "Parameter [" << n << "] " << cachedParameters[n] << " instead of " << parameters[n] << std::endl;
+      testPassed = false;
+      break;
+      }
+    }
+
+  if ( !testPassed )
+    {
+    return EXIT_FAILURE;
+    }
+  std::cout << "Test finished." << std::endl;
+  return EXIT_SUCCESS;
+}
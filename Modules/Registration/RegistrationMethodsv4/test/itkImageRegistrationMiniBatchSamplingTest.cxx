@@ -0,0 +1,253 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+#include <cmath>
+#include <iostream>
+
+#include "itkCommand.h"
+#include "itkGradientDescentOptimizerv4.h"
+#include "itkImageRegionIteratorWithIndex.h"
+#include "itkImageRegistrationMethodv4.h"
+#include "itkMeanSquaresImageToImageMetricv4.h"
+#include "itkRegistrationParameterScalesFromPhysicalShift.h"
+#include "itkRegularStepGradientDescentOptimizerv4.h"
+#include "itkTestingMacros.h"
+#include "itkTranslationTransform.h"
+
+/* ImageRegistrationMethodv4 with new metric samples drawn before each
+ * iteration of the optimizer. The registration of two shifted blobs must
+ * recover the shift, the samples must change from one iteration to the
+ * next, and a given seed must yield the same result whatever the number of
+ * work units of the registration method. The samples are drawn in several
+ * blocks, which are distributed over the work units.
+ */
+
+namespace
+{
+constexpr unsigned int Dimension = 2;
+
+using ImageType = itk::Image< double, Dimension >;
+using TransformType = itk::TranslationTransform< double, Dimension >;
+using RegistrationType = itk::ImageRegistrationMethodv4< ImageType, ImageType, TransformType >;
+using MetricType = itk::MeanSquaresImageToImageMetricv4< ImageType, ImageType >;
+
+ImageType::Pointer
+CreateImage( double shiftX, double shiftY )
+{
+  ImageType::SizeType size;
+  size.Fill( 64 );
+  ImageType::Pointer image = ImageType::New();
+  image->SetRegions( size );
+  image->Allocate();
+
+  itk::ImageRegionIteratorWithIndex< ImageType > it( image, image->GetLargestPossibleRegion() );
+  for ( ; !it.IsAtEnd(); ++it )
+    {
+    const double x = it.GetIndex()[0] - 31.5 - shiftX;
+    const double y = it.GetIndex()[1] - 31.5 - shiftY;
+    it.Set( 100.0 * std::exp( -( x * x + 1.5 * y * y ) / 200.0 ) );
+    }
+  return image;
+}
+
+// Records the first metric sample at each iteration, and whether it
+// differs from the one of the previous iteration.
+class SampleObserver : public itk::Command
+{
+public:
+  using Self = SampleObserver;
+  using Superclass = itk::Command;
+  using Pointer = itk::SmartPointer< Self >;
+  itkNewMacro( Self );
+
+  void Execute( itk::Object * caller, const itk::EventObject & event ) override
+  {
+    Execute( (const itk::Object *) caller, event );
+  }
+
+  void Execute( const itk::Object *, const itk::EventObject & event ) override
+  {
+    if ( !itk::IterationEvent().CheckEvent( &event ) )
+      {
+      return;
+      }
+    const MetricType::VirtualPointSetType * pointSet = m_Metric->GetVirtualSampledPointSet();
+    const MetricType::VirtualPointType point = pointSet->GetPoint( 0 );
+    if ( m_NumberOfIterations > 0 && point != m_PreviousPoint )
+      {
+      ++m_NumberOfChangedSamples;
+      }
+    m_PreviousPoint = point;
+    m_NumberOfSamples = pointSet->GetNumberOfPoints();
+    ++m_NumberOfIterations;
+  }
+
+  MetricType *                  m_Metric{ nullptr };
+  MetricType::VirtualPointType  m_PreviousPoint;
+  itk::SizeValueType            m_NumberOfIterations{ 0 };
+  itk::SizeValueType            m_NumberOfChangedSamples{ 0 };
+  itk::SizeValueType            m_NumberOfSamples{ 0 };
+
+protected:
+  SampleObserver() = default;
+};
+
+TransformType::ParametersType
+Register( RegistrationType::MetricSamplingStrategyType strategy, bool useRegularStep,
+          itk::ThreadIdType numberOfWorkUnits, SampleObserver * observer )
+{
+  MetricType::Pointer metric = MetricType::New();
+  metric->SetMaximumNumberOfWorkUnits( 2 );
+
+  using ScalesEstimatorType = itk::RegistrationParameterScalesFromPhysicalShift< MetricType >;
+  ScalesEstimatorType::Pointer scalesEstimator = ScalesEstimatorType::New();
+  scalesEstimator->SetMetric( metric );
+
+  RegistrationType::OptimizerPointer optimizer;
+  if ( useRegularStep )
+    {
+    using OptimizerType = itk::RegularStepGradientDescentOptimizerv4< double >;
+    OptimizerType::Pointer regularStepOptimizer = OptimizerType::New();
+    regularStepOptimizer->SetLearningRate( 1.0 );
+    regularStepOptimizer->SetMinimumStepLength( 1e-3 );
+    regularStepOptimizer->SetRelaxationFactor( 0.8 );
+    regularStepOptimizer->SetNumberOfIterations( 100 );
+    regularStepOptimizer->SetScalesEstimator( scalesEstimator );
+    optimizer = regularStepOptimizer;
+    }
+  else
+    {
+    using OptimizerType = itk::GradientDescentOptimizerv4;
+    OptimizerType::Pointer gradientDescentOptimizer = OptimizerType::New();
+    gradientDescentOptimizer->SetLearningRate( 1.0 );
+    gradientDescentOptimizer->SetNumberOfIterations( 100 );
+    gradientDescentOptimizer->SetScalesEstimator( scalesEstimator );
+    gradientDescentOptimizer->DoEstimateLearningRateOnceOn();
+    optimizer = gradientDescentOptimizer;
+    }
+  optimizer->SetNumberOfWorkUnits( 2 );
+
+  if ( observer != nullptr )
+    {
+    observer->m_Metric = metric;
+    optimizer->AddObserver( itk::IterationEvent(), observer );
+    }
+
+  RegistrationType::Pointer registration = RegistrationType::New();
+  registration->SetFixedImage( CreateImage( 0.0, 0.0 ) );
+  registration->SetMovingImage( CreateImage( 3.0, -2.0 ) );
+  registration->SetMetric( metric );
+  registration->SetOptimizer( optimizer );
+  registration->SetNumberOfLevels( 1 );
+  RegistrationType::ShrinkFactorsArrayType shrinkFactors( 1 );
+  shrinkFactors[0] = 1;
+  registration->SetShrinkFactorsPerLevel( shrinkFactors );
+  RegistrationType::SmoothingSigmasArrayType smoothingSigmas( 1 );
+  smoothingSigmas[0] = 0.0;
+  registration->SetSmoothingSigmasPerLevel( smoothingSigmas );
+  registration->SetMetricSamplingStrategy( strategy );
+  registration->SetMetricSamplingPercentage( 0.05 );
+  registration->ResampleMetricSamplesEachIterationOn();
+  registration->SetNumberOfMetricSamplesPerBlock( 50 );
+  registration->MetricSamplingReinitializeSeed( 121213 );
+  registration->SetNumberOfWorkUnits( numberOfWorkUnits );
+  registration->Update();
+
+  return registration->GetTransform()->GetParameters();
+}
+
+bool
+CheckShift( const TransformType::ParametersType & parameters )
+{
+  std::cout << "    Parameters: " << parameters << std::endl;
+  if ( std::abs( parameters[0] - 3.0 ) > 0.25 || std::abs( parameters[1] + 2.0 ) > 0.25 )
+    {
+    std::cerr << "Test failed!" << std::endl;
+    std::cerr << "Shift " << parameters << " instead of [3, -2]" << std::endl;
+    return false;
+    }
+  return true;
+}
+
+bool
+CheckSamples( const SampleObserver * observer, itk::SizeValueType expectedNumberOfSamples )
+{
+  std::cout << "    Iterations: " << observer->m_NumberOfIterations << ", changed samples: "
+            << observer->m_NumberOfChangedSamples << std::endl;
+  if ( observer->m_NumberOfIterations < 2 ||
+       observer->m_NumberOfChangedSamples + 1 != observer->m_NumberOfIterations )
+    {
+    std::cerr << "Test failed!" << std::endl;
+    std::cerr << "The samples were not drawn again at each iteration" << std::endl;
+    return false;
+    }
+  if ( observer->m_NumberOfSamples != expectedNumberOfSamples )
+    {
+    std::cerr << "Test failed!" << std::endl;
+    std::cerr << observer->m_NumberOfSamples << " samples instead of " << expectedNumberOfSamples << std::endl;
+    return false;
+    }
+  return true;
+}
+}
+
+int itkImageRegistrationMiniBatchSamplingTest( int, char *[] )
+{
+  RegistrationType::Pointer registration = RegistrationType::New();
+  TEST_SET_GET_BOOLEAN( registration, ResampleMetricSamplesEachIteration, true );
+  TEST_SET_GET_BOOLEAN( registration, ResampleMetricSamplesEachIteration, false );
+  TEST_EXPECT_EQUAL( registration->GetNumberOfMetricSamplesPerBlock(), 4096u );
+  const itk::SizeValueType numberOfMetricSamplesPerBlock = 100;
+  registration->SetNumberOfMetricSamplesPerBlock( numberOfMetricSamplesPerBlock );
+  TEST_SET_GET_VALUE( numberOfMetricSamplesPerBlock, registration->GetNumberOfMetricSamplesPerBlock() );
+
+  bool testPassed = true;
+
+  std::cout << "Random sampling, gradient descent" << std::endl;
+  SampleObserver::Pointer observer = SampleObserver::New();
+  const TransformType::ParametersType parameters = Register( RegistrationType::RANDOM, false, 4, observer );
+  testPassed &= CheckShift( parameters );
+  testPassed &= CheckSamples( observer, 204 );
+
+  std::cout << "Random sampling, gradient descent, one work unit" << std::endl;
+  const TransformType::ParametersType singleWorkUnitParameters = Register( RegistrationType::RANDOM, false, 1, nullptr );
+  TEST_EXPECT_EQUAL( singleWorkUnitParameters, parameters );
+
+  std::cout << "Random sampling, regular step gradient descent" << std::endl;
+  observer = SampleObserver::New();
+  testPassed &= CheckShift( Register( RegistrationType::RANDOM, true, 4, observer ) );
+  testPassed &= CheckSamples( observer, 204 );
+
+  std::cout << "Regular sampling, gradient descent" << std::endl;
+  observer = SampleObserver::New();
+  const TransformType::ParametersType regularParameters = Register( RegistrationType::REGULAR, false, 4, observer );
+  testPassed &= CheckShift( regularParameters );
+  testPassed &= CheckSamples( observer, 205 );
+
+  std::cout << "Regular sampling, gradient descent, one work unit" << std::endl;
+  const TransformType::ParametersType regularSingleWorkUnitParameters =
+    Register( RegistrationType::REGULAR, false, 1, nullptr );
+  TEST_EXPECT_EQUAL( regularSingleWorkUnitParameters, regularParameters );
+
+  if ( !testPassed )
+    {
+    return EXIT_FAILURE;
+    }
+  std::cout << "Test finished." << std::endl;
+  return EXIT_SUCCESS;
+}
@@ -64,6 +64,19 @@ namespace itk
  * Chapter 9.2 of Pierre Soille's book "Morphological Image Analysis:
  * Principles and Applications", Second Edition, Springer, 2003.
  *
+ * By default, the flooding uses a single hierarchical queue, and the label
+ * of a pixel reached by several basins at the same level depends on the
+ * order of the queue. When UseParallelFlooding is on, the image is split
+ * into slabs along its last dimension, which are flooded concurrently with
+ * their own priority queue. A pixel is flooded at the lowest level at
+ * which a marker reaches it, then in the fewest steps at that level, and
+ * gets the label of the neighbor the flood comes from. The floods which
+ * reach another slab are passed to it, and the slabs are flooded again
+ * until no flood can go further. This labeling does not depend on the
+ * processing order, so the output is the same whatever the number of work
+ * units, but it may differ from the serial one where basins meet, as may
+ * the watershed line (see SetMarkWatershedLine()).
+ *
  * This code was contributed in the Insight Journal paper:
  * "The watershed transform in ITK - discussion and new developments"
  * by Beare R., Lehmann G.
@@ -153,11 +166,31 @@ public:
    * Set/Get whether the watershed pixel must be marked or not. Default
    * is true. Set it to false do not only avoid writing watershed pixels,
    * it also decrease algorithm complexity.
+   *
+   * The serial flooding marks a pixel as soon as the flood reaches it
+   * from two basins, and floods the rest of the basins around the line.
+   * With UseParallelFlooding on, the line is only marked once the image
+   * is flooded: it is made of the pixels adjacent to a marker or to a
+   * pixel of another basin flooded before them. The pixels that the
+   * flood of their basin only reached through these line pixels are then
+   * cut off from their marker, and are marked as line pixels too, where
+   * the serial flooding would have labeled them by flooding around the
+   * line. The parallel line may thus be thicker.
    */
   itkSetMacro(MarkWatershedLine, bool);
   itkGetConstReferenceMacro(MarkWatershedLine, bool);
   itkBooleanMacro(MarkWatershedLine);
 
+  /**
+   * Set/Get whether the image is flooded in parallel. Default is false.
+   * The parallel flooding does not depend on the number of work units,
+   * but may assign the pixels where basins meet differently than the
+   * serial flooding.
+   */
+  itkSetMacro(UseParallelFlooding, bool);
+  itkGetConstReferenceMacro(UseParallelFlooding, bool);
+  itkBooleanMacro(UseParallelFlooding);
+
 protected:
   MorphologicalWatershedFromMarkersImageFilter();
   ~MorphologicalWatershedFromMarkersImageFilter() override = default;
@@ -173,13 +206,19 @@ protected:
    * \sa ProcessObject::EnlargeOutputRequestedRegion() */
   void EnlargeOutputRequestedRegion( DataObject *itkNotUsed(output) ) override;
 
-  /** The filter is single threaded. */
+  /** The filter is single threaded, unless UseParallelFlooding is on. */
   void GenerateData() override;
 
+  /** Flood the slabs of the image concurrently, and mark the watershed
+   * line afterwards if requested. */
+  void ParallelFlooding();
+
 private:
   bool m_FullyConnected{ false };
 
   bool m_MarkWatershedLine{ true };
+
+  bool m_UseParallelFlooding{ false };
 }; // end of class
 } // end namespace itk
 
@@ -19,8 +19,11 @@
 #define itkMorphologicalWatershedFromMarkersImageFilter_hxx
 
 #include <algorithm>
+#include <functional>
 #include <queue>
 #include <list>
+#include <type_traits>
+#include <vector>
 #include "itkMorphologicalWatershedFromMarkersImageFilter.h"
 #include "itkProgressReporter.h"
 #include "itkImageRegionIterator.h"
@@ -108,17 +111,23 @@ MorphologicalWatershedFromMarkersImageFilter< TInputImage, TLabelImage >
   const InputImageType * inputImage = this->GetInput();
   LabelImageType * outputImage = this->GetOutput();
 
-  // Set up the progress reporter
-  // we can't found the exact number of pixel to process in the 2nd pass, so we
-  // use the maximum number possible.
-  ProgressReporter progress(this, 0, markerImage->GetRequestedRegion().GetNumberOfPixels() * 2);
-
   // mask and marker must have the same size
   if ( markerImage->GetRequestedRegion().GetSize() != inputImage->GetRequestedRegion().GetSize() )
     {
     itkExceptionMacro(<< "Marker and input must have the same size.");
     }
 
+  if ( m_UseParallelFlooding )
+    {
+    this->ParallelFlooding();
+    return;
+    }
+
+  // Set up the progress reporter
+  // we can't found the exact number of pixel to process in the 2nd pass, so we
+  // use the maximum number possible.
+  ProgressReporter progress(this, 0, markerImage->GetRequestedRegion().GetNumberOfPixels() * 2);
+
   // FAH (in french: File d'Attente Hierarchique)
   using QueueType = std::queue< IndexType >;
   using MapType = std::map< InputImagePixelType, QueueType >;
@@ -445,6 +454,550 @@ MorphologicalWatershedFromMarkersImageFilter< TInputImage, TLabelImage >
 }
 
 
+template< typename TInputImage, typename TLabelImage >
+void
+MorphologicalWatershedFromMarkersImageFilter< TInputImage, TLabelImage >
+::ParallelFlooding()
+{
+  // the label used to find background in the marker image
+  static const LabelImagePixelType bgLabel =
+    NumericTraits< LabelImagePixelType >::ZeroValue();
+  // the label used to mark the watershed line in the output image
+  static const LabelImagePixelType wsLabel =
+    NumericTraits< LabelImagePixelType >::ZeroValue();
+
+  constexpr unsigned int LastDimension = ImageDimension - 1;
+
+  const LabelImageType * markerImage = this->GetMarkerImage();
+  const InputImageType * inputImage = this->GetInput();
+  LabelImageType * outputImage = this->GetOutput();
+
+  const LabelImageRegionType region = outputImage->GetRequestedRegion();
+  const typename LabelImageRegionType::SizeType size = region.GetSize();
+  const InputImagePixelType * input =
+    inputImage->GetBufferPointer() + inputImage->ComputeOffset( inputImage->GetRequestedRegion().GetIndex() );
+  const LabelImagePixelType * markers =
+    markerImage->GetBufferPointer() + markerImage->ComputeOffset( markerImage->GetRequestedRegion().GetIndex() );
+  LabelImagePixelType *   output = outputImage->GetBufferPointer() + outputImage->ComputeOffset( region.GetIndex() );
+  const OffsetValueType * offsetTable = outputImage->GetOffsetTable();
+
+  // The flooding key of a pixel: the level at which the flood reaches it,
+  // and the number of steps of the flood at that level. A pixel gets the
+  // lowest key of its neighbors, extended to the pixel.
+  struct FloodKey
+  {
+    InputImagePixelType level;
+    unsigned int        steps;
+
+    bool operator<(const FloodKey & other) const
+    {
+      if ( level < other.level || other.level < level )
+        {
+        return level < other.level;
+        }
+      return steps < other.steps;
+    }
+  };
+  struct FloodEntry
+  {
+    FloodKey        key;
+    OffsetValueType offset;
+
+    bool operator>(const FloodEntry & other) const
+    {
+      return other.key < key;
+    }
+  };
+  using PriorityQueueType = std::priority_queue< FloodEntry, std::vector< FloodEntry >, std::greater< FloodEntry > >;
+  using FloodMessageType = std::pair< OffsetValueType, FloodKey >;
+  using LabelMessageType = std::pair< OffsetValueType, LabelImagePixelType >;
+  constexpr unsigned int Unreached = NumericTraits< unsigned int >::max();
+
+  // the neighbors, as buffer offsets, with their steps along each dimension
+  using StepType = Offset< ImageDimension >;
+  std::vector< OffsetValueType > neighbors;
+  std::vector< StepType >        neighborSteps;
+  unsigned int numberOfNeighborhoodPixels = 1;
+  for ( unsigned int d = 0; d < ImageDimension; ++d )
+    {
+    numberOfNeighborhoodPixels *= 3;
+    }
+  for ( unsigned int n = 0; n < numberOfNeighborhoodPixels; ++n )
+    {
+    StepType        step;
+    OffsetValueType offset = 0;
+    unsigned int    numberOfNonZeroSteps = 0;
+    for ( unsigned int d = 0, k = n; d < ImageDimension; ++d, k /= 3 )
+      {
+      step[d] = static_cast< OffsetValueType >( k % 3 ) - 1;
+      offset += step[d] * offsetTable[d];
+      numberOfNonZeroSteps += ( step[d] != 0 );
+      }
+    if ( numberOfNonZeroSteps > 0 && ( m_FullyConnected || numberOfNonZeroSteps == 1 ) )
+      {
+      neighbors.push_back(offset);
+      neighborSteps.push_back(step);
+      }
+    }
+
+  auto isOnBorder = [&]( const IndexType & index ) -> bool
+    {
+    for ( unsigned int d = 0; d < ImageDimension; ++d )
+      {
+      if ( index[d] == 0 || index[d] + 1 == static_cast< IndexValueType >( size[d] ) )
+        {
+        return true;
+        }
+      }
+    return false;
+    };
+  auto isInside = [&]( const IndexType & index, unsigned int k ) -> bool
+    {
+    for ( unsigned int d = 0; d < ImageDimension; ++d )
+      {
+      const IndexValueType neighborIndex = index[d] + neighborSteps[k][d];
+      if ( neighborIndex < 0 || neighborIndex >= static_cast< IndexValueType >( size[d] ) )
+        {
+        return false;
+        }
+      }
+    return true;
+    };
+  // The index of a buffer offset, relative to the start of the region
+  auto indexOf = [&]( OffsetValueType offset ) -> IndexType
+    {
+    IndexType index;
+    for ( unsigned int d = ImageDimension - 1; d > 0; --d )
+      {
+      index[d] = static_cast< IndexValueType >( offset / offsetTable[d] );
+      offset -= index[d] * offsetTable[d];
+      }
+    index[0] = static_cast< IndexValueType >( offset );
+    return index;
+    };
+
+  // The slabs split the region along the last dimension. A slab only writes
+  // its own pixels.
+  const SizeValueType numberOfSlices = size[LastDimension];
+  const SizeValueType numberOfSlabs = ( ImageDimension > 1 )
+    ? std::max< SizeValueType >( 1, std::min< SizeValueType >( this->GetNumberOfWorkUnits(), numberOfSlices ) )
+    : 1;
+  std::vector< IndexValueType > slabStarts( numberOfSlabs + 1 );
+  for ( SizeValueType slab = 0; slab <= numberOfSlabs; ++slab )
+    {
+    slabStarts[slab] = static_cast< IndexValueType >( slab * numberOfSlices / numberOfSlabs );
+    }
+  auto slabBeginOf = [&]( SizeValueType slab ) -> OffsetValueType
+    {
+    return slabStarts[slab] * offsetTable[LastDimension];
+    };
+  // Whether the neighbor k of a pixel of a slab lies in the previous (-1)
+  // or the next (1) slab
+  auto crossingOf = [&]( SizeValueType slab, const IndexType & index, unsigned int k ) -> int
+    {
+    if ( slab > 0 && index[LastDimension] == slabStarts[slab] && neighborSteps[k][LastDimension] < 0 )
+      {
+      return -1;
+      }
+    if ( slab + 1 < numberOfSlabs && index[LastDimension] == slabStarts[slab + 1] - 1
+         && neighborSteps[k][LastDimension] > 0 )
+      {
+      return 1;
+      }
+    return 0;
+    };
+  // The messages sent to the slabs at a round, which are read at the
+  // next one. messages[2 * slab] holds the messages sent to the slab by
+  // the previous slab, and messages[2 * slab + 1] the ones sent by the next
+  // slab.
+  auto messageListOf = [&]( SizeValueType slab, int crossing ) -> SizeValueType
+    {
+    return ( crossing < 0 ) ? 2 * ( slab - 1 ) + 1 : 2 * ( slab + 1 );
+    };
+
+  const SizeValueType                numberOfPixels = region.GetNumberOfPixels();
+  std::vector< InputImagePixelType > levels(numberOfPixels);
+  std::vector< unsigned int >        steps(numberOfPixels);
+  auto keyOf = [&]( OffsetValueType p ) -> FloodKey
+    {
+    return FloodKey{ levels[p], steps[p] };
+    };
+  // The key of the flood from a pixel, when it reaches the pixel q
+  auto extend = [&]( const FloodKey & key, OffsetValueType q ) -> FloodKey
+    {
+    const InputImagePixelType value = input[q];
+    if ( key.level < value )
+      {
+      return FloodKey{ value, 0 };
+      }
+    return FloodKey{ key.level, key.steps + 1 };
+    };
+  auto update = [&]( OffsetValueType q, const FloodKey & key ) -> bool
+    {
+    if ( steps[q] != Unreached && !( key < keyOf(q) ) )
+      {
+      return false;
+      }
+    levels[q] = key.level;
+    steps[q] = key.steps;
+    return true;
+    };
+
+  // copy the markers to the output image, and init the queues with the
+  // marker pixels which have background pixel(s) in their neighborhood
+  std::vector< PriorityQueueType > queues(numberOfSlabs);
+  this->GetMultiThreader()->ParallelizeArray(0, numberOfSlabs,
+    [&]( SizeValueType slab )
+    {
+      for ( OffsetValueType p = slabBeginOf(slab); p < slabBeginOf(slab + 1); ++p )
+        {
+        const LabelImagePixelType markerPixel = markers[p];
+        output[p] = markerPixel;
+        if ( markerPixel == bgLabel )
+          {
+          steps[p] = Unreached;
+          continue;
+          }
+        levels[p] = input[p];
+        steps[p] = 0;
+        const IndexType index = indexOf(p);
+        const bool      onBorder = isOnBorder(index);
+        for ( unsigned int k = 0; k < neighbors.size(); ++k )
+          {
+          if ( ( !onBorder || isInside(index, k) ) && markers[p + neighbors[k]] == bgLabel )
+            {
+            queues[slab].push( FloodEntry{ keyOf(p), p } );
+            break;
+            }
+          }
+        }
+    },
+    nullptr);
+
+  // Flood the slabs. The keys of the pixels of another slab are sent to it.
+  unsigned int current = 0;
+  std::vector< std::vector< FloodMessageType > > floodMessages[2];
+  floodMessages[0].resize(2 * numberOfSlabs);
+  floodMessages[1].resize(2 * numberOfSlabs);
+  auto floodSlab = [&]( SizeValueType slab, std::vector< std::vector< FloodMessageType > > & received,
+                       std::vector< std::vector< FloodMessageType > > & sent )
+    {
+      PriorityQueueType & queue = queues[slab];
+      for ( unsigned int side = 0; side < 2; ++side )
+        {
+        for ( const FloodMessageType & message : received[2 * slab + side] )
+          {
+          if ( update(message.first, message.second) )
+            {
+            queue.push( FloodEntry{ message.second, message.first } );
+            }
+          }
+        received[2 * slab + side].clear();
+        }
+
+      while ( !queue.empty() )
+        {
+        const FloodEntry entry = queue.top();
+        queue.pop();
+        const OffsetValueType p = entry.offset;
+        // the pixel has been reached by a lower flood since it was queued
+        if ( keyOf(p) < entry.key )
+          {
+          continue;
+          }
+        const IndexType index = indexOf(p);
+        const bool      onBorder = isOnBorder(index);
+        for ( unsigned int k = 0; k < neighbors.size(); ++k )
+          {
+          if ( onBorder && !isInside(index, k) )
+            {
+            continue;
+            }
+          const OffsetValueType q = p + neighbors[k];
+          if ( markers[q] != bgLabel )
+            {
+            continue;
+            }
+          const FloodKey key = extend(entry.key, q);
+          const int      crossing = crossingOf(slab, index, k);
+          if ( crossing != 0 )
+            {
+            sent[messageListOf(slab, crossing)].emplace_back(q, key);
+            }
+          else if ( update(q, key) )
+            {
+            queue.push( FloodEntry{ key, q } );
+            }
+          }
+        }
+    };
+  do
+    {
+    this->GetMultiThreader()->ParallelizeArray(0, numberOfSlabs,
+      [&]( SizeValueType slab )
+      {
+        floodSlab(slab, floodMessages[current], floodMessages[1 - current]);
+      },
+      nullptr);
+    current = 1 - current;
+    }
+  while ( std::any_of( floodMessages[current].begin(), floodMessages[current].end(),
+                       []( const std::vector< FloodMessageType > & messageList ) { return !messageList.empty(); } ) );
+  this->UpdateProgress(0.4f);
+
+  // Each flooded pixel takes the label of the neighbor the flood comes
+  // from: the one with the lowest key among those whose flood reaches the
+  // pixel with its key, the first one in the neighborhood if several have
+  // the same key. The labels are propagated from the markers along these
+  // links.
+  // the index of the neighbor the flood comes from
+  using ParentType = typename std::conditional< ( ImageDimension <= 5 ), unsigned char, unsigned short >::type;
+  std::vector< ParentType > parents(numberOfPixels);
+  std::vector< std::queue< OffsetValueType > > fifos(numberOfSlabs);
+  this->GetMultiThreader()->ParallelizeArray(0, numberOfSlabs,
+    [&]( SizeValueType slab )
+    {
+      for ( OffsetValueType q = slabBeginOf(slab); q < slabBeginOf(slab + 1); ++q )
+        {
+        if ( markers[q] != bgLabel )
+          {
+          fifos[slab].push(q);
+          continue;
+          }
+        if ( steps[q] == Unreached )
+          {
+          continue;
+          }
+        const FloodKey  key = keyOf(q);
+        const IndexType index = indexOf(q);
+        const bool      onBorder = isOnBorder(index);
+        bool            hasParent = false;
+        FloodKey        parentKey = key;
+        for ( unsigned int k = 0; k < neighbors.size(); ++k )
+          {
+          if ( onBorder && !isInside(index, k) )
+            {
+            continue;
+            }
+          const OffsetValueType p = q + neighbors[k];
+          if ( steps[p] == Unreached )
+            {
+            continue;
+            }
+          const FloodKey neighborKey = keyOf(p);
+          const FloodKey extendedKey = extend(neighborKey, q);
+          if ( !( extendedKey < key ) && !( key < extendedKey ) && ( !hasParent || neighborKey < parentKey ) )
+            {
+            hasParent = true;
+            parentKey = neighborKey;
+            parents[q] = static_cast< ParentType >( k );
+            }
+          }
+        }
+    },
+    nullptr);
+
+  std::vector< std::vector< LabelMessageType > > labelMessages[2];
+  labelMessages[0].resize(2 * numberOfSlabs);
+  labelMessages[1].resize(2 * numberOfSlabs);
+  auto labelSlab = [&]( SizeValueType slab, std::vector< std::vector< LabelMessageType > > & received,
+                       std::vector< std::vector< LabelMessageType > > & sent )
+    {
+      std::queue< OffsetValueType > & fifo = fifos[slab];
+      for ( unsigned int side = 0; side < 2; ++side )
+        {
+        for ( const LabelMessageType & message : received[2 * slab + side] )
+          {
+          output[message.first] = message.second;
+          fifo.push(message.first);
+          }
+        received[2 * slab + side].clear();
+        }
+
+      while ( !fifo.empty() )
+        {
+        const OffsetValueType p = fifo.front();
+        fifo.pop();
+        const IndexType index = indexOf(p);
+        const bool      onBorder = isOnBorder(index);
+        for ( unsigned int k = 0; k < neighbors.size(); ++k )
+          {
+          if ( onBorder && !isInside(index, k) )
+            {
+            continue;
+            }
+          const OffsetValueType q = p + neighbors[k];
+          // only the pixels whose flood comes from this one
+          if ( markers[q] != bgLabel || steps[q] == Unreached || q + neighbors[parents[q]] != p )
+            {
+            continue;
+            }
+          const int crossing = crossingOf(slab, index, k);
+          if ( crossing != 0 )
+            {
+            sent[messageListOf(slab, crossing)].emplace_back(q, output[p]);
+            }
+          else
+            {
+            output[q] = output[p];
+            fifo.push(q);
+            }
+          }
+        }
+    };
+  current = 0;
+  do
+    {
+    this->GetMultiThreader()->ParallelizeArray(0, numberOfSlabs,
+      [&]( SizeValueType slab )
+      {
+        labelSlab(slab, labelMessages[current], labelMessages[1 - current]);
+      },
+      nullptr);
+    current = 1 - current;
+    }
+  while ( std::any_of( labelMessages[current].begin(), labelMessages[current].end(),
+                       []( const std::vector< LabelMessageType > & messageList ) { return !messageList.empty(); } ) );
+
+  if ( !m_MarkWatershedLine )
+    {
+    this->UpdateProgress(1.0f);
+    return;
+    }
+  this->UpdateProgress(0.7f);
+
+  // A pixel is on the watershed line if one of its neighbors belongs to
+  // another basin, and is a marker or has been flooded before it, or at the
+  // same time with a lower label. The basins are then flooded again from
+  // the markers without crossing the line, to find the pixels cut off by
+  // the line, which are on the line too.
+  enum : unsigned char { Unprocessed = 0, OnLine, Reached };
+  // the links to the parents are not needed anymore
+  std::vector< ParentType > & status = parents;
+  this->GetMultiThreader()->ParallelizeArray(0, numberOfSlabs,
+    [&]( SizeValueType slab )
+    {
+      for ( OffsetValueType p = slabBeginOf(slab); p < slabBeginOf(slab + 1); ++p )
+        {
+        if ( markers[p] != bgLabel )
+          {
+          status[p] = Reached;
+          fifos[slab].push(p);
+          continue;
+          }
+        status[p] = Unprocessed;
+        const LabelImagePixelType label = output[p];
+        if ( label == wsLabel )
+          {
+          continue;
+          }
+        const FloodKey  key = keyOf(p);
+        const IndexType index = indexOf(p);
+        const bool      onBorder = isOnBorder(index);
+        for ( unsigned int k = 0; k < neighbors.size(); ++k )
+          {
+          if ( onBorder && !isInside(index, k) )
+            {
+            continue;
+            }
+          const OffsetValueType     q = p + neighbors[k];
+          const LabelImagePixelType neighborLabel = output[q];
+          if ( neighborLabel == wsLabel || neighborLabel == label )
+            {
+            continue;
+            }
+          const FloodKey neighborKey = keyOf(q);
+          if ( markers[q] != bgLabel || neighborKey < key || ( !( key < neighborKey ) && neighborLabel < label ) )
+            {
+            status[p] = OnLine;
+            break;
+            }
+          }
+        }
+    },
+    nullptr);
+
+  std::vector< std::vector< OffsetValueType > > reachMessages[2];
+  reachMessages[0].resize(2 * numberOfSlabs);
+  reachMessages[1].resize(2 * numberOfSlabs);
+  auto reachSlab = [&]( SizeValueType slab, std::vector< std::vector< OffsetValueType > > & received,
+                       std::vector< std::vector< OffsetValueType > > & sent )
+    {
+      std::queue< OffsetValueType > & fifo = fifos[slab];
+      for ( unsigned int side = 0; side < 2; ++side )
+        {
+        for ( const OffsetValueType q : received[2 * slab + side] )
+          {
+          if ( status[q] == Unprocessed )
+            {
+            status[q] = Reached;
+            fifo.push(q);
+            }
+          }
+        received[2 * slab + side].clear();
+        }
+
+      while ( !fifo.empty() )
+        {
+        const OffsetValueType p = fifo.front();
+        fifo.pop();
+        const IndexType index = indexOf(p);
+        const bool      onBorder = isOnBorder(index);
+        for ( unsigned int k = 0; k < neighbors.size(); ++k )
+          {
+          if ( onBorder && !isInside(index, k) )
+            {
+            continue;
+            }
+          const OffsetValueType q = p + neighbors[k];
+          if ( markers[q] != bgLabel || output[q] != output[p] )
+            {
+            continue;
+            }
+          const int crossing = crossingOf(slab, index, k);
+          if ( crossing != 0 )
+            {
+            sent[messageListOf(slab, crossing)].push_back(q);
+            }
+          else if ( status[q] == Unprocessed )
+            {
+            status[q] = Reached;
+            fifo.push(q);
+            }
+          }
+        }
+    };
+  current = 0;
+  do
+    {
+    this->GetMultiThreader()->ParallelizeArray(0, numberOfSlabs,
+      [&]( SizeValueType slab )
+      {
+        reachSlab(slab, reachMessages[current], reachMessages[1 - current]);
+      },
+      nullptr);
+    current = 1 - current;
+    }
+  while ( std::any_of( reachMessages[current].begin(), reachMessages[current].end(),
+                       []( const std::vector< OffsetValueType > & messageList ) { return !messageList.empty(); } ) );
+
+  this->GetMultiThreader()->ParallelizeArray(0, numberOfSlabs,
+    [&]( SizeValueType slab )
+    {
+      for ( OffsetValueType p = slabBeginOf(slab); p < slabBeginOf(slab + 1); ++p )
+        {
+        if ( status[p] != Reached )
+          {
+          output[p] = wsLabel;
+          }
+        }
+    },
+    nullptr);
+
+  this->UpdateProgress(1.0f);
+}
+
+
 template< typename TInputImage, typename TLabelImage >
 void
 MorphologicalWatershedFromMarkersImageFilter< TInputImage, TLabelImage >
@@ -454,6 +1007,7 @@ MorphologicalWatershedFromMarkersImageFilter< TInputImage, TLabelImage >
 
   os << indent << "FullyConnected: "  << m_FullyConnected << std::endl;
   os << indent << "MarkWatershedLine: "  << m_MarkWatershedLine << std::endl;
+  os << indent << "UseParallelFlooding: "  << m_UseParallelFlooding << std::endl;
 }
 
 } // end namespace itk
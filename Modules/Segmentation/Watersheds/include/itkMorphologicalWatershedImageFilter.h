@@ -96,12 +96,22 @@ public:
   /**
    * Set/Get whether the watershed pixel must be marked or not. Default
    * is true. Set it to false do not only avoid writing watershed pixels,
-   * it also decrease algorithm complexity.
+   * it also decrease algorithm complexity. The line of the parallel
+   * flooding may be thicker than the serial one.
+   * \sa MorphologicalWatershedFromMarkersImageFilter::SetMarkWatershedLine
    */
   itkSetMacro(MarkWatershedLine, bool);
   itkGetConstReferenceMacro(MarkWatershedLine, bool);
   itkBooleanMacro(MarkWatershedLine);
 
+  /**
+   * Set/Get whether the image is flooded in parallel. Default is false.
+   * \sa MorphologicalWatershedFromMarkersImageFilter::SetUseParallelFlooding
+   */
+  itkSetMacro(UseParallelFlooding, bool);
+  itkGetConstReferenceMacro(UseParallelFlooding, bool);
+  itkBooleanMacro(UseParallelFlooding);
+
   /**
    */
   itkSetMacro(Level, InputImagePixelType);
@@ -129,6 +139,8 @@ private:
 
   bool m_MarkWatershedLine{ true };
 
+  bool m_UseParallelFlooding{ false };
+
   InputImagePixelType m_Level;
 }; // end of class
 } // end namespace itk
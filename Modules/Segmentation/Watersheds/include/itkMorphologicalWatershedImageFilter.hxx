@@ -107,6 +107,8 @@ MorphologicalWatershedImageFilter< TInputImage, TOutputImage >
   wshed->SetMarkerImage( label->GetOutput() );
   wshed->SetFullyConnected(m_FullyConnected);
   wshed->SetMarkWatershedLine(m_MarkWatershedLine);
+  wshed->SetUseParallelFlooding(m_UseParallelFlooding);
+  wshed->SetNumberOfWorkUnits( this->GetNumberOfWorkUnits() );
 
   if ( m_Level != NumericTraits< InputImagePixelType >::ZeroValue() )
     {
@@ -155,6 +157,7 @@ MorphologicalWatershedImageFilter< TInputImage, TOutputImage >
 
   os << indent << "FullyConnected: "  << m_FullyConnected << std::endl;
   os << indent << "MarkWatershedLine: "  << m_MarkWatershedLine << std::endl;
+  os << indent << "UseParallelFlooding: "  << m_UseParallelFlooding << std::endl;
   os << indent << "Level: "
      << static_cast< typename NumericTraits< InputImagePixelType >::PrintType >( m_Level )
      << std::endl;
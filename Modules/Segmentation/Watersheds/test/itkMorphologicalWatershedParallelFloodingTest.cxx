@@ -0,0 +1,375 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+#include <cmath>
+#include <iostream>
+#include <queue>
+#include <vector>
+
+#include "itkImageRegionConstIteratorWithIndex.h"
+#include "itkImageRegionIteratorWithIndex.h"
+#include "itkMersenneTwisterRandomVariateGenerator.h"
+#include "itkMorphologicalWatershedFromMarkersImageFilter.h"
+#include "itkMorphologicalWatershedImageFilter.h"
+#include "itkTestingMacros.h"
+
+/* MorphologicalWatershedFromMarkersImageFilter with the slabs of the image
+ * flooded in parallel. The labels must not depend on the number of work
+ * units, must agree with the serial flooding without the watershed line
+ * away from the places where the basins meet, and each basin must be
+ * connected to its marker. With
+ * the watershed line marked, no two basins may touch. In 2D and 3D, with
+ * face and full connectivity, on a smooth image and on an image with
+ * plateaus.
+ */
+
+namespace
+{
+
+// The neighbors of a pixel, as offsets
+template< unsigned int VDimension >
+std::vector< itk::Offset< VDimension > >
+Neighbors( bool fullyConnected )
+{
+  std::vector< itk::Offset< VDimension > > neighbors;
+  unsigned int numberOfNeighborhoodPixels = 1;
+  for ( unsigned int d = 0; d < VDimension; ++d )
+    {
+    numberOfNeighborhoodPixels *= 3;
+    }
+  for ( unsigned int n = 0; n < numberOfNeighborhoodPixels; ++n )
+    {
+    itk::Offset< VDimension > offset;
+    unsigned int              numberOfNonZeroSteps = 0;
+    for ( unsigned int d = 0, k = n; d < VDimension; ++d, k /= 3 )
+      {
+      offset[d] = static_cast< int >( k % 3 ) - 1;
+      numberOfNonZeroSteps += ( offset[d] != 0 );
+      }
+    if ( numberOfNonZeroSteps > 0 && ( fullyConnected || numberOfNonZeroSteps == 1 ) )
+      {
+      neighbors.push_back( offset );
+      }
+    }
+  return neighbors;
+}
+
+// A few wells, the markers at their bottom, and noise. Quantized, the
+// image has plateaus.
+template< typename TImage, typename TLabelImage >
+void
+CreateImages( const typename TImage::SizeType & size, bool quantize, typename TImage::Pointer & image,
+              typename TLabelImage::Pointer & markers )
+{
+  constexpr unsigned int Dimension = TImage::ImageDimension;
+  constexpr unsigned int NumberOfWells = 5;
+
+  using RandomizerType = itk::Statistics::MersenneTwisterRandomVariateGenerator;
+  RandomizerType::Pointer randomizer = RandomizerType::New();
+  randomizer->SetSeed( 4321 );
+
+  double centers[NumberOfWells][Dimension];
+  for ( auto & center : centers )
+    {
+    for ( unsigned int d = 0; d < Dimension; ++d )
+      {
+      center[d] = 2.0 + randomizer->GetVariateWithOpenUpperRange( size[d] - 4.0 );
+      }
+    }
+
+  image = TImage::New();
+  image->SetRegions( size );
+  image->Allocate();
+  markers = TLabelImage::New();
+  markers->SetRegions( size );
+  markers->Allocate( true );
+
+  itk::ImageRegionIteratorWithIndex< TImage > it( image, image->GetLargestPossibleRegion() );
+  for ( ; !it.IsAtEnd(); ++it )
+    {
+    double value = 0.0;
+    for ( unsigned int w = 0; w < NumberOfWells; ++w )
+      {
+      double squaredDistance = 0.0;
+      for ( unsigned int d = 0; d < Dimension; ++d )
+        {
+        const double delta = it.GetIndex()[d] - centers[w][d];
+        squaredDistance += delta * delta;
+        }
+      value -= 100.0 * std::exp( -squaredDistance / 30.0 );
+      if ( squaredDistance < 1.0 )
+        {
+        markers->SetPixel( it.GetIndex(), w + 1 );
+        }
+      }
+    value += randomizer->GetVariateWithOpenUpperRange( 0.5 );
+    it.Set( quantize ? std::floor( value / 8.0 ) : value );
+    }
+}
+
+// The label of each pixel, or of one of its neighbors, differs from the
+// one of the reference where they are different.
+template< typename TLabelImage >
+bool
+DifferOnlyWhereBasinsMeet( const TLabelImage * labels, const TLabelImage * reference, bool fullyConnected )
+{
+  const auto neighbors = Neighbors< TLabelImage::ImageDimension >( true );
+  const typename TLabelImage::RegionType region = reference->GetLargestPossibleRegion();
+  itk::SizeValueType numberOfDifferences = 0;
+  itk::ImageRegionConstIteratorWithIndex< TLabelImage > it( labels, region );
+  for ( ; !it.IsAtEnd(); ++it )
+    {
+    const typename TLabelImage::PixelType expected = reference->GetPixel( it.GetIndex() );
+    if ( it.Get() == expected )
+      {
+      continue;
+      }
+    ++numberOfDifferences;
+    bool atBasinBoundary = ( expected == 0 );
+    for ( const auto & offset : neighbors )
+      {
+      const typename TLabelImage::IndexType neighbor = it.GetIndex() + offset;
+      if ( region.IsInside( neighbor ) && reference->GetPixel( neighbor ) != expected )
+        {
+        atBasinBoundary = true;
+        }
+      }
+    if ( !atBasinBoundary )
+      {
+      std::cerr << "Test failed!" << std::endl;
+      std::cerr << "Label " << it.Get() << " instead of " << expected << " at " << it.GetIndex()
+                << ", inside a basin, FullyConnected: " << fullyConnected << std::endl;
+      return false;
+      }
+    }
+  std::cout << "    " << numberOfDifferences << " pixels differ from the serial flooding" << std::endl;
+  return true;
+}
+
+// Each basin is connected to its marker, and with the watershed line, no
+// two basins touch.
+template< typename TLabelImage >
+bool
+CheckBasins( const TLabelImage * labels, const TLabelImage * markers, bool fullyConnected, bool markWatershedLine )
+{
+  using IndexType = typename TLabelImage::IndexType;
+  const auto neighbors = Neighbors< TLabelImage::ImageDimension >( fullyConnected );
+  const typename TLabelImage::RegionType region = labels->GetLargestPossibleRegion();
+
+  using FlagImageType = itk::Image< unsigned char, TLabelImage::ImageDimension >;
+  typename FlagImageType::Pointer reached = FlagImageType::New();
+  reached->SetRegions( region );
+  reached->Allocate( true );
+
+  std::queue< IndexType > fifo;
+  itk::ImageRegionConstIteratorWithIndex< TLabelImage > mit( markers, region );
+  for ( ; !mit.IsAtEnd(); ++mit )
+    {
+    if ( mit.Get() != 0 )
+      {
+      if ( labels->GetPixel( mit.GetIndex() ) != mit.Get() )
+        {
+        std::cerr << "Test failed!" << std::endl;
+        std::cerr << "Marker " << mit.Get() << " not copied at " << mit.GetIndex() << std::endl;
+        return false;
+        }
+      reached->SetPixel( mit.GetIndex(), 1 );
+      fifo.push( mit.GetIndex() );
+      }
+    }
+  while ( !fifo.empty() )
+    {
+    const IndexType index = fifo.front();
+    fifo.pop();
+    const typename TLabelImage::PixelType label = labels->GetPixel( index );
+    for ( const auto & offset : neighbors )
+      {
+      const IndexType neighbor = index + offset;
+      if ( !region.IsInside( neighbor ) )
+        {
+        continue;
+        }
+      const typename TLabelImage::PixelType neighborLabel = labels->GetPixel( neighbor );
+      if ( markWatershedLine && neighborLabel != 0 && neighborLabel != label )
+        {
+        std::cerr << "Test failed!" << std::endl;
+        std::cerr << "Basins " << label << " and " << neighborLabel << " touch at " << neighbor << std::endl;
+        return false;
+        }
+      if ( neighborLabel == label && !reached->GetPixel( neighbor ) )
+        {
+        reached->SetPixel( neighbor, 1 );
+        fifo.push( neighbor );
+        }
+      }
+    }
+
+  itk::ImageRegionConstIteratorWithIndex< TLabelImage > it( labels, region );
+  for ( ; !it.IsAtEnd(); ++it )
+    {
+    if ( it.Get() != 0 && !reached->GetPixel( it.GetIndex() ) )
+      {
+      std::cerr << "Test failed!" << std::endl;
+      std::cerr << "Pixel " << it.GetIndex() << " of basin " << it.Get() << " not connected to its marker"
+                << std::endl;
+      return false;
+      }
+    if ( !markWatershedLine && it.Get() == 0 )
+      {
+      std::cerr << "Test failed!" << std::endl;
+      std::cerr << "Pixel " << it.GetIndex() << " not flooded" << std::endl;
+      return false;
+      }
+    }
+  return true;
+}
+
+template< typename TLabelImage >
+bool
+CompareImages( const TLabelImage * labels, const TLabelImage * expected )
+{
+  itk::ImageRegionConstIteratorWithIndex< TLabelImage > it( labels, labels->GetLargestPossibleRegion() );
+  for ( ; !it.IsAtEnd(); ++it )
+    {
+    if ( it.Get() != expected->GetPixel( it.GetIndex() ) )
+      {
+      std::cerr << "Test failed!" << std::endl;
+      std::cerr << "Label " << it.Get() << " instead of " << expected->GetPixel( it.GetIndex() ) << " at "
+                << it.GetIndex() << std::endl;
+      return false;
+      }
+    }
+  return true;
+}
+
+template< unsigned int VDimension >
+bool
+TestDimension( const itk::Size< VDimension > & size )
+{
+  using ImageType = itk::Image< float, VDimension >;
+  using LabelImageType = itk::Image< unsigned short, VDimension >;
+  using FilterType = itk::MorphologicalWatershedFromMarkersImageFilter< ImageType, LabelImageType >;
+
+  bool testPassed = true;
+  for ( bool quantize : { false, true } )
+    {
+    typename ImageType::Pointer      image;
+    typename LabelImageType::Pointer markers;
+    CreateImages< ImageType, LabelImageType >( size, quantize, image, markers );
+
+    for ( bool fullyConnected : { false, true } )
+      {
+      for ( bool markWatershedLine : { false, true } )
+        {
+        std::cout << VDimension << "D, plateaus: " << quantize << ", FullyConnected: " << fullyConnected
+                  << ", MarkWatershedLine: " << markWatershedLine << std::endl;
+
+        typename FilterType::Pointer serialFilter = FilterType::New();
+        serialFilter->SetInput( image );
+        serialFilter->SetMarkerImage( markers );
+        serialFilter->SetFullyConnected( fullyConnected );
+        serialFilter->SetMarkWatershedLine( markWatershedLine );
+        serialFilter->Update();
+
+        typename LabelImageType::Pointer expected;
+        for ( itk::ThreadIdType numberOfWorkUnits : { 1, 3, 8, 100 } )
+          {
+          typename FilterType::Pointer filter = FilterType::New();
+          filter->SetInput( image );
+          filter->SetMarkerImage( markers );
+          filter->SetFullyConnected( fullyConnected );
+          filter->SetMarkWatershedLine( markWatershedLine );
+          filter->UseParallelFloodingOn();
+          filter->SetNumberOfWorkUnits( numberOfWorkUnits );
+          filter->Update();
+          std::cout << "  " << numberOfWorkUnits << " work units" << std::endl;
+
+          if ( expected.IsNull() )
+            {
+            expected = filter->GetOutput();
+            expected->DisconnectPipeline();
+            testPassed &= CheckBasins< LabelImageType >( expected, markers, fullyConnected, markWatershedLine );
+            // the serial watershed line stops the floods, which may then
+            // take other paths
+            if ( !quantize && !markWatershedLine )
+              {
+              testPassed &= DifferOnlyWhereBasinsMeet< LabelImageType >( expected, serialFilter->GetOutput(),
+                                                                         fullyConnected );
+              }
+            }
+          else
+            {
+            testPassed &= CompareImages< LabelImageType >( filter->GetOutput(), expected );
+            }
+          }
+        }
+      }
+    }
+  return testPassed;
+}
+}
+
+int itkMorphologicalWatershedParallelFloodingTest( int, char *[] )
+{
+  using ImageType = itk::Image< float, 2 >;
+  using LabelImageType = itk::Image< unsigned short, 2 >;
+  using FilterType = itk::MorphologicalWatershedFromMarkersImageFilter< ImageType, LabelImageType >;
+  FilterType::Pointer filter = FilterType::New();
+  TEST_SET_GET_BOOLEAN( filter, UseParallelFlooding, true );
+  TEST_SET_GET_BOOLEAN( filter, UseParallelFlooding, false );
+
+  bool testPassed = true;
+
+  itk::Size< 2 > size2D = {{ 47, 39 }};
+  testPassed &= TestDimension< 2 >( size2D );
+
+  itk::Size< 3 > size3D = {{ 17, 15, 19 }};
+  testPassed &= TestDimension< 3 >( size3D );
+
+  // The watershed without markers forwards the option
+  using WatershedType = itk::MorphologicalWatershedImageFilter< ImageType, LabelImageType >;
+  ImageType::Pointer      image;
+  LabelImageType::Pointer markers;
+  CreateImages< ImageType, LabelImageType >( size2D, false, image, markers );
+  LabelImageType::Pointer expected;
+  for ( itk::ThreadIdType numberOfWorkUnits : { 1, 5 } )
+    {
+    WatershedType::Pointer watershed = WatershedType::New();
+    TEST_SET_GET_BOOLEAN( watershed, UseParallelFlooding, true );
+    watershed->SetInput( image );
+    watershed->SetLevel( 10.0 );
+    watershed->SetNumberOfWorkUnits( numberOfWorkUnits );
+    watershed->Update();
+    if ( expected.IsNull() )
+      {
+      expected = watershed->GetOutput();
+      expected->DisconnectPipeline();
+      }
+    else
+      {
+      testPassed &= CompareImages< LabelImageType >( watershed->GetOutput(), expected );
+      }
+    }
+
+  if ( !testPassed )
+    {
+    return EXIT_FAILURE;
+    }
+  std::cout << "Test finished." << std::endl;
+  return EXIT_SUCCESS;
+}